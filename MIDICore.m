@@ -8,14 +8,10 @@
 
 #import "MIDICore.h"
 
-#import <CoreMIDI/MIDIServices.h>
-#import <CoreAudio/HostTime.h>
-
 #import "MIOCConnection.h"
+#import "MIOCVelocityProcessor.h"
 #import "MIDIIO.h"
-
-// Forward definitions of callback
-static void MIDICoreReadProc(const MIDIPacketList *pktlist, void *refCon, void *connRefCon);
+#import "RNArchitectureDefines.h"
 
 @implementation MIDICore
 
@@ -26,66 +22,120 @@ static void MIDICoreReadProc(const MIDIPacketList *pktlist, void *refCon, void *
 	if (!self) return nil;
 
 	_MIDILink = midiIO;
-	[_MIDILink setReadProc:MIDICoreReadProc refCon:self];
-	// insert self into MIDIIO, gather local copy of ports
-
-	_outPortLocalCopy	= [_MIDILink outPort];
-	_MIDIDestLocalCopy	= [_MIDILink MIDIDest];
-
-	// register to be notified when destination changes (the only relevant change)
-	[[NSNotificationCenter defaultCenter] addObserver:self
-											 selector:@selector(newDestinationHandler:)
-												name	:@"MIDIIO_newDestinationNotification" object:nil];
+	_tables[0] = MIDICoreTableCreate();
+	_tables[1] = MIDICoreTableCreate();
+	_liveTable = -1;
+	_connections = [@[] retain];
+	_velocityProcessors = [@[] retain];
 	return self;
 }
 
 - (void)dealloc
 {
-	[[NSNotificationCenter defaultCenter] removeObserver:self];
-	[_MIDILink setDefaultReadProc];
+	[_MIDILink setMIDICoreTable:NULL];
+	MIDICoreTableDestroy(_tables[0]);
+	MIDICoreTableDestroy(_tables[1]);
+	[_connections release];
+	[_velocityProcessors release];
 	[super dealloc];
 }
 
-- (void)connect:(MIOCConnection *)aConnection
+static MIDICoreRoute routeForConnection(MIOCConnection *conn)
 {
-	// add to our list of
+	return (MIDICoreRoute){ [conn inPort], [conn inChannel], [conn outPort], [conn outChannel], (int64_t)([conn delay] * 1e6) };
 }
 
-- (void)disconnect:(MIOCConnection *)aConnection
-{}
-
-- (void)addVelocityProcessor:(MIOCVelocityProcessor *)aVelProc
-{}
-
-- (void)removeVelocityProcessor:(MIOCVelocityProcessor *)aVelProc
-{}
-
-- (void)newDestinationHandler:(NSNotification *)notification
+static MIDICoreVelocityMap mapForProcessor(MIOCVelocityProcessor *processor)
 {
-	// update local copies
-	_MIDIDestLocalCopy = [_MIDILink MIDIDest];
+	const Byte *bytes = [[processor MIDIBytes] bytes];	// 0-based port, encoded channel (MIDIBytes)
+	return (MIDICoreVelocityMap){
+		.port			= bytes[1] + 1,
+		.channel		= (bytes[2] == 0x10) ? kMIDICoreAnyChannel : bytes[2] - 0x90 + 1,
+		.onInput		= (bytes[0] == kMIOCInputVelocityProcessorType),
+		.position		= bytes[3],
+		.threshold		= bytes[4],
+		.gradientBelow	= (SInt8) bytes[5],
+		.gradientAbove	= (SInt8) bytes[6],
+		.offset			= (SInt8) bytes[7],
+	};
 }
 
-static void MIDICoreReadProc(const MIDIPacketList *pktlist, void *refCon, void *connRefCon)
+- (BOOL)setConnections:(NSArray *)connectionList velocityProcessors:(NSArray *)processorList
+   hardwareConnections:(NSArray **)hardwareConnections hardwareVelocityProcessors:(NSArray **)hardwareProcessors
 {
-	unsigned int	i, pktlistLength;
-	MIDICore		*myself = (MIDICore *)refCon;
-
-	NSLog(@"in MIDICoreReadProc");
-
-	// sketch
-	// NEW :jri:20050929 We'll use MIDIThruConnections for this first pass
-	// X walk packet list, for note on find port (connRefCon) and midi channel
-	// X use these to index into _processListPtrArray, walk the processList creating
-	// X new packets with new channel and possibly modified velocity. Send this new list marked for
-	// X		immediate scheduling
-	// X same for next input packet
-	//
-	// walk input packet list a second time, repeating process on _delayProcessListPtrArray
-	//	only difference: schedule for a later time relative to input timestamp
-	// AND, need to get data out to listeners registered in MIDIIO--we can store the original readproc
-	// when we patch ours in and then call it after we've done our scheduling. That's not time critical, so we'll
-	// best move out of the realtime thread to one of our methods
+	NSUInteger nRoutes = [connectionList count], nMaps = [processorList count];
+	NSMutableData *routeData = [NSMutableData dataWithLength:MAX(nRoutes, 1) * sizeof(MIDICoreRoute)];
+	NSMutableData *mapData = [NSMutableData dataWithLength:MAX(nMaps, 1) * sizeof(MIDICoreVelocityMap)];
+	NSMutableData *flagData = [NSMutableData dataWithLength:MAX(nRoutes, 1) + MAX(nMaps, 1)];
+	MIDICoreRoute *routes = [routeData mutableBytes], egress[kMIDICoreChannels];
+	MIDICoreVelocityMap *maps = [mapData mutableBytes];
+	bool *routeInSoftware = [flagData mutableBytes], *mapInSoftware = routeInSoftware + MAX(nRoutes, 1);
+
+	for (NSUInteger i = 0; i < nRoutes; i++)
+		routes[i] = routeForConnection(connectionList[i]);
+	for (NSUInteger m = 0; m < nMaps; m++)
+		maps[m] = mapForProcessor(processorList[m]);
+	uint32_t nEgress = MIDICoreSplit(routes, (uint32_t) nRoutes, maps, (uint32_t) nMaps, kBigBrotherPort, kDelayPort,
+									 routeInSoftware, mapInSoftware, egress, kMIDICoreChannels);
+
+	// the software part, packed in front of the lists
+	NSMutableArray *softwareConnections = [NSMutableArray arrayWithCapacity:nRoutes], *softwareProcessors = [NSMutableArray arrayWithCapacity:nMaps];
+	NSMutableArray *MIOCConnections = [NSMutableArray arrayWithCapacity:nRoutes + nEgress], *MIOCProcessors = [NSMutableArray arrayWithCapacity:nMaps];
+	uint32_t nSoftwareRoutes = 0, nSoftwareMaps = 0;
+	for (NSUInteger i = 0; i < nRoutes; i++) {
+		if (routeInSoftware[i]) {
+			routes[nSoftwareRoutes++] = routes[i];
+			[softwareConnections addObject:connectionList[i]];
+		} else {
+			[MIOCConnections addObject:connectionList[i]];
+		}
+	}
+	for (NSUInteger m = 0; m < nMaps; m++) {
+		if (mapInSoftware[m]) {
+			maps[nSoftwareMaps++] = maps[m];
+			[softwareProcessors addObject:processorList[m]];
+		} else {
+			[MIOCProcessors addObject:processorList[m]];
+		}
+	}
+	for (uint32_t i = 0; i < nEgress; i++) {
+		MIOCConnection *conn = [MIOCConnection connectionWithInPort:egress[i].inPort InChannel:egress[i].inChannel
+															OutPort:egress[i].outPort OutChannel:egress[i].outChannel];
+		if (![MIOCConnections containsObject:conn]) [MIOCConnections addObject:conn];
+	}
+
+	int nextTable = (_liveTable == 0) ? 1 : 0;
+	if (!MIDICoreTableCompile(_tables[nextTable], routes, nSoftwareRoutes, maps, nSoftwareMaps)) {
+		NSLog(@"MIDICore: %u routes are too many for the software matrix; the MIOC keeps them all", nSoftwareRoutes);
+		[_MIDILink setMIDICoreTable:NULL];
+		_liveTable = -1;
+		softwareConnections = [NSMutableArray array];
+		softwareProcessors = [NSMutableArray array];
+		MIOCConnections = [[connectionList mutableCopy] autorelease];
+		MIOCProcessors = [[processorList mutableCopy] autorelease];
+	} else {
+		[_MIDILink setMIDICoreTable:_tables[nextTable]];
+		_liveTable = nextTable;
+		NSLog(@"MIDICore: %lu connections (%u routes) and %lu velocity processors in software; %lu connections (%u to carry our output) stay on the MIOC",
+			  (unsigned long)[softwareConnections count], MIDICoreTableProcessCount(_tables[nextTable]), (unsigned long)[softwareProcessors count],
+			  (unsigned long)[MIOCConnections count], nEgress);
+	}
+
+	[_connections release];
+	_connections = [softwareConnections copy];
+	[_velocityProcessors release];
+	_velocityProcessors = [softwareProcessors copy];
+	*hardwareConnections = MIOCConnections;
+	*hardwareProcessors = MIOCProcessors;
+	return _liveTable >= 0;
+}
+
+- (NSArray *)connections {
+	return _connections;
+}
+
+- (NSArray *)velocityProcessors {
+	return _velocityProcessors;
 }
 
 @end
@@ -0,0 +1,260 @@
+//
+//  MIDICoreTable.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "MIDICoreTable.h"
+#include "MIOCVelocityMap.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define kLists			(kMIDICorePorts * kMIDICoreChannels)
+#define kAllChannels	0xFFFFu
+
+struct MIDICoreTable {
+	// list l (in port - 1, channel) is processes[first[l] .. first[l + 1]), its immediate routes up to delayed[l]
+	uint16_t		first[kLists + 1];
+	uint16_t		delayed[kLists];
+	uint8_t			inputPort[kMIDICoreChannels];
+	uint32_t		nProcesses;
+	uint32_t		nVelocityTables;
+	MIDICoreProcess	processes[kMIDICoreMaxProcesses];
+	uint8_t			velocityTables[kMIDICoreMaxVelocityTables][kMIOCVelocityTableLength];
+};
+
+MIDICoreTable *MIDICoreTableCreate(void)
+{
+	MIDICoreTable *table = calloc(1, sizeof(MIDICoreTable));
+	if (table == NULL) return NULL;
+	MIDICoreTableCompile(table, NULL, 0, NULL, 0);
+	return table;
+}
+
+void MIDICoreTableDestroy(MIDICoreTable *table)
+{
+	free(table);
+}
+
+static bool validPort(uint8_t port)
+{
+	return port >= 1 && port <= kMIDICorePorts;
+}
+
+static bool validChannel(uint8_t channel)
+{
+	return channel == kMIDICoreAnyChannel || (channel >= 1 && channel <= kMIDICoreChannels);
+}
+
+// MIDI channels a 1-based channel (or any) stands for
+static uint16_t channelMask(uint8_t channel)
+{
+	return (channel == kMIDICoreAnyChannel) ? kAllChannels : (uint16_t)(1u << (channel - 1));
+}
+
+// the maps on one side of a port and MIDI channel, in position order (stable, as the MIOC places them)
+static uint32_t mapsAt(const MIDICoreVelocityMap *maps, uint32_t nMaps, bool onInput, uint8_t port, uint8_t channel,
+					   const MIDICoreVelocityMap **found, uint32_t maxFound)
+{
+	uint32_t n = 0;
+	for (uint32_t i = 0; i < nMaps && n < maxFound; i++) {
+		const MIDICoreVelocityMap *map = &maps[i];
+		if (map->onInput != onInput || map->port != port || !(channelMask(map->channel) & (1u << channel))) continue;
+		uint32_t at = n++;
+		for (; at > 0 && found[at - 1]->position > map->position; at--)
+			found[at] = found[at - 1];
+		found[at] = map;
+	}
+	return n;
+}
+
+// index of the table for a route's maps, adding it if new; 0 is velocity unchanged, -1 if there's no room
+static int32_t velocityTableFor(MIDICoreTable *table, const MIDICoreVelocityMap *maps, uint32_t nMaps,
+								uint8_t inPort, uint8_t inChannel, uint8_t outPort, uint8_t outChannel)
+{
+	const MIDICoreVelocityMap *chain[2 * kMIDICorePorts * 8];
+	uint32_t n = mapsAt(maps, nMaps, true, inPort, inChannel, chain, 8 * kMIDICorePorts);
+	n += mapsAt(maps, nMaps, false, outPort, outChannel, chain + n, 8 * kMIDICorePorts);
+	if (n == 0) return 0;
+
+	MIOCVelocityCurve curves[2 * kMIDICorePorts * 8];
+	for (uint32_t k = 0; k < n; k++)
+		curves[k] = (MIOCVelocityCurve){ chain[k]->threshold, chain[k]->gradientBelow, chain[k]->gradientAbove, chain[k]->offset };
+	uint8_t mapped[kMIOCVelocityTableLength];
+	MIOCVelocityTableCompile(mapped, curves, n);
+	for (uint32_t i = 0; i < table->nVelocityTables; i++)
+		if (memcmp(table->velocityTables[i], mapped, sizeof(mapped)) == 0) return (int32_t) i;
+	if (table->nVelocityTables == kMIDICoreMaxVelocityTables) return -1;
+	memcpy(table->velocityTables[table->nVelocityTables], mapped, sizeof(mapped));
+	return (int32_t) table->nVelocityTables++;
+}
+
+static void clear(MIDICoreTable *table)
+{
+	memset(table->first, 0, sizeof(table->first));
+	memset(table->delayed, 0, sizeof(table->delayed));
+	memset(table->inputPort, 0, sizeof(table->inputPort));
+	table->nProcesses = 0;
+	table->nVelocityTables = 1;
+	MIOCVelocityTableCompile(table->velocityTables[0], NULL, 0);
+}
+
+bool MIDICoreTableCompile(MIDICoreTable *table, const MIDICoreRoute *routes, uint32_t nRoutes,
+						  const MIDICoreVelocityMap *maps, uint32_t nMaps)
+{
+	uint32_t counts[kLists][2];
+	memset(counts, 0, sizeof(counts));
+	clear(table);
+
+	// count each list's immediate and delayed routes, then lay the lists out
+	for (uint32_t i = 0; i < nRoutes; i++) {
+		const MIDICoreRoute *route = &routes[i];
+		if (!validPort(route->inPort) || !validPort(route->outPort) || !validChannel(route->inChannel) || !validChannel(route->outChannel))
+			continue;
+		uint16_t channels = channelMask(route->inChannel);
+		for (uint8_t channel = 0; channel < kMIDICoreChannels; channel++)
+			if (channels & (1u << channel)) counts[(route->inPort - 1) * kMIDICoreChannels + channel][route->delay_ns > 0]++;
+	}
+	uint32_t total = 0;
+	for (uint32_t l = 0; l < kLists; l++) {
+		table->first[l] = (uint16_t) total;
+		table->delayed[l] = (uint16_t)(total + counts[l][0]);
+		total += counts[l][0] + counts[l][1];
+		if (total > kMIDICoreMaxProcesses) {
+			clear(table);
+			return false;
+		}
+	}
+	table->first[kLists] = (uint16_t) total;
+
+	uint16_t next[kLists][2];
+	for (uint32_t l = 0; l < kLists; l++) {
+		next[l][0] = table->first[l];
+		next[l][1] = table->delayed[l];
+	}
+	for (uint32_t i = 0; i < nRoutes; i++) {
+		const MIDICoreRoute *route = &routes[i];
+		if (!validPort(route->inPort) || !validPort(route->outPort) || !validChannel(route->inChannel) || !validChannel(route->outChannel))
+			continue;
+		uint16_t channels = channelMask(route->inChannel);
+		for (uint8_t channel = 0; channel < kMIDICoreChannels; channel++) {
+			if (!(channels & (1u << channel))) continue;
+			uint32_t l = (route->inPort - 1) * kMIDICoreChannels + channel;
+			uint8_t outChannel = (route->outChannel == kMIDICoreAnyChannel) ? channel : route->outChannel - 1;
+			int32_t velocityTable = velocityTableFor(table, maps, nMaps, route->inPort, channel, route->outPort, outChannel);
+			if (velocityTable < 0) {
+				clear(table);
+				return false;
+			}
+			bool isDelayed = route->delay_ns > 0;
+			MIDICoreProcess process = { route->outPort, outChannel, (uint16_t) velocityTable, isDelayed ? route->delay_ns : 0 };
+			uint16_t at = next[l][isDelayed]++;
+			// delayed soonest first
+			for (; isDelayed && at > table->delayed[l] && table->processes[at - 1].delay_ns > process.delay_ns; at--)
+				table->processes[at] = table->processes[at - 1];
+			table->processes[at] = process;
+			if (route->inChannel != kMIDICoreAnyChannel && table->inputPort[channel] == 0)
+				table->inputPort[channel] = route->inPort;
+		}
+	}
+	table->nProcesses = total;
+	return true;
+}
+
+uint32_t MIDICoreTableProcessCount(const MIDICoreTable *table)
+{
+	return table->nProcesses;
+}
+
+uint32_t MIDICoreTableProcesses(const MIDICoreTable *table, uint8_t port, uint8_t channel, bool delayed,
+								const MIDICoreProcess **processes)
+{
+	if (!validPort(port) || channel >= kMIDICoreChannels) return 0;
+	uint32_t l = (port - 1) * kMIDICoreChannels + channel;
+	uint32_t start = delayed ? table->delayed[l] : table->first[l];
+	uint32_t end = delayed ? table->first[l + 1] : table->delayed[l];
+	*processes = &table->processes[start];
+	return end - start;
+}
+
+uint8_t MIDICoreTableVelocity(const MIDICoreTable *table, uint16_t velocityTable, uint8_t velocity)
+{
+	return table->velocityTables[velocityTable][velocity & 0x7F];
+}
+
+uint8_t MIDICoreTableInputPort(const MIDICoreTable *table, uint8_t channel)
+{
+	return (channel < kMIDICoreChannels) ? table->inputPort[channel] : 0;
+}
+
+// MIDI channels a route delivers, on its own channel or not
+static uint16_t deliveredChannels(const MIDICoreRoute *route)
+{
+	return (route->outChannel == kMIDICoreAnyChannel) ? channelMask(route->inChannel) : channelMask(route->outChannel);
+}
+
+uint32_t MIDICoreSplit(const MIDICoreRoute *routes, uint32_t nRoutes, const MIDICoreVelocityMap *maps, uint32_t nMaps,
+					   uint8_t computerPort, uint8_t egressPort, bool *routeInSoftware, bool *mapInSoftware,
+					   MIDICoreRoute *egress, uint32_t maxEgress)
+{
+	uint16_t heard[kMIDICorePorts + 1];			// channels of each input the computer hears as they came in
+	uint16_t egressTo[kMIDICoreChannels];		// out ports what goes into egressPort on a channel reaches
+	uint16_t egressRemapped = 0;				// channels it changes on the way
+	uint8_t channelPort[kMIDICoreChannels];		// input port the software routes on a channel came from
+	uint32_t nEgress = 0;
+	memset(heard, 0, sizeof(heard));
+	memset(egressTo, 0, sizeof(egressTo));
+	memset(channelPort, 0, sizeof(channelPort));
+
+	for (uint32_t i = 0; i < nRoutes; i++) {
+		const MIDICoreRoute *route = &routes[i];
+		routeInSoftware[i] = false;
+		if (!validPort(route->inPort) || !validPort(route->outPort) || !validChannel(route->inChannel) || !validChannel(route->outChannel))
+			continue;
+		if (route->outPort == computerPort && route->outChannel == kMIDICoreAnyChannel && route->delay_ns == 0)
+			heard[route->inPort] |= channelMask(route->inChannel);
+		if (route->inPort == egressPort) {
+			uint16_t channels = channelMask(route->inChannel);
+			for (uint8_t channel = 0; channel < kMIDICoreChannels; channel++)
+				if (channels & (1u << channel)) egressTo[channel] |= (uint16_t)(1u << (route->outPort - 1));
+			if (route->outChannel != kMIDICoreAnyChannel) egressRemapped |= channels;
+		}
+	}
+
+	for (uint32_t i = 0; i < nRoutes; i++) {
+		const MIDICoreRoute *route = &routes[i];
+		if (!validPort(route->inPort) || !validPort(route->outPort) || !validChannel(route->outChannel)
+			|| route->inChannel == kMIDICoreAnyChannel || !validChannel(route->inChannel))
+			continue;
+		if (route->inPort == computerPort || route->inPort == egressPort || route->outPort == computerPort)
+			continue;
+		uint8_t channel = route->inChannel - 1;
+		if (!(heard[route->inPort] & (1u << channel))) continue;
+		if (channelPort[channel] != 0 && channelPort[channel] != route->inPort) continue;
+		uint8_t outChannel = (route->outChannel == kMIDICoreAnyChannel) ? channel : route->outChannel - 1;
+		uint16_t outPortBit = (uint16_t)(1u << (route->outPort - 1));
+		if (egressRemapped & (1u << outChannel)) continue;
+		if (egressTo[outChannel] == 0) {
+			if (nEgress == maxEgress) continue;
+			egress[nEgress++] = (MIDICoreRoute) { egressPort, outChannel + 1, route->outPort, outChannel + 1, 0 };
+			egressTo[outChannel] = outPortBit;
+		} else if (egressTo[outChannel] != outPortBit) {
+			continue;
+		}
+		channelPort[channel] = route->inPort;
+		routeInSoftware[i] = true;
+	}
+
+	// an output map goes with the software routes if none of the MIOC's reach it (egress passes it untouched)
+	for (uint32_t m = 0; m < nMaps; m++) {
+		const MIDICoreVelocityMap *map = &maps[m];
+		mapInSoftware[m] = !map->onInput && validPort(map->port) && validChannel(map->channel);
+		for (uint32_t i = 0; mapInSoftware[m] && i < nRoutes; i++) {
+			const MIDICoreRoute *route = &routes[i];
+			if (!routeInSoftware[i] && route->outPort == map->port && (deliveredChannels(route) & channelMask(map->channel)))
+				mapInSoftware[m] = false;
+		}
+	}
+	return nEgress;
+}
@@ -0,0 +1,100 @@
+//
+//  MIDICoreTable.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// The software matrix's compiled form (MIDICore.h): for each input port and channel, the list of routes its
+//	messages take, immediate ones first and delayed ones after (by delay), so everything immediate can go out
+//	before anything delayed is worked out.
+//	- compiled off the realtime thread from routes and velocity maps, as MIOCConnection and
+//	  MIOCVelocityProcessor describe them; routing a message is then a lookup and a walk of one list, with
+//	  nothing allocated
+//	- omni inputs and same-as-input outputs are resolved per channel as it compiles
+//	- each route's velocity processing (input maps of its input, then output maps of its output, each in
+//	  position order) is folded into one 128-entry table (MIOCVelocityMap.h); note-on velocity only
+//	Ports and channels are 1-based, as MIOCConnection, except where a MIDI channel (0-based) is asked for.
+//
+// MIDICoreSplit decides what the software matrix can carry when the MIOC is still the patchbay: the computer
+//	hears its inputs merged on one port, and what it sends for others goes into the egress port, to be routed
+//	on by channel.
+//
+// Plain C: also built into Tools/rnmiocsim, to check hardware and software routing agree.
+
+#ifndef MIDICoreTable_h
+#define MIDICoreTable_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kMIDICorePorts				8
+#define kMIDICoreChannels			16
+#define kMIDICoreAnyChannel			0x80	// input: all channels; output: same as input (MIOCMessage.h)
+#define kMIDICoreMaxProcesses		2048	// routes, with omni inputs expanded
+#define kMIDICoreMaxVelocityTables	256		// distinct, the unchanged one included
+
+typedef struct {
+	uint8_t		inPort;
+	uint8_t		inChannel;		// or kMIDICoreAnyChannel
+	uint8_t		outPort;
+	uint8_t		outChannel;		// or kMIDICoreAnyChannel
+	int64_t		delay_ns;		// 0: immediate
+} MIDICoreRoute;
+
+typedef struct {
+	uint8_t		port;
+	uint8_t		channel;		// or kMIDICoreAnyChannel
+	bool		onInput;
+	uint8_t		position;		// 0..7, applied in ascending order
+	uint8_t		threshold;
+	int8_t		gradientBelow;	// eighths
+	int8_t		gradientAbove;
+	int8_t		offset;
+} MIDICoreVelocityMap;
+
+// one route of an input's list
+typedef struct {
+	uint8_t		outPort;
+	uint8_t		outChannel;		// MIDI channel, resolved
+	uint16_t	velocityTable;	// 0: velocity unchanged
+	int64_t		delay_ns;
+} MIDICoreProcess;
+
+typedef struct MIDICoreTable MIDICoreTable;
+
+MIDICoreTable	*MIDICoreTableCreate(void);
+void			MIDICoreTableDestroy(MIDICoreTable *table);
+
+// replaces what the table held; false (and the table left empty) if there is too much of it
+bool			MIDICoreTableCompile(MIDICoreTable *table, const MIDICoreRoute *routes, uint32_t nRoutes,
+									 const MIDICoreVelocityMap *maps, uint32_t nMaps);
+uint32_t		MIDICoreTableProcessCount(const MIDICoreTable *table);
+
+// the routes of one input and MIDI channel, immediate or delayed; returns how many
+uint32_t		MIDICoreTableProcesses(const MIDICoreTable *table, uint8_t port, uint8_t channel, bool delayed,
+									   const MIDICoreProcess **processes);
+uint8_t			MIDICoreTableVelocity(const MIDICoreTable *table, uint16_t velocityTable, uint8_t velocity);
+// the input port routes on this MIDI channel come from (the first compiled, if several), 0 if none
+uint8_t			MIDICoreTableInputPort(const MIDICoreTable *table, uint8_t channel);
+
+// The routes (and maps) the software matrix can take while the MIOC carries inputs to computerPort and output
+//	from egressPort on to where it's going, with the rest left to the MIOC. A route can go if the computer hears
+//	its input on its own channel (a route to computerPort brings it) and no other input port's routes use that
+//	channel, and if what leaves egressPort on its output channel goes to its output port alone; egress gets
+//	the routes from egressPort that make that so, beyond those asked for. Input maps stay with the MIOC (what
+//	the computer hears has been through them, as hardware routes would be); an output map goes to software
+//	only if nothing left with the MIOC leaves its port and channel. Returns the number of egress routes.
+uint32_t		MIDICoreSplit(const MIDICoreRoute *routes, uint32_t nRoutes, const MIDICoreVelocityMap *maps, uint32_t nMaps,
+							  uint8_t computerPort, uint8_t egressPort, bool *routeInSoftware, bool *mapInSoftware,
+							  MIDICoreRoute *egress, uint32_t maxEgress);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIDICoreTable_h */
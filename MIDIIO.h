@@ -10,6 +10,11 @@
 //#import "TimingUtils.h"
 #import "MIDIListenerProtocols.h"
 #import "RNMIDIRouting.h"
+#import "RNEventRecorder.h"
+#import "RNVirtualTappers.h"
+#import "RNPacketCapture.h"
+#import "RNStimulusStream.h"
+#import "MIDICoreTable.h"
 
 #define kSendMIDISuccess		TRUE
 #define kSendMIDIFailure		FALSE
@@ -27,8 +32,38 @@ typedef struct _NoteOnMessage {
 	Byte		note;
 	Byte		velocity;
 	Byte		spare;		// seems good to keep it multiple of 4 bytes--only matters if I'm going to pack them into a buffer
+	UInt32	tapID;		// sequence number of this note-on since MIDIIO started; referenced by the events it causes
 } NoteOnMessage;
 
+// an event we sent out (or the MIOC sent on our behalf) in response to a tap
+typedef struct _EmittedEventMessage {
+	UInt64	scheduledTime_ns;	// when it is due to sound
+	UInt64	sendTime_ns;		// when it was handed to CoreMIDI (MIOC routes: arrival of the tap)
+	UInt32	sourceTapID;		// NoteOnMessage.tapID of the tap that caused it
+	Byte		sourceChannel;		// 0-based MIDI channel of the tap
+	Byte		targetChannel;		// 0-based MIDI channel it was sent on (= target tapper)
+	Byte		note;
+	Byte		velocity;
+	Byte		isMIOCRoute;		// routed inside the MIOC: inferred from the routing table, not sent by us
+	Byte		spare[7];
+} EmittedEventMessage;
+
+#define kDelayPacketListLength 8192 //big enough for ~500 events
+#define kMaxEmittedEventsPerPass 1024	// per wake of the processing thread; further events are counted as dropped
+
+// delay routing under a synthetic load (RNRoutingLoad.h)
+typedef struct _DelayRoutingBenchmark {
+	UInt64	nLists;
+	UInt64	nPackets;
+	UInt64	nDelayNoteOns;		// put in delay packet lists (each with its note-off, if on)
+	double	routing_s;			// spent in emitDelayedNotes:, routing stage alone
+	double	noteOnsPerSecond;	// of routing time
+	double	nsPerNoteOn;
+	UInt32	maxDelayListBytes;	// largest delay packet list, alone and end to end
+	UInt32	nOverflows;			// events that didn't fit in it
+	RNPacketReplayResult replay;	// end to end, if run
+} DelayRoutingBenchmark;
+
 typedef struct _ProgramChangeMessage {
 	UInt64	eventTime_ns;
 	Byte		channel;
@@ -60,6 +95,29 @@ typedef struct _ProgramChangeMessage {
 	Byte                                   _offMessage[3];
 	MIDIPacket                             _delayPacket;
 	MIDIPacketList                        *_delayPacketList;
+	UInt32                                 _nextTapID;
+	NSMutableArray<id<EmittedEventReceiver>> *_emittedListenerArray;
+	EmittedEventMessage                   *_emittedEvents;  // preallocated log of events emitted during one pass
+	UInt32                                 _numEmittedEvents;
+	UInt32                                 _numEmittedEventsDropped;
+	_Atomic(RNEventRecorder *)             _eventRecorder;  // taps and emitted events are pushed here from the processing thread
+	RNEvent                               *_recorderEvents; // preallocated batch for pushing emitted events
+	MIDIEndpointRef                        _virtualSource;  // our own source, connected to _inPort: virtual taps enter here
+	_Atomic(RNVirtualTappers *)            _virtualTappers; // hear the feedback emitted, pushed from the processing thread
+	_Atomic(RNPacketCapture *)             _packetCapture;  // raw input (read proc) and delay output (processing thread) are copied here
+	_Atomic(UInt32)                        _numEnqueuedLists;  // packet lists into the ring since MIDIIO started (read proc or replay)
+	UInt32                                 _numProcessedLists; // and out of it (processing thread): captures pair outputs with inputs by these
+	atomic_int                             _ringProducer;   // who writes the ring: the read proc, one list at a time, or a replay throughout (live input dropped)
+	_Atomic(UInt64)                        _numPasses;      // processing passes completed: clearing a capture, recorder or tappers waits out the one under way
+	atomic_uint                            _numAttachmentUsers; // other MIDI threads' calls using a capture, recorder or tappers right now
+	BOOL                                   _emitsNoteOff;   // kDoEmitNoteOff, unless benchmarking (set only while the ring is drained)
+	BOOL                                   _delaySendDisabled; // benchmark: delay packet lists are built but not sent (as above)
+	UInt32                                 _maxDelayListBytes; // high-water mark of _delayPacketList (processing thread)
+	UInt32                                 _numDelayOverflows; // delay events that didn't fit in it
+	_Atomic(RNStimulusScheduler *)         _stimulusScheduler; // stimuli, sent a lookahead ahead from its own thread (created on first use); hears taps
+	RNEvent                               *_stimulusEvents;    // preallocated batch for recording them (scheduler thread)
+	_Atomic(MIDICoreTable *)               _coreTable;       // software matrix (MIDICore.h): routes the MIOC would make, sent through _delayMIDIIO
+	MIDIPacketList                        *_corePacketList;  // preallocated output of one pass of it
 }
 
 - (MIDIIO*)init;
@@ -68,6 +126,23 @@ typedef struct _ProgramChangeMessage {
 - (void)startMIDIProcessingThread;
 - (void)setupMIDI;
 - (void)setMIDIRoutingTable:(RNRealtimeRoutingTable *)routingTable;
+- (void)setMIDICoreTable:(MIDICoreTable *)table; // NULL: the MIOC does all the routing
+- (BOOL)hasDelayOutput; // a second interface port, for delay and software matrix output
+- (void)setEventRecorder:(RNEventRecorder *)recorder; // as for captures, below
+- (void)setVirtualTappers:(RNVirtualTappers *)tappers; // likewise
+- (RNVirtualTapProc)virtualTapProc; // refCon: this MIDIIO
+- (void)setPacketCapture:(RNPacketCapture *)capture; // returns once no MIDI thread holds the one it replaces
+- (BOOL)replayPacketCapture:(const RNPacketCaptureReader *)reader realTime:(BOOL)realTime result:(RNPacketReplayResult *)result;
+- (BOOL)benchmarkDelayRoutingOfCapture:(const RNPacketCaptureReader *)reader routingTable:(RNRealtimeRoutingTable *)table
+							   noteOff:(BOOL)noteOff endToEndCapture:(RNPacketCapture *)capture result:(DelayRoutingBenchmark *)result;
+
+- (RNStimulusScheduler *)startStimulusScheduler; // NULL if it can't run
+- (RNStimulusStreamID)startStimulusStream:(const RNStimulusStreamDefinition *)definition;
+- (void)cancelStimulusStream:(RNStimulusStreamID)stream;
+- (void)cancelAllStimulusStreams;
+- (BOOL)setIOI:(double)IOI_ms ofStimulusStream:(RNStimulusStreamID)stream generator:(RNOnsetGenerator *)generator;
+- (RNStimulusSchedulerCounts)stimulusCounts;
+- (RNStimulusScheduler *)stimulusScheduler; // NULL until a stimulus has played
 
 - (MIDIReadProc)defaultReadProc;
 - (void)setDefaultReadProc;
@@ -92,13 +167,21 @@ typedef struct _ProgramChangeMessage {
 
 - (void)handleMIDISetupChange; // change in MIDI system configuration
 
-- (void)emitDelayedNotes:(const MIDIPacketList*)pktlist availableBytes:(uint32_t)availableBytes;
-- (void)handleMIDIPktlist:(const MIDIPacketList *)pktlist availableBytes:(uint32_t)availableBytes;
+// the stages of a processing pass, each parsing the same lists from the sysex state the pass started in
+- (void)emitCoreRoutes:(const MIDIPacketList *)pktlist availableBytes:(uint32_t)availableBytes delayed:(BOOL)delayed
+		receivingSysex:(BOOL)isReceivingSysex;
+- (void)emitDelayedNotes:(const MIDIPacketList*)pktlist availableBytes:(uint32_t)availableBytes
+		  receivingSysex:(BOOL)isReceivingSysex;
+- (void)handleMIDIPktlist:(const MIDIPacketList *)pktlist availableBytes:(uint32_t)availableBytes
+		   receivingSysex:(BOOL)isReceivingSysex; // the last: leaves _isReceivingSysex as the lists end it
+- (void)dispatchEmittedEvents;
 
 - (void)registerSysexListener:(id<SysexDataReceiver>)object;
 - (void)removeSysexListener:  (id<SysexDataReceiver>)object;
 - (void)registerMIDIListener: (id<MIDIDataReceiver>)object;
 - (void)removeMIDIListener:   (id<MIDIDataReceiver>)object;
+- (void)registerEmittedEventListener:(id<EmittedEventReceiver>)object;
+- (void)removeEmittedEventListener:  (id<EmittedEventReceiver>)object;
 
 - (BOOL)sendMIDI:(NSData *)data;
 - (BOOL)sendMIDIPacketList:(NSData *)wrappedPacketList;
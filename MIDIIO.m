@@ -4,16 +4,21 @@
 #import <CoreAudio/HostTime.h>
 #include <assert.h>
 #include <os/log.h>
+#include <sched.h>
+#include <unistd.h>
 #import "NSStringHexStringCategory.h"
 #import "RNArchitectureDefines.h"
 #import "RTAssert.h"
 
-#define kDelayPacketListLength 8192 //big enough for ~500 events
+#define kVirtualTapPacketListLength 1024 //one note-on per agent
+#define kStimulusPacketListLength (4 + kRNStimulusBatchLength * 2 * 16) //a batch of onsets, each with its note-off
 
 #define NS_PER_MS 1000000ull
 #define MS_TO_HOSTTIME(ms) AudioConvertNanosToHostTime((ms) * NS_PER_MS)
 #define HOSTTIME_TO_MS(hosttime) (AudioConvertHostTimeToNanos((hosttime)) / NS_PER_MS)
 
+// the ring buffer's producer, claimed by the read proc for each list and by a replay for its whole run
+enum { kRingFree = 0, kRingLive, kRingReplay };
 
 // wrapper for simple midi io
 
@@ -21,6 +26,13 @@
 static void myReadProc(const MIDIPacketList *pktlist, void *refCon, void *connRefCon);
 static void mySysexCompletionProc(MIDISysexSendRequest *request);
 static void myMIDINotifyProc(const MIDINotification *message, void * refCon);
+static void virtualTapProc(const RNVirtualTap *taps, uint32_t nTaps, void *refCon);
+static bool replayPacketList(const void *packetList, uint32_t length, void *refCon);
+static void claimRingForReplay(MIDIIO *io);
+static void waitForRingToDrain(MIDIIO *io);
+static void waitForThreadsToLetGo(MIDIIO *io);
+static void stimulusSendProc(const RNStimulusStreamDefinition *definition, const RNStimulusOnset *onsets, uint32_t nOnsets,
+							 int64_t now_ns, void *refCon);
 
 #pragma mark CoreMIDI Error Handling
 // Error Handling (CGPT)
@@ -76,7 +88,23 @@ static NSString *CMIDIErrorDescription(OSStatus status) {
 	_MIDIDest           = kMIDIInvalidRef;
 	_sysexListenerArray = [[NSMutableArray arrayWithCapacity:0] retain];
 	_MIDIListenerArray  = [[NSMutableArray arrayWithCapacity:0] retain];
-
+	_emittedListenerArray = [[NSMutableArray arrayWithCapacity:0] retain];
+
+	// pre-allocate log of emitted events, so the processing thread never allocates per event
+	_emittedEvents = malloc(kMaxEmittedEventsPerPass * sizeof(EmittedEventMessage));
+	_numEmittedEvents = 0;
+	_numEmittedEventsDropped = 0;
+	_nextTapID = 0;
+	_recorderEvents = malloc(kMaxEmittedEventsPerPass * sizeof(RNEvent));
+	atomic_init(&_eventRecorder, NULL);
+	atomic_init(&_virtualTappers, NULL);
+	atomic_init(&_coreTable, NULL);
+	atomic_init(&_numEnqueuedLists, 0);
+	atomic_init(&_ringProducer, kRingFree);
+	atomic_init(&_numPasses, 0);
+	atomic_init(&_numAttachmentUsers, 0);
+	_virtualSource = kMIDIInvalidRef;
+	_emitsNoteOff = kDoEmitNoteOff;
 
 	_sysexData        = [[NSMutableData alloc] initWithCapacity:16 * 1024];
 	_isReceivingSysex = NO;
@@ -85,8 +113,9 @@ static NSString *CMIDIErrorDescription(OSStatus status) {
 	if (MIDIGetNumberOfDestinations() >= 2) {
 		_delayMIDIIO = [[MIDIIO alloc] initFollower];
 
-		// pre-allocate MIDIPacketList
+		// pre-allocate MIDIPacketLists
 		_delayPacketList = malloc(kDelayPacketListLength);
+		_corePacketList = malloc(kDelayPacketListLength);
 	} else {
 		NSLog(@"Warning: Only one MIDI output available. Delayed output functionality will be disabled.");
 		_delayMIDIIO = nil;
@@ -119,12 +148,39 @@ static NSString *CMIDIErrorDescription(OSStatus status) {
 	return self;
 }
 
+// *********************************************
+// a MIDIIO with no ports or thread, only delay routing state of its own: emitDelayedNotes: builds lists for the
+//	given output but doesn't send them, on whatever thread calls it
+- (MIDIIO *)initDelayRouterWithOutput:(MIDIIO *)delayMIDIIO routingTable:(RNRealtimeRoutingTable *)table noteOff:(BOOL)noteOff
+{
+	self = [self initFollower];
+	if (!self) return nil;
+	
+	_delayMIDIIO		= [delayMIDIIO retain];
+	_delayPacketList	= malloc(kDelayPacketListLength);
+	_emittedEvents		= malloc(kMaxEmittedEventsPerPass * sizeof(EmittedEventMessage));
+	atomic_init(&_routingTable, table);
+	_emitsNoteOff		= noteOff;
+	_delaySendDisabled	= YES;
+	
+	return self;
+}
+
 // *********************************************
 - (void)dealloc
 {
+	RNStimulusSchedulerDestroy(atomic_load(&_stimulusScheduler)); // first: its thread sends through our ports
+	free(_stimulusEvents);
+	if (_virtualSource != kMIDIInvalidRef)
+		MIDIEndpointDispose(_virtualSource);
 	MIDIClientDispose(_MIDIClient);	// automatically disposes of ports
 	[_sysexListenerArray release];
 	[_MIDIListenerArray  release];
+	[_emittedListenerArray release];
+	free(_emittedEvents);
+	free(_recorderEvents);
+	free(_delayPacketList);
+	free(_corePacketList);
 	[_sysexData release];
 	[_delayMIDIIO release];
 	[super dealloc];
@@ -153,6 +209,16 @@ static NSString *CMIDIErrorDescription(OSStatus status) {
 	status = MIDIOutputPortCreate(_MIDIClient, CFSTR("MIDIIO Output Port"), &_outPort);
 	CHECK_OSSTATUS_OR_BAIL(status, "MIDIOutputPortCreate");
 	
+	// our own source for virtual tappers, always connected: their taps arrive through myReadProc like any other
+	if (_isLeader) {
+		status = MIDISourceCreate(_MIDIClient, CFSTR("RhythmNetwork Virtual Tappers"), &_virtualSource);
+		CHECK_OSSTATUS(status, "MIDISourceCreate");
+		if (status == noErr) {
+			status = MIDIPortConnectSource(_inPort, _virtualSource, NULL);
+			CHECK_OSSTATUS(status, "MIDIPortConnectSource virtual tappers");
+		}
+	}
+	
 	// setup a secondary (follower) transmit-only client on the next port from the leader client.
 	// this totally requires that the MIDI interface has at least two ports, which we checked in init
 	if (_isLeader && _delayMIDIIO) {
@@ -196,6 +262,186 @@ bail:
 	atomic_store_explicit(&_routingTable, routingTable, memory_order_release);
 }
 
+// add event recorder. default null value means 'not recording'
+//	returns once the MIDI threads are done with the one it replaces, which the caller may then destroy
+- (void)setEventRecorder:(RNEventRecorder *)recorder {
+	RNEventRecorder *previous = atomic_exchange(&_eventRecorder, recorder);
+	if (previous != NULL)
+		waitForThreadsToLetGo(self);
+}
+
+// add virtual tappers: they hear the feedback we emit. default null value means 'none'
+//	as for the recorder, returns once the MIDI threads are done with the ones it replaces
+- (void)setVirtualTappers:(RNVirtualTappers *)tappers {
+	RNVirtualTappers *previous = atomic_exchange(&_virtualTappers, tappers);
+	if (previous != NULL)
+		waitForThreadsToLetGo(self);
+}
+
+- (RNVirtualTapProc)virtualTapProc
+{
+	return virtualTapProc;
+}
+
+// add packet capture: input and delay output are copied to it. default null value means 'not capturing'
+//	returns once the MIDI threads are done with the one it replaces, which the caller may then close
+- (void)setPacketCapture:(RNPacketCapture *)capture {
+	RNPacketCapture *previous = atomic_exchange(&_packetCapture, capture);
+	if (previous != NULL)
+		waitForThreadsToLetGo(self);
+}
+
+// *********************************************
+//    Stimuli
+// *********************************************
+#pragma mark Stimuli
+
+// the stimulus scheduler, started on first use; streams may then be started on it from other threads (e.g. the
+//	experiment's part scheduler) [main thread]
+- (RNStimulusScheduler *)startStimulusScheduler
+{
+	RNStimulusScheduler *scheduler = atomic_load_explicit(&_stimulusScheduler, memory_order_relaxed);
+	if (scheduler == NULL) {
+		_stimulusEvents = malloc(kRNStimulusBatchLength * (kMaxNodes + 1) * sizeof(RNEvent));
+		scheduler = RNStimulusSchedulerCreate(kRNStimulusLookahead_ns, stimulusSendProc, self);
+		if (scheduler == NULL) {
+			NSLog(@"Could not start the stimulus scheduler.");
+			return NULL;
+		}
+		atomic_store_explicit(&_stimulusScheduler, scheduler, memory_order_release); // the processing thread pushes taps to it
+	}
+	return scheduler;
+}
+
+// start playing a stimulus: its onsets are sent a lookahead ahead of time, and recorded as they are sent, for each
+//	of its listeners, to the event recorder and virtual tappers set at the time. kRNStimulusInvalidStream if it can't
+//	play (all streams busy, or no scheduler) [main thread]
+- (RNStimulusStreamID)startStimulusStream:(const RNStimulusStreamDefinition *)definition
+{
+	RNStimulusScheduler *scheduler = [self startStimulusScheduler];
+	return (scheduler != NULL) ? RNStimulusSchedulerStart(scheduler, definition) : kRNStimulusInvalidStream;
+}
+
+// onsets not yet sent are dropped: a stream falls silent within the lookahead. Already sent ones need flushOutput
+- (void)cancelStimulusStream:(RNStimulusStreamID)stream
+{
+	RNStimulusScheduler *scheduler = [self stimulusScheduler];
+	if (scheduler != NULL)
+		RNStimulusSchedulerCancel(scheduler, stream);
+}
+
+- (void)cancelAllStimulusStreams
+{
+	RNStimulusScheduler *scheduler = [self stimulusScheduler];
+	if (scheduler != NULL)
+		RNStimulusSchedulerCancelAll(scheduler);
+}
+
+// tempo change from the next onset not yet sent; generator (optional) gets the stream's onsets as they now stand
+- (BOOL)setIOI:(double)IOI_ms ofStimulusStream:(RNStimulusStreamID)stream generator:(RNOnsetGenerator *)generator
+{
+	RNStimulusScheduler *scheduler = [self stimulusScheduler];
+	if (scheduler == NULL)
+		return NO;
+	return RNStimulusSchedulerSetIOI(scheduler, stream, llround(IOI_ms * NS_PER_MS), generator);
+}
+
+- (RNStimulusSchedulerCounts)stimulusCounts
+{
+	RNStimulusSchedulerCounts counts = { 0 };
+	RNStimulusScheduler *scheduler = [self stimulusScheduler];
+	if (scheduler != NULL)
+		counts = RNStimulusSchedulerGetCounts(scheduler);
+	return counts;
+}
+
+// adaptive stimuli log their decisions here: one consumer may read them (RNStimulusSchedulerReadDecisions)
+- (RNStimulusScheduler *)stimulusScheduler
+{
+	return atomic_load_explicit(&_stimulusScheduler, memory_order_acquire);
+}
+
+// feed a capture's input through the ring as if it were arriving now: same consumer, delay output and listeners.
+//	Live input is dropped meanwhile. Blocks until all of it is processed [any thread but the processing thread]
+- (BOOL)replayPacketCapture:(const RNPacketCaptureReader *)reader realTime:(BOOL)realTime result:(RNPacketReplayResult *)result
+{
+	if (!atomic_load(&_MIDIConsumerReady)) {
+		return NO;
+	}
+	claimRingForReplay(self);
+	BOOL ok = RNPacketCaptureReplay(reader, realTime, replayPacketList, self, result);
+	waitForRingToDrain(self);
+	atomic_store_explicit(&_ringProducer, kRingFree, memory_order_release);
+	return ok;
+}
+
+// delay routing under load: each input list of the capture through emitDelayedNotes: of a private router (routing
+//	stage alone, timed, on this thread, with its own buffers), then, given a capture to record into, replayed in real
+//	time through the ring and processing thread (end to end). Routes by the given table with the given note-off
+//	setting and sends nothing. End to end, live input is dropped and the settings are swapped only while the ring is
+//	drained, so the processing thread is idle; all restored after. Listeners and any recorder see the replay [any
+//	thread but the processing thread]
+- (BOOL)benchmarkDelayRoutingOfCapture:(const RNPacketCaptureReader *)reader routingTable:(RNRealtimeRoutingTable *)table
+							   noteOff:(BOOL)noteOff endToEndCapture:(RNPacketCapture *)capture result:(DelayRoutingBenchmark *)result
+{
+	if (!atomic_load(&_MIDIConsumerReady) || _delayMIDIIO == nil || table == NULL) {
+		return NO;
+	}
+	memset(result, 0, sizeof(DelayRoutingBenchmark));
+	
+	MIDIIO *router = [[MIDIIO alloc] initDelayRouterWithOutput:_delayMIDIIO routingTable:table noteOff:noteOff];
+	UInt64 routingTicks = 0;
+	size_t cursor = 0;
+	const uint8_t *list;
+	const RNPacketCaptureRecord *record;
+	while ((record = RNPacketCaptureNext(reader, &cursor, &list)) != NULL) {
+		if (record->kind != kRNPacketCaptureInput) continue;
+		UInt64 t0 = AudioGetCurrentHostTime();
+		//sysex bytes are below 0x80, never taken for note-ons, so each list can start outside one
+		[router emitDelayedNotes:(const MIDIPacketList *)list availableBytes:record->length receivingSysex:NO];
+		routingTicks += AudioGetCurrentHostTime() - t0;
+		result->nLists++;
+		result->nPackets += ((const MIDIPacketList *)list)->numPackets;
+		result->nDelayNoteOns += router->_numEmittedEvents;
+		router->_numEmittedEvents = 0;
+		router->_numEmittedEventsDropped = 0;
+	}
+	result->routing_s = AudioConvertHostTimeToNanos(routingTicks) * 1e-9;
+	if (result->nDelayNoteOns > 0 && routingTicks > 0) {
+		result->noteOnsPerSecond = result->nDelayNoteOns / result->routing_s;
+		result->nsPerNoteOn = result->routing_s * 1e9 / result->nDelayNoteOns;
+	}
+	result->maxDelayListBytes = router->_maxDelayListBytes;
+	result->nOverflows = router->_numDelayOverflows;
+	[router release];
+	
+	if (capture != NULL) {
+		claimRingForReplay(self);
+		waitForRingToDrain(self);
+		RNRealtimeRoutingTable *savedTable = atomic_load_explicit(&_routingTable, memory_order_acquire);
+		UInt32 savedMaxDelayListBytes = _maxDelayListBytes;
+		UInt32 numDelayOverflows = _numDelayOverflows;
+		[self setMIDIRoutingTable:table];
+		_delaySendDisabled = YES;
+		_emitsNoteOff = noteOff;
+		_maxDelayListBytes = 0;
+		[self setPacketCapture:capture];
+		
+		RNPacketCaptureReplay(reader, true, replayPacketList, self, &result->replay);
+		waitForRingToDrain(self); //the last lists through the processing thread
+		
+		[self setPacketCapture:NULL];
+		result->maxDelayListBytes = MAX(result->maxDelayListBytes, _maxDelayListBytes);
+		result->nOverflows += _numDelayOverflows - numDelayOverflows;
+		_maxDelayListBytes = MAX(savedMaxDelayListBytes, _maxDelayListBytes);
+		_emitsNoteOff = kDoEmitNoteOff;
+		_delaySendDisabled = NO;
+		[self setMIDIRoutingTable:savedTable];
+		atomic_store_explicit(&_ringProducer, kRingFree, memory_order_release);
+	}
+	return YES;
+}
+
 // *********************************************
 //    external readProc support
 // *********************************************
@@ -222,6 +468,8 @@ bail:
 	_inPort = kMIDIInvalidRef;
 	
 	status = MIDIInputPortCreate(_MIDIClient, CFSTR("MIDIIO Input Port"), newReadProc, (void*)refCon, &_inPort);
+	if (status == noErr && _virtualSource != kMIDIInvalidRef)
+		MIDIPortConnectSource(_inPort, _virtualSource, NULL);
 }
 
 // *********************************************
@@ -254,6 +502,7 @@ bail:
 
 	for (i = 0; i < n; i++) {
 		MIDIEndpointRef src = MIDIGetSource(i);
+		if (src == _virtualSource) continue; // always connected, never chosen
 		MIDIObjectGetStringProperty(src, kMIDIPropertyName, &name);
 		[uniqueName setString:(NSString *)name];
 
@@ -315,6 +564,7 @@ return [NSArray arrayWithArray:list];	// returns immutable version
 
 	for (i = 0; i < n; i++) {
 		MIDIEndpointRef src = MIDIGetSource(i);
+		if (src == _virtualSource) continue;
 		MIDIObjectGetStringProperty(src, kMIDIPropertyName, &name);
 		
 		if ([sourceName isEqualToString:(NSString *)name]) {
@@ -568,6 +818,72 @@ static void myMIDINotifyProc(const MIDINotification *message, void *refCon)
 // *********************************************
 #pragma mark RECEIVING
 
+// waits out a list the read proc is enqueuing (or another replay); from here live input is dropped
+static void claimRingForReplay(MIDIIO *io)
+{
+	int expected = kRingFree;
+	while (!atomic_compare_exchange_weak_explicit(&io->_ringProducer, &expected, kRingReplay,
+												  memory_order_acquire, memory_order_relaxed)) {
+		expected = kRingFree;
+		sched_yield();
+	}
+}
+
+// a capture, recorder or tappers swapped out are used by a MIDI thread only while that thread's call is under way:
+//	the read proc's (or a replay's) enqueue and the stimulus thread's sends count themselves in _numAttachmentUsers,
+//	and the processing thread's pass ends by counting itself in _numPasses. Waits out both; an idle processing thread
+//	is woken for an empty pass. Their counts and loads and our swap are all sequentially consistent, so whatever
+//	starts after the swap sees the new pointer [any thread but the MIDI threads]
+static void waitForThreadsToLetGo(MIDIIO *io)
+{
+	while (atomic_load(&io->_numAttachmentUsers) > 0) {
+		sched_yield();
+	}
+	if (!atomic_load(&io->_MIDIConsumerReady)) {
+		return; // no processing thread
+	}
+	UInt64 pass = atomic_load(&io->_numPasses);
+	dispatch_semaphore_signal(io->_dataAvailableSemaphore);
+	while (atomic_load(&io->_numPasses) == pass) {
+		usleep(100);
+	}
+}
+
+// the processing thread is idle once it has consumed all of the ring. Only the ring's producer can wait for that, as
+//	nothing else is enqueued meanwhile
+static void waitForRingToDrain(MIDIIO *io)
+{
+	uint32_t space;
+	for (TPCircularBufferHead(&io->_packetBuffer, &space); space < io->_packetBuffer.length; TPCircularBufferHead(&io->_packetBuffer, &space)) {
+		usleep(1000);
+	}
+}
+
+// copy a packet list to the lockless ring buffer (and any capture) and raise semaphore for processing thread [ring producer:
+//	read proc, or replay]
+static bool enqueuePacketList(MIDIIO *io, const MIDIPacketList *pktlist, uint32_t pktlistLength)
+{
+	UInt64 arrivalHostTime = AudioGetCurrentHostTime();
+	
+	// copy entire packetlist to ring buffer (Use my variant that ensures aligned placement in buffer--consumer must be aware)
+	bool status = AlignedTPCircularBufferProduceBytes(&io->_packetBuffer, pktlist, pktlistLength);
+	if (!status) {
+		return false;
+	}
+	
+	UInt32 listNumber = atomic_fetch_add_explicit(&io->_numEnqueuedLists, 1, memory_order_relaxed);
+	atomic_fetch_add(&io->_numAttachmentUsers, 1);
+	RNPacketCapture *capture = atomic_load(&io->_packetCapture);
+	if (capture != NULL) {
+		RNPacketCaptureAppend(capture, kRNPacketCaptureProducerReadProc, kRNPacketCaptureInput, arrivalHostTime, listNumber, pktlist, pktlistLength);
+	}
+	atomic_fetch_sub_explicit(&io->_numAttachmentUsers, 1, memory_order_release);
+	
+	// signal processing thread that data are available
+	dispatch_semaphore_signal(io->_dataAvailableSemaphore);
+	return true;
+}
+
 // quickly copy packet list to lockless ring buffer and raise semaphore for processing thread
 static void myReadProc(const MIDIPacketList *pktlist, void *refCon, void *connRefCon)
 {
@@ -575,7 +891,12 @@ static void myReadProc(const MIDIPacketList *pktlist, void *refCon, void *connRe
 	MIDIIO *selfMIDIIO = (MIDIIO *)refCon;
 	
 	if (!atomic_load(&selfMIDIIO->_MIDIConsumerReady)) return; // short out if our listening thread is not up yet
-
+	
+	// the ring has one producer at a time: if a replay holds it, live input is dropped
+	int expected = kRingFree;
+	if (!atomic_compare_exchange_strong_explicit(&selfMIDIIO->_ringProducer, &expected, kRingLive,
+												 memory_order_acquire, memory_order_relaxed)) return;
+	
 	// packet list
 	MIDIPacket *packet = (MIDIPacket *)&pktlist->packet[0];
 	
@@ -590,17 +911,95 @@ static void myReadProc(const MIDIPacketList *pktlist, void *refCon, void *connRe
 	//logMIDIPacketList(pktlist, pktlistLength, t0);
 	//return;
 	
-	// copy entire packetlist to ring buffer (Use my variant that ensures aligned placement in buffer--consumer must be aware)
-	bool status = AlignedTPCircularBufferProduceBytes(&selfMIDIIO->_packetBuffer, pktlist, (uint32_t) pktlistLength);
+	bool status = enqueuePacketList(selfMIDIIO, pktlist, (uint32_t) pktlistLength);
+	atomic_store_explicit(&selfMIDIIO->_ringProducer, kRingFree, memory_order_release);
 	
 	RT_SAFE_ASSERT(status, "Buffer overrun in MIDI readProc--consider increasing buffer size.");
+}
+
+// captured input goes back in where it came from, taking the read proc's place; false (retried) if the ring is full
+static bool replayPacketList(const void *packetList, uint32_t length, void *refCon)
+{
+	return enqueuePacketList((MIDIIO *)refCon, (const MIDIPacketList *)packetList, length);
+}
+
+// virtual taps enter as if from an interface, stamped with the time each was meant for, so they mix with real
+//	input from here on [runs on the virtual tappers' thread]
+_Static_assert(kRNVirtualMaxNodes <= kMaxNodes, "virtual taps need one MIDI channel per node");
+
+static void virtualTapProc(const RNVirtualTap *taps, uint32_t nTaps, void *refCon)
+{
+	MIDIIO *selfMIDIIO = (MIDIIO *)refCon;
+	Byte buffer[kVirtualTapPacketListLength];
+	MIDIPacketList *pktlist = (MIDIPacketList *)buffer;
+	MIDIPacket *packet = MIDIPacketListInit(pktlist);
 	
-	if (!status) {
-		return;
+	for (uint32_t i = 0; i < nTaps && packet != NULL; i++) {
+		RNNodeNum_t node = taps[i].node;
+		Byte message[3] = { kNoteOnCommand | (node - 1), noteForNode(node), taps[i].velocity }; // channelForNode; node <= kRNVirtualMaxNodes
+		packet = MIDIPacketListAdd(pktlist, sizeof(buffer), packet, AudioConvertNanosToHostTime((UInt64) taps[i].time_ns), 3, message);
 	}
+	RT_SAFE_ASSERT(packet != NULL, "Virtual tap packet list overflow.");
 	
-	// signal processing thread that data are available
-	dispatch_semaphore_signal(selfMIDIIO->_dataAvailableSemaphore);
+	OSStatus status = MIDIReceived(selfMIDIIO->_virtualSource, pktlist);
+	CHECK_OSSTATUS(status, "MIDIReceived virtual taps");
+}
+
+// a batch of stimulus onsets due within the lookahead: sent, then recorded as heard by each listener (node 0 if
+//	none), with the onset number as sourceID [runs on the stimulus scheduler's thread]
+static void stimulusSendProc(const RNStimulusStreamDefinition *definition, const RNStimulusOnset *onsets, uint32_t nOnsets,
+							 int64_t now_ns, void *refCon)
+{
+	MIDIIO *selfMIDIIO = (MIDIIO *)refCon;
+	Byte buffer[kStimulusPacketListLength];
+	MIDIPacketList *pktlist = (MIDIPacketList *)buffer;
+	MIDIPacket *packet = MIDIPacketListInit(pktlist);
+	Byte onMessage[3]  = { kNoteOnCommand | (definition->channel & 0x0F), definition->note, definition->velocity };
+	Byte offMessage[3] = { onMessage[0], onMessage[1], 0 };
+	
+	for (uint32_t i = 0; i < nOnsets && packet != NULL; i++) {
+		packet = MIDIPacketListAdd(pktlist, sizeof(buffer), packet, AudioConvertNanosToHostTime((UInt64) onsets[i].time_ns), 3, onMessage);
+		if (packet != NULL && definition->noteDuration_ns > 0)
+			packet = MIDIPacketListAdd(pktlist, sizeof(buffer), packet, AudioConvertNanosToHostTime((UInt64) (onsets[i].time_ns + definition->noteDuration_ns)), 3, offMessage);
+	}
+	RT_SAFE_ASSERT(packet != NULL, "Stimulus packet list overflow.");
+	
+	if (selfMIDIIO->_MIDIDest != kMIDIInvalidRef) {
+		OSStatus status = MIDISend(selfMIDIIO->_outPort, selfMIDIIO->_MIDIDest, pktlist);
+		CHECK_OSSTATUS(status, "MIDISend stimulus");
+	}
+	
+	atomic_fetch_add(&selfMIDIIO->_numAttachmentUsers, 1);
+	RNEventRecorder *recorder = atomic_load(&selfMIDIIO->_eventRecorder);
+	RNVirtualTappers *tappers = atomic_load(&selfMIDIIO->_virtualTappers);
+	if (recorder == NULL && tappers == NULL) {
+		atomic_fetch_sub_explicit(&selfMIDIIO->_numAttachmentUsers, 1, memory_order_release);
+		return;
+	}
+	uint32_t listeners = (definition->listeners != 0) ? definition->listeners : 1;
+	uint32_t nEvents = 0;
+	for (uint32_t i = 0; i < nOnsets; i++) {
+		for (RNNodeNum_t node = 0; node <= kMaxNodes; node++) {
+			if (!((listeners >> node) & 1))
+				continue;
+			RNEvent event = {
+				.time_ns	= onsets[i].time_ns,
+				.sendTime_ns = now_ns,
+				.sourceID	= onsets[i].number,
+				.node		= node,
+				.channel	= definition->channel,
+				.note		= definition->note,
+				.velocity	= definition->velocity,
+				.kind		= kRNEventKindStimulus,
+			};
+			selfMIDIIO->_stimulusEvents[nEvents++] = event;
+		}
+	}
+	if (recorder != NULL)
+		RNEventRecorderPush(recorder, kRNEventRecorderProducerStimulus, selfMIDIIO->_stimulusEvents, nEvents);
+	if (tappers != NULL) //they hear it when it sounds
+		RNVirtualTappersPush(tappers, kRNEventRecorderProducerStimulus, selfMIDIIO->_stimulusEvents, nEvents);
+	atomic_fetch_sub_explicit(&selfMIDIIO->_numAttachmentUsers, 1, memory_order_release);
 }
 
 void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MIDITimeStamp t0)
@@ -646,15 +1045,28 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 			
 			os_log(OS_LOG_DEFAULT, "=========================================\nBuffer available bytes: 0x%x", availableBytes);
 			
-			//process packet list for delayed notes
-			[self emitDelayedNotes:(const MIDIPacketList*)packetList availableBytes:availableBytes];
+			//every stage parses these lists from where the last pass left sysex
+			BOOL isReceivingSysex = _isReceivingSysex;
+			
+			//software matrix: everything immediate goes out first
+			[self emitCoreRoutes:(const MIDIPacketList*)packetList availableBytes:availableBytes delayed:NO receivingSysex:isReceivingSysex];
+
+			//process packet list for delayed notes, then the software matrix's delayed routes
+			[self emitDelayedNotes:(const MIDIPacketList*)packetList availableBytes:availableBytes receivingSysex:isReceivingSysex];
+			[self emitCoreRoutes:(const MIDIPacketList*)packetList availableBytes:availableBytes delayed:YES receivingSysex:isReceivingSysex];
 
 			//process packet list for listeners
-			[self handleMIDIPktlist:(const MIDIPacketList*)packetList availableBytes:availableBytes];
+			[self handleMIDIPktlist:(const MIDIPacketList*)packetList availableBytes:availableBytes receivingSysex:isReceivingSysex];
+			
+			//pass on the log of what we (and the MIOC) emitted in response
+			[self dispatchEmittedEvents];
 			
 			//mark bytes as consumed (pad to 4-byte alignment as was done when producing)
 			
 			TPCircularBufferConsume(&_packetBuffer, availableBytes);
+			
+			//done with what this pass loaded: anyone waiting to free it may go ahead
+			atomic_fetch_add(&_numPasses, 1);
 
 		} // while _isRunning
 	});
@@ -664,9 +1076,140 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 // These next two methods are called from the high-priority processing thread. Both walk the packetList(s) & packets with two aims: 1) to output delay packets and 2) to send sysex and note on to listeners, which handle configuration, data saving, and UI
 // Not sure there is any way around walking through entire sysex streams because it may be spread across packets and not sure there is a test for a packet being sysex based on its first byte...In our use, sysex receiving is very rare, never during critical path, and short so it is really not any kind of issue
 
+// *********************************************
+// reserve the next slot in the emitted event log, or NULL (and count it) if this pass has filled it
+static inline EmittedEventMessage *appendEmittedEvent(MIDIIO *io)
+{
+	if (io->_emittedEvents == NULL || io->_numEmittedEvents >= kMaxEmittedEventsPerPass) {
+		io->_numEmittedEventsDropped++;
+		return NULL;
+	}
+	EmittedEventMessage *emitted = &io->_emittedEvents[io->_numEmittedEvents++];
+	memset(emitted, 0, sizeof(EmittedEventMessage));
+	return emitted;
+}
+
+// *********************************************
+// the software matrix: each channel message re-sent on the routes of the port and channel it came from, immediate
+//	ones (timestamp 0: as soon as possible) or delayed ones (from the packet's timestamp), with note-on velocity
+//	through the route's table. Output goes into the MIOC's delay port, to be routed on by channel [runs from
+//	high-priority processing thread]
+- (void)emitCoreRoutes:(const MIDIPacketList *)startList availableBytes:(uint32_t)availableBytes delayed:(BOOL)delayed
+		receivingSysex:(BOOL)isReceivingSysex {
+	
+	MIDICoreTable *table = atomic_load_explicit(&_coreTable, memory_order_acquire);
+	if (_delayMIDIIO == nil || table == NULL) {
+		return;
+	}
+	
+	const Byte *bufferPtr = (const Byte *)startList;
+	const Byte *bufferEnd = bufferPtr + availableBytes;
+	int nPacketList = 0;
+	UInt32 tapID = _nextTapID; // handleMIDIPktlist assigns ids in the same order; we only read them
+	UInt32 numDelayOverflows = _numDelayOverflows;
+	
+	while (bufferPtr < bufferEnd) {
+		
+		const MIDIPacketList *pktlist = (const MIDIPacketList *)(uintptr_t)bufferPtr;
+		const MIDIPacket *packet = &pktlist->packet[0];
+		for (int i = 0; i < pktlist->numPackets; i++) {
+			packet = MIDIPacketNext(packet);
+		}
+		RT_SAFE_ASSERT((Byte *)packet <= bufferEnd+1, "MIDIPacketList has overrun input buffer.");
+		size_t pktlistLength = (const Byte *)packet - (Byte *)pktlist;
+		if (bufferPtr + pktlistLength > bufferEnd) {
+			os_log(OS_LOG_DEFAULT, "Incomplete MIDIPacketList in input buffer. Skipping.");
+			break;
+		}
+		
+		MIDIPacket *curPkt = MIDIPacketListInit(_corePacketList);
+		UInt32 firstEmitted = _numEmittedEvents;
+		
+		packet = &pktlist->packet[0];
+		for (int i = 0; i < pktlist->numPackets; i++) {
+			const Byte *bp			= packet->data;
+			const Byte *packetEnd	= bp + packet->length;
+			
+			while (bp < packetEnd) {
+				const Byte status = *bp++;
+				
+				if (status == 0xF0) {
+					isReceivingSysex = YES;
+					continue;
+				} else if (isReceivingSysex) {
+					if (status == 0xF7) isReceivingSysex = NO;
+					continue;
+				} else if (status < 0x80 || status >= 0xF0) {
+					continue;	// realtime or stray data
+				}
+				
+				UInt16 length = ((status & 0xE0) == 0xC0) ? 2 : 3; // program change, channel pressure: one data byte
+				if (bp + length - 1 > packetEnd) break;
+				Byte channel = status & 0x0F;
+				Byte message[3] = { status, bp[0], (length == 3) ? bp[1] : 0 };
+				bp += length - 1;
+				BOOL isNoteOn = (status & 0xF0) == 0x90 && message[2] > 0;
+				
+				Byte inPort = MIDICoreTableInputPort(table, channel);
+				const MIDICoreProcess *processes;
+				UInt32 nProcesses = inPort ? MIDICoreTableProcesses(table, inPort, channel, delayed, &processes) : 0;
+				for (UInt32 p = 0; p < nProcesses; p++) {
+					Byte out[3] = { (status & 0xF0) | processes[p].outChannel, message[1], message[2] };
+					if (isNoteOn) out[2] = MIDICoreTableVelocity(table, processes[p].velocityTable, message[2]);
+					MIDITimeStamp timeStamp = delayed ? packet->timeStamp + AudioConvertNanosToHostTime(processes[p].delay_ns) : 0;
+					
+					MIDIPacket *addedPkt = MIDIPacketListAdd(_corePacketList, kDelayPacketListLength, curPkt, timeStamp, length, out);
+					if (addedPkt == NULL) {
+						_numDelayOverflows++;
+						continue;
+					}
+					curPkt = addedPkt;
+					
+					if (isNoteOn) {
+						EmittedEventMessage *emitted = appendEmittedEvent(self);
+						if (emitted) {
+							emitted->scheduledTime_ns	= AudioConvertHostTimeToNanos(delayed ? timeStamp : packet->timeStamp);
+							emitted->sourceTapID		= tapID;
+							emitted->sourceChannel		= channel;
+							emitted->targetChannel		= processes[p].outChannel;
+							emitted->note				= out[1];
+							emitted->velocity			= out[2];
+						}
+					}
+				}
+				if (isNoteOn) tapID++;
+			}
+			packet = MIDIPacketNext(packet);
+		}
+		
+		if (_corePacketList->numPackets > 0) {
+			UInt64 preHostTime = AudioGetCurrentHostTime();
+			OSStatus status = _delaySendDisabled ? noErr : MIDISend(_delayMIDIIO->_outPort, _delayMIDIIO->_MIDIDest, _corePacketList);
+			CHECK_OSSTATUS(status, "MIDISend software matrix packet list");
+			
+			RNPacketCapture *capture = atomic_load(&_packetCapture);
+			if (capture != NULL) {
+				uint32_t listLength = (uint32_t)((Byte *)MIDIPacketNext(curPkt) - (Byte *)_corePacketList);
+				RNPacketCaptureAppend(capture, kRNPacketCaptureProducerProcessing, kRNPacketCaptureDelayOutput, preHostTime, _numProcessedLists + nPacketList, _corePacketList, listLength);
+			}
+			UInt64 sendTime_ns = AudioConvertHostTimeToNanos(preHostTime);
+			for (UInt32 iEmitted = firstEmitted; iEmitted < _numEmittedEvents; iEmitted++) {
+				_emittedEvents[iEmitted].sendTime_ns = sendTime_ns;
+			}
+		}
+		
+		nPacketList++;
+		bufferPtr += TPAlignedRecordLength((uint32_t)pktlistLength);
+	}
+	if (_numDelayOverflows != numDelayOverflows) {
+		os_log(OS_LOG_DEFAULT, "emitCoreRoutes: packet list full, %u events not sent.", _numDelayOverflows - numDelayOverflows);
+	}
+}
+
 // *********************************************
 // quickly send out delayed midi [runs from high-priority processing thread]
-- (void)emitDelayedNotes:(const MIDIPacketList*)startList availableBytes:(uint32_t)availableBytes {
+- (void)emitDelayedNotes:(const MIDIPacketList*)startList availableBytes:(uint32_t)availableBytes
+		  receivingSysex:(BOOL)isReceivingSysex {
 	
 	RNRealtimeRoutingTable *table = atomic_load_explicit(&_routingTable, memory_order_acquire);
 	if (_delayMIDIIO == NULL || table == nil) { // with no delay output or routing table, this is a NOP!
@@ -678,6 +1221,8 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 	const Byte *bufferEnd = bufferPtr + availableBytes;
 	int nPacketList = 0;
 	int nDelayPackets = 0;
+	UInt32 tapID = _nextTapID; // handleMIDIPktlist assigns ids in the same order; we only read them
+	UInt32 numDelayOverflows = _numDelayOverflows;
 	
 	while (bufferPtr < bufferEnd) {
 		
@@ -699,13 +1244,15 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 		}
 		
 		//grab the routing and delay matrices (we'll maintain it constant across each packet list
-		NodeMatrix *weightMatrix = atomic_load(&_routingTable->weightMatrix);
-		NodeMatrix *delayMatrix = atomic_load(&_routingTable->delayMatrix);
+		RNWeightMatrix *weights = atomic_load(&table->weightMatrix);
+		NodeMatrix *weightMatrix = &weights->matrix;
+		NodeMatrix *delayMatrix = atomic_load(&table->delayMatrix);
 		
 		//prolly makes sense to iterate through all the notes and do a single packet list rather than a smaller packet list for each note--figure out the max possible notes in it: (someday) 12 tappers * 11 delay outputs = 132 note on events (worst case if everyone taps at same time and have an all-all network. In general N*(N-1), so now, for 6, 30
 		
 		// initialize the output packetList
 		MIDIPacket *curDelayPkt = MIDIPacketListInit(_delayPacketList);
+		UInt32 firstEmitted = _numEmittedEvents; // log entries for this list get their send time below
 		
 		MIDITimeStamp earliestTimestamp = UINT64_MAX;
 		
@@ -722,10 +1269,10 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 				
 				// handle sysex (and ignore)
 				if (status == 0xF0) {		// Sysex start
-					_isReceivingSysex = YES;
-				} else if (_isReceivingSysex) {	// Sysex continuation
+					isReceivingSysex = YES;
+				} else if (isReceivingSysex) {	// Sysex continuation
 					if (status == 0xF7) {	// Sysex end
-						_isReceivingSysex = NO;
+						isReceivingSysex = NO;
 					}
 				} else if ((status & 0xF0) == 0x90) {
 					RT_SAFE_ASSERT(bp + 1 < packetEnd, "Problem: partial note-on message in packet. Shouldn't happen");
@@ -738,7 +1285,8 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 					
 					// NB: check if target timestamp is _past_ now, in which case we're not able to meet the target and say by how far off
 					// Special case if delay is 0 pass 0 as timestamp (not input timestamp) as that means 'send as soon as possible' since there is no actual way to send with 0 delay.
-					// TODO: implement velocity weithging
+					// Weights other than 1 scale velocity as an MIOC velocity processor set to that weight would, by the tables
+					// compiled with the weights (RNMIDIRouting.h)
 					if (velocity > 0) {	// only note on
 						Byte channel		= (status & 0x0F);
 						//loop over potential destinations
@@ -760,23 +1308,42 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 								}
 								_onMessage[0] = 0x90 + toChan; //NB convert to MIDI 0-based index
 								_onMessage[1] = note;
-								_onMessage[2] = velocity;
+								_onMessage[2] = weights->velocity.table[weights->velocity.index[channel][toChan]][velocity & 0x7F];
 								
-								curDelayPkt =  MIDIPacketListAdd(_delayPacketList,kDelayPacketListLength,curDelayPkt,delayTimeStamp,3,_onMessage);
-								RT_SAFE_ASSERT(curDelayPkt,"MIDIPacketListAdd returned NULL!");
+								// a full list drops the event (counted) rather than handing MIDIPacketListAdd a NULL packet next time
+								MIDIPacket *addedPkt = MIDIPacketListAdd(_delayPacketList,kDelayPacketListLength,curDelayPkt,delayTimeStamp,3,_onMessage);
+								if (addedPkt == NULL) {
+									_numDelayOverflows++;
+									continue;
+								}
+								curDelayPkt = addedPkt;
 								
 								os_log(OS_LOG_DEFAULT, "    Added NOTEON with %lld ms delay", HOSTTIME_TO_MS(delayTicks));
-								if (kDoEmitNoteOff) {
+								
+								EmittedEventMessage *emitted = appendEmittedEvent(self);
+								if (emitted) {
+									emitted->scheduledTime_ns	= AudioConvertHostTimeToNanos(delayTimeStamp);
+									emitted->sourceTapID		= tapID;
+									emitted->sourceChannel		= channel;
+									emitted->targetChannel		= toChan;
+									emitted->note				= note;
+									emitted->velocity			= _onMessage[2];
+								}
+								if (_emitsNoteOff) {
 									_offMessage[0] = _onMessage[0];
 									_offMessage[1] = _onMessage[1];
 									_offMessage[2] = 0;
 									MIDITimeStamp offTimeStamp = delayTimeStamp + MS_TO_HOSTTIME(kNoteOffDelay_ms);
-									curDelayPkt =  MIDIPacketListAdd(_delayPacketList,kDelayPacketListLength,curDelayPkt,offTimeStamp,3,_offMessage);
+									addedPkt = MIDIPacketListAdd(_delayPacketList,kDelayPacketListLength,curDelayPkt,offTimeStamp,3,_offMessage);
+									if (addedPkt == NULL) {
+										_numDelayOverflows++;
+									} else {
+										curDelayPkt = addedPkt;
+									}
 								}
-								
-								RT_SAFE_ASSERT((curDelayPkt != NULL), "Packet List Overflow [chan %d -> %d]",channel,toChan);
 							}
 						}
+						tapID++;
 					}
 				} else {
 					os_log(OS_LOG_DEFAULT, "Received non note-on event! %x %x %x", packet->data[0], packet->data[1], packet->data[2]);
@@ -810,10 +1377,25 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 			os_log(OS_LOG_DEFAULT, "---_delayPacketList---");
 			logMIDIPacketList(_delayPacketList, 0, 0);
 			
+			// high-water mark of the list, for the margin under kDelayPacketListLength
+			uint32_t delayListLength = (uint32_t)((Byte *)MIDIPacketNext(curDelayPkt) - (Byte *)_delayPacketList);
+			_maxDelayListBytes = MAX(_maxDelayListBytes, delayListLength);
+			
 			// send our delayPacketList to Core MIDI
-			UInt64 pre = HOSTTIME_TO_MS(AudioGetCurrentHostTime());
-			OSStatus status = MIDISend(_delayMIDIIO->_outPort, _delayMIDIIO->_MIDIDest, _delayPacketList);
+			UInt64 preHostTime = AudioGetCurrentHostTime();
+			UInt64 pre = HOSTTIME_TO_MS(preHostTime);
+			OSStatus status = _delaySendDisabled ? noErr : MIDISend(_delayMIDIIO->_outPort, _delayMIDIIO->_MIDIDest, _delayPacketList);
 			UInt64 post = HOSTTIME_TO_MS(AudioGetCurrentHostTime());
+			
+			RNPacketCapture *capture = atomic_load(&_packetCapture);
+			if (capture != NULL) {
+				RNPacketCaptureAppend(capture, kRNPacketCaptureProducerProcessing, kRNPacketCaptureDelayOutput, preHostTime, _numProcessedLists + nPacketList, _delayPacketList, delayListLength);
+			}
+			
+			UInt64 sendTime_ns = AudioConvertHostTimeToNanos(preHostTime);
+			for (UInt32 iEmitted = firstEmitted; iEmitted < _numEmittedEvents; iEmitted++) {
+				_emittedEvents[iEmitted].sendTime_ns = sendTime_ns;
+			}
 			os_log(OS_LOG_DEFAULT, "emitDelayedNotes MIDISend MIDIPacketList (%d packets) @ time ~ %lld (+/- %lld) ms", pktlist->numPackets, (pre+post)/2, (post-pre)/2);
 			
 			CHECK_OSSTATUS(status, "MIDISend delay packet list");
@@ -830,6 +1412,9 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 		bufferPtr += TPAlignedRecordLength((uint32_t)pktlistLength);
 		
 	}
+	if (_numDelayOverflows != numDelayOverflows) {
+		os_log(OS_LOG_DEFAULT, "emitDelayedNotes: delay packet list full, %u events not sent.", _numDelayOverflows - numDelayOverflows);
+	}
 	if (nDelayPackets) {
 		os_log(OS_LOG_DEFAULT, "emitDelayedNotes parsed %d input MIDIPacketLists with %ld bytes left over and output %d packets.", nPacketList, bufferEnd-bufferPtr, nDelayPackets);
 	}
@@ -838,6 +1423,7 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 // *********************************************
 // send midi to listeners [runs from high-priority processing thread]
 - (void)handleMIDIPktlist:(const MIDIPacketList *)pktlist availableBytes:(uint32_t)availableBytes
+		   receivingSysex:(BOOL)isReceivingSysex
 {
 	
 	// TODO: not sure why we're getting empty buffers, but no need to handle them
@@ -850,6 +1436,14 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 	const Byte *bufferEnd = bufferPtr + availableBytes;
 	int nPacketList = 0;
 	
+	// tapper->tapper routes inside the MIOC: we don't send that feedback, but log it as if we had (unless the
+	//	software matrix routes the channel: emitCoreRoutes logged what it sent)
+	RNRealtimeRoutingTable *table = atomic_load_explicit(&_routingTable, memory_order_acquire);
+	NodeMatrix *MIOCMatrix = (table != nil) ? table->MIOCMatrix : NULL;
+	MIDICoreTable *coreTable = atomic_load_explicit(&_coreTable, memory_order_acquire);
+	RNEventRecorder *recorder = atomic_load(&_eventRecorder);
+	RNStimulusScheduler *scheduler = atomic_load_explicit(&_stimulusScheduler, memory_order_acquire);
+	
 	while (bufferPtr < bufferEnd) {
 		
 		pktlist = (const MIDIPacketList *) bufferPtr;
@@ -869,7 +1463,7 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 		}
 		
 		// TEST
-		os_log(OS_LOG_DEFAULT, "==handleMIDIPktlist== (_isReceivingSysex=%@)", _isReceivingSysex?@"YES":@"NO");
+		os_log(OS_LOG_DEFAULT, "==handleMIDIPktlist== (isReceivingSysex=%@)", isReceivingSysex?@"YES":@"NO");
 		logMIDIPacketList(pktlist, pktlistLength, 0);
 		
 		// Second, thoroughly parse midi packets in list--keeping it simple for now, and only doing what we need
@@ -882,10 +1476,10 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 				const Byte byte = *bp++;
 				
 				if (byte == 0xF0) {		// Sysex start
-					_isReceivingSysex = YES;
+					isReceivingSysex = YES;
 					[_sysexData setLength:0];
 					[_sysexData appendBytes:&byte length:1];
-				} else if (_isReceivingSysex) {	// Sysex continuation
+				} else if (isReceivingSysex) {	// Sysex continuation
 					if (byte < 0xF8) { // ignore realtime messages embedded in sysex
 						[_sysexData appendBytes:&byte length:1];
 					}
@@ -905,7 +1499,7 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 								[listenerCopy release];
 							});
 						}
-						_isReceivingSysex = NO;
+						isReceivingSysex = NO;
 					}
 				} else {// non sysex
 					// note-on (all we care about in RhythmNetwork, so this is hardly general purpose)
@@ -923,6 +1517,42 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 							thisMessage.channel		= channel;
 							thisMessage.note			= note;
 							thisMessage.velocity		= velocity;
+							thisMessage.spare			= 0;
+							thisMessage.tapID			= _nextTapID++;
+							
+							if (recorder != NULL || scheduler != NULL) { // absolute time: recorder rebases when it flushes
+								RNEvent tap = {
+									.time_ns	= (int64_t) thisMessage.eventTime_ns,
+									.sendTime_ns = (int64_t) thisMessage.eventTime_ns,
+									.sourceID	= thisMessage.tapID,
+									.node		= nodeForNote(note),
+									.channel	= channel,
+									.note		= note,
+									.velocity	= velocity,
+									.kind		= kRNEventKindTap,
+								};
+								if (recorder != NULL)
+									RNEventRecorderPush(recorder, kRNEventRecorderProducerMIDI, &tap, 1);
+								if (scheduler != NULL && note > kBaseNote) // adaptive stimuli follow tappers, not BB echo
+									RNStimulusSchedulerPushTaps(scheduler, &tap, 1);
+							}
+							
+							if (MIOCMatrix != NULL && channel < kMaxNodes && note > kBaseNote // tappers only, not BB echo
+								&& (coreTable == NULL || MIDICoreTableInputPort(coreTable, channel) == 0)) {
+								for (int toChan = 0; toChan < kMaxNodes; toChan++) {
+									if ((*MIOCMatrix)[channel][toChan] == 0) continue;
+									EmittedEventMessage *emitted = appendEmittedEvent(self);
+									if (!emitted) break;
+									emitted->scheduledTime_ns	= thisMessage.eventTime_ns;
+									emitted->sendTime_ns		= thisMessage.eventTime_ns;
+									emitted->sourceTapID		= thisMessage.tapID;
+									emitted->sourceChannel		= channel;
+									emitted->targetChannel		= toChan;
+									emitted->note				= note;
+									emitted->velocity			= velocity; // before any MIOC velocity processing
+									emitted->isMIOCRoute		= 1;
+								}
+							}
 							
 							NSData *MIDIData = [NSData dataWithBytes:&thisMessage length:sizeof(NoteOnMessage)];
 							for (id listener in _MIDIListenerArray) {
@@ -963,11 +1593,60 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 		nPacketList++;
 		bufferPtr += TPAlignedRecordLength((uint32_t)pktlistLength);
 	}
+	_numProcessedLists += nPacketList; // emitDelayedNotes numbered its output from here
+	_isReceivingSysex = isReceivingSysex; // where the next pass starts
 	
 	//os_log(OS_LOG_DEFAULT, "handleMIDIPktlist handled total %d MIDIPacketLists with %ld bytes left over.", nPacketList, bufferEnd-bufferPtr);
 
 }
 
+// *********************************************
+// hand the events logged during this pass to listeners as one packed block [runs from high-priority processing thread]
+- (void)dispatchEmittedEvents
+{
+	if (_numEmittedEventsDropped > 0) {
+		os_log(OS_LOG_DEFAULT, "Emitted event log full: %u events not logged.", _numEmittedEventsDropped);
+		_numEmittedEventsDropped = 0;
+	}
+	if (_numEmittedEvents == 0) {
+		return;
+	}
+	
+	RNEventRecorder *recorder = atomic_load(&_eventRecorder);
+	RNVirtualTappers *tappers = atomic_load(&_virtualTappers);
+	if ((recorder != NULL || tappers != NULL) && _recorderEvents != NULL) {
+		for (UInt32 iEmitted = 0; iEmitted < _numEmittedEvents; iEmitted++) {
+			const EmittedEventMessage *emitted = &_emittedEvents[iEmitted];
+			RNEvent event = {
+				.time_ns	= (int64_t) emitted->scheduledTime_ns,
+				.sendTime_ns = (int64_t) emitted->sendTime_ns,
+				.sourceID	= emitted->sourceTapID,
+				.node		= emitted->targetChannel + 1, // tapper channel -> node
+				.channel	= emitted->targetChannel,
+				.note		= emitted->note,
+				.velocity	= emitted->velocity,
+				.kind		= kRNEventKindFeedback,
+				.flags		= emitted->isMIOCRoute ? kRNEventFlagMIOCRoute : 0,
+			};
+			_recorderEvents[iEmitted] = event;
+		}
+		if (recorder != NULL)
+			RNEventRecorderPush(recorder, kRNEventRecorderProducerMIDI, _recorderEvents, _numEmittedEvents);
+		if (tappers != NULL)
+			RNVirtualTappersPush(tappers, kRNEventRecorderProducerMIDI, _recorderEvents, _numEmittedEvents);
+	}
+	
+	if ([_emittedListenerArray count] > 0) {
+		NSData *emittedData = [NSData dataWithBytes:_emittedEvents length:_numEmittedEvents * sizeof(EmittedEventMessage)];
+		for (id listener in _emittedListenerArray) {
+			dispatch_async(_listenerQueue, ^{
+				[listener receiveEmittedEventData:emittedData];
+			});
+		}
+	}
+	_numEmittedEvents = 0;
+}
+
 // *********************************************
 //     PUBLIC METHODS
 // *********************************************
@@ -1017,6 +1696,27 @@ void logMIDIPacketList(const MIDIPacketList *packetList, long pktlistLength, MID
 	[_MIDIListenerArray removeObject:object];
 }
 
+// *********************************************
+//
+- (void)registerEmittedEventListener:(id<EmittedEventReceiver>)object
+{
+	NSAssert([object conformsToProtocol:@protocol(EmittedEventReceiver)],
+			 @"Cannot register %@ as Emitted Event Listener. (Does not conform to <EmittedEventReceiver>)", object);
+
+	NSAssert(![_emittedListenerArray containsObject:object],
+			 @"Trying to add Emitted Event Listener object %@ again!", object);
+
+	[_emittedListenerArray addObject:object];	// this retains object
+}
+
+- (void)removeEmittedEventListener:(id<EmittedEventReceiver>)object
+{
+	NSAssert([_emittedListenerArray containsObject:object],
+			 @"Removing non-registered Emitted Event listener!: %@", object);
+
+	[_emittedListenerArray removeObject:object];
+}
+
 // *********************************************
 //    SENDING MIDI
 // *********************************************
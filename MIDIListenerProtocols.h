@@ -14,3 +14,8 @@
 @protocol SysexDataReceiver <NSObject>
 - (void)receiveSysexData:(NSData *)data;
 @end
+
+// emitted (delayed or MIOC-routed) events, delivered in batches: data holds a packed array of EmittedEventMessage
+@protocol EmittedEventReceiver <NSObject>
+- (void)receiveEmittedEventData:(NSData *)data;
+@end
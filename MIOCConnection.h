@@ -13,6 +13,7 @@
 #import <Foundation/Foundation.h>
 #import "MIOCProcessorProtocol.h"
 #import "MIOCMessage.h"
+#import "MIOCConnectionSet.h"
 
 @class MIOCVelocityProcessor;
 
@@ -30,6 +31,16 @@
 + (MIOCConnection *)connectionWithInPort:(int)anInPort InChannel:(int)anInChannel OutPort:(int)anOutPort OutChannel:(int)anOutChannel;
 - (MIOCConnection *)initWithInPort:(int)anInPort InChannel:(int)anInChannel OutPort:(int)anOutPort OutChannel:(int)anOutChannel;
 
+- (Byte)inPort;
+- (Byte)inChannel;
+- (Byte)outPort;
+- (Byte)outChannel;
+
+// position in a MIOCConnectionSet (ports and channels only), -1 if out of range
+- (int32_t)connectionSetIndex;
++ (void)addConnections:(NSArray *)connectionList toSet:(MIOCConnectionSet *)set;
++ (NSArray *)connectionsInSet:(const MIOCConnectionSet *)set;	// in set order
+
 - (double)weight;
 - (void)setWeight:(double)newWeight;
 
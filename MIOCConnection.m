@@ -48,6 +48,41 @@
 	[super dealloc];
 }
 
+- (Byte)inPort { return _inPort; }
+- (Byte)inChannel { return _inChannel; }
+- (Byte)outPort { return _outPort; }
+- (Byte)outChannel { return _outChannel; }
+
+- (int32_t)connectionSetIndex
+{
+	return MIOCConnectionSetIndex(_inPort, _inChannel, _outPort, _outChannel);
+}
+
++ (void)addConnections:(NSArray *)connectionList toSet:(MIOCConnectionSet *)set
+{
+	for (MIOCConnection *conn in connectionList) {
+		BOOL added = MIOCConnectionSetAdd(set, [conn connectionSetIndex]);
+		NSAssert1(added, @"Connection out of range: %@", conn);
+	}
+}
+
+// bypasses connectionWithInPort: and its logging: sets can hold hundreds
++ (NSArray *)connectionsInSet:(const MIOCConnectionSet *)set
+{
+	uint32_t count = MIOCConnectionSetCount(set);
+	MIOCConnectionBits *bits = malloc(count * sizeof(MIOCConnectionBits) + 1);
+	MIOCConnectionSetMembers(set, bits, count);
+	NSMutableArray *connectionList = [NSMutableArray arrayWithCapacity:count];
+	for (uint32_t i = 0; i < count; i++) {
+		MIOCConnection *conn = [[MIOCConnection alloc] initWithInPort:bits[i].inPort InChannel:bits[i].inChannel
+															  OutPort:bits[i].outPort OutChannel:bits[i].outChannel];
+		[connectionList addObject:conn];
+		[conn release];
+	}
+	free(bits);
+	return [NSArray arrayWithArray:connectionList];
+}
+
 - (double)weight {
 	return _weight;
 }
@@ -0,0 +1,99 @@
+//
+//  MIOCConnectionSet.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "MIOCConnectionSet.h"
+#include <string.h>
+
+static inline int32_t portIndex(uint8_t port)
+{
+	return (port >= 1 && port <= kMIOCSetPorts) ? port - 1 : -1;
+}
+
+static inline int32_t channelIndex(uint8_t channel)
+{
+	if (channel == kMIOCSetAnyChannel) return kMIOCSetChannels - 1;
+	return (channel >= 1 && channel <= kMIOCSetChannels - 1) ? channel - 1 : -1;
+}
+
+int32_t MIOCConnectionSetIndex(uint8_t inPort, uint8_t inChannel, uint8_t outPort, uint8_t outChannel)
+{
+	int32_t ip = portIndex(inPort), ic = channelIndex(inChannel), op = portIndex(outPort), oc = channelIndex(outChannel);
+	if (ip < 0 || ic < 0 || op < 0 || oc < 0) return -1;
+	return ((ip * kMIOCSetChannels + ic) * kMIOCSetPorts + op) * kMIOCSetChannels + oc;
+}
+
+MIOCConnectionBits MIOCConnectionSetConnection(uint32_t index)
+{
+	MIOCConnectionBits connection;
+	uint32_t oc = index % kMIOCSetChannels;	index /= kMIOCSetChannels;
+	uint32_t op = index % kMIOCSetPorts;	index /= kMIOCSetPorts;
+	uint32_t ic = index % kMIOCSetChannels;	index /= kMIOCSetChannels;
+	connection.inPort		= (uint8_t)(index + 1);
+	connection.inChannel	= (ic == kMIOCSetChannels - 1) ? kMIOCSetAnyChannel : (uint8_t)(ic + 1);
+	connection.outPort		= (uint8_t)(op + 1);
+	connection.outChannel	= (oc == kMIOCSetChannels - 1) ? kMIOCSetAnyChannel : (uint8_t)(oc + 1);
+	return connection;
+}
+
+void MIOCConnectionSetClear(MIOCConnectionSet *set)
+{
+	memset(set, 0, sizeof(MIOCConnectionSet));
+}
+
+bool MIOCConnectionSetAdd(MIOCConnectionSet *set, int32_t index)
+{
+	if (index < 0 || index >= kMIOCSetConnections) return false;
+	set->words[index >> 6] |= (uint64_t) 1 << (index & 63);
+	return true;
+}
+
+void MIOCConnectionSetRemove(MIOCConnectionSet *set, int32_t index)
+{
+	if (index < 0 || index >= kMIOCSetConnections) return;
+	set->words[index >> 6] &= ~((uint64_t) 1 << (index & 63));
+}
+
+bool MIOCConnectionSetContains(const MIOCConnectionSet *set, int32_t index)
+{
+	if (index < 0 || index >= kMIOCSetConnections) return false;
+	return (set->words[index >> 6] >> (index & 63)) & 1;
+}
+
+uint32_t MIOCConnectionSetCount(const MIOCConnectionSet *set)
+{
+	uint32_t count = 0;
+	for (unsigned w = 0; w < kMIOCSetWords; w++)
+		count += (uint32_t) __builtin_popcountll(set->words[w]);
+	return count;
+}
+
+bool MIOCConnectionSetEqual(const MIOCConnectionSet *a, const MIOCConnectionSet *b)
+{
+	return memcmp(a->words, b->words, sizeof(a->words)) == 0;
+}
+
+void MIOCConnectionSetDifference(MIOCConnectionSet *result, const MIOCConnectionSet *a, const MIOCConnectionSet *b)
+{
+	for (unsigned w = 0; w < kMIOCSetWords; w++)
+		result->words[w] = a->words[w] & ~b->words[w];
+}
+
+uint32_t MIOCConnectionSetMembers(const MIOCConnectionSet *set, MIOCConnectionBits *connections, uint32_t maxConnections)
+{
+	uint32_t count = 0;
+	for (unsigned w = 0; w < kMIOCSetWords; w++) {
+		uint64_t word = set->words[w];
+		while (word != 0) {
+			uint32_t bit = (uint32_t) __builtin_ctzll(word);
+			if (count < maxConnections)
+				connections[count] = MIOCConnectionSetConnection(w * 64 + bit);
+			count++;
+			word &= word - 1;
+		}
+	}
+	return count;
+}
@@ -0,0 +1,62 @@
+//
+//  MIOCConnectionSet.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// MIOC routing state as a bitset over every possible connection: in port x in channel (or all) x out port x
+//	out channel (or same as input), one bit each. Membership is a bit test and the difference between two
+//	states is a pass over the words, so diffing dense networks costs the same as sparse ones.
+//	Ports and channels are 1-based, as MIOCConnection; kMIOCInChannelAll and kMIOCOutChannelSameAsInput
+//	(0x80) are the 17th channel.
+//
+// Plain C: also built into Tools/rnmiocsim and Tools/rnvelocitymap.
+
+#ifndef MIOCConnectionSet_h
+#define MIOCConnectionSet_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kMIOCSetPorts			8
+#define kMIOCSetChannels		17		// 16 and all / same as input
+#define kMIOCSetAnyChannel		0x80	// kMIOCInChannelAll, kMIOCOutChannelSameAsInput
+#define kMIOCSetConnections		(kMIOCSetPorts * kMIOCSetChannels * kMIOCSetPorts * kMIOCSetChannels)
+#define kMIOCSetWords			((kMIOCSetConnections + 63) / 64)
+
+typedef struct {
+	uint64_t	words[kMIOCSetWords];
+} MIOCConnectionSet;
+
+typedef struct {
+	uint8_t		inPort;
+	uint8_t		inChannel;
+	uint8_t		outPort;
+	uint8_t		outChannel;
+} MIOCConnectionBits;
+
+// -1 if a port or channel is out of range
+int32_t		MIOCConnectionSetIndex(uint8_t inPort, uint8_t inChannel, uint8_t outPort, uint8_t outChannel);
+MIOCConnectionBits MIOCConnectionSetConnection(uint32_t index);
+
+void		MIOCConnectionSetClear(MIOCConnectionSet *set);
+bool		MIOCConnectionSetAdd(MIOCConnectionSet *set, int32_t index);		// false if out of range
+void		MIOCConnectionSetRemove(MIOCConnectionSet *set, int32_t index);
+bool		MIOCConnectionSetContains(const MIOCConnectionSet *set, int32_t index);
+uint32_t	MIOCConnectionSetCount(const MIOCConnectionSet *set);
+bool		MIOCConnectionSetEqual(const MIOCConnectionSet *a, const MIOCConnectionSet *b);
+void		MIOCConnectionSetDifference(MIOCConnectionSet *result, const MIOCConnectionSet *a, const MIOCConnectionSet *b);	// a and not b
+
+// The members, in index order, up to maxConnections. Returns how many there are in all.
+uint32_t	MIOCConnectionSetMembers(const MIOCConnectionSet *set, MIOCConnectionBits *connections, uint32_t maxConnections);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIOCConnectionSet_h */
@@ -7,18 +7,23 @@
 #import "MIOCProcessorProtocol.h"
 #import "MIDIListenerProtocols.h"
 #import "MIOCMessage.h"
+#import "MIOCConnectionSet.h"
 
 #define kSendSysexSuccess	TRUE
 #define kSendSysexFailure	FALSE
 
-@class MIDIIO, MIOCConnection, MIOCVelocityProcessor, MIDICore;
+// a switch's sysex goes out as one packet list, paced so no more than this is queued ahead of the cable
+//	(the MIOC has no flow control to ask)
+#define kMIOCSendWindowBytes	256
+
+@class MIDIIO, MIOCConnection, MIOCVelocityProcessor, MIOCTransition, MIDICore;
 
 @interface MIOCModel : NSObject <SysexDataReceiver> {
 	Byte      _deviceID;   // Fornet address
 	Byte      _deviceType; // Miditemp defined device types
 	NSString *_deviceName; // User-specified name of device
 
-	NSMutableArray *_connectionList;        // set of MIOCConnection objects (our model of MIOC state)
+	MIOCConnectionSet _connections;         // routing processors (our model of MIOC state)
 	NSMutableArray *_velocityProcessorList; // set of MIOCVelocityProcessor objects (model of MIOC state)
 	BOOL            _filtersInitialized;    // yes if filters have been initialized
 	BOOL            _isOnline;              // yes if MIOC is online
@@ -28,8 +33,12 @@
 	NSTimer *_replyTimer;                   // timer to check for MIOC reply timeout
 
 	MIDIIO   *_MIDILink;                 // our bridge to MIDI
-	MIDICore *_MIDICore;                 // internal midi processor (stands in for MIOC)
+	MIDICore *_MIDICore;                 // internal midi processor (stands in for MIOC routing, the MIOC as patchbay)
 	BOOL      _useInternalMIDIProcessor; // converse: use internal MIDICore
+	NSArray  *_requestedConnections;     // internal: what was asked for, split between MIDICore and the MIOC
+	NSArray  *_requestedVelocityProcessors;
+
+	NSTimeInterval _lastSwitchDuration;  // last setConnectionList:, setVelocityProcessorList: or applyTransition:
 }
 
 - (MIOCModel *)init;
@@ -39,6 +48,8 @@
 - (void)checkOnline;
 - (BOOL)isOnline;
 
+// internal: routes the software matrix can take (MIDICore.h) leave the MIOC, which needs a second interface port
+//	for our output; connectionList and velocityProcessorList are still all that was asked for
 - (BOOL)useInternalMIDIProcessor;
 - (void)setUseInternalMIDIProcessor:(BOOL)useInternal;
 
@@ -72,6 +83,21 @@
 - (NSArray *)connectionList;
 - (void)setConnectionList:(NSArray *)aConnectionList;
 
+// precompiled state changes (e.g. an experiment's parts, compiled at load)
+- (MIOCTransition *)transitionFromConnections:(NSArray *)fromConnections velocityProcessors:(NSArray *)fromProcessors
+								toConnections:(NSArray *)toConnections velocityProcessors:(NSArray *)toProcessors;
+- (BOOL)applyTransition:(MIOCTransition *)transition;
+- (BOOL)canSendTransitionsAheadFrom:(MIOCTransition *)transition;
+- (void)noteTransitionSent:(MIOCTransition *)transition;
+
+// from the start of working out the changes until their last byte is on the cable
+- (NSTimeInterval)lastSwitchDuration;
+
+// sysex messages as one packet list, in order, paced by kMIOCSendWindowBytes: timestamps are relative (host
+//	ticks after the send), 0 for those sent at once; sendPacketList: makes them absolute
++ (NSData *)packetListForSysexMessages:(NSArray *)messages;	// nil if they could not be packed
+- (BOOL)sendPacketList:(NSData *)packetList;
+
 - (MIDIIO *)MIDILink;
 - (void)receiveSysexData:(NSData *)data;
 
@@ -89,6 +115,10 @@
 - (BOOL)sendAddRemoveProcessorSysex:(id <MIOCProcessor>)aProc withFlag:(Byte *)flagPtr;
 
 - (NSData *)sysexMessageForProcessor:(id <MIOCProcessor>)aProc withFlag:(Byte *)flagPtr;
+- (BOOL)sendSysexMessages:(NSArray *)messages byteCount:(NSUInteger *)nBytes;
+- (void)noteSwitchStartedAt:(UInt64)startHostTime byteCount:(NSUInteger)nBytes;
+- (BOOL)routeConnections:(NSArray *)connectionList velocityProcessors:(NSArray *)processorList;
+- (BOOL)sendMIOCConnections:(NSArray *)connectionList velocityProcessors:(NSArray *)processorList byteCount:(NSUInteger *)nBytes;
 
 - (NSMutableData *)addChecksum:(NSMutableData *)message;
 - (BOOL)verifyChecksum:(NSData *)message;
@@ -4,24 +4,35 @@
 #import "MIOCConnection.h"
 #import "MIOCVelocityProcessor.h"
 #import "MIOCFilterProcessor.h"
+#import "MIOCTransition.h"
 #import "MIDIIO.h"
 #import "MIDICore.h"
 #import "NSStringHexStringCategory.h"
+#import "MIOCSysex.h"
+#import <CoreMIDI/MIDIServices.h>
+#import <CoreAudio/HostTime.h>
 
-// various components of sysex messages
-static Byte sysexStart[1]				= {kSysexStart};
-static Byte sysexEnd[1]					= {kSysexEnd};
-static Byte MIDITEMPID[3]				= {kMIDITEMPID};
-static Byte encodedMode[1]				= {kModeEncodedMask};	// we'll never send handshaking or multi-packet messages
-static Byte notEncodedMode[1]			= {0x00};	// so these two suffice
-static Byte addRemoveProcessorOpcode[1] = {kMIOCAddRemoveMIDIProcessorOpcode};
+// add/remove flags of processor messages, which we always send encoded (no handshaking, one packet)
 static Byte addProcessorFlag[1]			= {kMIOCAddMIDIProcessorFlag};
 static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
+#define kLogMIOCMessages NO	// each message of a packed send (there can be hundreds)
+
 #define SKIP_IF_OFFLINE if (!self->_isOnline) return;
 #define ONLY_IF_ONLINE if (self->_isOnline) {
 #define END_ONLY_IF_ONLINE }
 
+// items of list not in other
+static NSArray *missingFrom(NSArray *list, NSArray *other)
+{
+	NSMutableArray *missing = [NSMutableArray arrayWithCapacity:10];
+	for (id item in list) {
+		if ([other containsObject:item] == NO)
+			[missing addObject:item];
+	}
+	return missing;
+}
+
 
 @implementation MIOCModel
 
@@ -36,7 +47,7 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 	_deviceID				= 0x00;	// *** hard coded for now, later add discovery if we have multiple devices
 	_deviceType				= kDevicePMM88E;
-	_connectionList			= [[NSMutableArray arrayWithCapacity:0] retain];
+	MIOCConnectionSetClear(&_connections);
 	_velocityProcessorList	= [[NSMutableArray arrayWithCapacity:0] retain];
 
 	_MIDILink = [[MIDIIO alloc] init];
@@ -46,6 +57,8 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 	// default: use external (MIOC) processor
 	_useInternalMIDIProcessor = NO;
 	_MIDICore = nil;
+	_requestedConnections = nil;
+	_requestedVelocityProcessors = nil;
 
 	// check it mioc is online--if so, initialize it
 	[[NSNotificationCenter defaultCenter] addObserver:self
@@ -60,7 +73,9 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 - (void)dealloc
 {
-	[_connectionList release];
+	[_MIDICore release];
+	[_requestedConnections release];
+	[_requestedVelocityProcessors release];
 	[_velocityProcessorList release];
 	[_MIDILink release];// removes listeners too
 	[super dealloc];
@@ -77,20 +92,34 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 	return _useInternalMIDIProcessor;
 }
 
+// what was asked for moves across: to the software matrix and the MIOC's share of it, or back to the MIOC
 - (void)setUseInternalMIDIProcessor:(BOOL)useInternal
 {
-	_useInternalMIDIProcessor = useInternal;
+	if (useInternal == _useInternalMIDIProcessor) return;
+	if (useInternal && ![_MIDILink hasDelayOutput]) {
+		NSLog(@"No second MIDI output for the internal MIDI processor: routing stays on the MIOC");
+		return;
+	}
+	NSArray *connections = [self connectionList], *processors = [self velocityProcessorList];
 
 	if (useInternal == YES) {
-		if (_MIDICore == nil) {
-			_MIDICore = [[MIDICore alloc] initWithInterface:_MIDILink];
-		}
-
-		// initialize midi core with connections/velocities/delays...
-	} else if (useInternal == NO) {
-		[_MIDICore release];// restores original readProc
+		_MIDICore = [[MIDICore alloc] initWithInterface:_MIDILink];
+		_useInternalMIDIProcessor = YES;
+		_requestedConnections = [connections copy];
+		_requestedVelocityProcessors = [processors copy];
+		if (_isOnline) [self routeConnections:connections velocityProcessors:processors];
+	} else {
+		// the MIOC takes everything before software lets go, so routes are doubled for a moment rather than missing
+		if (_isOnline) [self sendMIOCConnections:connections velocityProcessors:processors byteCount:NULL];
+		_useInternalMIDIProcessor = NO;
+		[_MIDICore release];// stops the software matrix
 		_MIDICore = nil;
+		[_requestedConnections release];
+		_requestedConnections = nil;
+		[_requestedVelocityProcessors release];
+		_requestedVelocityProcessors = nil;
 	}
+	NSLog(@"MIDI routing: %@", _useInternalMIDIProcessor ? @"software matrix, MIOC as patchbay" : @"MIOC");
 }
 
 // reset MIOC: clear all existing connections, processors
@@ -111,8 +140,9 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 	if (returnCode == NSAlertFirstButtonReturn) {	// OK: assume they've powercycled
 		// reset our model state
-		[_connectionList removeAllObjects];
+		MIOCConnectionSetClear(&_connections);
 		[_velocityProcessorList removeAllObjects];
+		if (_useInternalMIDIProcessor) [self routeConnections:@[] velocityProcessors:@[]];
 		// initialize the MIOC (after checking it's connected)
 		[self checkOnline];
 	} else {// Cancel: do nothing
@@ -122,10 +152,8 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 - (void)checkOnline
 {
-	if (_useInternalMIDIProcessor == NO) {
-		// we send a test query--if it is replied to, we know we're online
-		[self queryPortAddress];
-	}
+	// we send a test query--if it is replied to, we know we're online (the internal processor needs the MIOC too)
+	[self queryPortAddress];
 }
 
 - (BOOL)isOnline {
@@ -293,10 +321,15 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //  --otherwise, do nothing (MIOC does no checking for multiple identical channels)
 - (void)connectOne:(MIOCConnection *)aConnection
 {
-	if (![_connectionList containsObject:aConnection]) {
+	if (_useInternalMIDIProcessor) {	// any connection can change the split: route the whole list again
+		if (![_requestedConnections containsObject:aConnection])
+			[self setConnectionList:[_requestedConnections arrayByAddingObject:aConnection]];
+		return;
+	}
+	if (!MIOCConnectionSetContains(&_connections, [aConnection connectionSetIndex])) {
 		ONLY_IF_ONLINE
 		if ([self sendConnect:aConnection] == kSendSysexSuccess) {
-			[_connectionList addObject:aConnection];
+			MIOCConnectionSetAdd(&_connections, [aConnection connectionSetIndex]);
 			NSLog(@"Connected:    %@", aConnection);
 		} else {
 			NSLog(@"\n\tFailed to add connection processor (%@).", aConnection);
@@ -335,10 +368,15 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //
 - (void)disconnectOne:(MIOCConnection *)aConnection
 {
-	if ([_connectionList containsObject:aConnection]) {
+	if (_useInternalMIDIProcessor) {
+		if ([_requestedConnections containsObject:aConnection])
+			[self setConnectionList:missingFrom(_requestedConnections, @[aConnection])];
+		return;
+	}
+	if (MIOCConnectionSetContains(&_connections, [aConnection connectionSetIndex])) {
 		ONLY_IF_ONLINE
 		if ([self sendDisconnect:aConnection] == kSendSysexSuccess) {
-			[_connectionList removeObject:aConnection];
+			MIOCConnectionSetRemove(&_connections, [aConnection connectionSetIndex]);
 			NSLog(@"Disconnected: %@", aConnection);
 		} else {
 			NSLog(@"\n\tFailed to remove connection processor (%@).", aConnection);
@@ -369,55 +407,62 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 }
 
 // *********************************************
-//  disconnect all entries in _connectionList & all velocity processors
+//  disconnect all connections & all velocity processors
 - (void)disconnectAll
 {
 	[self setConnectionList:@[]];
 	// sanity--
-	NSAssert(([_connectionList count] == 0), @"Non-empty connectionList after disconnectAll");
+	NSAssert(([[self connectionList] count] == 0), @"Non-empty connectionList after disconnectAll");
 
 	[self setVelocityProcessorList:@[]];
 	// sanity--
-	NSAssert(([_velocityProcessorList count] == 0), @"Non-empty velocityProcessorList after disconnectAll");
+	NSAssert(([[self velocityProcessorList] count] == 0), @"Non-empty velocityProcessorList after disconnectAll");
 }
 
 // *********************************************
-//  accessors for _connectionList NSMutableArray
-// we don't want anyone else to modify our connectionList, so return a copy & make it non-mutable so if they try
-//	they'll get an error. Since using class method, it's already autoreleased
+//  accessors for _connections
+// we don't want anyone else to modify our connections, so return them as a new array (autoreleased)
 - (NSArray *)connectionList
 {
-	return [NSArray arrayWithArray:_connectionList];
+	if (_useInternalMIDIProcessor)
+		return [NSArray arrayWithArray:_requestedConnections];
+	return [MIOCConnection connectionsInSet:&_connections];
 }
 
-// do an incremental change: determine connections that need to be lost and those needing to be added
+// do an incremental change: the connections to lose and to add are set differences, and their sysex goes
+//	out together, paced (sendSysexMessages:), rather than a send per connection
 - (void)setConnectionList:(NSArray *)newConnectionList
 {
-	NSMutableArray	*connectionsToRemove	= [NSMutableArray arrayWithCapacity:10];
-	NSMutableArray	*connectionsToAdd		= [NSMutableArray arrayWithCapacity:10];
-
-	// find current connections NOT in new list (to remove)
-	MIOCConnection	*conn;
-	NSEnumerator	*currentEnumerator = [[self connectionList] objectEnumerator];
-
-	while (conn = [currentEnumerator nextObject]) {
-		if ([newConnectionList containsObject:conn] == NO) {
-			[connectionsToRemove addObject:conn];
-		}
+	SKIP_IF_OFFLINE
+	if (_useInternalMIDIProcessor == YES) {
+		[self routeConnections:newConnectionList velocityProcessors:_requestedVelocityProcessors];
+		return;
 	}
 
-	// find new connections not already in current list (to add)
-	NSEnumerator *newEnumerator = [newConnectionList objectEnumerator];
-
-	while (conn = [newEnumerator nextObject]) {
-		if ([[self connectionList] containsObject:conn] == NO) {
-			[connectionsToAdd addObject:conn];
-		}
+	UInt64 startHostTime = AudioGetCurrentHostTime();
+	MIOCConnectionSet newConnections, toRemove, toAdd;
+	MIOCConnectionSetClear(&newConnections);
+	[MIOCConnection addConnections:newConnectionList toSet:&newConnections];
+	MIOCConnectionSetDifference(&toRemove, &_connections, &newConnections);
+	MIOCConnectionSetDifference(&toAdd, &newConnections, &_connections);
+	NSArray *connectionsToRemove	= [MIOCConnection connectionsInSet:&toRemove];
+	NSArray *connectionsToAdd		= [MIOCConnection connectionsInSet:&toAdd];
+	NSUInteger nBytes = 0;
+
+	NSMutableArray *messages = [NSMutableArray arrayWithCapacity:[connectionsToRemove count] + [connectionsToAdd count]];
+	for (MIOCConnection *conn in connectionsToRemove)
+		[messages addObject:[self sysexMessageForProcessor:conn withFlag:removeProcessorFlag]];
+	for (MIOCConnection *conn in connectionsToAdd)
+		[messages addObject:[self sysexMessageForProcessor:conn withFlag:addProcessorFlag]];
+	if ([self sendSysexMessages:messages byteCount:&nBytes] == kSendSysexSuccess) {
+		_connections = newConnections;
+	} else {
+		NSLog(@"\n\tFailed to update connections (Remove %lu; Add %lu).", (unsigned long)[connectionsToRemove count], (unsigned long)[connectionsToAdd count]);
+		return;
 	}
-
-	[self disconnectMany:connectionsToRemove];
-	[self connectMany:connectionsToAdd];
-	NSLog(@"Update connections: Remove %lu; Add %lu\n", (unsigned long)[connectionsToRemove count], (unsigned long)[connectionsToAdd count]);
+	[self noteSwitchStartedAt:startHostTime byteCount:nBytes];
+	NSLog(@"Update connections: Remove %lu; Add %lu (%lu B, switched in %.1f ms)\n", (unsigned long)[connectionsToRemove count],
+		  (unsigned long)[connectionsToAdd count], (unsigned long)nBytes, _lastSwitchDuration * 1000.0);
 }
 
 // *********************************************
@@ -427,6 +472,11 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 - (void)addVelocityProcessor:(MIOCVelocityProcessor *)aVelProc
 {
+	if (_useInternalMIDIProcessor) {
+		if (![_requestedVelocityProcessors containsObject:aVelProc])
+			[self setVelocityProcessorList:[_requestedVelocityProcessors arrayByAddingObject:aVelProc]];
+		return;
+	}
 	if (![_velocityProcessorList containsObject:aVelProc]) {
 		ONLY_IF_ONLINE
 		if ([self sendAddVelocityProcessor:aVelProc] == kSendSysexSuccess) {
@@ -443,6 +493,11 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 - (void)removeVelocityProcessor:(MIOCVelocityProcessor *)aVelProc
 {
+	if (_useInternalMIDIProcessor) {
+		if ([_requestedVelocityProcessors containsObject:aVelProc])
+			[self setVelocityProcessorList:missingFrom(_requestedVelocityProcessors, @[aVelProc])];
+		return;
+	}
 	if ([_velocityProcessorList containsObject:aVelProc]) {
 		ONLY_IF_ONLINE
 		if ([self sendRemoveVelocityProcessor:aVelProc] == kSendSysexSuccess) {
@@ -487,38 +542,182 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //  accessors for _velocityProcessorList NSMutableArray
 - (NSArray *)velocityProcessorList
 {
+	if (_useInternalMIDIProcessor)
+		return [NSArray arrayWithArray:_requestedVelocityProcessors];
 	return [NSArray arrayWithArray:_velocityProcessorList];
 }
 
-// do an incremental change: determine connections that need to be lost and those needing to be added
+// do an incremental change: determine processors that need to be lost and those needing to be added, and send
+//	them together, as setConnectionList:
 - (void)setVelocityProcessorList:(NSArray *)newVelocityProcessorList
 {
-	NSMutableArray	*processorsToRemove = [NSMutableArray arrayWithCapacity:10];
-	NSMutableArray	*processorsToAdd	= [NSMutableArray arrayWithCapacity:10];
-
-	// find current velocity processors NOT in new list (to remove)
-	MIOCVelocityProcessor	*processor;
-	NSEnumerator			*currentEnumerator = [[self velocityProcessorList] objectEnumerator];
+	SKIP_IF_OFFLINE
+	if (_useInternalMIDIProcessor == YES) {
+		[self routeConnections:_requestedConnections velocityProcessors:newVelocityProcessorList];
+		return;
+	}
 
-	while (processor = [currentEnumerator nextObject]) {
-		if ([newVelocityProcessorList containsObject:processor] == NO) {
-			[processorsToRemove addObject:processor];
-		}
+	UInt64 startHostTime = AudioGetCurrentHostTime();
+	NSArray *processorsToRemove	= missingFrom(_velocityProcessorList, newVelocityProcessorList);
+	NSArray *processorsToAdd	= missingFrom(newVelocityProcessorList, _velocityProcessorList);
+	NSUInteger nBytes = 0;
+
+	NSMutableArray *messages = [NSMutableArray arrayWithCapacity:[processorsToRemove count] + [processorsToAdd count]];
+	for (MIOCVelocityProcessor *processor in processorsToAdd)	// add before remove seems to work, prevents gap when there's no processor
+		[messages addObject:[self sysexMessageForProcessor:processor withFlag:addProcessorFlag]];
+	for (MIOCVelocityProcessor *processor in processorsToRemove)
+		[messages addObject:[self sysexMessageForProcessor:processor withFlag:removeProcessorFlag]];
+	if ([self sendSysexMessages:messages byteCount:&nBytes] == kSendSysexFailure) {
+		NSLog(@"\n\tFailed to update velocity processors (Remove %lu; Add %lu).", (unsigned long)[processorsToRemove count], (unsigned long)[processorsToAdd count]);
+		return;
 	}
+	[_velocityProcessorList removeObjectsInArray:processorsToRemove];
+	[_velocityProcessorList addObjectsFromArray:processorsToAdd];
+	[self noteSwitchStartedAt:startHostTime byteCount:nBytes];
+	NSLog(@"Update velocity processors: Remove %lu; Add %lu (%lu B, switched in %.1f ms)\n", (unsigned long)[processorsToRemove count],
+		  (unsigned long)[processorsToAdd count], (unsigned long)nBytes, _lastSwitchDuration * 1000.0);
+}
 
-	// find new connections not already in current list (to add)
-	NSEnumerator *newEnumerator = [newVelocityProcessorList objectEnumerator];
+// *********************************************
+//    Transitions
+// *********************************************
+#pragma mark TRANSITIONS
 
-	while (processor = [newEnumerator nextObject]) {
-		if ([[self velocityProcessorList] containsObject:processor] == NO) {
-			[processorsToAdd addObject:processor];
-		}
+// the changes setConnectionList: and setVelocityProcessorList: would make from one state to the other, with
+//	their sysex composed now, in the order those send it
+- (MIOCTransition *)transitionFromConnections:(NSArray *)fromConnections velocityProcessors:(NSArray *)fromProcessors
+								toConnections:(NSArray *)toConnections velocityProcessors:(NSArray *)toProcessors
+{
+	MIOCConnectionSet from, to, difference;
+	MIOCConnectionSetClear(&from);
+	MIOCConnectionSetClear(&to);
+	[MIOCConnection addConnections:fromConnections toSet:&from];
+	[MIOCConnection addConnections:toConnections toSet:&to];
+	MIOCConnectionSetDifference(&difference, &from, &to);
+	NSArray *connectionsToRemove	= [MIOCConnection connectionsInSet:&difference];
+	MIOCConnectionSetDifference(&difference, &to, &from);
+	NSArray *connectionsToAdd		= [MIOCConnection connectionsInSet:&difference];
+	NSArray *processorsToRemove		= missingFrom(fromProcessors, toProcessors);
+	NSArray *processorsToAdd		= missingFrom(toProcessors, fromProcessors);
+
+	NSMutableArray *messages = [NSMutableArray arrayWithCapacity:10];
+	for (MIOCConnection *conn in connectionsToRemove)
+		[messages addObject:[self sysexMessageForProcessor:conn withFlag:removeProcessorFlag]];
+	for (MIOCConnection *conn in connectionsToAdd)
+		[messages addObject:[self sysexMessageForProcessor:conn withFlag:addProcessorFlag]];
+	for (MIOCVelocityProcessor *processor in processorsToAdd)	// add before remove, as setVelocityProcessorList:
+		[messages addObject:[self sysexMessageForProcessor:processor withFlag:addProcessorFlag]];
+	for (MIOCVelocityProcessor *processor in processorsToRemove)
+		[messages addObject:[self sysexMessageForProcessor:processor withFlag:removeProcessorFlag]];
+
+	MIOCTransition *transition = [[MIOCTransition alloc] initFromConnections:fromConnections remove:connectionsToRemove add:connectionsToAdd
+														  velocityProcessors:fromProcessors remove:processorsToRemove add:processorsToAdd
+															   sysexMessages:messages];
+	return [transition autorelease];
+}
+
+// in a single send, if our model is where the transition starts from. Otherwise (or offline) fall back to working out the changes from the current state; returns NO if it did
+- (BOOL)applyTransition:(MIOCTransition *)transition
+{
+	UInt64 startHostTime = AudioGetCurrentHostTime();
+	if (_useInternalMIDIProcessor) {	// compiled for the MIOC alone: split and send what's left
+		if (_isOnline) [self routeConnections:[transition toConnections] velocityProcessors:[transition toVelocityProcessors]];
+		return NO;
+	}
+	if (!_isOnline
+		|| !MIOCConnectionSetEqual(&_connections, [transition fromConnectionSet])
+		|| ![_velocityProcessorList isEqualToArray:[transition fromVelocityProcessors]]) {
+		NSLog(@"MIOC state is not where the transition starts: updating incrementally");
+		[self setConnectionList:[transition toConnections]];
+		[self setVelocityProcessorList:[transition toVelocityProcessors]];
+		return NO;
 	}
 
-	[self addVelocityProcessorsInArray:processorsToAdd];// add before remove seems to work, prevents gap when there's no processor
-	[self removeVelocityProcessorsInArray:processorsToRemove];
+	if (![transition isEmpty] && [self sendPacketList:[transition packetList]] == kSendMIDIFailure) {
+		NSLog(@"\n\tFailed to send %@", transition);
+		return NO;
+	}
+	_connections = *[transition toConnectionSet];
+	[_velocityProcessorList setArray:[transition toVelocityProcessors]];
+	[self noteSwitchStartedAt:startHostTime byteCount:[transition byteCount]];
+	NSLog(@"Applied %@, switched in %.1f ms", transition, _lastSwitchDuration * 1000.0);
+	return YES;
+}
+
+// whether a chain of transitions starting with this one (nil: any) can be sent ahead, timestamped to land on time
+//	(MIOCTransition packetListStartingAt:), rather than applied as each part starts: only to the MIOC itself, and
+//	only from where our model of it is now
+- (BOOL)canSendTransitionsAheadFrom:(MIOCTransition *)transition
+{
+	if (!_isOnline || _useInternalMIDIProcessor) return NO;
+	return transition == nil
+		|| (MIOCConnectionSetEqual(&_connections, [transition fromConnectionSet])
+			&& [_velocityProcessorList isEqualToArray:[transition fromVelocityProcessors]]);
+}
+
+// a transition sent ahead has landed: our model of the MIOC follows
+- (void)noteTransitionSent:(MIOCTransition *)transition
+{
+	if (!MIOCConnectionSetEqual(&_connections, [transition fromConnectionSet]))
+		NSLog(@"MIOC model was not where the transition sent ahead starts: taking where it ends");
+	_connections = *[transition toConnectionSet];
+	[_velocityProcessorList setArray:[transition toVelocityProcessors]];
+	_lastSwitchDuration = [transition transmissionTime];
+	NSLog(@"Sent %@ ahead, landed as the part started", transition);
+}
+
+- (NSTimeInterval)lastSwitchDuration
+{
+	return _lastSwitchDuration;
+}
+
+- (void)noteSwitchStartedAt:(UInt64)startHostTime byteCount:(NSUInteger)nBytes
+{
+	_lastSwitchDuration = AudioConvertHostTimeToNanos(AudioGetCurrentHostTime() - startHostTime) * 1e-9 + nBytes / kMIDIBytesPerSecond;
+}
 
-	NSLog(@"Update velocity processors: Remove %lu; Add %lu\n", (unsigned long)[processorsToRemove count], (unsigned long)[processorsToAdd count]);
+// internal processor: what's asked for goes to MIDICore, and the MIOC gets the rest, with the routes that carry
+//	our output on from the delay port. Software switches first, so a route moving from the MIOC is doubled for a
+//	moment rather than missing
+- (BOOL)routeConnections:(NSArray *)connectionList velocityProcessors:(NSArray *)processorList
+{
+	UInt64 startHostTime = AudioGetCurrentHostTime();
+	NSArray *MIOCConnections, *MIOCProcessors;
+	NSUInteger nBytes = 0;
+
+	connectionList = [[connectionList copy] autorelease];	// either may be what we hold now
+	processorList = [[processorList copy] autorelease];
+	[_requestedConnections release];
+	_requestedConnections = [connectionList retain];
+	[_requestedVelocityProcessors release];
+	_requestedVelocityProcessors = [processorList retain];
+
+	[_MIDICore setConnections:connectionList velocityProcessors:processorList
+		  hardwareConnections:&MIOCConnections hardwareVelocityProcessors:&MIOCProcessors];
+	if ([self sendMIOCConnections:MIOCConnections velocityProcessors:MIOCProcessors byteCount:&nBytes] == kSendSysexFailure) {
+		NSLog(@"\n\tFailed to update the MIOC's share of routing (%lu connections, %lu velocity processors).",
+			  (unsigned long)[MIOCConnections count], (unsigned long)[MIOCProcessors count]);
+		return NO;
+	}
+	[self noteSwitchStartedAt:startHostTime byteCount:nBytes];
+	NSLog(@"Update routing: %lu connections, %lu velocity processors; %lu and %lu in software (%lu B, switched in %.1f ms)\n",
+		  (unsigned long)[connectionList count], (unsigned long)[processorList count], (unsigned long)[[_MIDICore connections] count],
+		  (unsigned long)[[_MIDICore velocityProcessors] count], (unsigned long)nBytes, _lastSwitchDuration * 1000.0);
+	return YES;
+}
+
+// the MIOC to exactly these, from our model of it, in one send
+- (BOOL)sendMIOCConnections:(NSArray *)connectionList velocityProcessors:(NSArray *)processorList byteCount:(NSUInteger *)nBytes
+{
+	MIOCTransition *transition = [self transitionFromConnections:[MIOCConnection connectionsInSet:&_connections] velocityProcessors:_velocityProcessorList
+												   toConnections:connectionList velocityProcessors:processorList];
+	if (![transition isEmpty] && [self sendPacketList:[transition packetList]] == kSendMIDIFailure) {
+		return kSendSysexFailure;
+	}
+	_connections = *[transition toConnectionSet];
+	[_velocityProcessorList setArray:processorList];
+	if (nBytes) *nBytes = [transition byteCount];
+	return kSendSysexSuccess;
 }
 
 // filter out active sense and note-offs from all inputs (1-2) that are potentially connected to
@@ -585,6 +784,7 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 - (void)receiveSysexData:(NSData *)data
 {
 	NSData *decoded = [self decodeMessage:data];
+	if (decoded == nil) return;	// logged
 
 	NSString *hexStr = [[NSString alloc] initHexStringWithData:decoded];
 	MIOCMessage *reply = (MIOCMessage *)[decoded bytes];
@@ -635,22 +835,12 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //
 - (BOOL)sendConnect:(MIOCConnection *)aConnection
 {
-	if (_useInternalMIDIProcessor == NO) {
-		return [self sendConnectDisconnectSysex:aConnection withFlag:addProcessorFlag];
-	} else {
-		[_MIDICore connect:aConnection];
-		return kSendSysexSuccess;	// cannot fail
-	}
+	return [self sendConnectDisconnectSysex:aConnection withFlag:addProcessorFlag];
 }
 
 - (BOOL)sendDisconnect:(MIOCConnection *)aConnection
 {
-	if (_useInternalMIDIProcessor == NO) {
-		return [self sendConnectDisconnectSysex:aConnection withFlag:removeProcessorFlag];
-	} else {
-		[_MIDICore disconnect:aConnection];
-		return kSendSysexSuccess;	// cannot fail
-	}
+	return [self sendConnectDisconnectSysex:aConnection withFlag:removeProcessorFlag];
 }
 
 // *********************************************
@@ -673,22 +863,12 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 
 - (BOOL)sendAddVelocityProcessor:(MIOCVelocityProcessor *)aVelProc
 {
-	if (_useInternalMIDIProcessor == NO) {
-		return [self sendAddRemoveVelocityProcessorSysex:aVelProc withFlag:addProcessorFlag];
-	} else {
-		[_MIDICore addVelocityProcessor:aVelProc];
-		return kSendSysexSuccess;	// cannot fail
-	}
+	return [self sendAddRemoveVelocityProcessorSysex:aVelProc withFlag:addProcessorFlag];
 }
 
 - (BOOL)sendRemoveVelocityProcessor:(MIOCVelocityProcessor *)aVelProc
 {
-	if (_useInternalMIDIProcessor == NO) {
-		return [self sendAddRemoveVelocityProcessorSysex:aVelProc withFlag:removeProcessorFlag];
-	} else {
-		[_MIDICore removeVelocityProcessor:aVelProc];
-		return kSendSysexSuccess;	// cannot fail
-	}
+	return [self sendAddRemoveVelocityProcessorSysex:aVelProc withFlag:removeProcessorFlag];
 }
 
 - (BOOL)sendAddRemoveVelocityProcessorSysex:(MIOCVelocityProcessor *)aVelProc withFlag:(Byte *)flagPtr
@@ -704,20 +884,12 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //  general method to send sysex messages
 - (BOOL)sendAddProcessor:(id <MIOCProcessor>)aProc
 {
-	if (_useInternalMIDIProcessor == NO) {
-		return [self sendAddRemoveProcessorSysex:aProc withFlag:addProcessorFlag];
-	} else {
-		return kSendSysexSuccess;
-	}
+	return [self sendAddRemoveProcessorSysex:aProc withFlag:addProcessorFlag];
 }
 
 - (BOOL)sendRemoveProcessor:(id <MIOCProcessor>)aProc
 {
-	if (_useInternalMIDIProcessor == NO) {
-		return [self sendAddRemoveProcessorSysex:aProc withFlag:removeProcessorFlag];
-	} else {
-		return kSendSysexSuccess;
-	}
+	return [self sendAddRemoveProcessorSysex:aProc withFlag:removeProcessorFlag];
 }
 
 - (BOOL)sendAddRemoveProcessorSysex:(id <MIOCProcessor>)aProc withFlag:(Byte *)flagPtr
@@ -730,32 +902,78 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 }
 
 // *********************************************
-//  general method to compose sysex message
-- (NSData *)sysexMessageForProcessor:(id <MIOCProcessor>)aProc withFlag:(Byte *)flagPtr
+//  packed sends: one packet list for many messages. The MIOC takes one processor per add/remove message and
+//	gives no acknowledgement, so the way to go faster is to hand the driver everything at once; the window
+//	keeps the queue ahead of the cable short, so a later switch (or a stop) isn't stuck behind a long one
++ (NSData *)packetListForSysexMessages:(NSArray *)messages
 {
-	NSMutableData *message = [NSMutableData dataWithCapacity:0];
-
-	// preamble
-	[message appendBytes:sysexStart length:sizeof(sysexStart)];		// sysex start
-	[message appendBytes:MIDITEMPID length:sizeof(MIDITEMPID)];		// manufacturer-ID
-	[message appendBytes:&_deviceID length:1];						// device ID (address)
-	[message appendBytes:&_deviceType length:1];					// device Type
-	[message appendBytes:encodedMode length:sizeof(encodedMode)];	// Mode (data are encoded)
-	[message appendBytes:addRemoveProcessorOpcode length:sizeof(addRemoveProcessorOpcode)];	// opcode
+	// MIDIPacketListAdd starts each packet on a 4-byte boundary on arm64: allow for the padding
+	ByteCount listSize = offsetof(MIDIPacketList, packet);
+	for (NSData *message in messages)
+		listSize += (offsetof(MIDIPacket, data) + [message length] + 3) & ~(ByteCount)3;
+	NSMutableData *packetList = [NSMutableData dataWithLength:(listSize > sizeof(MIDIPacketList)) ? listSize : sizeof(MIDIPacketList)];
+	MIDIPacketList *pktlist = (MIDIPacketList *)[packetList mutableBytes];
+	MIDIPacket *packet = MIDIPacketListInit(pktlist);
+	NSUInteger queued = 0;
+
+	for (NSData *message in messages) {
+		queued += [message length];
+		// held back until the bytes ahead of it, less a window, have gone out on the cable
+		MIDITimeStamp offset = 0;
+		if (queued > kMIOCSendWindowBytes)
+			offset = AudioConvertNanosToHostTime((UInt64)((queued - kMIOCSendWindowBytes) / kMIDIBytesPerSecond * 1e9));
+		packet = MIDIPacketListAdd(pktlist, [packetList length], packet, offset, [message length], [message bytes]);
+		if (packet == NULL) {
+			NSLog(@"MIOC packet list overflow: %lu messages not sent", (unsigned long)[messages count]);
+			return nil;
+		}
+	}
+	return [NSData dataWithData:packetList];
+}
 
-	// encoded portion of message
-	NSMutableData *toEncode = [NSMutableData dataWithCapacity:0];
-	[toEncode appendBytes:flagPtr length:1];						// *add/remove flag
-	NSData *processorData = [aProc MIDIBytes];					// processor data
-	[toEncode appendData:processorData];
-	NSData *encodedPortion = [self encode87:toEncode];			// encode it
-	[message appendData:encodedPortion];
+- (BOOL)sendPacketList:(NSData *)packetList
+{
+	if (packetList == nil) return kSendMIDIFailure;
+	NSMutableData *toSend = [packetList mutableCopy];
+	MIDIPacketList *pktlist = (MIDIPacketList *)[toSend mutableBytes];
+	MIDITimeStamp now = AudioGetCurrentHostTime();
+	MIDIPacket *packet = &pktlist->packet[0];
+
+	for (UInt32 i = 0; i < pktlist->numPackets; i++) {
+		if (packet->timeStamp != 0)
+			packet->timeStamp += now;
+		packet = MIDIPacketNext(packet);
+	}
+	BOOL success = [_MIDILink sendMIDIPacketList:toSend];
+	[toSend release];
+	return success;
+}
 
-	// checksum and termination
-	message = [self addChecksum:message];
-	[message appendBytes:sysexEnd length:sizeof(sysexEnd)];
+- (BOOL)sendSysexMessages:(NSArray *)messages byteCount:(NSUInteger *)nBytes
+{
+	*nBytes = 0;
+	for (NSData *message in messages) {
+		*nBytes += [message length];
+		if (kLogMIOCMessages) [self logMIOCMessage:message];
+	}
+	if ([messages count] == 0) return kSendSysexSuccess;
+	return [self sendPacketList:[MIOCModel packetListForSysexMessages:messages]];
+}
 
-	return message;
+// *********************************************
+//  general method to compose sysex message
+//		built in place (MIOCSysex.h) then copied once: a switch composes hundreds of these
+- (NSData *)sysexMessageForProcessor:(id <MIOCProcessor>)aProc withFlag:(Byte *)flagPtr
+{
+	Byte	toEncode[kMIOCSysexMaxData], message[kMIOCSysexMaxMessage];
+	NSData	*processorData = [aProc MIDIBytes];
+
+	NSAssert1(([processorData length] < kMIOCSysexMaxData), @"MIOCModel: processor too long to send: %@", processorData);
+	toEncode[0] = *flagPtr;											// add/remove flag
+	[processorData getBytes:toEncode + 1 length:[processorData length]];	// processor data
+	uint32_t length = MIOCSysexCompose(message, _deviceID, _deviceType, kModeEncodedMask, kMIOCAddRemoveMIDIProcessorOpcode,
+									   toEncode, 1 + (uint32_t)[processorData length]);
+	return [NSData dataWithBytes:message length:length];
 }
 
 // *********************************************
@@ -764,27 +982,13 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 // [e.g.] (00,20,...,01,01) = 0xD9, 2th-complement (negated value) is 0x27.
 //	0xD9 + 0x27 = 0x100 (lower 7 bits have to be 0)"
 // [query in regards to: f0 00 20 0d 00 20 40 04 06 40 00 00 00 00 01 01 ?? F7
+//	Composing and decoding sum as they go (MIOCSysex.h); these are for messages put together by hand.
 
 - (NSMutableData *)addChecksum:(NSMutableData *)message
 {
-	Byte		*p, *end, checksumByte;
-	unsigned	checksum = 0;
-
-	p	= (Byte *)[message bytes];
-	end = p + [message length] - 1;	// ***don't forget the -1 (took me 10mins to figure out why checksum was variable)
-	// printf("length = %d\n", [message length]);
-	p++;							// skip the initial F0
+	Byte checksumByte = MIOCSysexChecksum((const uint8_t *)[message bytes] + 1, (uint32_t)[message length] - 1);	// skip the initial F0
 
-	while (p <= end) {
-		// printf("%x -> ", *p);
-		checksum += *p++;
-		// printf("%x\n", checksum);
-	}
-
-	checksum		= 0x100 - checksum;			// 2's complement negation
-	checksumByte	= (Byte)(checksum & 0x7f);	// msb must be zero
 	[message appendBytes:&checksumByte length:1];
-	// NSLog(@"\n\tmessage: %@\n\tchecksum %x @ %p (%x)", message, checksumByte, &checksumByte, checksum);
 	return message;
 }
 
@@ -793,26 +997,15 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //		we receive an encoded message, with checksum and F7 at the end
 - (BOOL)verifyChecksum:(NSData *)message
 {
-	Byte		*p, *end, actualChecksumByte, calcChecksumByte;
-	unsigned	checksum = 0;
-
-	p	= (Byte *)[message bytes];
-	end = p + [message length] - 1;	// ***don't forget the -1 (took me 10mins to figure out why checksum was variable)
-	end = end - 2;					// ***don't include the actual checksum, or the ending F7
-	p++;							// skip the initial F0
-
-	while (p <= end) {
-		// printf("%x -> ", *p);
-		checksum += *p++;
-		// printf("%x\n", checksum);
-	}
+	const Byte	*p = (const Byte *)[message bytes];
+	NSUInteger	length = [message length];
 
-	checksum			= 0x100 - checksum;			// 2's complement negation
-	calcChecksumByte	= (Byte)(checksum & 0x7f);	// msb must be zero
-	actualChecksumByte	= *p;
+	if (length < 3) return NO;
+	Byte calcChecksumByte	= MIOCSysexChecksum(p + 1, (uint32_t)length - 3);	// not F0, the checksum, or the ending F7
+	Byte actualChecksumByte	= p[length - 2];
 
 	BOOL isChecksumOK = (calcChecksumByte == actualChecksumByte);
-	NSAssert((isChecksumOK == YES), @"MIOCModel verifyChecksum Checksum error: calc=%d, actual = %d, message = %@",
+	if (!isChecksumOK) NSLog(@"MIOCModel verifyChecksum Checksum error: calc=%d, actual = %d, message = %@",
 		calcChecksumByte, actualChecksumByte, message);
 
 	return isChecksumOK;
@@ -822,51 +1015,12 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //
 - (NSData *)encode87:(NSData *)sourceData
 {
-	Byte			msbByte, thisByte, encodedLength = 0;
-	Byte			*source, *end, *blockEnd, *sp;
-	unsigned long	inputLength, blockIdx;
-	NSRange firstByte = NSMakeRange(0, 1);
-
-	inputLength = [sourceData length];
-	source		= (Byte *)[sourceData bytes];
-
-	NSMutableData *encodedData = [NSMutableData dataWithCapacity:0];
-	[encodedData appendBytes:&encodedLength length:1];	// placeholder for length, overwritten later
-
-	end = source + inputLength - 1;						// points to last byte of source
-
-	while (source <= end) {
-		blockEnd = source + 6;	// grab 7 byte chunks
-
-		if (blockEnd > end) {
-			blockEnd = end;					// handle short final block
-		}
-
-		blockIdx	= 1;
-		msbByte		= 0;
-		sp			= source;
-
-		// collect the msbits from bytes in this block
-		while (sp <= blockEnd) {
-			msbByte += (*sp & 0x80) >> blockIdx;// shift msb according to byte position
-			sp++;
-			blockIdx++;
-		}
-
-		// save msbByte and truncated data bytes
-		[encodedData appendBytes:&msbByte length:1];
+	Byte		encoded[1 + kMIOCSysexMaxEncoded];
+	uint32_t	length = (uint32_t)[sourceData length];
 
-		while (source <= blockEnd) {
-			thisByte = *source++ & 0x7F;// mask msb
-			[encodedData appendBytes:&thisByte length:1];
-		}
-	}
-
-	// fill in the length (first byte)
-	encodedLength = [encodedData length] - 2;	// length should be length of encoded -1, and another -1 for the length byte itself
-	[encodedData replaceBytesInRange:firstByte withBytes:&encodedLength];
-
-	return [NSData dataWithData:encodedData];	// return unmutable
+	NSAssert1((length <= kMIOCSysexMaxData), @"MIOCModel encode87: more than one packet: %@", sourceData);
+	length = MIOCSysexEncode87((const uint8_t *)[sourceData bytes], length, encoded, NULL);
+	return [NSData dataWithBytes:encoded length:length];
 }
 
 // *********************************************
@@ -874,34 +1028,13 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //  thus, it'll ignore checksum and sysexterminator which may be present
 - (NSData *)decode87:(NSData *)sourceData
 {
-	Byte			count, msbByte, thisByte;
-	Byte			*source, *end, *blockEnd;
-	NSMutableData	*decodedData = [NSMutableData dataWithCapacity:0];
+	Byte	decoded[kMIOCSysexMaxEncoded];
+	int32_t	length = 0;
 
-	source	= (Byte *)[sourceData bytes];
-	count	= (*source++);
-
-	end = source + count;		// last byte to be decoded
-
-	// decode blocks of 8 bytes. Final block may be shorter
-	// idea, keep first byte, shift left, and w/ 0x80 and add to next
-	// repeat 7 times, then get next 'first byte'
-	while (source <= end) {
-		msbByte		= *source;
-		blockEnd	= source + 7;				// last byte in block
-
-		if (blockEnd > end) {
-			blockEnd = end;						// handle short final block
-		}
-
-		while (++source <= blockEnd) {
-			msbByte		= msbByte << 1;
-			thisByte	= *source + (msbByte & 0x80);
-			[decodedData appendBytes:&thisByte length:1];
-		}
-	}
-
-	return [NSData dataWithData:decodedData];
+	if ([sourceData length] > 0 && *(const Byte *)[sourceData bytes] < kMIOCSysexMaxEncoded)
+		length = MIOCSysexDecode87((const uint8_t *)[sourceData bytes], (uint32_t)[sourceData length], decoded, NULL);
+	if (length < 0) length = 0;	// short: nothing
+	return [NSData dataWithBytes:decoded length:length];
 }
 
 // *********************************************
@@ -909,39 +1042,30 @@ static Byte removeProcessorFlag[1]		= {kMIOCRemoveMIDIProcessorFlag};
 //  basic format: F0 00 20 0d <ID> 20 <mode> opcode <data> f7
 //  data may or may not be encoded, depending on bit 6 of mode
 //		40 -> encoded, 00 -> not
+//	Encoded, it comes back as preamble then decoded data (no checksum or F7), checked and
+//	decoded in one pass; nil if it doesn't check.
 
 - (NSData *)decodeMessage:(NSData *)sourceData
 {
-	MIOCMessage *message;
-	size_t		dataLength;
-	NSRange		dataRange, preambleRange;
-
-	message = (MIOCMessage *)[sourceData bytes];	// ***consider removing the initial F0
+	if ([sourceData length] < kPreambleLength) return sourceData;
+	MIOCMessage *message = (MIOCMessage *)[sourceData bytes];	// ***consider removing the initial F0
 
 	// check if data are encoded
-	if (message->mode & kModeEncodedMask) {
-		BOOL isChecksumOK = [self verifyChecksum:sourceData];
-
-		if (isChecksumOK == YES) {
-			dataLength			= [sourceData length] - kPreambleLength;
-			dataRange.location	= kPreambleLength;
-			dataRange.length	= dataLength;
-			NSData	*encodedData	= [sourceData subdataWithRange:dataRange];
-			NSData	*decodedData	= [self decode87:encodedData];
-			preambleRange.location	= 0;
-			preambleRange.length	= kPreambleLength;
-			NSData *preambleData = [sourceData subdataWithRange:preambleRange];
-			// reassemble
-			NSMutableData *temp = [NSMutableData dataWithData:preambleData];
-			[temp appendData:decodedData];
-			sourceData = [NSData dataWithData:temp];
-		} else {
-			NSLog(@"Bad checksum!");
-			sourceData = nil;
-		}
+	if (!(message->mode & kModeEncodedMask)) return sourceData;
+
+	MIOCSysexMessage parsed;
+	MIOCSysexStatus status = MIOCSysexParse((const uint8_t *)[sourceData bytes], (uint32_t)[sourceData length], &parsed);
+	if (status == kMIOCSysexNotMIDITEMP) return sourceData;	// not ours to decode
+	if (status != kMIOCSysexOK) {
+		NSLog(@"%@ (%@)", (status == kMIOCSysexBadChecksum) ? @"Bad checksum!" : @"Bad framing!", sourceData);
+		return nil;
 	}
 
-	return sourceData;
+	// reassemble
+	Byte decoded[kPreambleLength + kMIOCSysexMaxEncoded];
+	memcpy(decoded, [sourceData bytes], kPreambleLength);
+	memcpy(decoded + kPreambleLength, parsed.data, parsed.dataLength);
+	return [NSData dataWithBytes:decoded length:kPreambleLength + parsed.dataLength];
 }
 
 @end
@@ -0,0 +1,524 @@
+//
+//  MIOCSimulator.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "MIOCSimulator.h"
+#include "MIOCSysex.h"
+#include "MIOCVelocityMap.h"
+#include <stdlib.h>
+#include <string.h>
+
+// opcodes and processor types, as MIOCMessage.h
+#define kOpcodeAddRemoveProcessor	0x04
+#define kOpcodePortNamesRequest		0x42
+#define kOpcodePortNamesResponse	0x02
+#define kOpcodeDeviceNameRequest	0x45
+#define kOpcodeDeviceNameResponse	0x05
+#define kOpcodePortAddressAll		0x78
+#define kOpcodePortAddressOne		0x79
+#define kOpcodePortAddressResponse	0x38
+#define kOpcodeSetResponsePort		0x3A
+#define kOpcodeAcknowledge			0x7F
+#define kOpcodeCancel				0x7D
+#define kAddProcessorFlag			0x80
+
+#define kTypeRouting				0x00
+#define kTypeNoteOffFilterIn		0x08
+#define kTypeNoteOffFilterOut		0x09
+#define kTypeActiveSenseFilterIn	0x1A
+#define kTypeActiveSenseFilterOut	0x1B
+#define kTypeVelocityIn				0x24
+#define kTypeVelocityOut			0x25
+#define kAnyChannel					0x80	// routing: omni in, same as input out
+
+#define kNoteOnVelocityOmni			0x10	// velocity processor channel byte: note-on, omni
+#define kVelocityMaxPosition		8
+
+typedef struct {
+	uint8_t		bytes[kMIOCSimMaxProcessorLength];
+	uint8_t		length;
+} Processor;
+
+typedef struct {
+	uint8_t		outPort;
+	uint8_t		outChannel;	// or kAnyChannel
+} Route;
+
+// velocity processor, as applied
+typedef struct {
+	uint8_t		position;
+	uint8_t		channel;	// 0-15, or kAnyChannel
+	MIOCVelocityCurve	curve;
+} VelocityMap;
+
+// one input's parser
+typedef struct {
+	uint8_t		runningStatus;
+	uint8_t		message[3];
+	uint8_t		have;
+	uint8_t		need;
+	bool		inSysex;
+	bool		sysexOverflow;
+	uint32_t	sysexLength;
+	uint8_t		sysex[kMIOCSimMaxSysex];
+} Parser;
+
+// 17 lists a port: channels 0-15 (routes for that channel and omni) and 16 (omni only, for system messages)
+#define kRouteLists		17
+
+struct MIOCSimulator {
+	MIOCSimConfig		config;
+	MIOCSimOutputProc	outputProc;
+	void				*refCon;
+
+	Processor			processors[kMIOCSimMaxProcessors];
+	uint32_t			nProcessors;
+
+	// compiled from processors after each change
+	uint16_t			routeStart[kMIOCSimPorts][kRouteLists + 1];
+	Route				routes[kRouteLists * kMIOCSimMaxProcessors];	// an omni route is in all of its port's lists
+	uint32_t			noteOffFilter[2][kMIOCSimPorts];	// [in, out]: bit n: channel n, bit 16: omni
+	bool				activeSenseFilter[2][kMIOCSimPorts];
+	VelocityMap			velocity[2][kMIOCSimPorts][kVelocityMaxPosition * 2];
+	uint8_t				nVelocity[2][kMIOCSimPorts];
+
+	Parser				parsers[kMIOCSimPorts];
+	uint8_t				responsePort;
+	int64_t				outputFree_ns[kMIOCSimPorts];
+	MIOCSimCounts		counts;
+};
+
+// data bytes after a status byte
+static uint8_t dataLength(uint8_t status)
+{
+	switch (status & 0xF0) {
+		case 0xC0: case 0xD0: return 1;
+		case 0xF0:
+			switch (status) {
+				case 0xF1: case 0xF3: return 1;
+				case 0xF2: return 2;
+				default: return 0;
+			}
+		default: return 2;
+	}
+}
+
+// length of a processor of a type, as the spec lists them; 0: not usable in an add/remove message
+static uint8_t processorLength(uint8_t type)
+{
+	switch (type) {
+		case 0x00: return 5;
+		case 0x02: case 0x03: case 0x04: case 0x05: case 0x08: case 0x09: return 3;
+		case 0x0A: case 0x0B: case 0x0C: case 0x0D: case 0x0E: case 0x0F: case 0x10: case 0x11:
+		case 0x16: case 0x17: case 0x20: case 0x21: case 0x28: case 0x2A: case 0x63: case 0x69: case 0x70: return 4;
+		case 0x18: case 0x19: case 0x1A: case 0x1B: case 0x1C: case 0x1D: case 0x1E: case 0x1F: return 2;
+		case 0x22: return 7;
+		case 0x24: case 0x25: return 8;
+		case 0x26: case 0x27: return 5;
+		case 0x2C: case 0x2D: case 0x61: return 6;
+		default: return 0;
+	}
+}
+
+// filter channel byte: 00 omni, 8N channel N
+static uint32_t filterChannels(uint8_t channel)
+{
+	return (channel & 0x80) ? (1u << (channel & 0x0F)) : (1u << 16);
+}
+
+static void compileProcessors(MIOCSimulator *simulator)
+{
+	uint16_t counts[kMIOCSimPorts][kRouteLists];
+	memset(counts, 0, sizeof(counts));
+	memset(simulator->noteOffFilter, 0, sizeof(simulator->noteOffFilter));
+	memset(simulator->activeSenseFilter, 0, sizeof(simulator->activeSenseFilter));
+	memset(simulator->nVelocity, 0, sizeof(simulator->nVelocity));
+	simulator->counts.routes = 0;
+
+	for (uint32_t i = 0; i < simulator->nProcessors; i++) {
+		const uint8_t *p = simulator->processors[i].bytes;
+		uint8_t port = p[1];
+		switch (p[0]) {
+			case kTypeRouting:
+				simulator->counts.routes++;
+				if (p[2] == kAnyChannel) {
+					for (unsigned c = 0; c < kRouteLists; c++) counts[port][c]++;
+				} else
+					counts[port][p[2]]++;
+				break;
+			case kTypeNoteOffFilterIn: case kTypeNoteOffFilterOut:
+				simulator->noteOffFilter[p[0] & 1][port] |= filterChannels(p[2]);
+				break;
+			case kTypeActiveSenseFilterIn: case kTypeActiveSenseFilterOut:
+				simulator->activeSenseFilter[p[0] & 1][port] = true;
+				break;
+			case kTypeVelocityIn: case kTypeVelocityOut: {
+				unsigned io = p[0] & 1;
+				if ((p[2] & 0x70) != kNoteOnVelocityOmni) break;	// note-off or polypressure maps: unused
+				if (simulator->nVelocity[io][port] >= kVelocityMaxPosition * 2) break;
+				VelocityMap map = { p[3], (p[2] & 0x80) ? (p[2] & 0x0F) : kAnyChannel, MIOCVelocityCurveFromProcessor(p) };
+				// in position order, stable
+				VelocityMap *maps = simulator->velocity[io][port];
+				unsigned k = simulator->nVelocity[io][port]++;
+				while (k > 0 && maps[k - 1].position > map.position) {
+					maps[k] = maps[k - 1];
+					k--;
+				}
+				maps[k] = map;
+				break;
+			}
+			default:
+				break;
+		}
+	}
+
+	uint32_t start = 0;
+	for (unsigned port = 0; port < kMIOCSimPorts; port++) {
+		for (unsigned c = 0; c < kRouteLists; c++) {
+			simulator->routeStart[port][c] = (uint16_t) start;
+			start += counts[port][c];
+			counts[port][c] = 0;
+		}
+		simulator->routeStart[port][kRouteLists] = (uint16_t) start;
+	}
+	for (uint32_t i = 0; i < simulator->nProcessors; i++) {
+		const uint8_t *p = simulator->processors[i].bytes;
+		if (p[0] != kTypeRouting) continue;
+		Route route = { p[3], p[4] };
+		uint8_t port = p[1];
+		unsigned first = (p[2] == kAnyChannel) ? 0 : p[2], last = (p[2] == kAnyChannel) ? kRouteLists - 1 : p[2];
+		for (unsigned c = first; c <= last; c++)
+			simulator->routes[simulator->routeStart[port][c] + counts[port][c]++] = route;
+	}
+}
+
+static void emit(MIOCSimulator *simulator, uint8_t port, const uint8_t *bytes, uint32_t length, int64_t time_ns)
+{
+	int64_t departure_ns = time_ns + simulator->config.hopLatency_ns;
+	if (simulator->config.serialOutputs) {
+		if (departure_ns < simulator->outputFree_ns[port]) departure_ns = simulator->outputFree_ns[port];
+		simulator->outputFree_ns[port] = departure_ns + (int64_t) length * kMIOCSimByte_ns;
+	}
+	simulator->counts.messagesOut++;
+	simulator->outputProc(port, bytes, length, departure_ns, simulator->refCon);
+}
+
+static void reply(MIOCSimulator *simulator, uint8_t inPort, uint8_t deviceID, uint8_t deviceType, uint8_t mode, uint8_t opcode,
+				  const uint8_t *data, uint32_t n, int64_t time_ns)
+{
+	uint8_t message[kMIOCSysexMaxMessage];
+	uint32_t length = MIOCSysexCompose(message, deviceID, deviceType, mode, opcode, data, n);
+	uint8_t port = (simulator->responsePort < kMIOCSimPorts) ? simulator->responsePort : inPort;
+	emit(simulator, port, message, length, time_ns);
+}
+
+static void handshake(MIOCSimulator *simulator, uint8_t inPort, const MIOCSysexMessage *message, uint8_t opcode, int64_t time_ns)
+{
+	if (opcode == kOpcodeAcknowledge) simulator->counts.acks++;
+	else simulator->counts.cancels++;
+	reply(simulator, inPort, message->deviceID, message->deviceType, 0x00, opcode, NULL, 0, time_ns);
+}
+
+static bool addRemoveProcessor(MIOCSimulator *simulator, const uint8_t *data, uint32_t n, int64_t time_ns)
+{
+	if (n < 3) return false;
+	const uint8_t *processor = data + 1;
+	uint8_t length = processorLength(processor[0]);
+	if (length == 0 || length > kMIOCSimMaxProcessorLength || n - 1 != length || processor[1] >= kMIOCSimPorts) return false;
+	if ((processor[0] == kTypeVelocityIn || processor[0] == kTypeVelocityOut) && processor[3] >= kVelocityMaxPosition) return false;
+	if (processor[0] == kTypeRouting
+		&& (processor[3] >= kMIOCSimPorts || (processor[2] != kAnyChannel && processor[2] > 15) || (processor[4] != kAnyChannel && processor[4] > 15)))
+		return false;
+
+	if (data[0] & kAddProcessorFlag) {
+		if (simulator->nProcessors == kMIOCSimMaxProcessors) return false;
+		Processor *added = &simulator->processors[simulator->nProcessors++];
+		memcpy(added->bytes, processor, length);
+		added->length = length;
+		simulator->counts.processorsAdded++;
+	} else {
+		uint32_t i;
+		for (i = 0; i < simulator->nProcessors; i++) {
+			if (simulator->processors[i].length == length && memcmp(simulator->processors[i].bytes, processor, length) == 0) break;
+		}
+		if (i == simulator->nProcessors) {
+			simulator->counts.removeMisses++;
+			return true;	// nothing to do is not an error
+		}
+		memmove(&simulator->processors[i], &simulator->processors[i + 1], (simulator->nProcessors - i - 1) * sizeof(Processor));
+		simulator->nProcessors--;
+		simulator->counts.processorsRemoved++;
+	}
+	simulator->counts.processors = simulator->nProcessors;
+	simulator->counts.lastChange_ns = time_ns;
+	compileProcessors(simulator);
+	return true;
+}
+
+static void evaluateSysex(MIOCSimulator *simulator, uint8_t inPort, const MIOCSysexMessage *message, int64_t time_ns)
+{
+	const MIOCSimConfig *config = &simulator->config;
+	bool ok = true;
+	simulator->counts.sysexEvaluated++;
+
+	switch (message->opcode) {
+		case kOpcodeAddRemoveProcessor:
+			ok = addRemoveProcessor(simulator, message->data, message->dataLength, time_ns);
+			break;
+		case kOpcodeDeviceNameRequest: {
+			uint8_t name[9];
+			name[0] = (uint8_t) config->prefix;
+			memcpy(name + 1, config->name, 8);
+			reply(simulator, inPort, config->deviceID, config->deviceType, 0x00, kOpcodeDeviceNameResponse, name, sizeof(name), time_ns);
+			return;	// no ACK needed for a request
+		}
+		case kOpcodePortNamesRequest:
+			reply(simulator, inPort, config->deviceID, config->deviceType, 0x00, kOpcodePortNamesResponse,
+				  (const uint8_t *) config->portNames, sizeof(config->portNames), time_ns);
+			return;
+		case kOpcodePortAddressAll:
+		case kOpcodePortAddressOne: {
+			// on the output(s) themselves, so the inquirer learns which it is connected to
+			uint8_t response[kMIOCSysexMaxMessage];
+			for (uint8_t out = 0; out < kMIOCSimPorts; out++) {
+				if (message->opcode == kOpcodePortAddressOne && (message->dataLength < 1 || message->data[0] != out)) continue;
+				uint8_t data[2] = { out, inPort };
+				uint32_t length = MIOCSysexCompose(response, config->deviceID, config->deviceType, 0x00, kOpcodePortAddressResponse, data, 2);
+				emit(simulator, out, response, length, time_ns);
+			}
+			return;
+		}
+		case kOpcodeSetResponsePort:
+			if (message->dataLength < 1) ok = false;
+			else simulator->responsePort = (message->data[0] < kMIOCSimPorts) ? message->data[0] : kMIOCSimNoResponsePort;
+			break;
+		case kOpcodeAcknowledge:
+		case kOpcodeCancel:
+			return;		// we never wait for either
+		default:
+			ok = false;
+			break;
+	}
+
+	if (!ok)
+		handshake(simulator, inPort, message, kOpcodeCancel, time_ns);
+	else if (message->mode & kMIOCSysexModeHandshake)
+		handshake(simulator, inPort, message, kOpcodeAcknowledge, time_ns);
+}
+
+static void receiveSysex(MIOCSimulator *simulator, uint8_t inPort, const uint8_t *sysex, uint32_t length, int64_t time_ns)
+{
+	MIOCSysexMessage message;
+	MIOCSysexStatus status = MIOCSysexParse(sysex, length, &message);
+	if (status == kMIOCSysexNotMIDITEMP) {
+		// someone else's (an identity request, say): routed as any system message
+		const Route *route = &simulator->routes[simulator->routeStart[inPort][kRouteLists - 1]];
+		const Route *end = &simulator->routes[simulator->routeStart[inPort][kRouteLists]];
+		for (; route < end; route++)
+			emit(simulator, route->outPort, sysex, length, time_ns);
+		return;
+	}
+	if (length >= 5 && sysex[4] != simulator->config.deviceID && sysex[4] != kMIOCSysexAllDevices) return;	// another device's
+	if (status != kMIOCSysexOK) {
+		if (status == kMIOCSysexBadChecksum) simulator->counts.checksumErrors++;
+		simulator->counts.sysexEvaluated++;
+		uint8_t cancel[kMIOCSysexMaxMessage];
+		uint32_t n = MIOCSysexCompose(cancel, (length > 5) ? sysex[4] : 0, (length > 5) ? sysex[5] : 0, 0x00, kOpcodeCancel, NULL, 0);
+		simulator->counts.cancels++;
+		emit(simulator, (simulator->responsePort < kMIOCSimPorts) ? simulator->responsePort : inPort, cancel, n, time_ns);
+		return;
+	}
+	evaluateSysex(simulator, inPort, &message, time_ns);
+}
+
+// a channel message through input processing, the routing, and each output's processing
+static void routeChannelMessage(MIOCSimulator *simulator, uint8_t inPort, const uint8_t *message, uint8_t length, int64_t time_ns)
+{
+	uint8_t status = message[0] & 0xF0, channel = message[0] & 0x0F;
+	bool noteOff = (status == 0x80) || (status == 0x90 && message[2] == 0);
+	bool noteOn = (status == 0x90 && message[2] != 0);
+
+	if (noteOff && (simulator->noteOffFilter[0][inPort] & ((1u << channel) | (1u << 16)))) {
+		simulator->counts.filtered++;
+		return;
+	}
+	uint8_t velocity = noteOn ? message[2] : 0;
+	for (unsigned k = 0; noteOn && k < simulator->nVelocity[0][inPort]; k++) {
+		const VelocityMap *map = &simulator->velocity[0][inPort][k];
+		if (map->channel == kAnyChannel || map->channel == channel) velocity = MIOCVelocityCurveMap(&map->curve, velocity);
+	}
+
+	const Route *route = &simulator->routes[simulator->routeStart[inPort][channel]];
+	const Route *end = &simulator->routes[simulator->routeStart[inPort][channel + 1]];
+	for (; route < end; route++) {
+		uint8_t outChannel = (route->outChannel == kAnyChannel) ? channel : route->outChannel;
+		uint8_t out[3] = { (uint8_t)(status | outChannel), message[1], message[2] };
+		if (noteOff && (simulator->noteOffFilter[1][route->outPort] & ((1u << outChannel) | (1u << 16)))) {
+			simulator->counts.filtered++;
+			continue;
+		}
+		if (noteOn) {
+			out[2] = velocity;
+			for (unsigned k = 0; k < simulator->nVelocity[1][route->outPort]; k++) {
+				const VelocityMap *map = &simulator->velocity[1][route->outPort][k];
+				if (map->channel == kAnyChannel || map->channel == outChannel) out[2] = MIOCVelocityCurveMap(&map->curve, out[2]);
+			}
+		}
+		emit(simulator, route->outPort, out, length, time_ns);
+	}
+}
+
+// system common and realtime: through omni routes only
+static void routeSystemMessage(MIOCSimulator *simulator, uint8_t inPort, const uint8_t *message, uint8_t length, int64_t time_ns)
+{
+	bool activeSense = (message[0] == 0xFE);
+	if (activeSense && simulator->activeSenseFilter[0][inPort]) {
+		simulator->counts.filtered++;
+		return;
+	}
+	const Route *route = &simulator->routes[simulator->routeStart[inPort][kRouteLists - 1]];
+	const Route *end = &simulator->routes[simulator->routeStart[inPort][kRouteLists]];
+	for (; route < end; route++) {
+		if (activeSense && simulator->activeSenseFilter[1][route->outPort]) {
+			simulator->counts.filtered++;
+			continue;
+		}
+		emit(simulator, route->outPort, message, length, time_ns);
+	}
+}
+
+void MIOCSimDefaultConfig(MIOCSimConfig *config)
+{
+	memset(config, 0, sizeof(MIOCSimConfig));
+	config->deviceID		= 0x00;
+	config->deviceType		= 0x20;
+	config->prefix			= 'A';
+	memcpy(config->name, "MIOC SIM", 8);
+	for (unsigned port = 0; port < kMIOCSimPorts; port++) {
+		char name[16];
+		memset(name, ' ', sizeof(name));
+		name[0] = 'I'; name[1] = 'N'; name[3] = (char)('1' + port);
+		memcpy(config->portNames[2 * port], name, 8);
+		name[0] = 'O'; name[1] = 'U'; name[2] = 'T'; name[3] = (char)('1' + port);
+		memcpy(config->portNames[2 * port + 1], name, 8);
+	}
+	config->hopLatency_ns	= kMIOCSimHopLatency_ns;
+	config->serialOutputs	= false;
+}
+
+MIOCSimulator *MIOCSimCreate(const MIOCSimConfig *config, MIOCSimOutputProc outputProc, void *refCon)
+{
+	MIOCSimulator *simulator = calloc(1, sizeof(MIOCSimulator));
+	if (simulator == NULL) return NULL;
+	simulator->config		= *config;
+	simulator->outputProc	= outputProc;
+	simulator->refCon		= refCon;
+	MIOCSimReset(simulator);
+	return simulator;
+}
+
+void MIOCSimDestroy(MIOCSimulator *simulator)
+{
+	free(simulator);
+}
+
+void MIOCSimReset(MIOCSimulator *simulator)
+{
+	simulator->nProcessors = 0;
+	memset(simulator->parsers, 0, sizeof(simulator->parsers));
+	memset(simulator->outputFree_ns, 0, sizeof(simulator->outputFree_ns));
+	memset(&simulator->counts, 0, sizeof(simulator->counts));
+	simulator->responsePort = kMIOCSimNoResponsePort;
+	compileProcessors(simulator);
+}
+
+void MIOCSimReceive(MIOCSimulator *simulator, uint8_t port, const uint8_t *bytes, uint32_t n, int64_t time_ns)
+{
+	if (port >= kMIOCSimPorts) return;
+	Parser *parser = &simulator->parsers[port];
+	simulator->counts.bytesIn += n;
+
+	for (uint32_t i = 0; i < n; i++) {
+		uint8_t byte = bytes[i];
+
+		if (byte >= 0xF8) {	// realtime: anywhere, even inside sysex
+			simulator->counts.messagesIn++;
+			routeSystemMessage(simulator, port, &byte, 1, time_ns);
+			continue;
+		}
+		if (parser->inSysex) {
+			if (byte == 0xF7 || byte & 0x80) {
+				parser->inSysex = false;
+				if (byte == 0xF7 && !parser->sysexOverflow) {
+					parser->sysex[parser->sysexLength++] = 0xF7;
+					simulator->counts.messagesIn++;
+					receiveSysex(simulator, port, parser->sysex, parser->sysexLength, time_ns);
+				}
+				if (byte == 0xF7) continue;
+				// any other status ends it unfinished, and is taken below
+			} else {
+				if (parser->sysexLength < kMIOCSimMaxSysex - 1) parser->sysex[parser->sysexLength++] = byte;
+				else parser->sysexOverflow = true;
+				continue;
+			}
+		}
+
+		if (byte == 0xF7) continue;	// end of nothing
+		if (byte == 0xF0) {
+			parser->inSysex = true;
+			parser->sysexOverflow = false;
+			parser->sysex[0] = 0xF0;
+			parser->sysexLength = 1;
+			parser->runningStatus = 0;
+			continue;
+		}
+		if (byte & 0x80) {
+			parser->message[0] = byte;
+			parser->have = 1;
+			parser->need = dataLength(byte);
+			parser->runningStatus = (byte < 0xF0) ? byte : 0;	// system common cancels running status
+		} else {
+			if (parser->have == 0) {
+				if (parser->runningStatus == 0) continue;	// stray data
+				parser->message[0] = parser->runningStatus;
+				parser->have = 1;
+				parser->need = dataLength(parser->runningStatus);
+			}
+			parser->message[parser->have++] = byte;
+		}
+		if (parser->have == parser->need + 1) {
+			simulator->counts.messagesIn++;
+			if (parser->message[0] < 0xF0) routeChannelMessage(simulator, port, parser->message, parser->have, time_ns);
+			else routeSystemMessage(simulator, port, parser->message, parser->have, time_ns);
+			parser->have = 0;
+		}
+	}
+}
+
+void MIOCSimGetRouting(const MIOCSimulator *simulator, MIOCConnectionSet *routing)
+{
+	MIOCConnectionSetClear(routing);
+	for (uint32_t i = 0; i < simulator->nProcessors; i++) {
+		const uint8_t *p = simulator->processors[i].bytes;
+		if (p[0] != kTypeRouting) continue;
+		MIOCConnectionSetAdd(routing, MIOCConnectionSetIndex(p[1] + 1, (p[2] == kAnyChannel) ? kAnyChannel : p[2] + 1,
+															p[3] + 1, (p[4] == kAnyChannel) ? kAnyChannel : p[4] + 1));
+	}
+}
+
+uint32_t MIOCSimProcessorCount(const MIOCSimulator *simulator, const uint8_t *processor, uint32_t length)
+{
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < simulator->nProcessors; i++) {
+		if (simulator->processors[i].length == length && memcmp(simulator->processors[i].bytes, processor, length) == 0) count++;
+	}
+	return count;
+}
+
+MIOCSimCounts MIOCSimGetCounts(const MIOCSimulator *simulator)
+{
+	return simulator->counts;
+}
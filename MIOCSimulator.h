@@ -0,0 +1,97 @@
+//
+//  MIOCSimulator.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// A stand-in for the MIDITEMP matrix (PMM-88E), speaking its sysex protocol (MIOC MIDI SYSEX specs.txt),
+//	so MIOCModel's messages, network switches and routing can be exercised without the box.
+//	- bytes go in at an input port and come out of output ports through an output proc: it sits behind
+//	  whatever carries MIDI (a test driver, a virtual endpoint), with no transport of its own
+//	- each input is parsed as a MIDI cable would be: running status, realtime bytes anywhere, sysex
+//	- MIDITEMP sysex addressed to it (or to all devices) is evaluated, not routed: add/remove I/O
+//	  processors (04), device name (45) and port names (42) requests, port address inquiry (78, 79)
+//	  and the sysex response port (3A). Encoded messages are checksummed; what it can't evaluate
+//	  gets a CANCEL, and with handshaking on, what it can gets an ACK. Replies go to the port the
+//	  request came in on, as the box does
+//	- the processors are kept as the box keeps them (duplicates and all) and applied to everything
+//	  else: routing, velocity processors in position order, note-off and active sensing filters, on
+//	  inputs and outputs. Other processor types are accepted and kept but have no effect
+//	- everything routed leaves a fixed hop latency after it arrived, and optionally no faster than
+//	  the 31250 baud an output can carry
+//
+// Single threaded: calls must come from one thread at a time, with times in order.
+//
+// Plain C: also built into Tools/rnmiocsim and Tools/rnvelocitymap.
+
+#ifndef MIOCSimulator_h
+#define MIOCSimulator_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "MIOCConnectionSet.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kMIOCSimPorts				8
+#define kMIOCSimMaxProcessors		1024
+#define kMIOCSimMaxProcessorLength	8		// velocity processor, the longest applied
+#define kMIOCSimMaxSysex			512		// longer sysex is dropped
+#define kMIOCSimByte_ns				320000	// 10 bits at 31250 baud
+#define kMIOCSimHopLatency_ns		1000000	// default: about what the box adds
+#define kMIOCSimNoResponsePort		0xFF
+
+typedef struct {
+	uint8_t		deviceID;							// FORNET base address / 2: 0 stand-alone
+	uint8_t		deviceType;							// 0x20: PMM-88E
+	char		prefix;
+	char		name[8];
+	char		portNames[2 * kMIOCSimPorts][8];	// IN1, OUT1, IN2, OUT2, ...
+	int64_t		hopLatency_ns;						// arrival to departure, for everything it sends
+	bool		serialOutputs;						// outputs carry kMIOCSimByte_ns a byte (else at once)
+} MIOCSimConfig;
+
+// ports are 0-based here, as on the wire
+typedef void (*MIOCSimOutputProc)(uint8_t port, const uint8_t *bytes, uint32_t length, int64_t time_ns, void *refCon);
+
+typedef struct {
+	uint64_t	bytesIn;
+	uint64_t	messagesIn;			// MIDI messages parsed, sysex included
+	uint64_t	messagesOut;		// routed and replies
+	uint64_t	filtered;			// dropped by a filter
+	uint64_t	sysexEvaluated;		// MIDITEMP sysex addressed to us
+	uint64_t	acks;
+	uint64_t	cancels;
+	uint64_t	checksumErrors;
+	uint64_t	processorsAdded;
+	uint64_t	processorsRemoved;
+	uint64_t	removeMisses;		// remove of a processor it didn't have
+	uint32_t	processors;			// now
+	uint32_t	routes;				// now, of the processors
+	int64_t		lastChange_ns;		// when the processors last changed
+} MIOCSimCounts;
+
+typedef struct MIOCSimulator MIOCSimulator;
+
+void			MIOCSimDefaultConfig(MIOCSimConfig *config);
+MIOCSimulator	*MIOCSimCreate(const MIOCSimConfig *config, MIOCSimOutputProc outputProc, void *refCon);
+void			MIOCSimDestroy(MIOCSimulator *simulator);
+void			MIOCSimReset(MIOCSimulator *simulator);	// as after a power cycle: no processors
+
+// bytes arriving at an input port, the last of them at time_ns
+void			MIOCSimReceive(MIOCSimulator *simulator, uint8_t port, const uint8_t *bytes, uint32_t n, int64_t time_ns);
+
+// routing processors as a set (ports and channels 1-based, as MIOCConnection); duplicates count once
+void			MIOCSimGetRouting(const MIOCSimulator *simulator, MIOCConnectionSet *routing);
+// processor as sent in an add/remove message (type, I/O-number, channel, parameters)
+uint32_t		MIOCSimProcessorCount(const MIOCSimulator *simulator, const uint8_t *processor, uint32_t length);
+MIOCSimCounts	MIOCSimGetCounts(const MIOCSimulator *simulator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIOCSimulator_h */
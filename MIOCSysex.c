@@ -0,0 +1,134 @@
+//
+//  MIOCSysex.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "MIOCSysex.h"
+#include <string.h>
+
+static const uint8_t MIDITEMPID[3] = { 0x00, 0x20, 0x0D };
+
+// one 7-byte block and its MSB byte, summed towards the checksum as it goes
+static inline uint32_t encodeBlock(const uint8_t *data, uint32_t blockLength, uint8_t *encoded, uint32_t *total)
+{
+	uint8_t msbs = 0;
+	for (uint32_t i = 0; i < blockLength; i++)
+		msbs |= (data[i] & 0x80) >> (i + 1);
+	encoded[0] = msbs;
+	*total += msbs;
+	for (uint32_t i = 0; i < blockLength; i++) {
+		encoded[i + 1] = data[i] & 0x7F;
+		*total += encoded[i + 1];
+	}
+	return blockLength + 1;
+}
+
+// the inverse: a block's MSB byte and up to 7 bytes
+static inline void decodeBlock(const uint8_t *source, uint32_t blockLength, uint8_t *data, uint32_t *total)
+{
+	uint8_t msbs = source[0];
+	*total += msbs;
+	for (uint32_t i = 1; i < blockLength; i++) {
+		data[i - 1] = source[i] | ((msbs << i) & 0x80);
+		*total += source[i];
+	}
+}
+
+uint32_t MIOCSysexEncode87(const uint8_t *data, uint32_t n, uint8_t *encoded, uint32_t *sum)
+{
+	uint32_t length = 1, total = 0;
+	for (uint32_t block = 0; block < n; block += 7)
+		length += encodeBlock(data + block, (n - block < 7) ? n - block : 7, encoded + length, &total);
+	encoded[0] = (uint8_t)(length - 2);	// encoded bytes - 1
+	if (sum) *sum = total + encoded[0];
+	return length;
+}
+
+int32_t MIOCSysexDecode87(const uint8_t *encoded, uint32_t available, uint8_t *data, uint32_t *sum)
+{
+	if (available < 1) return -1;
+	uint32_t count = (uint32_t) encoded[0] + 1;
+	if (count + 1 > available) return -1;
+	const uint8_t *source = encoded + 1;
+	uint32_t length = 0, total = encoded[0];
+	for (uint32_t block = 0; block < count; block += 8) {
+		uint32_t blockLength = (count - block < 8) ? count - block : 8;	// MSB byte and up to 7
+		decodeBlock(source + block, blockLength, data + length, &total);
+		length += blockLength - 1;
+	}
+	if (sum) *sum = total;
+	return (int32_t) length;
+}
+
+static inline uint8_t checksumOfSum(uint32_t sum)
+{
+	return (uint8_t)((0x100 - sum) & 0x7F);
+}
+
+uint8_t MIOCSysexChecksum(const uint8_t *bytes, uint32_t n)
+{
+	uint32_t sum = 0;
+	for (uint32_t i = 0; i < n; i++)
+		sum += bytes[i];
+	return checksumOfSum(sum);
+}
+
+uint32_t MIOCSysexCompose(uint8_t *message, uint8_t deviceID, uint8_t deviceType, uint8_t mode, uint8_t opcode,
+						  const uint8_t *data, uint32_t n)
+{
+	if (n == 0) mode &= ~kMIOCSysexModeEncoded;	// nothing to count
+	message[0] = 0xF0;
+	memcpy(message + 1, MIDITEMPID, 3);
+	message[4] = deviceID;
+	message[5] = deviceType;
+	message[6] = mode;
+	message[7] = opcode;
+	uint32_t length = kMIOCSysexPreambleLength;
+	if (mode & kMIOCSysexModeEncoded) {
+		uint32_t sum;
+		if (n > kMIOCSysexMaxData) n = kMIOCSysexMaxData;
+		length += MIOCSysexEncode87(data, n, message + length, &sum);
+		sum += MIDITEMPID[1] + MIDITEMPID[2] + deviceID + deviceType + mode + opcode;
+		message[length++] = checksumOfSum(sum);
+	} else {
+		if (n > kMIOCSysexMaxEncoded) n = kMIOCSysexMaxEncoded;
+		memcpy(message + length, data, n);
+		length += n;
+	}
+	message[length++] = 0xF7;
+	return length;
+}
+
+MIOCSysexStatus MIOCSysexParse(const uint8_t *message, uint32_t length, MIOCSysexMessage *parsed)
+{
+	if (length < 2 || message[0] != 0xF0 || message[length - 1] != 0xF7) return kMIOCSysexNotMIDITEMP;
+	if (length < 4 || memcmp(message + 1, MIDITEMPID, 3) != 0) return kMIOCSysexNotMIDITEMP;
+	if (length < kMIOCSysexPreambleLength + 1) return kMIOCSysexTruncated;
+	parsed->deviceID	= message[4];
+	parsed->deviceType	= message[5];
+	parsed->mode		= message[6];
+	parsed->opcode		= message[7];
+
+	const uint8_t *body = message + kMIOCSysexPreambleLength;
+	uint32_t bodyLength = length - kMIOCSysexPreambleLength - 1;	// without F7
+	if (parsed->mode & kMIOCSysexModeEncoded) {
+		// <count> <data87> <checksum>
+		if (bodyLength < 2) return kMIOCSysexTruncated;
+		uint32_t encodedLength = (uint32_t) body[0] + 2;	// count byte too
+		if (encodedLength > kMIOCSysexMaxEncoded + 1) return kMIOCSysexTooLong;
+		if (encodedLength + 1 > bodyLength) return kMIOCSysexTruncated;
+		if (encodedLength + 1 < bodyLength) return kMIOCSysexTooLong;	// more than the count says
+		uint32_t sum;
+		int32_t dataLength = MIOCSysexDecode87(body, encodedLength, parsed->data, &sum);
+		sum += message[1] + message[2] + message[3] + message[4] + message[5] + message[6] + message[7];
+		if (dataLength < 0 || checksumOfSum(sum) != body[encodedLength]) return kMIOCSysexBadChecksum;
+		parsed->dataLength = (uint32_t) dataLength;
+	} else {
+		if (bodyLength > kMIOCSysexMaxEncoded) return kMIOCSysexTooLong;
+		memcpy(parsed->data, body, bodyLength);
+		parsed->dataLength = bodyLength;
+	}
+	return kMIOCSysexOK;
+}
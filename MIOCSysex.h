@@ -0,0 +1,70 @@
+//
+//  MIOCSysex.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// MIDITEMP sysex framing (MIOC MIDI SYSEX specs.txt), into and out of caller buffers:
+//	F0 00 20 0D <ID> <DT> <mode> <opcode> <data> F7, where data with mode bit 6 set is 8->7 encoded,
+//	<count> <data87> <checksum>, and the checksum makes the low 7 bits of everything after F0 sum to 0.
+//	The same layout MIOCMessage.h describes to the app.
+//	- coding goes a 7-byte block at a time, with the checksum summed in the same pass; nothing is allocated
+//
+// Plain C: also built into Tools/rnsysexbench, Tools/rnmiocsim and Tools/rnvelocitymap.
+
+#ifndef MIOCSysex_h
+#define MIOCSysex_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kMIOCSysexPreambleLength	8		// F0 through opcode (MIOCMessage.h kPreambleLength)
+#define kMIOCSysexMaxData			112		// user bytes in one encoded packet
+#define kMIOCSysexMaxEncoded		128		// their encoding, without count or checksum
+#define kMIOCSysexMaxMessage		(kMIOCSysexPreambleLength + 1 + kMIOCSysexMaxEncoded + 2)
+#define kMIOCSysexModeEncoded		0x40	// MIOCMessage.h kModeEncodedMask
+#define kMIOCSysexModeHandshake		0x04	// kModeHandshakeMask
+#define kMIOCSysexAllDevices		0x7F
+
+typedef enum {
+	kMIOCSysexOK = 0,
+	kMIOCSysexNotMIDITEMP,		// someone else's sysex (or not sysex)
+	kMIOCSysexTruncated,		// shorter than its framing says
+	kMIOCSysexBadChecksum,
+	kMIOCSysexTooLong,
+} MIOCSysexStatus;
+
+typedef struct {
+	uint8_t		deviceID;
+	uint8_t		deviceType;
+	uint8_t		mode;
+	uint8_t		opcode;
+	uint32_t	dataLength;
+	uint8_t		data[kMIOCSysexMaxEncoded];	// decoded if the message was encoded
+} MIOCSysexMessage;
+
+// 8->7: encoded (count byte first) from n (1..kMIOCSysexMaxData) user bytes. Returns its length, count byte
+//	included. sum (optional) gets the sum of the encoded bytes, towards a checksum.
+uint32_t		MIOCSysexEncode87(const uint8_t *data, uint32_t n, uint8_t *encoded, uint32_t *sum);
+// 7->8: encoded starts at its count byte; available is how much of it there is. Returns the decoded length, -1 if
+//	short. sum (optional) as for encoding.
+int32_t			MIOCSysexDecode87(const uint8_t *encoded, uint32_t available, uint8_t *data, uint32_t *sum);
+// the byte that makes the low 7 bits of bytes[0..n) and it sum to 0
+uint8_t			MIOCSysexChecksum(const uint8_t *bytes, uint32_t n);
+
+// A whole message, encoding data (with checksum) if mode says to. Returns its length (<= kMIOCSysexMaxMessage).
+uint32_t		MIOCSysexCompose(uint8_t *message, uint8_t deviceID, uint8_t deviceType, uint8_t mode, uint8_t opcode,
+								 const uint8_t *data, uint32_t n);
+// length runs through F7
+MIOCSysexStatus	MIOCSysexParse(const uint8_t *message, uint32_t length, MIOCSysexMessage *parsed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIOCSysex_h */
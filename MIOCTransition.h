@@ -0,0 +1,57 @@
+//
+//  MIOCTransition.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// A precompiled change of MIOC state from one experiment part to the next: the connections and velocity
+//	processors before and after, what is removed and added, and the sysex for it preassembled as a single
+//	packet list, paced as MIOCModel sends any switch, so applying it (MIOCModel applyTransition:) is one send.
+//	Immutable.
+
+#import <Foundation/Foundation.h>
+#import <CoreMIDI/MIDIServices.h>
+#import "MIOCConnectionSet.h"
+
+#define kMIDIBytesPerSecond	3125.0	// 31250 baud, 10 bits per byte
+
+@interface MIOCTransition : NSObject
+{
+	NSArray    *_fromConnections;
+	NSArray    *_connectionsToRemove;
+	NSArray    *_connectionsToAdd;
+	NSArray    *_toConnections;          // in set order, as the MIOC model will hold them
+	MIOCConnectionSet _fromConnectionSet;
+	MIOCConnectionSet _toConnectionSet;
+	NSArray    *_fromVelocityProcessors;
+	NSArray    *_velocityProcessorsToRemove;
+	NSArray    *_velocityProcessorsToAdd;
+	NSArray    *_toVelocityProcessors;
+	NSData     *_packetList;             // wrapped MIDIPacketList, a sysex message per packet, in send order
+	NSUInteger  _nMessages;
+	NSUInteger  _nBytes;
+}
+
+- (MIOCTransition *)initFromConnections:(NSArray *)fromConnections remove:(NSArray *)connectionsToRemove add:(NSArray *)connectionsToAdd
+					 velocityProcessors:(NSArray *)fromProcessors remove:(NSArray *)processorsToRemove add:(NSArray *)processorsToAdd
+						  sysexMessages:(NSArray *)messages;
+
+- (NSArray *)fromConnections;
+- (NSArray *)connectionsToRemove;
+- (NSArray *)connectionsToAdd;
+- (NSArray *)toConnections;
+- (const MIOCConnectionSet *)fromConnectionSet;
+- (const MIOCConnectionSet *)toConnectionSet;
+- (NSArray *)fromVelocityProcessors;
+- (NSArray *)velocityProcessorsToRemove;
+- (NSArray *)velocityProcessorsToAdd;
+- (NSArray *)toVelocityProcessors;
+- (NSData *)packetList;				// nil if the messages could not be packed
+- (NSUInteger)messageCount;
+- (NSUInteger)byteCount;
+- (NSTimeInterval)transmissionTime;	// on the MIDI cable
+- (BOOL)isEmpty;
+- (NSData *)packetListStartingAt:(MIDITimeStamp)startHostTime;	// timestamps absolute, for sending ahead
+
+@end
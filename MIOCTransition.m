@@ -0,0 +1,111 @@
+//
+//  MIOCTransition.m
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#import "MIOCTransition.h"
+#import "MIOCConnection.h"
+#import "MIOCModel.h"
+
+@implementation MIOCTransition
+
+// what remains of from once remove is taken out, then add
+static NSArray *applyChanges(NSArray *from, NSArray *remove, NSArray *add)
+{
+	NSMutableArray *to = [NSMutableArray arrayWithCapacity:[from count] + [add count]];
+	for (id item in from) {
+		if ([remove containsObject:item] == NO)
+			[to addObject:item];
+	}
+	[to addObjectsFromArray:add];
+	return [NSArray arrayWithArray:to];
+}
+
+// messages: complete sysex messages (NSData), in the order they are to be sent
+- (MIOCTransition *)initFromConnections:(NSArray *)fromConnections remove:(NSArray *)connectionsToRemove add:(NSArray *)connectionsToAdd
+					 velocityProcessors:(NSArray *)fromProcessors remove:(NSArray *)processorsToRemove add:(NSArray *)processorsToAdd
+						  sysexMessages:(NSArray *)messages
+{
+	self = [super init];
+	if (!self) return nil;
+
+	_fromConnections			= [fromConnections copy];
+	_connectionsToRemove		= [connectionsToRemove copy];
+	_connectionsToAdd			= [connectionsToAdd copy];
+	MIOCConnectionSetClear(&_fromConnectionSet);
+	[MIOCConnection addConnections:fromConnections toSet:&_fromConnectionSet];
+	MIOCConnectionSet removeSet;
+	MIOCConnectionSetClear(&removeSet);
+	[MIOCConnection addConnections:connectionsToRemove toSet:&removeSet];
+	MIOCConnectionSetDifference(&_toConnectionSet, &_fromConnectionSet, &removeSet);
+	[MIOCConnection addConnections:connectionsToAdd toSet:&_toConnectionSet];
+	_toConnections				= [[MIOCConnection connectionsInSet:&_toConnectionSet] retain];
+	_fromVelocityProcessors		= [fromProcessors copy];
+	_velocityProcessorsToRemove	= [processorsToRemove copy];
+	_velocityProcessorsToAdd	= [processorsToAdd copy];
+	_toVelocityProcessors		= [applyChanges(fromProcessors, processorsToRemove, processorsToAdd) retain];
+
+	_nMessages = [messages count];
+	for (NSData *message in messages)
+		_nBytes += [message length];
+	_packetList = [[MIOCModel packetListForSysexMessages:messages] retain];
+
+	return self;
+}
+
+- (void)dealloc
+{
+	[_fromConnections release];
+	[_connectionsToRemove release];
+	[_connectionsToAdd release];
+	[_toConnections release];
+	[_fromVelocityProcessors release];
+	[_velocityProcessorsToRemove release];
+	[_velocityProcessorsToAdd release];
+	[_toVelocityProcessors release];
+	[_packetList release];
+	[super dealloc];
+}
+
+- (NSArray *)fromConnections { return _fromConnections; }
+- (NSArray *)connectionsToRemove { return _connectionsToRemove; }
+- (NSArray *)connectionsToAdd { return _connectionsToAdd; }
+- (NSArray *)toConnections { return _toConnections; }
+- (const MIOCConnectionSet *)fromConnectionSet { return &_fromConnectionSet; }
+- (const MIOCConnectionSet *)toConnectionSet { return &_toConnectionSet; }
+- (NSArray *)fromVelocityProcessors { return _fromVelocityProcessors; }
+- (NSArray *)velocityProcessorsToRemove { return _velocityProcessorsToRemove; }
+- (NSArray *)velocityProcessorsToAdd { return _velocityProcessorsToAdd; }
+- (NSArray *)toVelocityProcessors { return _toVelocityProcessors; }
+- (NSData *)packetList { return _packetList; }
+- (NSUInteger)messageCount { return _nMessages; }
+- (NSUInteger)byteCount { return _nBytes; }
+- (NSTimeInterval)transmissionTime { return _nBytes / kMIDIBytesPerSecond; }
+- (BOOL)isEmpty { return _nMessages == 0; }
+
+// the packet list with its paced offsets made absolute from startHostTime, so it can be handed to CoreMIDI ahead of
+//	time and still go out (and land, transmissionTime later) when meant to
+- (NSData *)packetListStartingAt:(MIDITimeStamp)startHostTime
+{
+	if (_packetList == nil) return nil;
+	NSMutableData *packetList = [[_packetList mutableCopy] autorelease];
+	MIDIPacketList *pktlist = (MIDIPacketList *)[packetList mutableBytes];
+	MIDIPacket *packet = &pktlist->packet[0];
+	for (UInt32 i = 0; i < pktlist->numPackets; i++) {
+		packet->timeStamp += startHostTime;
+		packet = MIDIPacketNext(packet);
+	}
+	return packetList;
+}
+
+- (NSString *)description
+{
+	return [NSString stringWithFormat:@"MIOC transition: -%lu +%lu connections, -%lu +%lu velocity processors, %lu sysex bytes (%.1f ms)",
+		(unsigned long)[_connectionsToRemove count], (unsigned long)[_connectionsToAdd count],
+		(unsigned long)[_velocityProcessorsToRemove count], (unsigned long)[_velocityProcessorsToAdd count],
+		(unsigned long)_nBytes, [self transmissionTime] * 1000.0];
+}
+
+@end
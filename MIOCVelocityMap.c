@@ -0,0 +1,35 @@
+//
+//  MIOCVelocityMap.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "MIOCVelocityMap.h"
+#include <math.h>
+#include <string.h>
+
+MIOCVelocityCurve MIOCVelocityCurveFromProcessor(const uint8_t bytes[8])
+{
+	return (MIOCVelocityCurve){ bytes[4], (int8_t) bytes[5], (int8_t) bytes[6], (int8_t) bytes[7] };
+}
+
+MIOCVelocityCurve MIOCVelocityCurveForWeight(double weight)
+{
+	double eighths = round(weight * 8);
+	return (MIOCVelocityCurve){ 0, 8, (int8_t)((eighths < -128) ? -128 : (eighths > 127) ? 127 : eighths), 0 };
+}
+
+void MIOCVelocityTableCompile(uint8_t table[kMIOCVelocityTableLength], const MIOCVelocityCurve *curves, uint32_t nCurves)
+{
+	for (unsigned velocity = 0; velocity < kMIOCVelocityTableLength; velocity++)
+		table[velocity] = (uint8_t) velocity;
+	for (uint32_t k = 0; k < nCurves; k++)
+		MIOCVelocityTableAppend(table, &curves[k]);
+}
+
+void MIOCVelocityTableAppend(uint8_t table[kMIOCVelocityTableLength], const MIOCVelocityCurve *curve)
+{
+	for (unsigned velocity = 1; velocity < kMIOCVelocityTableLength; velocity++)
+		table[velocity] = MIOCVelocityCurveMap(curve, table[velocity]);
+}
@@ -0,0 +1,59 @@
+//
+//  MIOCVelocityMap.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// The MIOC's velocity processor (24/25, MIOC MIDI SYSEX specs.txt) as arithmetic the app can run: a line
+//	through the threshold with a gradient (in eighths) either side of it, plus the offset,
+//	threshold + ((gradient * (velocity - threshold)) >> 3) + offset, kept a note-on (1..127).
+//	- processors in a chain (position order) compile to one 128-entry table; entry 0, a note-off, stays 0
+//	- a weight compiles to a table too, so the delay path (RNMIDIRouting.h) looks velocities up as it routes
+//	MIOCSimulator and MIDICoreTable use it, so the simulated box, the software matrix and a processor's
+//	preview (MIOCVelocityProcessor) all weight alike.
+//
+// Plain C: also built into Tools/rnmiocsim and Tools/rnvelocitymap.
+
+#ifndef MIOCVelocityMap_h
+#define MIOCVelocityMap_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kMIOCVelocityTableLength	128
+
+typedef struct {
+	uint8_t		threshold;
+	int8_t		gradientBelow;	// eighths
+	int8_t		gradientAbove;
+	int8_t		offset;
+} MIOCVelocityCurve;
+
+static inline uint8_t MIOCVelocityCurveMap(const MIOCVelocityCurve *curve, uint8_t velocity)
+{
+	int difference = (int) velocity - curve->threshold;
+	int gradient = (velocity < curve->threshold) ? curve->gradientBelow : curve->gradientAbove;
+	int mapped = curve->threshold + ((gradient * difference) >> 3) + curve->offset;
+	return (uint8_t)((mapped < 1) ? 1 : (mapped > 127) ? 127 : mapped);
+}
+
+// from a velocity processor's bytes (MIOCVelocityProcessor MIDIBytes: type, port, channel, position,
+//	threshold, gradients, offset)
+MIOCVelocityCurve	MIOCVelocityCurveFromProcessor(const uint8_t bytes[8]);
+// what MIOCVelocityProcessor setWeight: sends: gradient above a threshold of 0, in eighths
+MIOCVelocityCurve	MIOCVelocityCurveForWeight(double weight);
+
+// the chain, first to last, as a table (identity for none)
+void	MIOCVelocityTableCompile(uint8_t table[kMIOCVelocityTableLength], const MIOCVelocityCurve *curves, uint32_t nCurves);
+// a curve after what the table already does
+void	MIOCVelocityTableAppend(uint8_t table[kMIOCVelocityTableLength], const MIOCVelocityCurve *curve);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MIOCVelocityMap_h */
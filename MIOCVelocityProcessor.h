@@ -31,6 +31,10 @@
 - (void)setConstantVelocity:(Byte)velocity;
 - (void)setPosition:(Byte)position;
 
+// what the MIOC will make of a note-on's velocity (MIOCVelocityMap.h), one or all 128 (0 stays 0)
+- (Byte)mapVelocity:(Byte)velocity;
+- (NSData *)velocityTable;
+
 - (NSString *)description;
 - (BOOL)isEqual:(id)anObject;	// used for uniqueness testing in NSArray
 
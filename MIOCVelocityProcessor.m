@@ -8,6 +8,7 @@
 
 #import "MIOCVelocityProcessor.h"
 #import "MIOCConnection.h"
+#import "MIOCVelocityMap.h"
 
 @implementation MIOCVelocityProcessor
 
@@ -84,6 +85,20 @@
 	_position = position;
 }
 
+- (Byte)mapVelocity:(Byte)velocity
+{
+	MIOCVelocityCurve curve = { _threshold, _gradientBelowThreshold, _gradientAboveThreshold, _offset };
+	return (velocity == 0) ? 0 : MIOCVelocityCurveMap(&curve, velocity & 0x7F);
+}
+
+- (NSData *)velocityTable
+{
+	MIOCVelocityCurve curve = { _threshold, _gradientBelowThreshold, _gradientAboveThreshold, _offset };
+	uint8_t table[kMIOCVelocityTableLength];
+	MIOCVelocityTableCompile(table, &curve, 1);
+	return [NSData dataWithBytes:table length:sizeof(table)];
+}
+
 - (NSString *)description
 {
 	return [NSString stringWithFormat:@"%c port %d, channel %d: %.2f (%u) %.2f +%u", \
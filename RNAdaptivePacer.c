@@ -0,0 +1,68 @@
+//
+//  RNAdaptivePacer.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNAdaptivePacer.h"
+#include <stdlib.h>
+#include <math.h>
+
+void RNAdaptiveTapsInit(RNAdaptiveTaps *taps)
+{
+	for (unsigned node = 0; node <= kRNAdaptiveMaxNodes; node++) {
+		for (unsigned k = 0; k < kRNAdaptiveTapHistory; k++)
+			taps->tap_ns[node][k] = kRNPacerNoTap;
+		taps->next[node] = 0;
+	}
+}
+
+void RNAdaptiveTapsAdd(RNAdaptiveTaps *taps, uint16_t node, int64_t time_ns)
+{
+	if (node == 0 || node > kRNAdaptiveMaxNodes) return;
+	taps->tap_ns[node][taps->next[node]] = time_ns;
+	taps->next[node] = (taps->next[node] + 1) % kRNAdaptiveTapHistory;
+}
+
+int64_t RNAdaptivePacerDecide(const RNAdaptivePacerParameters *parameters, const RNAdaptiveTaps *taps,
+							  int64_t previousOnset_ns, int64_t IOI_ns, int64_t now_ns, RNPacerDecision *decision)
+{
+	int64_t window_ns = IOI_ns / 2;
+	int64_t sum_ns = 0;
+	uint32_t nTaps = 0;
+	decision->tapNodes = 0;
+	for (unsigned node = 0; node <= kRNAdaptiveMaxNodes; node++) {
+		decision->tap_ns[node] = kRNPacerNoTap;
+		if (!((parameters->sources >> node) & 1)) continue;
+		int64_t best = INT64_MAX;
+		for (unsigned k = 0; k < kRNAdaptiveTapHistory; k++) {
+			int64_t tap_ns = taps->tap_ns[node][k];
+			if (tap_ns == kRNPacerNoTap) continue;
+			int64_t distance = llabs(tap_ns - previousOnset_ns);
+			if (distance < window_ns && distance < best) {
+				best = distance;
+				decision->tap_ns[node] = tap_ns;
+			}
+		}
+		if (best == INT64_MAX) continue;
+		sum_ns += decision->tap_ns[node] - previousOnset_ns;
+		decision->tapNodes |= 1u << node;
+		nTaps++;
+	}
+
+	int64_t asynchrony_ns = (nTaps > 0) ? sum_ns / (int64_t) nTaps : 0;
+	int64_t onset_ns = previousOnset_ns + IOI_ns + llround(parameters->alpha * asynchrony_ns);
+	int64_t nextIOI_ns = IOI_ns + llround(parameters->beta * asynchrony_ns);
+	if (parameters->minIOI_ns > 0 && nextIOI_ns < parameters->minIOI_ns) nextIOI_ns = parameters->minIOI_ns;
+	if (parameters->maxIOI_ns > 0 && nextIOI_ns > parameters->maxIOI_ns) nextIOI_ns = parameters->maxIOI_ns;
+	if (onset_ns < now_ns) onset_ns = now_ns;
+
+	decision->decided_ns		= now_ns;
+	decision->previousOnset_ns	= previousOnset_ns;
+	decision->onset_ns			= onset_ns;
+	decision->IOI_ns			= IOI_ns;
+	decision->nextIOI_ns		= nextIOI_ns;
+	decision->asynchrony_ns		= asynchrony_ns;
+	return onset_ns;
+}
@@ -0,0 +1,80 @@
+//
+//  RNAdaptivePacer.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Closed-loop pacing: a stimulus that adapts to the tappers, as the adaptive "virtual partner" of
+//	sensorimotor synchronization studies. Each onset is decided a short lead before it is due, from
+//	the taps of selected nodes around the onset before it.
+//	- their mean asynchrony A (tap - onset) moves the next onset by alpha * A (phase correction)
+//	  and the pacer's period by beta * A (period correction): alpha = beta = 0 is isochronous,
+//	  alpha near 1 follows the group's phase, beta its tempo
+//	- a tap counts for the onset it is nearest, within half a period; nodes without one are left
+//	  out, and with none at all the pacer keeps its phase and period
+//	- the period stays within [minIOI, maxIOI], and an onset is never decided into the past
+//	- every decision is logged with its inputs (each node's tap), so a run can be replayed offline
+//	- deciding is one pass over a fixed tap history: bounded time, no allocation or locks, so it
+//	  runs on the stimulus scheduler's thread (RNStimulusStream.h)
+
+#ifndef RNAdaptivePacer_h
+#define RNAdaptivePacer_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNAdaptiveMaxNodes		16			// kMaxNodes
+#define kRNAdaptiveTapHistory	4			// taps remembered per node, enough to find the one nearest an onset
+#define kRNAdaptiveLead_ns		20000000	// default: onsets are decided (and sent) this long before they sound
+
+typedef struct {
+	uint32_t	sources;	// bit n: node n's taps steer the pacer; 0: not adaptive
+	double		alpha;		// phase correction, fraction of the asynchrony
+	double		beta;		// period correction, fraction of the asynchrony
+	int64_t		minIOI_ns;
+	int64_t		maxIOI_ns;
+	int64_t		lead_ns;	// <= 0: kRNAdaptiveLead_ns
+} RNAdaptivePacerParameters;
+
+// recent taps of every node (any node may steer some pacer); filled in arrival order
+typedef struct {
+	int64_t		tap_ns[kRNAdaptiveMaxNodes + 1][kRNAdaptiveTapHistory];
+	uint8_t		next[kRNAdaptiveMaxNodes + 1];
+} RNAdaptiveTaps;
+
+void	RNAdaptiveTapsInit(RNAdaptiveTaps *taps);
+void	RNAdaptiveTapsAdd(RNAdaptiveTaps *taps, uint16_t node, int64_t time_ns);	// other nodes ignored
+
+#define kRNPacerNoTap	INT64_MIN
+
+// A decision and what went into it. Times are absolute (host clock) until whoever stores it rebases them.
+typedef struct {
+	int64_t		due_ns;				// when it should have been made (onset as it stood - lead)
+	int64_t		decided_ns;			// when it was
+	int64_t		previousOnset_ns;	// the onset the taps were matched to
+	int64_t		onset_ns;			// decided
+	int64_t		IOI_ns;				// period, before
+	int64_t		nextIOI_ns;			// and after
+	int64_t		asynchrony_ns;		// mean of the taps used (0 if none)
+	int64_t		tap_ns[kRNAdaptiveMaxNodes + 1];	// input: each source node's tap, or kRNPacerNoTap
+	uint32_t	number;				// onset number within the stimulus
+	uint32_t	tapNodes;			// bit n: node n had a tap
+	uint8_t		stimulusChannel;
+	uint8_t		spare[7];
+} RNPacerDecision;
+
+// The onset after previousOnset_ns, for a pacer currently at period IOI_ns. Fills decision (all but
+//	due_ns, number and stimulusChannel) and returns the onset.
+int64_t	RNAdaptivePacerDecide(const RNAdaptivePacerParameters *parameters, const RNAdaptiveTaps *taps,
+							  int64_t previousOnset_ns, int64_t IOI_ns, int64_t now_ns, RNPacerDecision *decision);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNAdaptivePacer_h */
@@ -58,5 +58,6 @@
 - (void)updateExperimentTimer:(NSTimer *)timer;
 - (void)experimentOvertimeNotificationHandler:(NSNotification *)notification;
 - (void)experimentEndNotificationHandler:(NSNotification *)notification;
+- (void)recordedEventsNotificationHandler:(NSNotification *)notification;
 
 @end
@@ -63,6 +63,9 @@
 	[[NSNotificationCenter defaultCenter] addObserver:self 
 											 selector:@selector(experimentOvertimeNotificationHandler:) 
 												 name:@"experimentOvertimeNotification" object:nil];
+	[[NSNotificationCenter defaultCenter] addObserver:self 
+											 selector:@selector(recordedEventsNotificationHandler:) 
+												 name:@"recordedEventsNotification" object:nil];
 
 		
 	[_experimentTimer setFont:[NSFont fontWithName:@"Helvetica" size:16]];
@@ -214,6 +217,12 @@
 		if (_experiment != nil) {
 			[[[_MIOCController deviceObject] MIDILink] removeMIDIListener:_networkView]; //***fix, may already be removed
 			[_networkView setNetwork:nil];
+			[_networkView setEventStore:NULL]; //store goes away with the experiment
+			[_networkView setTimingStats:NULL];
+			[_networkView setAsynchronyHistograms:NULL];
+			[_networkView setSynchrony:NULL];
+			[_networkView setLeadLag:NULL];
+			[_networkView setITISeries:NULL];
 			
 			[_experimentPartsController setSelectedObjects:@[]]; //TODO: there's another way using indexes used elsewhere
 			[_experimentPartsController setContent:nil];
@@ -240,7 +249,13 @@
 		NSURL *selectedDir = [[oPanel URL] URLByDeletingLastPathComponent];
 		[defaults setObject:selectedDir.path forKey:@"LastOpenDirectory"];
 		
-		//Configure view: current network and register view to receive midi
+		//Configure view: recorded events, current network and register view to receive midi
+		[_networkView setEventStore: [_experiment eventStore]];
+		[_networkView setTimingStats: [_experiment timingStats]];
+		[_networkView setAsynchronyHistograms: [_experiment asynchronyHistograms]];
+		[_networkView setSynchrony: [_experiment synchrony]];
+		[_networkView setLeadLag: [_experiment leadLag]];
+		[_networkView setITISeries: [_experiment ITISeries]];
 		[_networkView setNetwork: [_experiment currentNetwork]];	
 		[[[_MIOCController deviceObject] MIDILink] registerMIDIListener:_networkView];
 		
@@ -253,9 +268,21 @@
 		[_startButton setEnabled:YES];
 		[_saveButton setEnabled:NO];
 		
-		//experiment has not started yet, so clear MIOC
+		//routing in the MIOC or the software matrix, as the experiment asks; then, as it has not started yet, clear MIOC
+		[[_MIOCController deviceObject] setUseInternalMIDIProcessor:[_experiment usesSoftwareRouting]];
 		[[_MIOCController deviceObject] disconnectAll];
 		
+		//compile the parts' MIOC changes from there, and report on the timeline before anything plays
+		NSUInteger nProblems = [_experiment compileTimelineForDevice:[_MIOCController deviceObject]];
+		NSLog(@"\n%@", [_experiment timelineReport]);
+		if (nProblems > 0) {
+			NSAlert *alert = [[[NSAlert alloc] init] autorelease];
+			[alert setMessageText:@"Problems with experiment timeline"];
+			[alert setInformativeText:[_experiment timelineReport]];
+			[alert setAlertStyle:NSAlertStyleWarning];
+			[alert beginSheetModalForWindow:[self window] completionHandler:nil];
+		}
+		
 		//Bind experiment parts to List view controller
 		[_experimentPartsController setContent: [_experiment experimentParts]];
 		//[self synchronizePartsListSelection]; 
@@ -319,17 +346,13 @@
 }
 
 //handle notifications of experiment parts becoming active
-// stimulus: schedule midi, update experiment (which updates network), update view
+// stimulus: already streaming (started a lookahead ahead by the experiment's part scheduler), update experiment
+//	(which updates network), update view
 - (void) newStimulusNotificationHandler: (NSNotification *) notification
 {
-	MIDIIO *io = [[_MIOCController deviceObject] MIDILink];
-	
 	RNExperimentPart *part = [notification object];
 	RNStimulus *stim = (RNStimulus *) [part experimentPart];
 	NSLog(@"received notification stimulus: %@", [stim description]);
-	//schedule midi
-	NSData *pl = [stim MIDIPacketListForExperimentStartTime:[_experiment experimentStartTimeNanoseconds] ];
-	[io sendMIDIPacketList:pl];
 	//store scheduled times in experiment part
 	[part setSubEventTimes:[stim eventTimes]];
 	//update experiment
@@ -340,19 +363,21 @@
 	[self synchronizePartsListSelection]; 
 }
 
-//program MIOC, documenting actual time of network instantiation,
-// update experiment currentNetwork
+//program MIOC, unless the part scheduler sent its switch ahead (the realtime routing table was swapped in as the part
+// started: RNExperiment part scheduler), update experiment currentNetwork
 // update  view
 - (void) newNetworkNotificationHandler: (NSNotification *) notification
 {
 	RNExperimentPart *part = [notification object];
 	RNNetwork *net = (RNNetwork *) [part experimentPart];
 	NSLog(@"received notification network: %@", [net description]);
-	[part setActualStartTime:[_experiment secondsSinceExperimentStartDate] ];
-	[self programMIDIRoutingWithNetwork:net];
-	NSTimeInterval uncertainty = [_experiment secondsSinceExperimentStartDate] - [part actualStartTime];
-	[part setStartTimeUncertainty:uncertainty];
-	NSLog(@"MIOC has been programmed");
+	if ([part MIOCTransitionSentAhead])
+		[[_MIOCController deviceObject] noteTransitionSent:[part MIOCTransition]];
+	else if ([part MIOCTransition] != nil)
+		[[_MIOCController deviceObject] applyTransition:[part MIOCTransition]];
+	else
+		[self programMIOCWithNetwork:net];
+	NSLog(@"MIOC has been programmed (switched in %.1f ms)", [[_MIOCController deviceObject] lastSwitchDuration] * 1000.0);
 	
 	[_experiment setCurrentNetwork:net];
 	[_networkView setNetwork:net];
@@ -365,14 +390,16 @@
 	RNExperimentPart *part = [notification object];
 	RNGlobalConnectionStrength *weight = (RNGlobalConnectionStrength *) [part experimentPart];
 	NSLog(@"received notification global connection strength: %@", [weight description]);
-	[part setActualStartTime:[_experiment secondsSinceExperimentStartDate] ];
 	RNNetwork *net = [_experiment currentNetwork];
 	NSAssert( (net != nil), @"no current network.");
 	[net setGlobalConnectionStrength:weight];
-	[self programMIOCVelocityProcessorsForNetwork:net];
-	NSTimeInterval uncertainty = [_experiment secondsSinceExperimentStartDate] - [part actualStartTime];
-	[part setStartTimeUncertainty:uncertainty];
-	NSLog(@"MIOC has been programmed with velocity processors");
+	if ([part MIOCTransitionSentAhead])
+		[[_MIOCController deviceObject] noteTransitionSent:[part MIOCTransition]];
+	else if ([part MIOCTransition] != nil)
+		[[_MIOCController deviceObject] applyTransition:[part MIOCTransition]];
+	else
+		[self programMIOCVelocityProcessorsForNetwork:net];
+	NSLog(@"MIOC has been programmed with velocity processors (switched in %.1f ms)", [[_MIOCController deviceObject] lastSwitchDuration] * 1000.0);
 	[_experiment setCurrentGlobalConnectionStrength:weight];
 	
 	[self synchronizePartsListSelection]; 
@@ -481,7 +508,7 @@
 	NSLog(@"\n\tStartTime: %@\n\t(Now: %@)\n\t%.3f s before start", startDate, [rightNow description], timeUntilStart_s);
 	NSAssert( (timeUntilStart_s > 0), @"Problem: start time has already passed, init taking too long");
 	
-	//from here, experiment is automatically carried out via timers
+	//from here, experiment is automatically carried out by the part scheduler
 	// ending naturally with experiment's stop, or via user action stopExperiment
 }
 
@@ -510,6 +537,13 @@
 	[_experimentTimer setTextColor:[NSColor redColor] ];
 }
 
+// experiment has flushed newly recorded events into its store
+- (void) recordedEventsNotificationHandler: (NSNotification *) notification
+{
+	if ([notification object] == _experiment)
+		[_networkView eventStoreDidChange];
+}
+
 // once experiment has really stopped, we'll be notified here
 - (void) experimentEndNotificationHandler: (NSNotification *) notification
 {
@@ -632,8 +666,9 @@
 		//Play Stimulus
 		MIDIIO *io = [[_MIOCController deviceObject] MIDILink];
 		UInt64 now_ns = AudioConvertHostTimeToNanos(AudioGetCurrentHostTime()) + 1000000; //1ms later
-		NSData *pl = [[testPart experimentPart] MIDIPacketListForExperimentStartTime:now_ns ];
-		[io sendMIDIPacketList:pl];
+		RNStimulus *stim = [testPart experimentPart];
+		RNStimulusStreamDefinition definition = [stim streamDefinitionForExperimentStartTime:now_ns];
+		[stim setStream:[io startStimulusStream:&definition]];
 		[_testStopButton setEnabled:YES];
 		
 	} else if ([[testPart partType] isEqualToString: @"RNNetwork"]) {
@@ -656,6 +691,7 @@
 - (IBAction)stopTestPart:(id)sender
 {
 	MIDIIO *io = [[_MIOCController deviceObject] MIDILink];
+	[io cancelAllStimulusStreams];
 	[io flushOutput];
 	[_testStopButton setEnabled:NO];
 }
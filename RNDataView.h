@@ -3,11 +3,14 @@
 #import <Cocoa/Cocoa.h>
 
 #import "RNTapperNode.h"
+#import "RNTimeSeries.h"
 
 @interface RNDataView : NSView
 {
-	NSMutableArray	*_x;
-	NSMutableArray	*_y;
+	RNTimeSeries	*_ITISeries;	// per node ITIs (not owned); drawing asks for about one min/max bucket per pixel
+	RNTimeSeriesBucket *_buckets;	// query buffer
+	uint32_t		_maxBuckets;
+	int64_t			_drawnLastTime_ns;	// latest point when last invalidated
 	NSMutableArray	*_xMarks;
 	NSMutableArray	*_yMarks;
 	NSSize			_xlim;
@@ -16,7 +19,8 @@
 
 - (void)clearData;
 
-- (void)addEventAtTime:(double)time_ms withITI:(double)ITI_ms forNode:(RNNodeNum_t)iNode;
+- (void)setTimeSeries:(RNTimeSeries *)ITISeries;
+- (void)eventStoreDidChange;	// new events were recorded: rescale and redraw if there are new ITIs
 
 - (void)addMarkAtTime:(double)time_ms;
 - (void)addMarkAtITI:(double)ITI_ms;
@@ -5,12 +5,10 @@
 - (id)initWithFrame:(NSRect)frameRect
 {
 	if ((self = [super initWithFrame:frameRect]) != nil) {
-		// initialize data storage
 		// hardwired for now
-		_x		= [[NSMutableArray alloc] initWithCapacity:10];
-		_y		= [[NSMutableArray alloc] initWithCapacity:10];
 		_xlim	= NSMakeSize(0.0, 60.0);	// unconventional usage
 		_ylim	= NSMakeSize(400.0, 1500.0);// ms
+		_drawnLastTime_ns = INT64_MIN;
 	}
 
 	return self;
@@ -18,50 +16,47 @@
 
 - (void)clearData
 {
-	[_x release];
-	_x = nil;
-	[_y release];
-	_y	= nil;
-	_x	= [[NSMutableArray alloc] initWithCapacity:10];
-	_y	= [[NSMutableArray alloc] initWithCapacity:10];
-
+	_xlim	= NSMakeSize(0.0, 60.0);
+	_drawnLastTime_ns = INT64_MIN;
 	[self setNeedsDisplay:YES];
 }
 
 - (void)dealloc
 {
-	[_x release];
-	_x = nil;
-	[_y release];
-	_y = nil;
+	free(_buckets);
 	[super dealloc];
 }
 
-- (void)addEventAtTime:(double)time_ms withITI:(double)ITI_ms forNode:(RNNodeNum_t)iNode
+- (void)setTimeSeries:(RNTimeSeries *)ITISeries
 {
-	// add event to appropriate array (indexed by node)
-	// if necessary, extend
-	RNNodeNum_t nNodes = [_x count] - 1;// we use 1-based indexes
-
-	if (iNode > nNodes) {
-		for (int i = (nNodes + 1); i <= iNode; i++) {
-			[_x addObject:[[NSMutableArray alloc] initWithCapacity:100]];
-			[_y addObject:[[NSMutableArray alloc] initWithCapacity:100]];
-		}
+	_ITISeries = ITISeries;
+	_drawnLastTime_ns = INT64_MIN;
+	[self setNeedsDisplay:YES];
+}
+
+- (void)eventStoreDidChange
+{
+	if (_ITISeries == NULL) {
+		return;
 	}
 
-	// don't add 0 iti (e.g. first tap has no ITI defined)
-	if (ITI_ms > 0) {
-		[_x[iNode] addObject:@(time_ms)];
-		[_y[iNode] addObject:@(ITI_ms)];
+	// nothing new to plot (e.g. only stimulus events arrived)
+	int64_t lastTime_ns = RNTimeSeriesLastTime(_ITISeries);
+	if (lastTime_ns == _drawnLastTime_ns) {
+		return;
+	}
+	_drawnLastTime_ns = lastTime_ns;
 
-		// if exceeds limit, rescale axis limits
-		if (time_ms / 1e3 > _xlim.height) {
+	// if latest point exceeds limit, rescale axis limits
+	if (lastTime_ns != INT64_MIN) {
+		double time_s = lastTime_ns / 1e9;
+		while (time_s > _xlim.height) {
 			_xlim.height = _xlim.height + 10;	// add in 10s steps
 		}
-
-		[self setNeedsDisplay:YES];
 	}
+
+	// decimation may regroup buckets anywhere along the axis, so redraw it all: cost is per pixel, not per tap
+	[self setNeedsDisplay:YES];
 }
 
 // for the future...
@@ -84,44 +79,59 @@
 	[aPath stroke];
 	
 	// July 2025 for some reason this never failed before--why is this view being drawn on init now--it's hidden and there is no experiment loaded
-	if ([_x count] == 0) {
+	if (_ITISeries == NULL) {
 		return;
 	}
 
-	// now draw curves for nodes
-	RNNodeNum_t		nNodes = [_x count] - 1;// we don't use element 0
-	NSUInteger		iNode, nPoints, iPoint;
+	// about one bucket per device pixel across the width
+	uint32_t maxBuckets = (uint32_t) ceil([self convertSizeToBacking:bounds.size].width);
+	if (maxBuckets < 1) {
+		return;
+	}
+	if (maxBuckets > _maxBuckets) {
+		RNTimeSeriesBucket *buckets = realloc(_buckets, maxBuckets * sizeof(RNTimeSeriesBucket));
+		if (buckets == NULL) {
+			return;
+		}
+		_buckets	= buckets;
+		_maxBuckets	= maxBuckets;
+	}
+
+	// now draw ITI curves for nodes: each bucket is a vertical min-max stroke, joined to the next
+	RNNodeNum_t		iNode;
+	uint32_t		nBuckets, iBucket;
 	NSColor			*color;
-	NSMutableArray	*thisx, *thisy;
-	double			px, py;
-
-	if (nNodes >= 1) {
-		for (iNode = 1; iNode <= nNodes; iNode++) {
-			color	= [RNTapperNode colorArray][iNode - 1];
-			thisx	= _x[iNode];
-			thisy	= _y[iNode];
-			[aPath removeAllPoints];
-			nPoints = [thisx count];
-
-			for (iPoint = 0; iPoint < nPoints; iPoint++) {
-				px	= [thisx[iPoint] doubleValue] / 1e3;// convert to s
-				py	= [thisy[iPoint] doubleValue];
-				// scale into pixels (nb w = min; h = max for axes limits)
-				px	= (px - _xlim.width) / (_xlim.height - _xlim.width) * bounds.size.width;
-				py	= (py - _ylim.width) / (_ylim.height - _ylim.width) * bounds.size.height;
-
-				if (iPoint == 0) {
-					[aPath moveToPoint:NSMakePoint(px, py)];
-				} else {
-					[aPath lineToPoint:NSMakePoint(px, py)];
-				}
-
-				[color setStroke];
-				[aPath stroke];
-			}	// loop on points
-
-			// NSLog(@"Draw Node %d (color %@), x data: %@; y data: %@", iNode, color, thisx, [_y objectAtIndex:iNode]);
+	double			px, pyMin, pyMax;
+	NSArray			*colors = [RNTapperNode colorArray];
+
+	for (iNode = 1; iNode <= kMaxNodes && iNode <= [colors count]; iNode++) {
+		nBuckets = RNTimeSeriesQuery(_ITISeries, iNode, (int64_t) (_xlim.width * 1e9), (int64_t) (_xlim.height * 1e9),
+									 maxBuckets, _buckets);
+		if (nBuckets < 2) {
+			continue;
 		}
+
+		color = colors[iNode - 1];
+		[aPath removeAllPoints];
+
+		for (iBucket = 0; iBucket < nBuckets; iBucket++) {
+			// scale into pixels (nb w = min; h = max for axes limits)
+			px		= (_buckets[iBucket].time_ns / 1e9 - _xlim.width) / (_xlim.height - _xlim.width) * bounds.size.width;
+			pyMin	= (_buckets[iBucket].min - _ylim.width) / (_ylim.height - _ylim.width) * bounds.size.height;
+			pyMax	= (_buckets[iBucket].max - _ylim.width) / (_ylim.height - _ylim.width) * bounds.size.height;
+
+			if (iBucket == 0) {
+				[aPath moveToPoint:NSMakePoint(px, pyMin)];
+			} else {
+				[aPath lineToPoint:NSMakePoint(px, pyMin)];
+			}
+			if (pyMax != pyMin) {
+				[aPath lineToPoint:NSMakePoint(px, pyMax)];
+			}
+		}	// loop on buckets
+
+		[color setStroke];
+		[aPath stroke];
 	}
 
 	// to do: axes, limits
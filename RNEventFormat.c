@@ -0,0 +1,159 @@
+//
+//  RNEventFormat.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNEventFormat.h"
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+// "00" "01" ... "99": two output digits per table lookup
+static const char kDigitPairs[201] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+size_t RNFormatInt64(char *dst, int64_t value)
+{
+	char		tmp[kRNEventFormatMaxInt64Length];
+	char		*p = tmp + sizeof(tmp);
+	uint64_t	u;
+	size_t		len = 0;
+
+	if (value < 0) {
+		*dst++ = '-';
+		len = 1;
+		u = (uint64_t)0 - (uint64_t)value; // safe for INT64_MIN
+	} else {
+		u = (uint64_t)value;
+	}
+
+	// fill from the right, two digits at a time
+	while (u >= 100) {
+		unsigned pair = (unsigned)(u % 100);
+		u /= 100;
+		p -= 2;
+		memcpy(p, &kDigitPairs[pair * 2], 2);
+	}
+	if (u >= 10) {
+		p -= 2;
+		memcpy(p, &kDigitPairs[u * 2], 2);
+	} else {
+		*--p = (char)('0' + u);
+	}
+
+	size_t nDigits = (size_t)(tmp + sizeof(tmp) - p);
+	memcpy(dst, p, nDigits);
+	return len + nDigits;
+}
+
+size_t RNFormatUInt8(char *dst, uint8_t value)
+{
+	if (value >= 100) {
+		unsigned hundreds = value / 100;
+		dst[0] = (char)('0' + hundreds);
+		memcpy(dst + 1, &kDigitPairs[(value - hundreds * 100) * 2], 2);
+		return 3;
+	} else if (value >= 10) {
+		memcpy(dst, &kDigitPairs[value * 2], 2);
+		return 2;
+	}
+	dst[0] = (char)('0' + value);
+	return 1;
+}
+
+size_t RNFormatEventRows(char *dst, size_t capacity, const RNEventColumns *columns, size_t nRows,
+						 RNEventFormatStyle style, size_t *rowsWritten)
+{
+	const char		sep = (style == kRNEventFormatCSV) ? ',' : '\t';
+	const unsigned	nFields = (columns->nByteFields > kRNEventFormatMaxByteFields) ? kRNEventFormatMaxByteFields : columns->nByteFields;
+	const size_t	maxRow = RNEventFormatMaxRowLength(nFields);
+	char			*p = dst;
+	char			*end = dst + capacity;
+	const char		*timePtr = (const char *)columns->time;
+	size_t			iRow;
+
+	for (iRow = 0; iRow < nRows; iRow++) {
+		// worst-case check only near the end of the buffer
+		if ((size_t)(end - p) < maxRow) {
+			char	row[kRNEventFormatMaxInt64Length + (kRNEventFormatMaxByteFields * 4) + 1];
+			char	*q = row;
+			q += RNFormatInt64(q, *(const int64_t *)(timePtr + iRow * columns->timeStride));
+			for (unsigned iField = 0; iField < nFields; iField++) {
+				*q++ = sep;
+				q += RNFormatUInt8(q, columns->field[iField][iRow * columns->fieldStride[iField]]);
+			}
+			*q++ = '\n';
+			if ((size_t)(q - row) > (size_t)(end - p)) break;
+			memcpy(p, row, (size_t)(q - row));
+			p += (q - row);
+			continue;
+		}
+
+		p += RNFormatInt64(p, *(const int64_t *)(timePtr + iRow * columns->timeStride));
+		for (unsigned iField = 0; iField < nFields; iField++) {
+			*p++ = sep;
+			p += RNFormatUInt8(p, columns->field[iField][iRow * columns->fieldStride[iField]]);
+		}
+		*p++ = '\n';
+	}
+
+	if (rowsWritten) *rowsWritten = iRow;
+	return (size_t)(p - dst);
+}
+
+size_t RNFormatTimeList(char *dst, size_t capacity, const int64_t *times, size_t nTimes, size_t *timesWritten)
+{
+	RNEventColumns columns = { .time = times, .timeStride = sizeof(int64_t), .nByteFields = 0 };
+	return RNFormatEventRows(dst, capacity, &columns, nTimes, kRNEventFormatTSV, timesWritten);
+}
+
+double RNEventFormatBenchmark(size_t nRows, unsigned nRepeats)
+{
+	int64_t		*times = malloc(nRows * sizeof(int64_t));
+	uint8_t		*bytes = malloc(nRows * 3);
+	size_t		capacity = nRows * RNEventFormatMaxRowLength(3);
+	char		*buf = malloc(capacity);
+	struct timespec t0, t1;
+	size_t		total = 0;
+
+	if (!times || !bytes || !buf || nRows == 0 || nRepeats == 0) {
+		free(times); free(bytes); free(buf);
+		return 0.0;
+	}
+
+	// plausible session: ~500 ms spacing, 16 channels, node notes, varied velocity
+	for (size_t i = 0; i < nRows; i++) {
+		times[i] = (int64_t)i * 487123457LL + 5000000000LL;
+		bytes[3 * i + 0] = (uint8_t)(i % 16);
+		bytes[3 * i + 1] = (uint8_t)(64 + (i % 16));
+		bytes[3 * i + 2] = (uint8_t)(i % 128);
+	}
+
+	RNEventColumns columns = {
+		.time = times, .timeStride = sizeof(int64_t), .nByteFields = 3,
+		.field = { bytes, bytes + 1, bytes + 2 }, .fieldStride = { 3, 3, 3 },
+	};
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (unsigned r = 0; r < nRepeats; r++) {
+		total += RNFormatEventRows(buf, capacity, &columns, nRows, kRNEventFormatTSV, NULL);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	double elapsed_ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+	volatile size_t sink = total; (void)sink; // keep the work
+
+	free(times); free(bytes); free(buf);
+	return elapsed_ns / ((double)nRows * nRepeats);
+}
@@ -0,0 +1,72 @@
+//
+//  RNEventFormat.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Bulk text formatting of recorded events. Writes integer ns timestamps and
+//	byte fields straight into a caller-supplied char buffer using a two-digit
+//	lookup table, so no per-event objects or printf parsing are involved.
+//	Output is byte-for-byte what "%qi\t%d\t%d\t%d\n" produced, so existing
+//	saved-file readers (matlab) are unaffected.
+//
+// Plain C: also built into Tools/rnanalyze.
+
+#ifndef RNEventFormat_h
+#define RNEventFormat_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	kRNEventFormatTSV = 0,	// tab separated, as stored in the save file's recordedEvents field
+	kRNEventFormatCSV = 1,	// comma separated, for export
+} RNEventFormatStyle;
+
+#define kRNEventFormatMaxByteFields	8
+#define kRNEventFormatMaxInt64Length	20	// "-9223372036854775808"
+
+// Worst-case length of one formatted row: timestamp, byte fields (<=3 digits), separators and newline.
+static inline size_t RNEventFormatMaxRowLength(unsigned nByteFields) {
+	return kRNEventFormatMaxInt64Length + (nByteFields * 4) + 1;
+}
+
+// Column description for RNFormatEventRows. Pointers are to the first element, strides
+//	are in bytes, so an array of structs (e.g. NoteOnMessage) and plain columns both work.
+typedef struct {
+	const int64_t	*time;
+	size_t			timeStride;
+	unsigned		nByteFields;
+	const uint8_t	*field[kRNEventFormatMaxByteFields];
+	size_t			fieldStride[kRNEventFormatMaxByteFields];
+} RNEventColumns;
+
+// Format a signed integer into dst (no terminator). Returns number of chars written (<= 20).
+size_t RNFormatInt64(char *dst, int64_t value);
+
+// Format a byte as decimal into dst (no terminator). Returns number of chars written (1..3).
+size_t RNFormatUInt8(char *dst, uint8_t value);
+
+// Format nRows rows "time<sep>f0<sep>f1...\n" into dst. Stops before a row that would not fit
+//	in capacity. Returns bytes written; *rowsWritten (optional) receives the number of complete rows.
+size_t RNFormatEventRows(char *dst, size_t capacity, const RNEventColumns *columns, size_t nRows,
+						 RNEventFormatStyle style, size_t *rowsWritten);
+
+// Format a list of times, one per line ("%qi\n"), as used for stimulus eventTimes.
+//	Same truncation rules as RNFormatEventRows.
+size_t RNFormatTimeList(char *dst, size_t capacity, const int64_t *times, size_t nTimes, size_t *timesWritten);
+
+// Rough timing of the formatter: formats nRows synthetic 3-field rows nRepeats times and
+//	returns mean ns per row (uses clock_gettime, so usable off the realtime path only).
+double RNEventFormatBenchmark(size_t nRows, unsigned nRepeats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNEventFormat_h */
@@ -0,0 +1,66 @@
+//
+//  RNEventJournal.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Binary journal of recorded events: a fixed header followed by one packed record per event,
+//	in recording order. Written next to the plist when an experiment is saved (<file>.rnj) and
+//	read by offline tools with mmap, so nothing has to parse the recordedEvents text.
+//	Little-endian, as on every machine we record or analyze on.
+//
+// Plain C: read by Tools/rnanalyze and Tools/rnsimulate.
+
+#ifndef RNEventJournal_h
+#define RNEventJournal_h
+
+#include <stdint.h>
+#include "RNEventStore.h"
+
+#define kRNEventJournalMagic	"RNJ1"
+#define kRNEventJournalVersion	1
+
+typedef struct {
+	char		magic[4];					// kRNEventJournalMagic
+	uint32_t	version;
+	uint32_t	recordSize;					// sizeof(RNEventJournalRecord); readers skip any extra bytes
+	uint32_t	reserved;
+	uint64_t	nRecords;
+	int64_t		experimentStartTime_ns;		// host clock; record times are relative to this
+} RNEventJournalHeader;
+
+// same fields as RNEvent, with the layout pinned down
+typedef struct {
+	int64_t		time_ns;
+	int64_t		sendTime_ns;
+	uint32_t	sourceID;
+	uint16_t	node;
+	uint8_t		channel;
+	uint8_t		note;
+	uint8_t		velocity;
+	uint8_t		kind;		// RNEventKind
+	uint8_t		flags;
+	uint8_t		spare[5];	// explicit padding to 32 bytes
+} RNEventJournalRecord;
+
+_Static_assert(sizeof(RNEventJournalHeader) == 32, "journal header layout");
+_Static_assert(sizeof(RNEventJournalRecord) == 32, "journal record layout");
+
+static inline RNEventJournalRecord RNEventJournalRecordFromEvent(const RNEvent *event)
+{
+	RNEventJournalRecord record = {
+		.time_ns		= event->time_ns,
+		.sendTime_ns	= event->sendTime_ns,
+		.sourceID		= event->sourceID,
+		.node			= event->node,
+		.channel		= event->channel,
+		.note			= event->note,
+		.velocity		= event->velocity,
+		.kind			= event->kind,
+		.flags			= event->flags,
+	};
+	return record;
+}
+
+#endif /* RNEventJournal_h */
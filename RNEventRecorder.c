@@ -0,0 +1,135 @@
+//
+//  RNEventRecorder.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNEventRecorder.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kRingMask	(kRNEventRecorderRingLength - 1)
+
+typedef struct {
+	RNEvent				events[kRNEventRecorderRingLength];
+	_Atomic(uint32_t)	head;		// next slot to write; producer only (free running, wraps)
+	_Atomic(uint32_t)	tail;		// next slot to read; consumer only
+	_Atomic(uint64_t)	received;
+	_Atomic(uint64_t)	dropped;
+} RNEventRing;
+
+struct RNEventRecorder {
+	RNEventStore		*store;
+	int64_t				timeBase_ns;
+	RNEventRing			rings[kRNEventRecorderNumProducers];
+	_Atomic(uint64_t)	stored;
+	_Atomic(uint64_t)	storeDropped;						// ring delivered, store refused
+	RNEvent				batch[kRNEventRecorderBatchLength];	// consumer scratch
+};
+
+RNEventRecorder *RNEventRecorderCreate(RNEventStore *store)
+{
+	RNEventRecorder *recorder = calloc(1, sizeof(RNEventRecorder));
+	if (recorder) recorder->store = store;
+	return recorder;
+}
+
+void RNEventRecorderDestroy(RNEventRecorder *recorder)
+{
+	free(recorder);
+}
+
+void RNEventRecorderSetTimeBase(RNEventRecorder *recorder, int64_t timeBase_ns)
+{
+	recorder->timeBase_ns = timeBase_ns;
+}
+
+uint32_t RNEventRecorderPush(RNEventRecorder *recorder, RNEventRecorderProducer producer,
+							 const RNEvent *events, uint32_t nEvents)
+{
+	if ((unsigned)producer >= kRNEventRecorderNumProducers) return 0;
+	RNEventRing *ring = &recorder->rings[producer];
+
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	uint32_t space = kRNEventRecorderRingLength - (head - tail);
+	uint32_t nAccepted = (nEvents < space) ? nEvents : space;
+
+	// at most two contiguous copies
+	uint32_t slot = head & kRingMask;
+	uint32_t first = kRNEventRecorderRingLength - slot;
+	if (first > nAccepted) first = nAccepted;
+	memcpy(&ring->events[slot], events, first * sizeof(RNEvent));
+	memcpy(&ring->events[0], events + first, (nAccepted - first) * sizeof(RNEvent));
+
+	atomic_store_explicit(&ring->head, head + nAccepted, memory_order_release);
+	atomic_fetch_add_explicit(&ring->received, nEvents, memory_order_relaxed);
+	if (nAccepted < nEvents)
+		atomic_fetch_add_explicit(&ring->dropped, nEvents - nAccepted, memory_order_relaxed);
+	return nAccepted;
+}
+
+uint32_t RNEventRecorderFlush(RNEventRecorder *recorder)
+{
+	const int64_t base = recorder->timeBase_ns;
+	uint32_t nStored = 0;
+
+	for (unsigned iRing = 0; iRing < kRNEventRecorderNumProducers; iRing++) {
+		RNEventRing *ring = &recorder->rings[iRing];
+		uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+		while (tail != head) {
+			// contiguous span, at most one batch
+			uint32_t slot = tail & kRingMask;
+			uint32_t n = head - tail;
+			if (n > kRNEventRecorderRingLength - slot) n = kRNEventRecorderRingLength - slot;
+			if (n > kRNEventRecorderBatchLength) n = kRNEventRecorderBatchLength;
+
+			memcpy(recorder->batch, &ring->events[slot], n * sizeof(RNEvent));
+			atomic_store_explicit(&ring->tail, tail + n, memory_order_release); // slots free for the producer
+			tail += n;
+
+			for (uint32_t i = 0; i < n; i++) {
+				recorder->batch[i].time_ns		-= base;
+				recorder->batch[i].sendTime_ns	-= base;
+			}
+
+			uint32_t nAppended = RNEventStoreAppendEvents(recorder->store, recorder->batch, n);
+			nStored += nAppended;
+			if (nAppended < n)
+				atomic_fetch_add_explicit(&recorder->storeDropped, n - nAppended, memory_order_relaxed);
+		}
+	}
+
+	atomic_fetch_add_explicit(&recorder->stored, nStored, memory_order_relaxed);
+	return nStored;
+}
+
+void RNEventRecorderReset(RNEventRecorder *recorder)
+{
+	for (unsigned iRing = 0; iRing < kRNEventRecorderNumProducers; iRing++) {
+		RNEventRing *ring = &recorder->rings[iRing];
+		atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->head, memory_order_acquire), memory_order_release);
+		atomic_store_explicit(&ring->received, 0, memory_order_relaxed);
+		atomic_store_explicit(&ring->dropped, 0, memory_order_relaxed);
+	}
+	atomic_store_explicit(&recorder->stored, 0, memory_order_relaxed);
+	atomic_store_explicit(&recorder->storeDropped, 0, memory_order_relaxed);
+}
+
+RNEventRecorderCounts RNEventRecorderGetCounts(const RNEventRecorder *recorder)
+{
+	RNEventRecorder *r = (RNEventRecorder *)recorder;
+	RNEventRecorderCounts counts = { 0, 0, 0 };
+
+	for (unsigned iRing = 0; iRing < kRNEventRecorderNumProducers; iRing++) {
+		counts.received	+= atomic_load_explicit(&r->rings[iRing].received, memory_order_relaxed);
+		counts.dropped	+= atomic_load_explicit(&r->rings[iRing].dropped, memory_order_relaxed);
+	}
+	counts.stored	= atomic_load_explicit(&r->stored, memory_order_relaxed);
+	counts.dropped	+= atomic_load_explicit(&r->storeDropped, memory_order_relaxed);
+	return counts;
+}
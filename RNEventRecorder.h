@@ -0,0 +1,73 @@
+//
+//  RNEventRecorder.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Recording path between the MIDI processing thread and the event store.
+//
+//	- each producer (the MIDI processing thread, the stimulus scheduler) owns one
+//	  single-producer/single-consumer ring of RNEvents: pushing is a copy and a release
+//	  store, with no locks or allocation, so it is safe on the realtime thread
+//	- producers push times as absolute ns (host clock); the consumer rebases them to the
+//	  experiment start in bulk when it flushes
+//	- a single consumer flushes rings into the store in large batches, so the store keeps
+//	  its single writer no matter how many threads produce events
+//	- if a ring is full, events are dropped and counted, never blocked on
+
+#ifndef RNEventRecorder_h
+#define RNEventRecorder_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNEventStore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNEventRecorderRingLength	8192	// events per producer ring (power of 2): ~minutes of tapping
+#define kRNEventRecorderBatchLength	1024	// events rebased and appended per batch when flushing
+
+typedef enum {
+	kRNEventRecorderProducerMIDI		= 0,	// MIDI processing thread: taps and the feedback they cause
+	kRNEventRecorderProducerStimulus	= 1,	// stimulus scheduler thread: stimuli as they are sent
+	kRNEventRecorderNumProducers
+} RNEventRecorderProducer;
+
+typedef struct {
+	uint64_t	received;	// pushed by producers
+	uint64_t	stored;		// appended to the store
+	uint64_t	dropped;	// lost because a ring or the store was full
+} RNEventRecorderCounts;
+
+typedef struct RNEventRecorder RNEventRecorder;
+
+// The recorder appends to store, which it does not own.
+RNEventRecorder			*RNEventRecorderCreate(RNEventStore *store);
+void					RNEventRecorderDestroy(RNEventRecorder *recorder);
+
+// Absolute time (ns) subtracted from every event time as it is flushed. Consumer side.
+void					RNEventRecorderSetTimeBase(RNEventRecorder *recorder, int64_t timeBase_ns);
+
+// Producer side: only one thread may push to a given producer ring. Event times (time_ns and
+//	sendTime_ns) are absolute. Returns the number of events accepted; the rest are counted as dropped.
+uint32_t				RNEventRecorderPush(RNEventRecorder *recorder, RNEventRecorderProducer producer,
+											const RNEvent *events, uint32_t nEvents);
+
+// Consumer side: drain all rings into the store. Returns the number of events stored.
+uint32_t				RNEventRecorderFlush(RNEventRecorder *recorder);
+
+// Consumer side: discard anything pending and zero the counts (e.g. when the store is cleared).
+void					RNEventRecorderReset(RNEventRecorder *recorder);
+
+// Any thread.
+RNEventRecorderCounts	RNEventRecorderGetCounts(const RNEventRecorder *recorder);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNEventRecorder_h */
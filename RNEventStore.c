@@ -0,0 +1,383 @@
+//
+//  RNEventStore.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNEventStore.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kChunkMask	(kRNEventStoreChunkSize - 1)
+
+typedef struct {
+	int64_t		time_ns[kRNEventStoreChunkSize];
+	int64_t		sendTime_ns[kRNEventStoreChunkSize];
+	int64_t		maxTime_ns[kRNEventStoreChunkSize];		// running maximum of time_ns up to here
+	uint32_t	sourceID[kRNEventStoreChunkSize];
+	uint16_t	node[kRNEventStoreChunkSize];
+	uint8_t		channel[kRNEventStoreChunkSize];
+	uint8_t		note[kRNEventStoreChunkSize];
+	uint8_t		velocity[kRNEventStoreChunkSize];
+	uint8_t		kind[kRNEventStoreChunkSize];
+	uint8_t		flags[kRNEventStoreChunkSize];
+} RNEventChunk;
+
+// Stimulus events are appended up to a lookahead ahead of taps, so neither the store nor a
+//	list is strictly in time order. Each keeps the running maximum time per position, which is
+//	monotonic, and the largest amount any event fell behind it (disorder). An event's time is
+//	then within [max - disorder, max], so range queries binary search the running maximum and
+//	only scan the disorder window at each end.
+
+// append-only list of event indexes; chunk tables allocated on first use
+typedef struct {
+	uint32_t			**chunks;		// kRNEventStoreMaxChunks entries
+	int64_t				**maxChunks;	// running maximum time, parallel to chunks
+	_Atomic(uint32_t)	count;
+	int64_t				maxTime_ns;		// writer only
+	_Atomic(int64_t)	disorder_ns;
+} RNEventIndexList;
+
+struct RNEventStore {
+	RNEventChunk		*chunks[kRNEventStoreMaxChunks];
+	_Atomic(uint32_t)	count;
+	int64_t				maxTime_ns;
+	_Atomic(int64_t)	disorder_ns;
+	RNEventIndexList	lists[kRNEventKindCount][kRNEventStoreMaxNodes];
+};
+
+RNEventStore *RNEventStoreCreate(void)
+{
+	RNEventStore *store = calloc(1, sizeof(RNEventStore));
+	if (store) RNEventStoreClear(store);
+	return store;
+}
+
+void RNEventStoreDestroy(RNEventStore *store)
+{
+	if (!store) return;
+	for (unsigned i = 0; i < kRNEventStoreMaxChunks; i++) free(store->chunks[i]);
+	for (unsigned k = 0; k < kRNEventKindCount; k++) {
+		for (unsigned n = 0; n < kRNEventStoreMaxNodes; n++) {
+			RNEventIndexList *list = &store->lists[k][n];
+			if (!list->chunks) continue;
+			for (unsigned i = 0; i < kRNEventStoreMaxChunks; i++) {
+				free(list->chunks[i]);
+				free(list->maxChunks[i]);
+			}
+			free(list->chunks);
+			free(list->maxChunks);
+		}
+	}
+	free(store);
+}
+
+void RNEventStoreClear(RNEventStore *store)
+{
+	atomic_store(&store->count, 0);
+	atomic_store(&store->disorder_ns, 0);
+	store->maxTime_ns = INT64_MIN;
+	for (unsigned k = 0; k < kRNEventKindCount; k++) {
+		for (unsigned n = 0; n < kRNEventStoreMaxNodes; n++) {
+			RNEventIndexList *list = &store->lists[k][n];
+			atomic_store(&list->count, 0);
+			atomic_store(&list->disorder_ns, 0);
+			list->maxTime_ns = INT64_MIN;
+		}
+	}
+}
+
+static bool indexListAppend(RNEventIndexList *list, uint32_t eventIndex, int64_t time_ns)
+{
+	uint32_t n = atomic_load_explicit(&list->count, memory_order_relaxed);
+	uint32_t iChunk = n >> kRNEventStoreChunkShift;
+
+	if (iChunk >= kRNEventStoreMaxChunks) return false;
+	if (!list->chunks) {
+		list->chunks = calloc(kRNEventStoreMaxChunks, sizeof(uint32_t *));
+		list->maxChunks = calloc(kRNEventStoreMaxChunks, sizeof(int64_t *));
+		if (!list->chunks || !list->maxChunks) {
+			free(list->chunks);							// both or neither: the rest of the store tests only chunks
+			free(list->maxChunks);
+			list->chunks = NULL;
+			list->maxChunks = NULL;
+			return false;
+		}
+	}
+	if (!list->chunks[iChunk]) {
+		list->chunks[iChunk] = malloc(kRNEventStoreChunkSize * sizeof(uint32_t));
+		if (!list->chunks[iChunk]) return false;
+	}
+	if (!list->maxChunks[iChunk]) {
+		list->maxChunks[iChunk] = malloc(kRNEventStoreChunkSize * sizeof(int64_t));
+		if (!list->maxChunks[iChunk]) return false;
+	}
+
+	if (time_ns > list->maxTime_ns) list->maxTime_ns = time_ns;
+	else if (list->maxTime_ns - time_ns > atomic_load_explicit(&list->disorder_ns, memory_order_relaxed))
+		atomic_store_explicit(&list->disorder_ns, list->maxTime_ns - time_ns, memory_order_relaxed);
+	list->chunks[iChunk][n & kChunkMask] = eventIndex;
+	list->maxChunks[iChunk][n & kChunkMask] = list->maxTime_ns;
+	atomic_store_explicit(&list->count, n + 1, memory_order_release);
+	return true;
+}
+
+bool RNEventStoreAppend(RNEventStore *store, const RNEvent *event)
+{
+	uint32_t n = atomic_load_explicit(&store->count, memory_order_relaxed);
+	uint32_t iChunk = n >> kRNEventStoreChunkShift;
+	uint32_t slot = n & kChunkMask;
+
+	if (iChunk >= kRNEventStoreMaxChunks || event->kind >= kRNEventKindCount) return false;
+	if (!store->chunks[iChunk]) {
+		store->chunks[iChunk] = malloc(sizeof(RNEventChunk));
+		if (!store->chunks[iChunk]) return false;
+	}
+
+	RNEventChunk *chunk = store->chunks[iChunk];
+	chunk->time_ns[slot]	= event->time_ns;
+	chunk->sendTime_ns[slot] = event->sendTime_ns;
+	chunk->sourceID[slot]	= event->sourceID;
+	chunk->node[slot]		= event->node;
+	chunk->channel[slot]	= event->channel;
+	chunk->note[slot]		= event->note;
+	chunk->velocity[slot]	= event->velocity;
+	chunk->kind[slot]		= event->kind;
+	chunk->flags[slot]		= event->flags;
+
+	if (event->time_ns > store->maxTime_ns) store->maxTime_ns = event->time_ns;
+	else if (store->maxTime_ns - event->time_ns > atomic_load_explicit(&store->disorder_ns, memory_order_relaxed))
+		atomic_store_explicit(&store->disorder_ns, store->maxTime_ns - event->time_ns, memory_order_relaxed);
+	chunk->maxTime_ns[slot]	= store->maxTime_ns;
+	atomic_store_explicit(&store->count, n + 1, memory_order_release);
+
+	// index lists are published after the event itself, so any index a reader finds is valid
+	if (event->node < kRNEventStoreMaxNodes)
+		indexListAppend(&store->lists[event->kind][event->node], n, event->time_ns);
+
+	return true;
+}
+
+uint32_t RNEventStoreAppendEvents(RNEventStore *store, const RNEvent *events, uint32_t nEvents)
+{
+	uint32_t i;
+	for (i = 0; i < nEvents; i++) {
+		if (!RNEventStoreAppend(store, &events[i])) break;
+	}
+	return i;
+}
+
+// *********************************************
+//    Readers
+// *********************************************
+
+uint32_t RNEventStoreCount(const RNEventStore *store)
+{
+	return atomic_load_explicit(&((RNEventStore *)store)->count, memory_order_acquire);
+}
+
+RNEvent RNEventStoreEventAtIndex(const RNEventStore *store, uint32_t index)
+{
+	const RNEventChunk *chunk = store->chunks[index >> kRNEventStoreChunkShift];
+	uint32_t slot = index & kChunkMask;
+	RNEvent event = {
+		.time_ns	= chunk->time_ns[slot],
+		.sendTime_ns = chunk->sendTime_ns[slot],
+		.sourceID	= chunk->sourceID[slot],
+		.node		= chunk->node[slot],
+		.channel	= chunk->channel[slot],
+		.note		= chunk->note[slot],
+		.velocity	= chunk->velocity[slot],
+		.kind		= chunk->kind[slot],
+		.flags		= chunk->flags[slot],
+	};
+	return event;
+}
+
+int64_t RNEventStoreTimeAtIndex(const RNEventStore *store, uint32_t index)
+{
+	return store->chunks[index >> kRNEventStoreChunkShift]->time_ns[index & kChunkMask];
+}
+
+static const RNEventIndexList *indexList(const RNEventStore *store, RNEventKind kind, uint16_t node)
+{
+	if ((unsigned)kind >= kRNEventKindCount || node >= kRNEventStoreMaxNodes) return NULL;
+	return &store->lists[kind][node];
+}
+
+uint32_t RNEventStoreNodeCount(const RNEventStore *store, RNEventKind kind, uint16_t node)
+{
+	const RNEventIndexList *list = indexList(store, kind, node);
+	return list ? atomic_load_explicit(&((RNEventIndexList *)list)->count, memory_order_acquire) : 0;
+}
+
+uint32_t RNEventStoreNodeEventIndex(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position)
+{
+	const RNEventIndexList *list = &store->lists[kind][node];
+	return list->chunks[position >> kRNEventStoreChunkShift][position & kChunkMask];
+}
+
+int64_t RNEventStoreNodeTime(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position)
+{
+	return RNEventStoreTimeAtIndex(store, RNEventStoreNodeEventIndex(store, kind, node, position));
+}
+
+// generic search over a sequence of times given by accessors for the time and running maximum
+typedef int64_t (*TimeAccessor)(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position);
+
+static int64_t globalTime(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position)
+{
+	(void)kind; (void)node;
+	return RNEventStoreTimeAtIndex(store, position);
+}
+
+static int64_t globalMaxTime(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position)
+{
+	(void)kind; (void)node;
+	return store->chunks[position >> kRNEventStoreChunkShift]->maxTime_ns[position & kChunkMask];
+}
+
+static int64_t nodeMaxTime(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position)
+{
+	return store->lists[kind][node].maxChunks[position >> kRNEventStoreChunkShift][position & kChunkMask];
+}
+
+static uint32_t lowerBound(const RNEventStore *store, RNEventKind kind, uint16_t node, TimeAccessor timeAt, uint32_t n, int64_t t)
+{
+	uint32_t lo = 0, hi = n;
+	while (lo < hi) {
+		uint32_t mid = lo + ((hi - lo) >> 1);
+		if (timeAt(store, kind, node, mid) < t) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+static RNEventRange rangeForTime(const RNEventStore *store, RNEventKind kind, uint16_t node, TimeAccessor timeAt,
+								 TimeAccessor maxTimeAt, uint32_t n, int64_t disorder_ns, int64_t t0, int64_t t1)
+{
+	RNEventRange range = { 0, 0 };
+
+	if (n == 0 || t1 <= t0) return range;
+
+	if (disorder_ns == 0) {
+		range.first	= lowerBound(store, kind, node, timeAt, n, t0);
+		range.end	= lowerBound(store, kind, node, timeAt, n, t1);
+		return range;
+	}
+
+	// before first every time is < t0; from end on every time is >= t1
+	uint32_t first	= lowerBound(store, kind, node, maxTimeAt, n, t0);
+	uint32_t end	= lowerBound(store, kind, node, maxTimeAt, n, t1 > INT64_MAX - disorder_ns ? INT64_MAX : t1 + disorder_ns);
+
+	// trim to the hull of the matches, scanning only the disorder window
+	while (first < end) {
+		int64_t t = timeAt(store, kind, node, first);
+		if (t >= t0 && t < t1) break;
+		first++;
+	}
+	if (first == end) return range;
+	while (end > first) {
+		int64_t t = timeAt(store, kind, node, end - 1);
+		if (t >= t0 && t < t1) break;
+		end--;
+	}
+	range.first = first;
+	range.end	= end;
+	return range;
+}
+
+RNEventRange RNEventStoreNodeRangeForTime(const RNEventStore *store, RNEventKind kind, uint16_t node, int64_t t0, int64_t t1)
+{
+	const RNEventIndexList *list = indexList(store, kind, node);
+	RNEventRange empty = { 0, 0 };
+	if (!list) return empty;
+	uint32_t n = RNEventStoreNodeCount(store, kind, node);
+	int64_t disorder_ns = atomic_load_explicit(&((RNEventIndexList *)list)->disorder_ns, memory_order_relaxed);
+	return rangeForTime(store, kind, node, RNEventStoreNodeTime, nodeMaxTime, n, disorder_ns, t0, t1);
+}
+
+RNEventRange RNEventStoreRangeForTime(const RNEventStore *store, int64_t t0, int64_t t1)
+{
+	uint32_t n = RNEventStoreCount(store);
+	int64_t disorder_ns = atomic_load_explicit(&((RNEventStore *)store)->disorder_ns, memory_order_relaxed);
+	return rangeForTime(store, kRNEventKindTap, 0, globalTime, globalMaxTime, n, disorder_ns, t0, t1);
+}
+
+// *********************************************
+//    Export
+// *********************************************
+
+size_t RNEventStoreFormatLength(const RNEventStore *store, RNEventKind kind)
+{
+	(void)kind; // bounded by the total, which also covers events with unindexed node numbers
+	return (size_t)RNEventStoreCount(store) * RNEventFormatMaxRowLength(3);
+}
+
+size_t RNEventStoreFormat(const RNEventStore *store, RNEventKind kind, char *dst, size_t capacity, RNEventFormatStyle style)
+{
+	uint32_t	n = RNEventStoreCount(store);
+	size_t		length = 0;
+	uint32_t	iEvent = 0;
+
+	// walk chunk by chunk, formatting runs of the requested kind in bulk
+	while (iEvent < n) {
+		const RNEventChunk *chunk = store->chunks[iEvent >> kRNEventStoreChunkShift];
+		uint32_t slot = iEvent & kChunkMask;
+		uint32_t chunkEnd = kRNEventStoreChunkSize;
+		if ((iEvent - slot) + chunkEnd > n) chunkEnd = n - (iEvent - slot);
+
+		while (slot < chunkEnd) {
+			if (chunk->kind[slot] != kind) { slot++; continue; }
+			uint32_t runEnd = slot + 1;
+			while (runEnd < chunkEnd && chunk->kind[runEnd] == kind) runEnd++;
+
+			RNEventColumns columns = {
+				.time = &chunk->time_ns[slot], .timeStride = sizeof(int64_t), .nByteFields = 3,
+				.field = { &chunk->channel[slot], &chunk->note[slot], &chunk->velocity[slot] },
+				.fieldStride = { 1, 1, 1 },
+			};
+			size_t nRows = runEnd - slot, nWritten = 0;
+			length += RNFormatEventRows(dst + length, capacity - length, &columns, nRows, style, &nWritten);
+			if (nWritten < nRows) return length;	// out of space
+			slot = runEnd;
+		}
+		iEvent = (iEvent - (iEvent & kChunkMask)) + chunkEnd;
+	}
+	return length;
+}
+
+size_t RNEventStoreFormatEmittedLength(const RNEventStore *store)
+{
+	return (size_t)RNEventStoreCount(store) * kRNEventStoreEmittedMaxRowLength;
+}
+
+// emitted events are comparatively few (a handful per tap), so a plain row loop suffices
+size_t RNEventStoreFormatEmitted(const RNEventStore *store, char *dst, size_t capacity, RNEventFormatStyle style)
+{
+	const char	sep = (style == kRNEventFormatCSV) ? ',' : '\t';
+	uint32_t	n = RNEventStoreCount(store);
+	char		*p = dst;
+	char		*end = dst + capacity;
+
+	for (uint32_t iEvent = 0; iEvent < n; iEvent++) {
+		const RNEventChunk *chunk = store->chunks[iEvent >> kRNEventStoreChunkShift];
+		uint32_t slot = iEvent & kChunkMask;
+		if (chunk->kind[slot] == kRNEventKindTap) continue;
+		if ((size_t)(end - p) < kRNEventStoreEmittedMaxRowLength) break;	// out of space
+
+		p += RNFormatInt64(p, chunk->time_ns[slot]);			*p++ = sep;
+		p += RNFormatInt64(p, chunk->sendTime_ns[slot]);		*p++ = sep;
+		p += RNFormatUInt8(p, chunk->kind[slot]);				*p++ = sep;
+		p += RNFormatInt64(p, chunk->sourceID[slot]);			*p++ = sep;
+		p += RNFormatInt64(p, chunk->node[slot]);				*p++ = sep;
+		p += RNFormatUInt8(p, chunk->channel[slot]);			*p++ = sep;
+		p += RNFormatUInt8(p, chunk->note[slot]);				*p++ = sep;
+		p += RNFormatUInt8(p, chunk->velocity[slot]);			*p++ = sep;
+		p += RNFormatUInt8(p, chunk->flags[slot]);
+		*p++ = '\n';
+	}
+	return (size_t)(p - dst);
+}
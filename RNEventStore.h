@@ -0,0 +1,116 @@
+//
+//  RNEventStore.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Columnar in-memory store of experiment events: one copy of the data, queried by
+//	recording, display, analysis and export alike.
+//
+//	- columns (time, send time, source id, node, channel, note, velocity, kind, flags) live in fixed-size chunks that are
+//	  never moved once allocated, so appends never invalidate what a reader is looking at
+//	- every event is also appended to a per-(kind, node) index list, so e.g. all taps of
+//	  node 3 are available without scanning
+//	- one writer, any number of readers: the writer fills a slot, then publishes the new
+//	  count with release semantics; readers acquire the count and only look below it
+//	- times are ns relative to experiment start (signed: events can precede the start)
+//
+// Plain C: its event type reaches Tools/rnsimulate through RNSimulator.h.
+
+#ifndef RNEventStore_h
+#define RNEventStore_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNEventFormat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNEventStoreChunkShift		12
+#define kRNEventStoreChunkSize		(1u << kRNEventStoreChunkShift)	// events per chunk
+#define kRNEventStoreMaxChunks		2048							// => 8M events
+#define kRNEventStoreMaxNodes		64								// node numbers with per-node indexes (0 = BB)
+#define kRNEventStoreInvalidNode	0xFFFF
+
+typedef enum {
+	kRNEventKindTap			= 0,	// note-on received from a tapper (or BB echo)
+	kRNEventKindStimulus	= 1,	// metronome event sent to a stimulus channel
+	kRNEventKindFeedback	= 2,	// event delivered to a tapper via the network
+	kRNEventKindCount
+} RNEventKind;
+
+// flags
+#define kRNEventFlagMIOCRoute		0x01	// feedback routed inside the MIOC: inferred from the routing, not observed
+
+// For taps, time_ns is the arrival time, sendTime_ns equals it and sourceID is the tap's own id.
+//	For emitted events (stimulus, feedback), time_ns is when the event was scheduled to sound,
+//	sendTime_ns is when it was handed to CoreMIDI, node is the node that heard it and sourceID
+//	is the id of the tap that caused it (feedback) or the event number within its stimulus.
+typedef struct {
+	int64_t		time_ns;
+	int64_t		sendTime_ns;
+	uint32_t	sourceID;
+	uint16_t	node;
+	uint8_t		channel;	// 0-based MIDI channel
+	uint8_t		note;
+	uint8_t		velocity;
+	uint8_t		kind;		// RNEventKind
+	uint8_t		flags;
+} RNEvent;
+
+// half-open range of positions [first, end)
+typedef struct {
+	uint32_t	first;
+	uint32_t	end;
+} RNEventRange;
+
+typedef struct RNEventStore RNEventStore;
+
+RNEventStore	*RNEventStoreCreate(void);
+void			RNEventStoreDestroy(RNEventStore *store);
+
+// Forget all events (keeps allocated chunks). Not safe against concurrent readers or writer.
+void			RNEventStoreClear(RNEventStore *store);
+
+// Writer only. Returns false if the store is full or out of memory.
+bool			RNEventStoreAppend(RNEventStore *store, const RNEvent *event);
+// Writer only. Appends in order until done or full; returns the number appended.
+uint32_t		RNEventStoreAppendEvents(RNEventStore *store, const RNEvent *events, uint32_t nEvents);
+
+// Readers: all events, in append order
+uint32_t		RNEventStoreCount(const RNEventStore *store);
+RNEvent			RNEventStoreEventAtIndex(const RNEventStore *store, uint32_t index);
+int64_t			RNEventStoreTimeAtIndex(const RNEventStore *store, uint32_t index);
+
+// Readers: per-node index lists. position is 0..count-1 within the (kind, node) list
+uint32_t		RNEventStoreNodeCount(const RNEventStore *store, RNEventKind kind, uint16_t node);
+uint32_t		RNEventStoreNodeEventIndex(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position);
+int64_t			RNEventStoreNodeTime(const RNEventStore *store, RNEventKind kind, uint16_t node, uint32_t position);
+
+// Positions of events with t0 <= time < t1, by binary search. Lists that were appended in
+//	time order (taps always are) give an exact range. Otherwise (stimuli appended ahead by the
+//	lookahead) the range is the smallest one containing every match, found by binary search on
+//	the running maximum time plus a scan of the out-of-order window, and the caller must check times.
+RNEventRange	RNEventStoreNodeRangeForTime(const RNEventStore *store, RNEventKind kind, uint16_t node, int64_t t0, int64_t t1);
+RNEventRange	RNEventStoreRangeForTime(const RNEventStore *store, int64_t t0, int64_t t1);
+
+// Text export of events of one kind: "time<sep>channel<sep>note<sep>velocity\n" per event.
+//	RNEventStoreFormatLength gives a buffer size that is always large enough.
+size_t			RNEventStoreFormatLength(const RNEventStore *store, RNEventKind kind);
+size_t			RNEventStoreFormat(const RNEventStore *store, RNEventKind kind, char *dst, size_t capacity, RNEventFormatStyle style);
+
+// Text export of all emitted (stimulus and feedback) events, one row per event:
+//	"time<sep>sendTime<sep>kind<sep>sourceID<sep>node<sep>channel<sep>note<sep>velocity<sep>flags\n"
+#define kRNEventStoreEmittedMaxRowLength	(2 * kRNEventFormatMaxInt64Length + 10 + 5 + 5 * 3 + 9)
+size_t			RNEventStoreFormatEmittedLength(const RNEventStore *store);
+size_t			RNEventStoreFormatEmitted(const RNEventStore *store, char *dst, size_t capacity, RNEventFormatStyle style);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNEventStore_h */
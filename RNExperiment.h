@@ -9,6 +9,18 @@
 #import <Foundation/Foundation.h>
 #import <CoreMidi/MidiServices.h>
 #import "MIDIListenerProtocols.h"
+#import "RNEventFormat.h"
+#import "RNEventStore.h"
+#import "RNEventRecorder.h"
+#import "RNTimingStats.h"
+#import "RNSynchrony.h"
+#import "RNLeadLag.h"
+#import "RNHistogram.h"
+#import "RNTimeSeries.h"
+#import "RNVirtualTappers.h"
+#import "RNPacketCapture.h"
+#import "RNPartScheduler.h"
+#import "RNArchitectureDefines.h"
 
 @class	RNNetwork;
 @class	MIDIIO;
@@ -17,24 +29,44 @@
 @class	RNExperimentPart;
 @class	RNGlobalConnectionStrength;
 
-@interface RNExperiment : NSObject <MIDIDataReceiver>
+@interface RNExperiment : NSObject
 {
 	// the structure of the experiment
 	NSString                   *_definitionFilePath;
 	NSDictionary               *_definitionDictionary;     // copy of the dictionary used to define the experiment
 	NSMutableArray             *_experimentParts;          // a list of experiment parts, stimuli, networks w/ associated start times
+	uint64_t                    _randomSeed;               // stimulus jitter derives from it (definition's randomSeed, else chosen at load)
 	RNNetwork                  *_currentNetwork;           // currently active network
 	RNStimulus                 *_currentStimulusArray[17]; // currently active stimuli
 	RNGlobalConnectionStrength *_currentGlobalConnectionStrength;
+	NSString                   *_timelineReport;           // what compileTimelineForDevice: made of the parts, and any problems
 
 	// these refer to an instantiation of the experiment--data to be saved
 	// coming perilously close to document/file wrapper classes, but here will roll my own
 	NSTimeInterval _experimentDuration_s;
 	NSTimeInterval _experimentActualStopTime_s;
 	NSTimer       *_experimentEndTimer;
+	RNPartScheduler *_partScheduler;  // fires the parts' start times (host clock), once recording
+	struct RNPartStimulus *_partStimuli; // by part index: streams the part scheduler starts ahead of stimulus parts
+	NSMutableArray *_partPacketLists; // MIOC switches it sends ahead, timestamped to land as their parts start
 	MIDITimeStamp  _experimentStartTimestamp; // we maintain two formats of the starting moment
 	NSDate        *_experimentStartDate;
-	NSMutableData *_recordedEvents;
+	RNEventStore  *_eventStore;    // recorded events (single writer: the recording path)
+	RNEventRecorder *_eventRecorder;  // rings from the MIDI thread and the stimulus scheduler into _eventStore
+	dispatch_queue_t _recordingQueue; // the recorder's only consumer: flushes, clears
+	dispatch_source_t _flushTimer;
+	RNTimingStats *_timingStats;      // running per-node tap statistics, fed as events are flushed (recording queue)
+	RNSynchrony   *_synchrony;        // network order parameter and pairwise PLV, fed with _timingStats
+	RNLeadLag     *_leadLag;          // lagged ITI correlation of connected pairs, fed with _timingStats
+	RNHistogram   *_asynchronyHistograms[kMaxNodes + 1]; // per node asynchrony to its pacer, fed with _timingStats
+	RNTimingPacer  _histogramPacers[kMaxNodes + 1];      // pacer each histogram is binned for (recording queue)
+	RNTimeSeries  *_ITISeries;        // per node ITIs (ms) at each tap, decimated for plotting, fed with _timingStats
+	NSMutableArray *_frozenHistograms; // one dictionary per node and stimulus change: the histogram it closed (recording queue)
+	uint32_t       _numTimedEvents;   // store events already fed to _timingStats, _synchrony and _leadLag
+	NSMutableData *_pacerDecisions;   // RNPacerDecisions of adaptive stimuli, as read from the scheduler (recording queue)
+	RNVirtualTappers *_virtualTappers; // simulated tappers for rehearsal (RNVirtualTapperNodes default), once recording
+	uint64_t       _virtualTapperNodes; // nodes they play, where in the current network
+	RNPacketCapture *_packetCapture;  // raw MIDI input and delay output while recording (RNPacketCaptureDirectory default)
 	NSString      *_experimentDescription;
 	NSString      *_experimentNotes;
 
@@ -50,6 +82,11 @@
 - (RNExperiment *)initFromPath:(NSString *)filePath;
 - (void)dealloc;
 - (void)initializeExperimentPartsWithArray:(NSArray *)partArray NetworkSizeDict:(NSDictionary *)sizeDict;
+- (NSUInteger)compileTimelineForDevice:(MIOCModel *)device;
+- (NSString *)timelineReport;
+- (void)seedStimuli;
+- (uint64_t)randomSeed;
+- (BOOL)usesSoftwareRouting; // definition's MIDIRouting is "software": MIOCModel's internal processor (default "hardware")
 
 // accessors--structure
 - (NSString *)definitionFilePath;
@@ -84,20 +121,47 @@
 - (BOOL)needsSave;
 - (void)setNeedsSave:(BOOL)flag;
 - (void)clearRecordedEvents;
+- (RNEventStore *)eventStore;
 - (NSString *)recordedEventsString;
+- (NSString *)emittedEventsString;
+- (BOOL)writeRecordedEventsToPath:(NSString *)filePath style:(RNEventFormatStyle)style;
 - (NSDictionary *)experimentSaveDictionary;
 
-- (void)receiveMIDIData:(NSData *)MIDIData;
+- (void)flushRecordedEvents;
+- (RNEventRecorderCounts)recordingCounts;
+- (NSString *)pacerDecisionsString;
+- (RNTimingStats *)timingStats;
+- (RNSynchrony *)synchrony;
+- (NSString *)synchronyIndexString;
+- (RNLeadLag *)leadLag;
+- (RNHistogram **)asynchronyHistograms;
+- (RNTimeSeries *)ITISeries;
+- (NSArray *)frozenHistograms;
+- (NSString *)leadLagString;
+- (void)updateLeadLagConnections;
+- (void)updateTimingPacers;
+- (void)updateVirtualTappers;
+- (RNVirtualTappers *)virtualTappers;
+- (BOOL)setIOI:(double)IOI_ms forStimulus:(RNStimulus *)stim withMIDIIO:(MIDIIO *)io;
 
 // actions
 - (void)prepareToStartAtTimestamp:(MIDITimeStamp)timestamp StartDate:(NSDate *)date;
 - (void)scheduleExperimentParts;
+- (void)experimentPartAtIndex:(NSUInteger)index firedAt:(UInt64)fired_ns due:(UInt64)due_ns;
 - (void)unscheduleExperimentParts;
 - (void)startRecordingFromDevice:(MIOCModel *)MIOC;
+- (void)startVirtualTappersWithMIDIIO:(MIDIIO *)io;
+- (void)startPacketCaptureWithMIDIIO:(MIDIIO *)io;
 - (void)stopRecording;
 
 - (void)stopTimerHandler:(NSTimer *)timer;
 - (void)stop;
 - (void)saveToPath:(NSString *)filePath;
+- (BOOL)writeEventJournalToPath:(NSString *)filePath;
+
+// benchmark (debugging aid)
+- (void)benchmarkRecordedEventsString:(NSUInteger)nEvents;
+- (BOOL)replayPacketCaptureAtPath:(NSString *)path realTime:(BOOL)realTime;
+- (void)benchmarkDelayRoutingWithLoad:(NSDictionary *)load;
 
 @end
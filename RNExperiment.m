@@ -13,12 +13,27 @@
 #import "RNNetwork.h"
 #import "RNGlobalConnectionStrength.h"
 #import "RNBBNode.h"
+#import "RNConnection.h"
 #import "MIDIIO.h"
 #import "MIOCModel.h"
+#import "MIOCTransition.h"
 #import <CoreAudio/HostTime.h>
 #import "BuildFingerprint.h"
+#import "RNEventFormat.h"
+#import "RNEventJournal.h"
+#import "RNRoutingLoad.h"
 
-#define kInitialEventCapacity 10000 
+#define kRecordingFlushInterval_ns (50 * NSEC_PER_MSEC)
+#define kMIOCSendAhead_ns (20 * NSEC_PER_MSEC) //part scheduler hands a timestamped MIOC switch to CoreMIDI this early
+
+// a stimulus part's stream, started by the part scheduler a lookahead ahead of the part
+struct RNPartStimulus {
+	RNStimulusScheduler        *scheduler;
+	RNStimulusStreamDefinition  definition;
+	RNStimulusStreamID          stream;     //set as it starts [part scheduler thread]; read once the part is reported
+};
+
+static void closePacketCapture(MIDIIO *io, RNPacketCapture *capture);
 
 @implementation RNExperiment
 
@@ -38,6 +53,9 @@
 	
 	[self initializeExperimentPartsWithArray: [_definitionDictionary valueForKey:@"experimentParts"] 
 							 NetworkSizeDict: networkSize];
+	NSNumber *seedNum = [_definitionDictionary valueForKey:@"randomSeed"];
+	_randomSeed = (seedNum != nil) ? [seedNum unsignedLongLongValue] : AudioGetCurrentHostTime();
+	[self seedStimuli];
 		
 	//initialize others
 	_experimentDescription	= [[_definitionDictionary valueForKey:@"description"] copy];
@@ -46,7 +64,28 @@
 	NSAssert1( (durationNum != nil), @"Experiment Part is missing experimentDuration: %@", _definitionDictionary);
 	_experimentDuration_s	= [durationNum doubleValue];
 	
-	_recordedEvents = [[NSMutableData dataWithCapacity: (sizeof(NoteOnMessage) * kInitialEventCapacity)] retain];
+	_eventStore = RNEventStoreCreate();
+	NSAssert( (_eventStore != NULL), @"Could not allocate event store");
+	_eventRecorder = RNEventRecorderCreate(_eventStore);
+	NSAssert( (_eventRecorder != NULL), @"Could not allocate event recorder");
+	_recordingQueue = dispatch_queue_create("org.johniversen.recording", DISPATCH_QUEUE_SERIAL);
+	_timingStats = RNTimingStatsCreate(kRNEventStoreMaxNodes);
+	NSAssert( (_timingStats != NULL), @"Could not allocate timing statistics");
+	_synchrony = RNSynchronyCreate(kMaxNodes + 1, kRNSynchronyDefaultWindow);
+	NSAssert( (_synchrony != NULL), @"Could not allocate synchrony measures");
+	_leadLag = RNLeadLagCreate(kMaxNodes + 1, kRNLeadLagDefaultWindow, kRNLeadLagDefaultMaxLag);
+	NSAssert( (_leadLag != NULL), @"Could not allocate lead/lag estimator");
+	[self updateLeadLagConnections];
+	_ITISeries = RNTimeSeriesCreate(kMaxNodes + 1);
+	NSAssert( (_ITISeries != NULL), @"Could not allocate ITI series");
+	RNHistogramBinning noBinning = { 0, kRNHistogramDefaultBins, 0 }; //binned once the node has a pacer
+	for (unsigned iNode = 0; iNode <= kMaxNodes; iNode++) {
+		_asynchronyHistograms[iNode] = RNHistogramCreate(noBinning);
+		NSAssert( (_asynchronyHistograms[iNode] != NULL), @"Could not allocate asynchrony histogram");
+	}
+	_frozenHistograms = [[NSMutableArray alloc] init];
+	_pacerDecisions = [[NSMutableData alloc] init];
+	[self updateTimingPacers];
 	
 	[self setNeedsSave:NO];
 	
@@ -81,19 +120,158 @@
 	} //enumerate over part-defining dictionaries
 }
 
+// each stimulus gets its own seed, from the experiment's and its place among the stimuli, and plans its
+//	onsets now: the same definition and seed give the same schedule, and starting a part computes nothing
+- (void) seedStimuli
+{
+	uint64_t iStimulus = 0;
+	for (RNExperimentPart *part in _experimentParts) {
+		if ([[part partType] isEqualToString:@"RNStimulus"])
+			[(RNStimulus *) [part experimentPart] setSeed:RNOnsetRandom(_randomSeed, iStimulus++)];
+	}
+}
+
+- (uint64_t) randomSeed
+{
+	return _randomSeed;
+}
+
+- (BOOL) usesSoftwareRouting
+{
+	return [[_definitionDictionary valueForKey:@"MIDIRouting"] isEqual:@"software"];
+}
+
+//once loaded, with the device cleared: work out every part's MIOC changes now, in start order, from the state the
+// part before leaves (stimuli are already planned, networks carry their routing tables), so a part's start only
+// swaps in what is ready. Checks the timeline as it goes; returns the number of problems, written up in timelineReport
+- (NSUInteger) compileTimelineForDevice: (MIOCModel *) device
+{
+	NSArray *timeline = [self timeline];
+	NSMutableString *report = [NSMutableString string];
+	NSUInteger nProblems = 0;
+	NSArray *connections = [device connectionList];
+	NSArray *processors = [device velocityProcessorList];
+	RNNetwork *net = nil;
+	NSMutableDictionary *strengths = [NSMutableDictionary dictionary]; //per network: strengths set so far, by type
+	NSTimeInterval busyUntil_s = -INFINITY;
+	
+	for (RNExperimentPart *part in timeline) {
+		NSTimeInterval startTime_s = [part startTime];
+		NSMutableArray *problems = [NSMutableArray arrayWithCapacity:1];
+		NSString *summary = @"";
+		MIOCTransition *transition = nil;
+		
+		if (startTime_s > _experimentDuration_s)
+			[problems addObject:@"starts after the experiment ends"];
+		if ([[part partType] isEqualToString:@"RNNetwork"]) {
+			net = [part experimentPart];
+			transition = [device transitionFromConnections:connections velocityProcessors:processors
+											 toConnections:[net MIOCConnectionList] velocityProcessors:processors];
+		} else if ([[part partType] isEqualToString:@"RNGlobalConnectionStrength"]) {
+			RNGlobalConnectionStrength *weight = [part experimentPart];
+			if (net == nil)
+				[problems addObject:@"no network to apply it to"];
+			else if (![[weight type] isEqual:@"constantInput"] && ![net isWeighted])
+				[problems addObject:@"network is not weighted"];
+			else {
+				//processors as they will be when the part starts; the network itself is left alone until then
+				NSValue *netKey = [NSValue valueWithNonretainedObject:net];
+				NSMutableDictionary *netStrengths = strengths[netKey];
+				if (netStrengths == nil)
+					strengths[netKey] = netStrengths = [NSMutableDictionary dictionaryWithCapacity:2];
+				netStrengths[[[weight type] isEqual:@"constantInput"] ? @"input" : @"otherNode"] = weight;
+				NSArray *weightedProcessors = [net MIOCVelocityProcessorListWithInputStrength:netStrengths[@"input"]
+																			otherNodeStrength:netStrengths[@"otherNode"]];
+				transition = [device transitionFromConnections:connections velocityProcessors:processors
+												 toConnections:connections velocityProcessors:weightedProcessors];
+			}
+		} else if ([[part partType] isEqualToString:@"RNStimulus"]) {
+			RNStimulus *stim = [part experimentPart];
+			RNOnsetIndex *onsets = [stim timingPacer].onsets;
+			if (net != nil && [stim stimulusChannel] > [net numStimulusChannels])
+				[problems addObject:[NSString stringWithFormat:@"network has %u stimulus channels", [net numStimulusChannels]]];
+			if (onsets != NULL && RNOnsetIndexCount(onsets) > 0) {
+				SInt64 last_ns = RNOnsetIndexOnsets(onsets)[RNOnsetIndexCount(onsets) - 1];
+				summary = [NSString stringWithFormat:@"%u onsets planned, last @T+%.2f", RNOnsetIndexCount(onsets), last_ns / 1e9];
+				if (last_ns / 1e9 > _experimentDuration_s)
+					[problems addObject:@"plays past the end of the experiment"];
+			} else
+				summary = @"onsets worked out as it plays";
+		}
+		
+		if (transition != nil) {
+			summary = [transition description];
+			if (startTime_s - [transition transmissionTime] < busyUntil_s) //sent ahead to land as the part starts
+				[problems addObject:[NSString stringWithFormat:@"MIOC transition can't land on time: previous one sending until T+%.3f", busyUntil_s]];
+			busyUntil_s = MAX(startTime_s, busyUntil_s + [transition transmissionTime]);
+			connections = [transition toConnections];
+			processors = [transition toVelocityProcessors];
+		}
+		[part setMIOCTransition:transition];
+		[report appendFormat:@"T+%.2f %@: %@\n", startTime_s, [part shortDescription], summary];
+		for (NSString *problem in problems)
+			[report appendFormat:@"\tproblem: %@\n", problem];
+		nProblems += [problems count];
+	}
+	[report insertString:[NSString stringWithFormat:@"Timeline: %lu parts, %lu problems\n", (unsigned long)[timeline count], (unsigned long)nProblems] atIndex:0];
+	
+	[_timelineReport autorelease];
+	_timelineReport = [report copy];
+	return nProblems;
+}
+
+//the parts in start order; parts starting together in the order they were defined
+- (NSArray *) timeline
+{
+	return [_experimentParts sortedArrayWithOptions:NSSortStable usingComparator:^NSComparisonResult(RNExperimentPart *a, RNExperimentPart *b) {
+		return ([a startTime] < [b startTime]) ? NSOrderedAscending : ([a startTime] > [b startTime]) ? NSOrderedDescending : NSOrderedSame;
+	}];
+}
+
+- (NSString *) timelineReport
+{
+	return _timelineReport;
+}
+
 - (void) dealloc
 {
+	RNPartSchedulerDestroy(_partScheduler);
+	free(_partStimuli);
+	[_partPacketLists release];
 	[_definitionFilePath autorelease];
 	[_definitionDictionary autorelease];
 	[_experimentParts autorelease];
 	[_experimentStartDate autorelease];
 	[_experimentEndTimer invalidate];
 	[_experimentEndTimer autorelease];
-	[_recordedEvents autorelease];
+	if (_flushTimer) { //still recording: the MIDI threads let go of what we made first
+		[[_MIOC MIDILink] setEventRecorder:NULL];
+		[[_MIOC MIDILink] setVirtualTappers:NULL];
+		dispatch_source_cancel(_flushTimer);
+		dispatch_release(_flushTimer);
+	}
+	dispatch_sync(_recordingQueue, ^{}); // let a pending flush finish
+	dispatch_release(_recordingQueue);
+	RNEventRecorderDestroy(_eventRecorder);
+	RNEventStoreDestroy(_eventStore);
+	RNTimingStatsDestroy(_timingStats);
+	RNSynchronyDestroy(_synchrony);
+	RNLeadLagDestroy(_leadLag);
+	RNTimeSeriesDestroy(_ITISeries);
+	RNVirtualTappersDestroy(_virtualTappers);
+	if (_packetCapture != NULL)
+		closePacketCapture([_MIOC MIDILink], _packetCapture);
+	for (unsigned iNode = 0; iNode <= kMaxNodes; iNode++) {
+		RNHistogramDestroy(_asynchronyHistograms[iNode]);
+		RNOnsetIndexRelease(_histogramPacers[iNode].onsets);
+	}
+	[_frozenHistograms release];
+	[_pacerDecisions release];
 	[_experimentDescription autorelease];
 	[_experimentNotes autorelease];
 	[_experimentSaveFilePath autorelease];
 	[_experimentSaveDictionary autorelease];
+	[_timelineReport release];
 	
 	_definitionFilePath = nil;
 	_definitionDictionary = nil;
@@ -101,7 +279,7 @@
 	_currentNetwork = nil;
 	_experimentStartDate = nil;
 	_experimentEndTimer = nil;
-	_recordedEvents = nil;
+	_eventStore = NULL;
 	_experimentDescription = nil;
 	_experimentNotes = nil;
 	_experimentSaveFilePath = nil;
@@ -136,6 +314,9 @@
 	if (_currentNetwork != newNet) {		
 		_currentNetwork = newNet; //networks 'live' in experimentParts, so don't need to retain
 		[_currentNetwork setStimulusArray:[self currentStimulusArray]];
+		[self updateTimingPacers];
+		[self updateLeadLagConnections];
+		[self updateVirtualTappers];
 	}
 }
 
@@ -149,6 +330,8 @@
 {
 	_currentStimulusArray[stimulusChannel]=stim;
 	[[self currentNetwork] setStimulus:stim ForChannel:stimulusChannel];
+	[self updateTimingPacers];
+	[self updateVirtualTappers];
 }
 
 - (RNStimulus **) currentStimulusArray
@@ -230,6 +413,9 @@
 - (void) setExperimentStartTimestamp: (MIDITimeStamp) newExperimentStartTimestamp
 {
     _experimentStartTimestamp = newExperimentStartTimestamp;
+	dispatch_sync(_recordingQueue, ^{
+		RNEventRecorderSetTimeBase(_eventRecorder, (int64_t) AudioConvertHostTimeToNanos(newExperimentStartTimestamp));
+	});
 }
 //convenience
 - (UInt64) experimentStartTimeNanoseconds 
@@ -277,50 +463,380 @@
 //initialize recorded events
 - (void) clearRecordedEvents
 {
-	if (_recordedEvents != nil) {
-		[_recordedEvents autorelease];
-		_recordedEvents = [[NSMutableData dataWithCapacity: (sizeof(NoteOnMessage) * kInitialEventCapacity)] retain];
-	}
+	dispatch_sync(_recordingQueue, ^{
+		RNEventRecorderReset(_eventRecorder);
+		RNEventStoreClear(_eventStore);
+		RNTimingStatsReset(_timingStats);
+		RNSynchronyReset(_synchrony);
+		RNLeadLagReset(_leadLag);
+		RNTimeSeriesClear(_ITISeries);
+		for (unsigned iNode = 0; iNode <= kMaxNodes; iNode++)
+			RNHistogramClear(_asynchronyHistograms[iNode]);
+		[_frozenHistograms removeAllObjects];
+		[_pacerDecisions setLength:0];
+		_numTimedEvents = 0;
+	});
+}
+
+//the single store of recorded events, shared with display and analysis code (read only)
+- (RNEventStore *) eventStore
+{
+	return _eventStore;
+}
+
+// format recorded taps in one pass into a single malloc'd buffer, which the returned data owns
+- (NSData *) recordedEventsDataWithStyle: (RNEventFormatStyle) style header: (NSString *) header
+{
+	const char *headerStr = [header UTF8String];
+	size_t headerLength = (headerStr != NULL) ? strlen(headerStr) : 0;
+	size_t capacity = headerLength + RNEventStoreFormatLength(_eventStore, kRNEventKindTap) + 1;
+	char *buf = malloc(capacity);
+	NSAssert( (buf != NULL), @"Could not allocate recorded events buffer");
+
+	if (headerLength > 0)
+		memcpy(buf, headerStr, headerLength);
+
+	size_t length = headerLength + RNEventStoreFormat(_eventStore, kRNEventKindTap, buf + headerLength, capacity - headerLength, style);
+
+	return [NSData dataWithBytesNoCopy:buf length:length freeWhenDone:YES];
 }
 
 //method to convert recorded events data into a string representation
+//	one row per event: time_ns <tab> channel <tab> note <tab> velocity
 - (NSString *) recordedEventsString 
 {
-	NoteOnMessage *eventPtr;
-	size_t nEvents;
-	unsigned int iEvent = 0;
-	NSMutableString *eventsString;
-	NSString *singleEventString;
+	NSData *data = [self recordedEventsDataWithStyle:kRNEventFormatTSV header:nil];
+	return [[[NSString alloc] initWithData:data encoding:NSASCIIStringEncoding] autorelease];
+}
+
+//export recorded events as a standalone TSV or CSV file with a header row
+- (BOOL) writeRecordedEventsToPath: (NSString *) filePath style: (RNEventFormatStyle) style
+{
+	NSString *header = (style == kRNEventFormatCSV) ? @"time_ns,channel,note,velocity\n" : @"time_ns\tchannel\tnote\tvelocity\n";
+	NSData *data = [self recordedEventsDataWithStyle:style header:header];
+	return [data writeToFile:filePath atomically:YES];
+}
+
+//emitted (stimulus and feedback) events: time_ns <tab> sendTime_ns <tab> kind <tab> sourceID <tab> node <tab> channel <tab> note <tab> velocity <tab> flags
+- (NSString *) emittedEventsString
+{
+	size_t capacity = RNEventStoreFormatEmittedLength(_eventStore) + 1;
+	char *buf = malloc(capacity);
+	NSAssert( (buf != NULL), @"Could not allocate emitted events buffer");
+	size_t length = RNEventStoreFormatEmitted(_eventStore, buf, capacity, kRNEventFormatTSV);
+	return [[[NSString alloc] initWithBytesNoCopy:buf length:length encoding:NSASCIIStringEncoding freeWhenDone:YES] autorelease];
+}
+
+//drain the recorder into the store (on the recording queue, its only consumer) and tell the UI if anything arrived
+- (void) flushRecordedEvents
+{
+	__block uint32_t nStored;
+	RNStimulusScheduler *scheduler = [[_MIOC MIDILink] stimulusScheduler];
+	dispatch_sync(_recordingQueue, ^{
+		nStored = RNEventRecorderFlush(_eventRecorder);
+		//adaptive pacer decisions, kept as made (absolute times) until saved
+		if (scheduler != NULL) {
+			RNPacerDecision decisions[64];
+			uint32_t nDecisions;
+			while ((nDecisions = RNStimulusSchedulerReadDecisions(scheduler, decisions, 64)) > 0)
+				[_pacerDecisions appendBytes:decisions length:nDecisions * sizeof(RNPacerDecision)];
+		}
+		//taps in the store's order are in time order per node, which is all the statistics need
+		uint32_t nEvents = RNEventStoreCount(_eventStore);
+		for (; _numTimedEvents < nEvents; _numTimedEvents++) {
+			RNEvent event = RNEventStoreEventAtIndex(_eventStore, _numTimedEvents);
+			if (event.kind == kRNEventKindTap) {
+				int64_t asynchrony_ns = RNTimingStatsAddTap(_timingStats, event.node, event.time_ns);
+				RNTimingSnapshot timing;
+				if (RNTimingStatsGetSnapshot(_timingStats, event.node, &timing) && timing.nITIs > 0)
+					RNTimeSeriesAppend(_ITISeries, event.node, event.time_ns, (float) timing.lastITI_ms);
+				if (event.node <= kMaxNodes && _histogramPacers[event.node].IOI_ns > 0)
+					RNHistogramAdd(_asynchronyHistograms[event.node], asynchrony_ns);
+				RNSynchronyAddTap(_synchrony, event.node, event.time_ns);
+				RNLeadLagAddTap(_leadLag, event.node, event.time_ns);
+			}
+		}
+	});
+	if (nStored > 0) {
+		dispatch_async(dispatch_get_main_queue(), ^{
+			[[NSNotificationCenter defaultCenter] postNotificationName:@"recordedEventsNotification" object:self];
+		});
+	}
+}
+
+- (RNEventRecorderCounts) recordingCounts
+{
+	return RNEventRecorderGetCounts(_eventRecorder);
+}
+
+//adaptive pacer decisions, one row each: onset number, stimulus channel, then times relative to experiment start (ns):
+//	onset decided, previous onset, period before and after, mean asynchrony, when due and when decided, then each
+//	node's tap used (1..kMaxNodes, empty if none)
+- (NSString *) pacerDecisionsString
+{
+	__block char *buf;
+	__block size_t length = 0;
+	SInt64 start_ns = (SInt64) [self experimentStartTimeNanoseconds];
+	dispatch_sync(_recordingQueue, ^{
+		const RNPacerDecision *decisions = [_pacerDecisions bytes];
+		NSUInteger nDecisions = [_pacerDecisions length] / sizeof(RNPacerDecision);
+		//every field a tab (or the newline) and at most an int64
+		buf = malloc(nDecisions * (9 + kMaxNodes) * (kRNEventFormatMaxInt64Length + 1) + 1);
+		NSAssert( (buf != NULL), @"Could not allocate pacer decisions buffer");
+		char *p = buf;
+		for (NSUInteger i = 0; i < nDecisions; i++) {
+			const RNPacerDecision *d = &decisions[i];
+			const int64_t times[] = { d->onset_ns - start_ns, d->previousOnset_ns - start_ns, d->IOI_ns, d->nextIOI_ns,
+				d->asynchrony_ns, d->due_ns - start_ns, d->decided_ns - start_ns };
+			p += RNFormatInt64(p, d->number);
+			*p++ = '\t';
+			p += RNFormatUInt8(p, d->stimulusChannel);
+			for (unsigned f = 0; f < sizeof(times) / sizeof(times[0]); f++) {
+				*p++ = '\t';
+				p += RNFormatInt64(p, times[f]);
+			}
+			for (unsigned node = 1; node <= kMaxNodes; node++) {
+				*p++ = '\t';
+				if ((d->tapNodes >> node) & 1)
+					p += RNFormatInt64(p, d->tap_ns[node] - start_ns);
+			}
+			*p++ = '\n';
+		}
+		length = (size_t)(p - buf);
+	});
+	return [[[NSString alloc] initWithBytesNoCopy:buf length:length encoding:NSASCIIStringEncoding freeWhenDone:YES] autorelease];
+}
+
+//readers take snapshots (RNTimingStatsGetSnapshot) from any thread; only the recording queue writes
+- (RNTimingStats *) timingStats
+{
+	return _timingStats;
+}
+
+//network synchrony: snapshots from any thread
+- (RNSynchrony *) synchrony
+{
+	return _synchrony;
+}
+
+//order parameter at every tap: time_ns, R, windowed R, node, number of active nodes
+- (NSString *) synchronyIndexString
+{
+	__block NSString *string;
+	dispatch_sync(_recordingQueue, ^{
+		size_t capacity = RNSynchronySeriesFormatLength(_synchrony) + 1;
+		char *buf = malloc(capacity);
+		NSAssert( (buf != NULL), @"Could not allocate buffer for synchrony index");
+		size_t length = RNSynchronySeriesFormat(_synchrony, buf, capacity);
+		string = [[NSString alloc] initWithBytesNoCopy:buf length:length encoding:NSASCIIStringEncoding freeWhenDone:YES];
+	});
+	return [string autorelease];
+}
+
+//histograms of asynchrony per node (indexed by node number), binned over the IOI of the node's pacer;
+//	views take snapshots of them
+- (RNHistogram **) asynchronyHistograms
+{
+	return _asynchronyHistograms;
+}
+
+//recording queue: new pacer for a node. Freeze what its histogram held, compare it with the last
+//	one frozen for the node, then rebin for the new IOI
+- (void) rebinHistogramForNode: (unsigned) iNode pacer: (RNTimingPacer) pacer
+{
+	if (RNTimingPacerEqual(_histogramPacers[iNode], pacer))
+		return;
 	
-	nEvents = [_recordedEvents length] / sizeof(NoteOnMessage);
-	eventPtr = (NoteOnMessage *) [_recordedEvents bytes];
-	eventsString = [NSMutableString stringWithCapacity:(nEvents * 32)]; //rough estimate
+	RNHistogramSnapshot *snapshot = malloc(sizeof(RNHistogramSnapshot));
+	NSAssert( (snapshot != NULL), @"Could not allocate histogram snapshot");
+	RNHistogramGetSnapshot(_asynchronyHistograms[iNode], snapshot);
+	if (snapshot->total > 0) {
+		RNTimingSnapshot timing;
+		RNTimingStatsGetSnapshot(_timingStats, iNode, &timing); //taken before the pacer change resets it
+		NSMutableDictionary *frozen = [NSMutableDictionary dictionaryWithCapacity:8];
+		frozen[@"node"] = @(iNode);
+		frozen[@"lastTapTime_ms"] = @(timing.lastTapTime_ms);
+		frozen[@"IOI_ms"] = @(snapshot->binning.IOI_ns / 1e6);
+		frozen[@"outOfRange"] = @(snapshot->outOfRange);
+		NSMutableString *counts = [NSMutableString stringWithCapacity:4 * snapshot->binning.nBins];
+		for (unsigned iBin = 0; iBin < snapshot->binning.nBins; iBin++)
+			[counts appendFormat:(iBin == 0) ? @"%u" : @"\t%u", snapshot->counts[iBin]];
+		frozen[@"counts"] = counts;
+		
+		//compare with the previous histogram frozen for this node
+		NSData *previous = nil;
+		for (NSDictionary *earlier in [_frozenHistograms reverseObjectEnumerator]) {
+			if ([earlier[@"node"] unsignedIntValue] == iNode) {
+				previous = earlier[@"snapshot"];
+				break;
+			}
+		}
+		if (previous != nil) {
+			RNHistogramComparison comparison = RNHistogramSnapshotCompare([previous bytes], snapshot);
+			frozen[@"meanShift_ms"] = @(comparison.shift_ms);
+			if (!isnan(comparison.overlap))
+				frozen[@"overlap"] = @(comparison.overlap);
+		}
+		frozen[@"snapshot"] = [NSData dataWithBytesNoCopy:snapshot length:sizeof(RNHistogramSnapshot) freeWhenDone:YES];
+		[_frozenHistograms addObject:frozen];
+	} else {
+		free(snapshot);
+	}
+	
+	RNOnsetIndexRetain(pacer.onsets);
+	RNOnsetIndexRelease(_histogramPacers[iNode].onsets);
+	_histogramPacers[iNode] = pacer;
+	RNHistogramBinning binning = { pacer.IOI_ns, kRNHistogramDefaultBins, 0 };
+	RNHistogramSetBinning(_asynchronyHistograms[iNode], binning);
+}
+
+//histograms closed by stimulus changes so far, for saving (without the raw snapshots)
+- (NSArray *) frozenHistograms
+{
+	NSMutableArray *frozenList = [NSMutableArray arrayWithCapacity:1];
+	dispatch_sync(_recordingQueue, ^{
+		for (NSDictionary *frozen in _frozenHistograms) {
+			NSMutableDictionary *entry = [[frozen mutableCopy] autorelease];
+			[entry removeObjectForKey:@"snapshot"];
+			[frozenList addObject:entry];
+		}
+	});
+	return frozenList;
+}
+
+//per node ITIs for plotting: queries from any thread
+- (RNTimeSeries *) ITISeries
+{
+	return _ITISeries;
+}
+
+//leader/follower estimates: matrix snapshots from any thread
+- (RNLeadLag *) leadLag
+{
+	return _leadLag;
+}
+
+//every pair update: time_ns, node a, node b (a < b), lead/lag index (> 0: a leads), zero-lag r, peak lag
+- (NSString *) leadLagString
+{
+	__block NSString *string;
+	dispatch_sync(_recordingQueue, ^{
+		size_t capacity = RNLeadLagSeriesFormatLength(_leadLag) + 1;
+		char *buf = malloc(capacity);
+		NSAssert( (buf != NULL), @"Could not allocate buffer for lead/lag series");
+		size_t length = RNLeadLagSeriesFormat(_leadLag, buf, capacity);
+		string = [[NSString alloc] initWithBytesNoCopy:buf length:length encoding:NSASCIIStringEncoding freeWhenDone:YES];
+	});
+	return [string autorelease];
+}
+
+//pairs of tappers that hear each other in the current network (big brother and self connections don't count)
+- (void) updateLeadLagConnections
+{
+	if (_leadLag == NULL) //not yet initialized
+		return;
+	
+	struct { uint64_t row[kMaxNodes + 1]; } connected = {{ 0 }}; //wrapped so the block captures a copy
+	NSEnumerator *connEnumerator = [[_currentNetwork connectionList] objectEnumerator];
+	RNConnection *conn;
+	while (conn = [connEnumerator nextObject]) {
+		RNNodeNum_t from = [conn fromNode], to = [conn toNode];
+		if (from != 0 && to != 0 && from != to && from <= kMaxNodes && to <= kMaxNodes)
+			connected.row[from] |= (1ULL << to);
+	}
+	dispatch_async(_recordingQueue, ^{
+		RNLeadLagClearConnections(_leadLag);
+		for (unsigned from = 1; from <= kMaxNodes; from++)
+			for (unsigned to = 1; to <= kMaxNodes; to++)
+				if (connected.row[from] & (1ULL << to))
+					RNLeadLagSetConnected(_leadLag, from, to, true);
+	});
+}
+
+//each tapper is timed against the stimulus it hears (the first one if it hears none),
+//	as in the network view's histograms: against its scheduled onsets once it has been scheduled
+- (void) updateTimingPacers
+{
+	if (_timingStats == NULL || _synchrony == NULL || _frozenHistograms == nil) //not yet initialized
+		return;
 	
-	while (iEvent < nEvents) {
-		SInt64 signedEventTime_ns = UInt64ToSInt64(eventPtr->eventTime_ns);
-		singleEventString = [NSString stringWithFormat:@"%qi\t%d\t%d\t%d\n", \
-			signedEventTime_ns, eventPtr->channel, eventPtr->note, eventPtr->velocity];
-		[eventsString appendString:singleEventString];
-		eventPtr++;
-		iEvent++;
+	struct { RNTimingPacer node[kMaxNodes + 1]; } pacers = {{{ 0, 0, NULL }}}; //wrapped so the block captures a copy
+	NSArray *nodeList = [_currentNetwork nodeList];
+	for (NSUInteger iNode = 1; iNode < [nodeList count] && iNode <= kMaxNodes; iNode++) {
+		RNTapperNode *node = nodeList[iNode];
+		Byte subChannel = [node hearsBigBrother] ? [node bigBrotherSubChannel] : 1;
+		RNStimulus *stim = [_currentNetwork stimulusForChannel:subChannel];
+		if (stim != nil) {
+			pacers.node[[node nodeNumber]] = [stim timingPacer];
+			RNOnsetIndexRetain(pacers.node[[node nodeNumber]].onsets); //the stimulus may reschedule before the block runs
+		}
 	}
+	dispatch_async(_recordingQueue, ^{
+		for (unsigned iNode = 1; iNode <= kMaxNodes; iNode++) {
+			[self rebinHistogramForNode:iNode pacer:pacers.node[iNode]]; //first: it reads the old timing stats
+			RNTimingStatsSetPacer(_timingStats, iNode, pacers.node[iNode]);
+			RNSynchronySetPacer(_synchrony, iNode, pacers.node[iNode]);
+			RNOnsetIndexRelease(pacers.node[iNode].onsets);
+		}
+	});
+}
+
+//virtual tappers play their nodes of the current network, hearing its connections with their weights as gains
+//	(stimulus connections too); their preferred period is the IOI of the first stimulus
+- (void) updateVirtualTappers
+{
+	if (_virtualTappers == NULL) //not started
+		return;
 	
-	return [NSString stringWithString:eventsString]; //make immutable
+	RNVirtualNetwork *network = calloc(1, sizeof(RNVirtualNetwork)); //large for the stack
+	NSArray *nodeList = [_currentNetwork nodeList];
+	for (NSUInteger iNode = 1; iNode < [nodeList count] && iNode <= kRNVirtualMaxNodes; iNode++)
+		network->agents |= _virtualTapperNodes & (1ULL << iNode);
+	NSEnumerator *connEnumerator = [[_currentNetwork connectionList] objectEnumerator];
+	RNConnection *conn;
+	while (conn = [connEnumerator nextObject]) {
+		RNNodeNum_t from = [conn fromNode], to = [conn toNode];
+		if (from <= kRNVirtualMaxNodes && to <= kRNVirtualMaxNodes)
+			network->gain[from][to] = (float) [conn weight];
+	}
+	RNStimulus *stim = [_currentNetwork stimulusForChannel:1];
+	network->period_ms = (stim != nil) ? [stim IOI_ms] : 0.0;
+	RNVirtualTappersSetNetwork(_virtualTappers, network);
+	free(network);
 }
 
+- (RNVirtualTappers *) virtualTappers
+{
+	return _virtualTappers;
+}
 
-//here is where we receive and store incoming MIDI note on events
-//  so long as we're listed as a listener, we'll store
-//  note, we adjust timestamps to be relative to experiment start
-- (void) receiveMIDIData: (NSData *) MIDIData
+//what a stimulus streams: its onsets go out a lookahead ahead, recorded as they are sent, one event per tapper
+//	hearing the stimulus in net, the network in place as it starts (node 0 if none does); sourceID is the event
+//	number within the stimulus
+- (RNStimulusStreamDefinition) streamDefinitionForStimulus: (RNStimulus *) stim inNetwork: (RNNetwork *) net
 {
-	NSAssert( ([MIDIData length] == sizeof(NoteOnMessage)), @"Unexpected MIDI Data size");
+	RNStimulusStreamDefinition definition = [stim streamDefinitionForExperimentStartTime:[self experimentStartTimeNanoseconds]];
 	
-	NoteOnMessage *message = (NoteOnMessage *) [MIDIData bytes];
-	UInt64 startTime_ns = AudioConvertHostTimeToNanos([self experimentStartTimestamp]);
-	SInt64 experimentTime_ns = message->eventTime_ns - startTime_ns;
-	message->eventTime_ns = experimentTime_ns;
-	[_recordedEvents appendData:MIDIData];
+	//who hears this stimulus channel
+	NSArray *nodeList = [net nodeList];
+	for (NSUInteger iNode = 1; iNode < [nodeList count]; iNode++) {
+		RNTapperNode *node = nodeList[iNode];
+		if ([node hearsBigBrother] && [node bigBrotherSubChannel] == [stim stimulusChannel])
+			definition.listeners |= 1u << [node nodeNumber];
+	}
+	return definition;
+}
+
+//tempo change within the lookahead; the stimulus replans its onsets (and so its pacer) from the next one not yet sent
+- (BOOL) setIOI: (double) IOI_ms forStimulus: (RNStimulus *) stim withMIDIIO: (MIDIIO *) io
+{
+	RNOnsetGenerator generator;
+	if (![io setIOI:IOI_ms ofStimulusStream:[stim stream] generator:&generator])
+		return NO;
+	[stim replanFromGenerator:&generator];
+	[self updateTimingPacers];
+	[self updateVirtualTappers];
+	return YES;
 }
 
 // *********************************************
@@ -345,6 +861,8 @@
 	//now add what we want to save
 	temp[@"definitionFilePath"] = _definitionFilePath;
 	temp[@"definitionDictionary"] = _definitionDictionary;
+	temp[@"randomSeed"] = @(_randomSeed); //put in a definition as randomSeed to play the same stimuli again
+	temp[@"timelineReport"] = _timelineReport ?: @"";
 	//wrap our starting timestamp in NSNumber
 	NSNumber *timestamp = @([self experimentStartTimestamp]);
 	temp[@"experimentStartTimestamp"] = timestamp;
@@ -372,6 +890,13 @@
 	}
 	temp[@"partTiming"] = partTimingArray;
 	temp[@"recordedEvents"] = [self recordedEventsString];
+	temp[@"emittedEvents"] = [self emittedEventsString];
+	temp[@"synchronyIndex"] = [self synchronyIndexString];
+	temp[@"leadLag"] = [self leadLagString];
+	temp[@"pacerDecisions"] = [self pacerDecisionsString];
+	temp[@"asynchronyHistograms"] = [self frozenHistograms];
+	RNEventRecorderCounts counts = [self recordingCounts];
+	temp[@"recordingCounts"] = @{@"received": @(counts.received), @"stored": @(counts.stored), @"dropped": @(counts.dropped)};
 	
 	return [NSDictionary dictionaryWithDictionary:temp];
 }
@@ -400,53 +925,267 @@
 	uncertainty = interval1 - interval2;
 	NSLog(@"\n\tUncertainty in experiment end timer maximum %g ms (%g - %g)", uncertainty * 1000.0, interval1, interval2);
 	
-	//set up experiment parts
-	[self scheduleExperimentParts];
+	//set the current network; the parts are scheduled once recording starts
+	for (RNExperimentPart *part in _experimentParts) {
+		if ([[part partType] isEqualToString:@"RNNetwork"] && [part startTime] == 0)
+			[self setCurrentNetwork:[part experimentPart] ];
+	}
 
 	[self clearRecordedEvents]; //controller starts recording
 	
 	[self setNeedsSave:YES];
 }
 
-//iterate thru experiment parts, scheduling as needed
+// part scheduler thread: make the part's realtime change now, then record and announce it on the main thread. Entries
+//	ahead of a part start what takes time to be heard, and are announced with the part
+static void firePart(const RNPartEntry *entry, int64_t fired_ns, void *refCon)
+{
+	RNExperiment *experiment = (RNExperiment *) refCon;
+	switch (entry->action) {
+		case kRNPartActionStimulus: {
+			struct RNPartStimulus *partStimulus = entry->payload;
+			partStimulus->stream = RNStimulusSchedulerStart(partStimulus->scheduler, &partStimulus->definition);
+			return;
+		}
+		case kRNPartActionMIOC:
+			[[experiment->_MIOC MIDILink] sendMIDIPacketList:(NSData *) entry->payload];
+			return;
+		case kRNPartActionRouting:
+			[[experiment->_MIOC MIDILink] setMIDIRoutingTable:(RNRealtimeRoutingTable *) entry->payload];
+			break;
+		case kRNPartActionNotify:
+			break;
+	}
+	NSUInteger index = entry->part;
+	UInt64 due_ns = (UInt64) entry->due_ns;
+	dispatch_async(dispatch_get_main_queue(), ^{
+		[experiment experimentPartAtIndex:index firedAt:(UInt64) fired_ns due:due_ns];
+	});
+}
+
+//compile the parts into a host clock timeline, fired from the part scheduler's thread. Stimuli start streaming a
+//	lookahead ahead of their part, and MIOC switches (if the chain of them starts where the MIOC is) are sent
+//	timestamped to land as their part starts, one after another on the cable: both are heard on time
 - (void) scheduleExperimentParts
 {
-	RNExperimentPart *part;
-	NSEnumerator *partEnumerator = [_experimentParts objectEnumerator];
+	NSAssert( (_partScheduler == NULL), @"experiment parts already scheduled");
+	NSAssert( (_MIOC != nil), @"parts are scheduled once recording from a device");
+	UInt64 experimentStartTime_ns = AudioConvertHostTimeToNanos([self experimentStartTimestamp]);
+	MIDIIO *io = [_MIOC MIDILink];
+	NSArray *timeline = [self timeline];
+	NSUInteger nParts = [timeline count];
+	RNPartEntry *entries = malloc((nParts > 0 ? 3 * nParts : 1) * sizeof(RNPartEntry));
+	uint32_t nEntries = 0;
+	_partStimuli = calloc((nParts > 0 ? nParts : 1), sizeof(struct RNPartStimulus));
+	_partPacketLists = [[NSMutableArray alloc] initWithCapacity:nParts];
 	
-	while (part = [partEnumerator nextObject]) {
-		[part scheduleForExperimentStartTime:[self experimentStartDate]
-								   Timestamp:[self experimentStartTimestamp] ];
-		//set the current network and stimuli
-		if ([[part partType] isEqualToString:@"RNNetwork"]) {
-			if ([part startTime] == 0)
-				[self setCurrentNetwork:[part experimentPart] ];
+	MIOCTransition *firstTransition = nil;
+	for (RNExperimentPart *part in timeline) {
+		if ((firstTransition = [part MIOCTransition]) != nil) break;
+	}
+	BOOL sendsMIOCAhead = [_MIOC canSendTransitionsAheadFrom:firstTransition];
+	SInt64 MIOCFree_ns = (SInt64) AudioConvertHostTimeToNanos(AudioGetCurrentHostTime()) + kMIOCSendAhead_ns;
+	RNNetwork *net = _currentNetwork;
+	
+	for (RNExperimentPart *part in timeline) {
+		uint32_t iPart = (uint32_t) [_experimentParts indexOfObjectIdenticalTo:part];
+		RNPartEntry entry = [part timelineEntryForExperimentStartTime:experimentStartTime_ns];
+		entry.part = iPart;
+		entries[nEntries++] = entry;
+		NSLog(@"Scheduling %@ @T+%.2f", [part shortDescription], [part startTime]);
+		
+		if ([[part partType] isEqualToString:@"RNNetwork"])
+			net = [part experimentPart];
+		
+		if ([[part partType] isEqualToString:@"RNStimulus"]) {
+			struct RNPartStimulus *partStimulus = &_partStimuli[iPart];
+			partStimulus->scheduler = [io startStimulusScheduler];
+			partStimulus->stream = kRNStimulusInvalidStream;
+			if (partStimulus->scheduler != NULL) {
+				partStimulus->definition = [self streamDefinitionForStimulus:[part experimentPart] inNetwork:net];
+				entries[nEntries++] = (RNPartEntry) {
+					.due_ns = entry.due_ns - RNStimulusSchedulerLookahead(partStimulus->scheduler),
+					.part = iPart, .action = kRNPartActionStimulus, .payload = partStimulus };
+			}
 		}
+		
+		MIOCTransition *transition = [part MIOCTransition];
+		[part setMIOCTransitionSentAhead:NO];
+		if (sendsMIOCAhead && transition != nil && ![transition isEmpty] && [transition packetList] != nil) {
+			SInt64 transmission_ns = llround([transition transmissionTime] * 1e9);
+			SInt64 send_ns = MAX(entry.due_ns - transmission_ns, MIOCFree_ns); //late only if the one before is still sending
+			MIOCFree_ns = send_ns + transmission_ns;
+			NSData *packetList = [transition packetListStartingAt:AudioConvertNanosToHostTime((UInt64) send_ns)];
+			[_partPacketLists addObject:packetList];
+			entries[nEntries++] = (RNPartEntry) {
+				.due_ns = send_ns - kMIOCSendAhead_ns, .part = iPart, .action = kRNPartActionMIOC, .payload = packetList };
+			[part setMIOCTransitionSentAhead:YES];
+		}
+	}
+	if (!sendsMIOCAhead && firstTransition != nil)
+		NSLog(@"MIOC is not where the timeline starts (or is routed in software): its switches are made as parts start");
+	_partScheduler = RNPartSchedulerCreate(entries, nEntries, firePart, self);
+	free(entries);
+	NSAssert( (_partScheduler != NULL), @"Could not start part scheduler");
+}
+
+//main thread, after the part scheduler has fired it
+- (void) experimentPartAtIndex: (NSUInteger) index firedAt: (UInt64) fired_ns due: (UInt64) due_ns
+{
+	if (_partScheduler == NULL) return; //unscheduled since
+	RNExperimentPart *part = _experimentParts[index];
+	UInt64 experimentStartTime_ns = AudioConvertHostTimeToNanos([self experimentStartTimestamp]);
+	[part setActualStartTime:((SInt64) (fired_ns - experimentStartTime_ns)) / 1000000000.0];
+	[part setStartTimeUncertainty:((SInt64) (fired_ns - due_ns)) / 1000000000.0];
+	if ([[part partType] isEqualToString:@"RNStimulus"] && _partStimuli != NULL) {
+		RNStimulus *stim = [part experimentPart];
+		[stim setStream:_partStimuli[index].stream]; //started ahead by the part scheduler
+		if ([stim stream] == kRNStimulusInvalidStream)
+			NSLog(@"Could not play stimulus %@", [stim description]);
 	}
+	[part postStartNotification];
 }
 
 - (void) unscheduleExperimentParts
 {
-	RNExperimentPart *part;
-	NSEnumerator *partEnumerator = [_experimentParts objectEnumerator];
-	
-	while (part = [partEnumerator nextObject]) 
-		[part unschedule];
+	if (_partScheduler == NULL) return;
+	RNPartSchedulerCounts counts = RNPartSchedulerGetCounts(_partScheduler);
+	RNPartSchedulerDestroy(_partScheduler);
+	_partScheduler = NULL;
+	free(_partStimuli);
+	_partStimuli = NULL;
+	[_partPacketLists release];
+	_partPacketLists = nil;
+	for (RNExperimentPart *part in _experimentParts)
+		[part setMIOCTransitionSentAhead:NO];
+	NSLog(@"\n\tExperiment parts: %u entries fired (at most %.3f ms late), %u not reached", counts.fired, counts.maxLateness_ns / 1e6, counts.pending);
 }
 
 - (void) startRecordingFromDevice: (MIOCModel *) MIOC
 {
 	_MIOC = [MIOC retain];
 	MIDIIO *io = [_MIOC MIDILink];
-	[io registerMIDIListener:self];
+	[io setEventRecorder:_eventRecorder];
+	[self startVirtualTappersWithMIDIIO:io];
+	[self startPacketCaptureWithMIDIIO:io];
+	[self scheduleExperimentParts];
+	
+	//flush periodically: batches are large, and the UI updates once per flush
+	if (_flushTimer == NULL) {
+		_flushTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0));
+		dispatch_source_set_timer(_flushTimer, dispatch_time(DISPATCH_TIME_NOW, kRecordingFlushInterval_ns), kRecordingFlushInterval_ns, kRecordingFlushInterval_ns / 10);
+		dispatch_source_set_event_handler(_flushTimer, ^{
+			[self flushRecordedEvents];
+		});
+		dispatch_resume(_flushTimer);
+	}
+}
+
+static double parameterFromDictionary(NSDictionary *dict, NSString *key, double fallback)
+{
+	NSNumber *value = dict[key];
+	return (value != nil) ? [value doubleValue] : fallback;
+}
+
+//simulated tappers for rehearsal, only if configured, e.g. defaults write <bundle id> RNVirtualTapperNodes "1-6".
+//	Optional RNVirtualTapperParameters dictionary: alpha, beta, period_ms, periodSD_ms, timekeeperSD_ms, motorSD_ms
+//	(see RNSimulator.h). Their taps enter through the MIDIIO's own source, mixed with real input.
+- (void) startVirtualTappersWithMIDIIO: (MIDIIO *) io
+{
+	NSUserDefaults *defaults = [NSUserDefaults standardUserDefaults];
+	NSString *nodes = [defaults stringForKey:@"RNVirtualTapperNodes"];
+	_virtualTapperNodes = 0;
+	if (nodes == nil || [nodes length] == 0) {
+		[self updateVirtualTappers]; //any left from a previous recording fall silent
+		return;
+	}
+	if (!RNVirtualTappersParseNodes([nodes UTF8String], &_virtualTapperNodes)) {
+		NSLog(@"RNVirtualTapperNodes: can't read \"%@\" (e.g. \"1-6,9\")", nodes);
+		return;
+	}
+	
+	if (_virtualTappers == NULL) {
+		NSDictionary *dict = [defaults dictionaryForKey:@"RNVirtualTapperParameters"];
+		RNSimTapperParameters parameters = {
+			.alpha				= parameterFromDictionary(dict, @"alpha", 0.5),
+			.beta				= parameterFromDictionary(dict, @"beta", 0.0),
+			.period_ms			= parameterFromDictionary(dict, @"period_ms", 0.0),
+			.periodSD_ms		= parameterFromDictionary(dict, @"periodSD_ms", 0.0),
+			.timekeeperSD_ms	= parameterFromDictionary(dict, @"timekeeperSD_ms", 15.0),
+			.motorSD_ms			= parameterFromDictionary(dict, @"motorSD_ms", 5.0),
+		};
+		uint64_t seed = AudioGetCurrentHostTime();
+		_virtualTappers = RNVirtualTappersCreate(&parameters, seed, [io virtualTapProc], io);
+		NSAssert( (_virtualTappers != NULL), @"Could not start virtual tappers");
+		NSLog(@"Virtual tappers on nodes %@ (alpha %g, beta %g, seed %llu)", nodes, parameters.alpha, parameters.beta, seed);
+	}
+	[self updateVirtualTappers];
+	[io setVirtualTappers:_virtualTappers];
+}
+
+//raw MIDI input and delay output, for replaying a session's timing through the pipeline later, only if configured,
+//	e.g. defaults write <bundle id> RNPacketCaptureDirectory ~/Captures. One .rnpc file per recording (see RNPacketCapture.h).
+- (void) startPacketCaptureWithMIDIIO: (MIDIIO *) io
+{
+	NSString *directory = [[[NSUserDefaults standardUserDefaults] stringForKey:@"RNPacketCaptureDirectory"] stringByExpandingTildeInPath];
+	if (directory == nil || [directory length] == 0 || _packetCapture != NULL)
+		return;
+	
+	NSDateFormatter *formatter = [[[NSDateFormatter alloc] init] autorelease];
+	[formatter setDateFormat:@"yyyyMMdd-HHmmss"];
+	NSString *path = [directory stringByAppendingPathComponent:[NSString stringWithFormat:@"capture-%@.rnpc", [formatter stringFromDate:[NSDate date]]]];
+	_packetCapture = RNPacketCaptureCreate([path fileSystemRepresentation]);
+	if (_packetCapture == NULL) {
+		NSLog(@"RNPacketCaptureDirectory: can't create %@", path);
+		return;
+	}
+	[io setPacketCapture:_packetCapture];
+	NSLog(@"Capturing MIDI input to %@", path);
+}
+
+//stop capturing; closed once the MIDI threads are done with it
+static void closePacketCapture(MIDIIO *io, RNPacketCapture *capture)
+{
+	[io setPacketCapture:NULL];
+	RNPacketCaptureCounts counts = RNPacketCaptureGetCounts(capture);
+	RNPacketCaptureClose(capture);
+	NSLog(@"\n\tPacket capture: %llu packet lists, %llu bytes, %llu dropped", counts.records, counts.bytes, counts.dropped);
 }
 
 - (void) stopRecording
 {
 	MIDIIO *io = [_MIOC MIDILink];
-	[io removeMIDIListener:self];
-	//remove any pending midi events
+	[io setEventRecorder:NULL];
+	[io setVirtualTappers:NULL];
+	if (_packetCapture != NULL) {
+		closePacketCapture(io, _packetCapture);
+		_packetCapture = NULL;
+	}
+	if (_virtualTappers != NULL) { //silent until recording starts again, when they are reused; the MIDI threads have let go
+		_virtualTapperNodes = 0;
+		[self updateVirtualTappers];
+		RNVirtualTappersCounts virtualCounts = RNVirtualTappersGetCounts(_virtualTappers);
+		NSLog(@"\n\tVirtual tappers: %llu taps (late by %.3f ms on average, %.3f ms at most), %llu events heard, %llu dropped",
+			  virtualCounts.taps, virtualCounts.meanLateness_ns / 1e6, virtualCounts.maxLateness_ns / 1e6, virtualCounts.heard, virtualCounts.dropped);
+	}
+	//stop stimuli, and remove any pending midi events
+	[io cancelAllStimulusStreams];
 	[io flushOutput];	
+	
+	if (_flushTimer) {
+		dispatch_source_cancel(_flushTimer);
+		dispatch_release(_flushTimer);
+		_flushTimer = NULL;
+	}
+	[self flushRecordedEvents];
+	
+	RNEventRecorderCounts counts = [self recordingCounts];
+	NSLog(@"\n\tRecording stopped: %llu events received, %llu stored, %llu dropped", counts.received, counts.stored, counts.dropped);
+	RNStimulusSchedulerCounts stimulusCounts = [io stimulusCounts];
+	if (stimulusCounts.decisions > 0)
+		NSLog(@"\n\tAdaptive pacing: %llu onsets decided (at most %.3f ms late, %.1f us each), %llu not logged, %llu taps dropped",
+			  stimulusCounts.decisions, stimulusCounts.maxDecisionLatency_ns / 1e6, stimulusCounts.maxDecisionTime_ns / 1e3,
+			  stimulusCounts.decisionsDropped, stimulusCounts.tapsDropped);
 }
 
 //take care of the ending timer !!!:jri:20050923 don't actually stop-keep recording
@@ -467,10 +1206,11 @@
 	
 	_experimentActualStopTime_s = [self secondsSinceExperimentStartDate];
 	
+	//stop parts first, so none starts once recording has stopped
+	[self unscheduleExperimentParts];
 	[self stopRecording];
 	
-	//invalidate timers for parts & end timer
-	[self unscheduleExperimentParts];
+	//invalidate end timer
 	[_experimentEndTimer invalidate];
 	[_experimentEndTimer autorelease];
 	_experimentEndTimer = nil;
@@ -486,8 +1226,203 @@
 	BOOL success = [ [self experimentSaveDictionary] writeToFile:filePath atomically:YES];
 	NSAssert( (success == YES), @"file did not save successfully");
 	
-	//consider an alternate way of saving
+	//binary journal of the same events, for offline tools
+	success = [self writeEventJournalToPath:[filePath stringByAppendingPathExtension:@"rnj"]];
+	if (success == NO)
+		NSLog(@"\n\tCould not write event journal for %@", filePath);
+	
 	[self setNeedsSave:NO];
 }
 
+//all recorded events (taps, stimuli, feedback) as an RNEventJournal: header plus one fixed-size record per event
+- (BOOL) writeEventJournalToPath: (NSString *) filePath
+{
+	uint32_t nEvents = RNEventStoreCount(_eventStore);
+	NSMutableData *journal = [NSMutableData dataWithLength:sizeof(RNEventJournalHeader) + (size_t) nEvents * sizeof(RNEventJournalRecord)];
+	
+	RNEventJournalHeader *header = (RNEventJournalHeader *) [journal mutableBytes];
+	memcpy(header->magic, kRNEventJournalMagic, sizeof(header->magic));
+	header->version					= kRNEventJournalVersion;
+	header->recordSize				= sizeof(RNEventJournalRecord);
+	header->nRecords				= nEvents;
+	header->experimentStartTime_ns	= (int64_t) [self experimentStartTimeNanoseconds];
+	
+	RNEventJournalRecord *records = (RNEventJournalRecord *) (header + 1);
+	for (uint32_t iEvent = 0; iEvent < nEvents; iEvent++) {
+		RNEvent event = RNEventStoreEventAtIndex(_eventStore, iEvent);
+		records[iEvent] = RNEventJournalRecordFromEvent(&event);
+	}
+	return [journal writeToFile:filePath atomically:YES];
+}
+
+// *********************************************
+//    Benchmark
+// *********************************************
+#pragma mark  BENCHMARK
+
+// compare bulk formatter against the former per-event stringWithFormat: approach on synthetic data
+//	not called in normal operation; run from the debugger, e.g. "expr [experiment benchmarkRecordedEventsString:200000]"
+- (void) benchmarkRecordedEventsString: (NSUInteger) nEvents
+{
+	RNEventStore *savedStore = _eventStore;
+	_eventStore = RNEventStoreCreate();
+	NSUInteger iEvent;
+	for (iEvent = 0; iEvent < nEvents; iEvent++) {
+		RNEvent event = {
+			.time_ns	= 5000000000LL + iEvent * 487123457LL,
+			.node		= 1 + (iEvent % 16),
+			.channel	= iEvent % 16,
+			.note		= kBaseNote + 1 + (iEvent % 16),
+			.velocity	= iEvent % 128,
+			.kind		= kRNEventKindTap,
+		};
+		RNEventStoreAppend(_eventStore, &event);
+	}
+
+	UInt64 t0 = AudioGetCurrentHostTime();
+	NSMutableString *eventsString = [NSMutableString stringWithCapacity:(nEvents * 32)];
+	for (iEvent = 0; iEvent < nEvents; iEvent++) {
+		RNEvent event = RNEventStoreEventAtIndex(_eventStore, (uint32_t) iEvent);
+		[eventsString appendString:[NSString stringWithFormat:@"%qi\t%d\t%d\t%d\n", \
+			event.time_ns, event.channel, event.note, event.velocity]];
+	}
+	UInt64 t1 = AudioGetCurrentHostTime();
+	NSString *bulkString = [self recordedEventsString];
+	UInt64 t2 = AudioGetCurrentHostTime();
+
+	NSAssert( [bulkString isEqualToString:eventsString], @"bulk formatter output differs from stringWithFormat:");
+	NSLog(@"recordedEventsString, %lu events: stringWithFormat %.1f ms, bulk %.1f ms (C kernel alone %.1f ns/event)", \
+		  (unsigned long) nEvents, AudioConvertHostTimeToNanos(t1 - t0) / 1e6, AudioConvertHostTimeToNanos(t2 - t1) / 1e6, \
+		  RNEventFormatBenchmark(nEvents, 10));
+
+	RNEventStoreDestroy(_eventStore);
+	_eventStore = savedStore;
+}
+
+//feed a capture's input back through the MIDI pipeline (ring, delay output, listeners), capturing again alongside
+//	to <path>.replay.rnpc, and compare what was emitted: same bytes at the same offsets from each input, and latency.
+//	realTime: at the captured spacing; else as fast as the processing thread takes it. Needs the MIDI link of a
+//	recording (delay output is sent for real); not called in normal operation; run from the debugger, e.g.
+//	"expr [experiment replayPacketCaptureAtPath:@"/Users/me/Captures/capture-20261019-101500.rnpc" realTime:NO]"
+- (BOOL) replayPacketCaptureAtPath: (NSString *) path realTime: (BOOL) realTime
+{
+	MIDIIO *io = [_MIOC MIDILink];
+	RNPacketCaptureReader *original = RNPacketCaptureOpen([path fileSystemRepresentation]);
+	if (io == nil || original == NULL || _packetCapture != NULL) {
+		NSLog(@"replayPacketCapture: %@", (original == NULL) ? @"not a capture" : @"needs the MIDI link of a stopped recording");
+		RNPacketCaptureReaderClose(original);
+		return NO;
+	}
+	
+	NSString *replayPath = [[path stringByDeletingPathExtension] stringByAppendingPathExtension:@"replay.rnpc"];
+	RNPacketCapture *capture = RNPacketCaptureCreate([replayPath fileSystemRepresentation]);
+	if (capture == NULL) {
+		RNPacketCaptureReaderClose(original);
+		return NO;
+	}
+	[io setPacketCapture:capture];
+	RNPacketReplayResult result;
+	BOOL success = [io replayPacketCapture:original realTime:realTime result:&result]; //returns with the last lists processed
+	[io setPacketCapture:NULL];
+	RNPacketCaptureClose(capture);
+	
+	RNPacketCaptureReader *replay = RNPacketCaptureOpen([replayPath fileSystemRepresentation]);
+	RNPacketCaptureComparison comparison;
+	success = success && replay != NULL && RNPacketCaptureCompare(original, replay, &comparison);
+	if (success) {
+		NSLog(@"replayPacketCapture %@: %llu lists in %.3f s (%llu retries, %.3f ms late at most)\n"
+			  "\toutputs %llu matched, %llu differing, %llu unpaired (first at %lld)\n"
+			  "\tlatency (us) original: mean %.1f p50 %.1f p99 %.1f max %.1f; replay: mean %.1f p50 %.1f p99 %.1f max %.1f",
+			  realTime ? @"in real time" : @"as fast as possible", result.nLists, result.duration_s, result.nRetries, result.maxLateness_ns / 1e6,
+			  comparison.nMatched, comparison.nDiffering, comparison.nUnpaired, comparison.firstDifference,
+			  comparison.latency[0].mean_us, comparison.latency[0].p50_us, comparison.latency[0].p99_us, comparison.latency[0].max_us,
+			  comparison.latency[1].mean_us, comparison.latency[1].p50_us, comparison.latency[1].p99_us, comparison.latency[1].max_us);
+		success = (comparison.nDiffering == 0 && comparison.nUnpaired == 0);
+	}
+	RNPacketCaptureReaderClose(replay);
+	RNPacketCaptureReaderClose(original);
+	return success;
+}
+
+//delay routing under a synthetic load (RNRoutingLoad.h): the routing stage alone, then end to end through the ring and
+//	processing thread in real time, reporting throughput, delay packet list margin and latency. Keys (all optional): nodes,
+//	rate_Hz, synchronySD_ms, density, delay_ms, delaySpread_ms, delayDistribution (fixed, uniform, gaussian), noteOff,
+//	serial, duration_s, seed. Delay output is built but not sent. Needs the MIDI link of a stopped recording;
+//	not called in normal operation; run from the debugger, e.g.
+//	"expr [experiment benchmarkDelayRoutingWithLoad:@{@"nodes": @16, @"synchronySD_ms": @0, @"noteOff": @YES}]"
+- (void) benchmarkDelayRoutingWithLoad: (NSDictionary *) load
+{
+	MIDIIO *io = [_MIOC MIDILink];
+	if (io == nil || _packetCapture != NULL) {
+		NSLog(@"benchmarkDelayRouting: needs the MIDI link of a stopped recording");
+		return;
+	}
+	
+	RNRoutingLoadConfig config;
+	RNRoutingLoadDefaultConfig(&config);
+	config.nodes			= (unsigned) parameterFromDictionary(load, @"nodes", config.nodes);
+	config.rate_Hz			= parameterFromDictionary(load, @"rate_Hz", config.rate_Hz);
+	config.synchronySD_ms	= parameterFromDictionary(load, @"synchronySD_ms", config.synchronySD_ms);
+	config.density			= parameterFromDictionary(load, @"density", config.density);
+	config.delay_ms			= parameterFromDictionary(load, @"delay_ms", config.delay_ms);
+	config.delaySpread_ms	= parameterFromDictionary(load, @"delaySpread_ms", config.delaySpread_ms);
+	config.noteOff			= parameterFromDictionary(load, @"noteOff", config.noteOff) != 0.0;
+	config.transport		= (parameterFromDictionary(load, @"serial", 0.0) != 0.0) ? kRNLoadTransportSerial : kRNLoadTransportIdeal;
+	config.duration_s		= parameterFromDictionary(load, @"duration_s", 10.0);
+	config.seed				= (uint64_t) parameterFromDictionary(load, @"seed", config.seed);
+	NSString *distribution = load[@"delayDistribution"];
+	if ([distribution isEqualToString:@"uniform"])
+		config.delayDistribution = kRNLoadDelayUniform;
+	else if ([distribution isEqualToString:@"gaussian"])
+		config.delayDistribution = kRNLoadDelayGaussian;
+	
+	NSString *loadPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"RhythmNetwork-load.rnpc"];
+	NSString *outputPath = [NSTemporaryDirectory() stringByAppendingPathComponent:@"RhythmNetwork-load-output.rnpc"];
+	RNRoutingLoadSummary summary;
+	if (!RNRoutingLoadWriteCapture(&config, [loadPath fileSystemRepresentation], &summary)) {
+		NSLog(@"benchmarkDelayRouting: can't write %@", loadPath);
+		return;
+	}
+	
+	_Static_assert(sizeof(RNLoadMatrix) == sizeof(NodeMatrix), "load matrices are routing matrices");
+	RNWeightMatrix *weightMatrix = malloc(sizeof(RNWeightMatrix));
+	NodeMatrix *delayMatrix = malloc(sizeof(NodeMatrix));
+	RNRoutingLoadMatrices(&config, weightMatrix->matrix, *delayMatrix);
+	RNWeightMatrixCompileVelocityTables(weightMatrix);
+	RNRealtimeRoutingTable table = { .MIOCMatrix = NULL };
+	atomic_init(&table.weightMatrix, weightMatrix);
+	atomic_init(&table.delayMatrix, delayMatrix);
+	
+	RNPacketCaptureReader *reader = RNPacketCaptureOpen([loadPath fileSystemRepresentation]);
+	RNPacketCapture *capture = RNPacketCaptureCreate([outputPath fileSystemRepresentation]);
+	DelayRoutingBenchmark result;
+	BOOL success = reader != NULL && capture != NULL
+		&& [io benchmarkDelayRoutingOfCapture:reader routingTable:&table noteOff:config.noteOff endToEndCapture:capture result:&result];
+	RNPacketCaptureClose(capture);
+	RNPacketCaptureReaderClose(reader);
+	free(weightMatrix);
+	free(delayMatrix);
+	if (!success) {
+		NSLog(@"benchmarkDelayRouting: no delay output to route to");
+		return;
+	}
+	
+	RNPacketCaptureReader *output = RNPacketCaptureOpen([outputPath fileSystemRepresentation]);
+	RNPacketCaptureComparison comparison = { 0 };
+	if (output != NULL)
+		RNPacketCaptureCompare(output, output, &comparison); //against itself: its latencies
+	RNPacketCaptureReaderClose(output);
+	
+	NSLog(@"benchmarkDelayRouting: %u nodes, %g Hz, synchrony SD %g ms, density %g, delay %g (+/- %g) ms, note-offs %@, %@ transport\n"
+		  "\trouting alone: %llu lists, %llu packets, %llu note-ons in %.3f ms: %.0f note-ons/s, %.0f ns each\n"
+		  "\tdelay packet list: largest %u of %d bytes (predicted %u), %u events overflowed\n"
+		  "\tend to end: %llu lists in %.3f s (%.3f ms late at most); arrival to send (us) mean %.1f p50 %.1f p99 %.1f max %.1f",
+		  config.nodes, config.rate_Hz, config.synchronySD_ms, config.density, config.delay_ms, config.delaySpread_ms,
+		  config.noteOff ? @"on" : @"off", (config.transport == kRNLoadTransportSerial) ? @"serial" : @"ideal",
+		  result.nLists, result.nPackets, result.nDelayNoteOns, result.routing_s * 1e3, result.noteOnsPerSecond, result.nsPerNoteOn,
+		  result.maxDelayListBytes, kDelayPacketListLength, summary.maxDelayListBytes, result.nOverflows,
+		  result.replay.nLists, result.replay.duration_s, result.replay.maxLateness_ns / 1e6,
+		  comparison.latency[0].mean_us, comparison.latency[0].p50_us, comparison.latency[0].p99_us, comparison.latency[0].max_us);
+}
+
 @end
@@ -9,9 +9,11 @@
 #import <Foundation/Foundation.h>
 
 #import <CoreMIDI/MIDIServices.h>
+#import "RNPartScheduler.h"
 
 @class	RNController;
 @class	MIOCModel;
+@class	MIOCTransition;
 
 @interface RNExperimentPart : NSObject
 {
@@ -21,7 +23,8 @@
 	NSTimeInterval _actualStartTime_s;
 	NSTimeInterval _startTimeUncertainty_s;
 	NSString      *_subEventTimes;
-	NSTimer       *_startTimer;
+	MIOCTransition *_MIOCTransition;  // from the MIOC state before the part, compiled at load (RNExperiment compileTimelineForDevice:)
+	BOOL           _MIOCTransitionSentAhead; // by the part scheduler, timed to land as the part starts: only the model is left to update
 }
 
 + (RNExperimentPart *)experimentPartFromDictionary:(NSDictionary *)aDict;
@@ -41,17 +44,15 @@
 - (void)setStartTimeUncertainty:(NSTimeInterval)time;
 - (NSString *)subEventTimes;
 - (void)setSubEventTimes:(NSString *)timesStr;
-
-- (NSTimer *)startTimer;
-- (void)setStartTimer:(NSTimer *)theTimer;
+- (MIOCTransition *)MIOCTransition;	// nil: none compiled, or nothing to change
+- (void)setMIOCTransition:(MIOCTransition *)transition;
+- (BOOL)MIOCTransitionSentAhead;
+- (void)setMIOCTransitionSentAhead:(BOOL)sentAhead;
 
 - (BOOL)containsObject:(id)aPart;
 
 // Actions
-- (void)postNewStimulusNotification:(NSTimer *)timer;
-- (void)postNewNetworkNotification:(NSTimer *)timer;
-- (void)postNewGlobalConnectionStrengthNotification:(NSTimer *)timer;
-- (void)scheduleForExperimentStartTime:(NSDate *)time Timestamp:(MIDITimeStamp)timestamp;
-- (void)unschedule;
+- (RNPartEntry)timelineEntryForExperimentStartTime:(UInt64)experimentStartTime_ns;
+- (void)postStartNotification;
 
 @end
@@ -104,13 +104,12 @@
 {
 	[_experimentPart release];
 	_experimentPart = nil;
-	[_startTimer invalidate];
-	[_startTimer release];
-	_startTimer = nil;
 	[_description release];
 	_description = nil;
 	[_subEventTimes release];
 	_subEventTimes = nil;
+	[_MIOCTransition release];
+	_MIOCTransition = nil;
 	[super dealloc];
 }
 
@@ -182,21 +181,25 @@
 	_subEventTimes	= [timesStr copy];
 }
 
-- (NSTimer *)startTimer
+- (MIOCTransition *)MIOCTransition
 {
-	return _startTimer;
+	return _MIOCTransition;
 }
 
-// passing nil removes the timer
-- (void)setStartTimer:(NSTimer *)theTimer
+- (void)setMIOCTransition:(MIOCTransition *)transition
 {
-	if ((_startTimer != nil) && (theTimer != nil)) {
-		NSAssert((0), @"Assigning a new timer on top of an existing one");
-	}
+	[_MIOCTransition autorelease];
+	_MIOCTransition = [transition retain];
+}
+
+- (BOOL)MIOCTransitionSentAhead
+{
+	return _MIOCTransitionSentAhead;
+}
 
-	[_startTimer invalidate];
-	[_startTimer autorelease];
-	_startTimer = [theTimer retain];
+- (void)setMIOCTransitionSentAhead:(BOOL)sentAhead
+{
+	_MIOCTransitionSentAhead = sentAhead;
 }
 
 - (BOOL)containsObject:(id)aPart
@@ -209,97 +212,39 @@
 //
 #pragma mark  Actions
 
-// timer callbacks that post notifications
-- (void)postNewStimulusNotification:(NSTimer *)timer
-{
-	RNStimulus *stim = (RNStimulus *)[timer userInfo];
-
-	NSLog(@"activating stimulus %@", [stim description]);
-	[[NSNotificationCenter defaultCenter] postNotificationName:@"newStimulusNotification" object:self];
-}
-
-- (void)postNewNetworkNotification:(NSTimer *)timer
-{
-	RNNetwork *net = (RNNetwork *)[timer userInfo];
-
-	NSLog(@"activating network %@", [net description]);
-	[[NSNotificationCenter defaultCenter] postNotificationName:@"newNetworkNotification" object:self];
-}
-
-- (void)postNewGlobalConnectionStrengthNotification:(NSTimer *)timer
-{
-	RNGlobalConnectionStrength *weight = (RNGlobalConnectionStrength *)[timer userInfo];
-
-	NSLog(@"activating global connection strength %@", [weight description]);
-	[[NSNotificationCenter defaultCenter] postNotificationName:@"newGlobalConnectionStrengthNotification" object:self];
+// when the part starts, and what changes then in realtime (RNPartScheduler): a network swaps in its routing table,
+//	the rest (stimuli, connection strengths) only need their notification. part is left to the caller
+- (RNPartEntry)timelineEntryForExperimentStartTime:(UInt64)experimentStartTime_ns
+{
+	RNPartEntry entry = {
+		.due_ns		= (int64_t) experimentStartTime_ns + llround(_startTime_s * 1000000000.0),
+		.action		= kRNPartActionNotify,
+	};
+	if ([[self partType] isEqualToString:@"RNNetwork"]) {
+		RNMIDIRouting *routing = [(RNNetwork *)[self experimentPart] MIDIRouting];
+		entry.action	= kRNPartActionRouting;
+		entry.payload	= (routing != nil) ? [routing routingTable] : NULL; //none: hardware routing only
+	}
+	return entry;
 }
 
-// schedule timers
-- (void)scheduleForExperimentStartTime:(NSDate *)time Timestamp:(MIDITimeStamp)timestamp
+// once the part has started (its actual start time set), tell the UI
+- (void)postStartNotification
 {
-	// setup a timer to trigger the start
-	NSTimeInterval	interval1, interval2, preroll, uncertainty;
-	NSDate			*absStartTime;
+	NSString *name;
 
-	//  in the case of a stimulus, schedule it now with the MIDI system
 	if ([[self partType] isEqualToString:@"RNStimulus"]) {
-		NSLog(@"Scheduling stimulus: %@\n\t%@", [self description], [self experimentPart]);
-		preroll			= 0.001;// empirical: notification received ~1ms after timer fires
-		absStartTime	= [time dateByAddingTimeInterval:_startTime_s];
-		interval1		= [absStartTime timeIntervalSinceNow] - preroll;
-		NSTimer *startTimer = [NSTimer scheduledTimerWithTimeInterval:interval1
-			target	:self
-			selector:@selector(postNewStimulusNotification:)
-			userInfo:[self experimentPart]
-			repeats :NO];
-		interval2	= [absStartTime timeIntervalSinceNow] - preroll;
-		uncertainty = (interval1 - interval2) * 1000.0;
-		NSLog(@"Scheduling stimulus @T+%.2f: %@\n\t%@", _startTime_s, [self description], [self experimentPart]);
-		NSLog(@"\n\tUncertainty in part timer scheduling is maximum %.3f ms (%g - %g)", uncertainty, interval1, interval2);
-		[self setStartTimer:startTimer];
-
-		// for network, setup a timer to trigger the reprogramming
+		name = @"newStimulusNotification";
 	} else if ([[self partType] isEqualToString:@"RNNetwork"]) {
-		preroll = 0.03;	// just a guess for how long it'll take to reprogram MIOC
-		absStartTime = [time dateByAddingTimeInterval:_startTime_s];
-		interval1 = [absStartTime timeIntervalSinceNow] - preroll;
-		NSTimer *startTimer = [NSTimer scheduledTimerWithTimeInterval:interval1
-			target	:self
-			selector:@selector(postNewNetworkNotification:)
-			userInfo:[self experimentPart]
-			repeats :NO];
-		// NSTimer *startTimer = [NSTimer scheduledTimerWithTimeInterval:interval1
-		//													   target:MIOC
-		//													 selector:@selector(setConnectionListTimerHandler:)
-		//													 userInfo:[[self experimentPart] MIOCConnectionList]
-		//													  repeats:NO];
-		interval2	= [absStartTime timeIntervalSinceNow] - preroll;
-		uncertainty = (interval1 - interval2) * 1000.0;
-		NSLog(@"Scheduling network @T+%.2f: %@\n\t%@", _startTime_s, [self description], [self experimentPart]);
-		NSLog(@"\n\tUncertainty in part timer scheduling is maximum %.3f ms (%g - %g)", uncertainty, interval1, interval2);
-		[self setStartTimer:startTimer];
+		name = @"newNetworkNotification";
 	} else if ([[self partType] isEqualToString:@"RNGlobalConnectionStrength"]) {
-		preroll = 0.02;	// just a guess for how long it'll take to reprogram MIOC
-		absStartTime = [time dateByAddingTimeInterval:_startTime_s];
-		interval1 = [absStartTime timeIntervalSinceNow] - preroll;
-		NSTimer *startTimer = [NSTimer scheduledTimerWithTimeInterval:interval1
-			target	:self
-			selector:@selector(postNewGlobalConnectionStrengthNotification:)
-			userInfo:[self experimentPart]
-			repeats :NO];
-		interval2	= [absStartTime timeIntervalSinceNow] - preroll;
-		uncertainty = (interval1 - interval2) * 1000.0;
-		NSLog(@"Scheduling global connection strength @T+%.2f: %@\n\t%@", _startTime_s, [self description], [self experimentPart]);
-		NSLog(@"\n\tUncertainty in part timer scheduling is maximum %.3f ms (%g - %g)", uncertainty, interval1, interval2);
-		[self setStartTimer:startTimer];
+		name = @"newGlobalConnectionStrengthNotification";
 	} else {
 		NSAssert1(0, @"Unknown experiment part type: %@", [self partType]);
+		return;
 	}
-}
-
-- (void)unschedule
-{
-	[self setStartTimer:nil];
+	NSLog(@"activating %@ @T+%.4f (%.3f ms late)", [self shortDescription], _actualStartTime_s, _startTimeUncertainty_s * 1000.0);
+	[[NSNotificationCenter defaultCenter] postNotificationName:name object:self];
 }
 
 @end
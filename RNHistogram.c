@@ -0,0 +1,188 @@
+//
+//  RNHistogram.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNHistogram.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+struct RNHistogram {
+	_Atomic(uint32_t)	configSequence;		// odd while the binning is being changed
+	_Atomic(int64_t)	IOI_ns;
+	_Atomic(uint32_t)	nBins;
+	_Atomic(uint64_t)	epoch;
+	_Atomic(uint64_t)	outOfRange;
+	_Atomic(uint32_t)	counts[kRNHistogramMaxBins];
+};
+
+static inline RNHistogramBinning validBinning(RNHistogramBinning binning)
+{
+	if (binning.nBins > kRNHistogramMaxBins) binning.nBins = kRNHistogramMaxBins;
+	if (binning.nBins == 0) binning.IOI_ns = 0;
+	binning.spare = 0;
+	return binning;
+}
+
+RNHistogram *RNHistogramCreate(RNHistogramBinning binning)
+{
+	RNHistogram *histogram = calloc(1, sizeof(RNHistogram));
+	if (histogram) RNHistogramSetBinning(histogram, binning);
+	return histogram;
+}
+
+void RNHistogramDestroy(RNHistogram *histogram)
+{
+	free(histogram);
+}
+
+static void clearCounts(RNHistogram *h)
+{
+	for (unsigned i = 0; i < kRNHistogramMaxBins; i++)
+		atomic_store_explicit(&h->counts[i], 0, memory_order_relaxed);
+	atomic_store_explicit(&h->outOfRange, 0, memory_order_relaxed);
+	atomic_fetch_add_explicit(&h->epoch, 1, memory_order_relaxed); // readers see a change
+}
+
+void RNHistogramSetBinning(RNHistogram *h, RNHistogramBinning binning)
+{
+	binning = validBinning(binning);
+	uint32_t sequence = atomic_load_explicit(&h->configSequence, memory_order_relaxed);
+	atomic_store_explicit(&h->configSequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&h->IOI_ns, binning.IOI_ns, memory_order_relaxed);
+	atomic_store_explicit(&h->nBins, binning.nBins, memory_order_relaxed);
+	clearCounts(h);
+	atomic_store_explicit(&h->configSequence, sequence + 2, memory_order_release);
+}
+
+void RNHistogramClear(RNHistogram *h)
+{
+	uint32_t sequence = atomic_load_explicit(&h->configSequence, memory_order_relaxed);
+	atomic_store_explicit(&h->configSequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	clearCounts(h);
+	atomic_store_explicit(&h->configSequence, sequence + 2, memory_order_release);
+}
+
+int RNHistogramBinForValue(RNHistogramBinning binning, int64_t asynchrony_ns)
+{
+	if (binning.IOI_ns <= 0 || binning.nBins == 0) return -1;
+	int64_t offset_ns = asynchrony_ns + binning.IOI_ns / 2;
+	if (offset_ns < 0 || offset_ns >= binning.IOI_ns) return -1;
+	return (int)((offset_ns * (int64_t) binning.nBins) / binning.IOI_ns);
+}
+
+double RNHistogramBinCentre_ms(RNHistogramBinning binning, unsigned iBin)
+{
+	if (binning.nBins == 0) return 0.0;
+	double binWidth_ms = binning.IOI_ns / 1e6 / binning.nBins;
+	return (iBin + 0.5) * binWidth_ms - binning.IOI_ns / 2e6;
+}
+
+bool RNHistogramAdd(RNHistogram *h, int64_t asynchrony_ns)
+{
+	RNHistogramBinning binning = {
+		.IOI_ns	= atomic_load_explicit(&h->IOI_ns, memory_order_relaxed),
+		.nBins	= atomic_load_explicit(&h->nBins, memory_order_relaxed),
+	};
+	if (binning.IOI_ns <= 0) return false;
+
+	int iBin = RNHistogramBinForValue(binning, asynchrony_ns);
+	if (iBin < 0)
+		atomic_fetch_add_explicit(&h->outOfRange, 1, memory_order_relaxed);
+	else
+		atomic_fetch_add_explicit(&h->counts[iBin], 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&h->epoch, 1, memory_order_release);
+	return iBin >= 0;
+}
+
+uint64_t RNHistogramEpoch(const RNHistogram *histogram)
+{
+	return atomic_load_explicit(&((RNHistogram *) histogram)->epoch, memory_order_acquire);
+}
+
+void RNHistogramGetSnapshot(const RNHistogram *histogram, RNHistogramSnapshot *snapshot)
+{
+	RNHistogram *h = (RNHistogram *) histogram;
+	uint32_t before, after;
+
+	do {
+		before = atomic_load_explicit(&h->configSequence, memory_order_acquire);
+		snapshot->binning.IOI_ns	= atomic_load_explicit(&h->IOI_ns, memory_order_relaxed);
+		snapshot->binning.nBins		= atomic_load_explicit(&h->nBins, memory_order_relaxed);
+		snapshot->binning.spare		= 0;
+		snapshot->epoch				= atomic_load_explicit(&h->epoch, memory_order_acquire);
+		snapshot->outOfRange		= atomic_load_explicit(&h->outOfRange, memory_order_relaxed);
+
+		// counts may run ahead of the epoch read above, never behind it
+		uint64_t total = 0;
+		uint32_t maxCount = 0;
+		for (unsigned i = 0; i < snapshot->binning.nBins; i++) {
+			uint32_t count = atomic_load_explicit(&h->counts[i], memory_order_relaxed);
+			snapshot->counts[i] = count;
+			total += count;
+			if (count > maxCount) maxCount = count;
+		}
+		snapshot->total		= total;
+		snapshot->maxCount	= maxCount;
+
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&h->configSequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	memset(&snapshot->counts[snapshot->binning.nBins], 0,
+		   (kRNHistogramMaxBins - snapshot->binning.nBins) * sizeof(uint32_t));
+}
+
+uint32_t RNHistogramSnapshotDiff(const RNHistogramSnapshot *before, const RNHistogramSnapshot *after,
+								 uint16_t *changedBins, uint32_t maxChanged)
+{
+	if (before->binning.IOI_ns != after->binning.IOI_ns || before->binning.nBins != after->binning.nBins)
+		return UINT32_MAX;
+
+	uint32_t nChanged = 0;
+	for (unsigned i = 0; i < after->binning.nBins; i++) {
+		if (before->counts[i] != after->counts[i]) {
+			if (nChanged < maxChanged) changedBins[nChanged] = (uint16_t) i;
+			nChanged++;
+		}
+	}
+	return nChanged;
+}
+
+static void snapshotMoments(const RNHistogramSnapshot *s, double *mean_ms, double *sd_ms)
+{
+	double sum = 0.0, sumSquares = 0.0;
+	for (unsigned i = 0; i < s->binning.nBins; i++) {
+		double centre = RNHistogramBinCentre_ms(s->binning, i);
+		sum += s->counts[i] * centre;
+		sumSquares += s->counts[i] * centre * centre;
+	}
+	*mean_ms = (s->total > 0) ? sum / s->total : 0.0;
+	*sd_ms = (s->total > 1) ? sqrt(fmax(0.0, (sumSquares - sum * (*mean_ms)) / (s->total - 1))) : 0.0;
+}
+
+RNHistogramComparison RNHistogramSnapshotCompare(const RNHistogramSnapshot *a, const RNHistogramSnapshot *b)
+{
+	RNHistogramComparison comparison;
+	snapshotMoments(a, &comparison.meanA_ms, &comparison.sdA_ms);
+	snapshotMoments(b, &comparison.meanB_ms, &comparison.sdB_ms);
+	comparison.shift_ms = comparison.meanB_ms - comparison.meanA_ms;
+
+	if (a->binning.IOI_ns != b->binning.IOI_ns || a->binning.nBins != b->binning.nBins) {
+		comparison.overlap = NAN;
+	} else if (a->total == 0 || b->total == 0) {
+		comparison.overlap = 0.0;
+	} else {
+		double overlap = 0.0;
+		for (unsigned i = 0; i < a->binning.nBins; i++)
+			overlap += fmin((double) a->counts[i] / a->total, (double) b->counts[i] / b->total);
+		comparison.overlap = overlap;
+	}
+	return comparison;
+}
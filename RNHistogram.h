@@ -0,0 +1,87 @@
+//
+//  RNHistogram.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Fixed-bin asynchrony histogram, independent of any view.
+//	- bins span one target IOI, centred on the pacer onset: [-IOI/2, IOI/2)
+//	- adding a value is one atomic increment, so any thread may add without locks; values
+//	  outside the bins are counted, never written out of bounds
+//	- the epoch counts adds: a reader compares epochs to see if anything changed, takes a
+//	  snapshot, and diffs it against its last one to find the bins to redraw
+//	- snapshots can be kept (frozen) to compare one experiment part against the next
+//
+// SetBinning and Clear must not race Add (call them from the thread that adds); snapshots
+//	taken meanwhile retry until they see one binning throughout.
+
+#ifndef RNHistogram_h
+#define RNHistogram_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNHistogramMaxBins		1000
+#define kRNHistogramDefaultBins	100
+
+typedef struct {
+	int64_t		IOI_ns;			// range covered: -IOI/2 .. IOI/2; <= 0: unconfigured, adds are ignored
+	uint32_t	nBins;			// <= kRNHistogramMaxBins
+	uint32_t	spare;
+} RNHistogramBinning;
+
+typedef struct {
+	RNHistogramBinning	binning;
+	uint64_t			epoch;			// adds seen when the snapshot was taken
+	uint64_t			total;			// binned values
+	uint64_t			outOfRange;		// values that fell outside the bins
+	uint32_t			maxCount;		// largest bin
+	uint32_t			counts[kRNHistogramMaxBins];
+} RNHistogramSnapshot;
+
+typedef struct {
+	double		meanA_ms, meanB_ms;		// means of bin centres
+	double		sdA_ms, sdB_ms;
+	double		shift_ms;				// meanB - meanA
+	double		overlap;				// sum of min(pA, pB) over bins: 1 = same shape, 0 = disjoint; NAN if binnings differ
+} RNHistogramComparison;
+
+typedef struct RNHistogram RNHistogram;
+
+RNHistogram	*RNHistogramCreate(RNHistogramBinning binning);
+void		RNHistogramDestroy(RNHistogram *histogram);
+
+// Adding thread only: new binning (clears the counts) and clearing.
+void		RNHistogramSetBinning(RNHistogram *histogram, RNHistogramBinning binning);
+void		RNHistogramClear(RNHistogram *histogram);
+
+// Any thread. Returns false (and counts it) if the value is outside the bins.
+bool		RNHistogramAdd(RNHistogram *histogram, int64_t asynchrony_ns);
+
+// Any thread.
+uint64_t	RNHistogramEpoch(const RNHistogram *histogram);
+void		RNHistogramGetSnapshot(const RNHistogram *histogram, RNHistogramSnapshot *snapshot);
+
+// Bin of a value under a binning, or -1 if outside.
+int			RNHistogramBinForValue(RNHistogramBinning binning, int64_t asynchrony_ns);
+// Centre of bin iBin in ms (relative to the pacer onset).
+double		RNHistogramBinCentre_ms(RNHistogramBinning binning, unsigned iBin);
+
+// Bins whose counts differ between two snapshots of the same binning, written to changedBins (at
+//	most maxChanged). Returns the number found, or UINT32_MAX if the binnings differ (redraw all).
+uint32_t	RNHistogramSnapshotDiff(const RNHistogramSnapshot *before, const RNHistogramSnapshot *after,
+									uint16_t *changedBins, uint32_t maxChanged);
+
+// Compare two snapshots (e.g. a frozen part against the current one); binnings may differ.
+RNHistogramComparison RNHistogramSnapshotCompare(const RNHistogramSnapshot *a, const RNHistogramSnapshot *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNHistogram_h */
@@ -0,0 +1,36 @@
+//
+//  RNHostClock.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// The host clock (ns) that scheduler threads time against: mach absolute time on macOS, as
+//	CoreMIDI timestamps (AudioConvertHostTimeToNanos), so times compare directly with MIDI input.
+
+#ifndef RNHostClock_h
+#define RNHostClock_h
+
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline int64_t RNHostClockNow(void)
+{
+#ifdef __APPLE__
+	return (int64_t) clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNHostClock_h */
@@ -0,0 +1,330 @@
+//
+//  RNLeadLag.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNLeadLag.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define kHistoryMask		(kRNLeadLagHistory - 1)
+#define kMaxLags			(2 * kRNLeadLagMaxLag + 1)
+#define kSeriesRowLength	64
+_Static_assert((kRNLeadLagHistory & kHistoryMask) == 0, "history length must be a power of 2");
+
+typedef struct {
+	int64_t		nTaps;
+	int64_t		lastTap_ns;
+	float		ITI_ms[kRNLeadLagHistory];	// ring
+	uint32_t	nITIs;						// total, free running
+} RNLeadLagNode;
+
+struct RNLeadLag {
+	unsigned			nNodes;
+	unsigned			window;
+	unsigned			maxLag;
+	RNLeadLagNode		node[kRNLeadLagMaxNodes];
+	uint64_t			connected[kRNLeadLagMaxNodes];	// bit b of row a
+
+	RNLeadLagSample		*series;
+	size_t				nSeries, seriesCapacity;
+
+	_Atomic(uint32_t)	sequence;
+	_Atomic(float)		*leadLag;						// nNodes * nNodes
+	_Atomic(int8_t)		*peakLag;
+};
+
+RNLeadLag *RNLeadLagCreate(unsigned nNodes, unsigned window, unsigned maxLag)
+{
+	if (window == 0) window = kRNLeadLagDefaultWindow;
+	if (maxLag == 0) maxLag = kRNLeadLagDefaultMaxLag;
+	if (nNodes == 0 || nNodes > kRNLeadLagMaxNodes || maxLag > kRNLeadLagMaxLag
+		|| window < 3 || window + 2 * maxLag > kRNLeadLagHistory)
+		return NULL;
+
+	RNLeadLag *ll = calloc(1, sizeof(RNLeadLag));
+	if (ll == NULL) return NULL;
+	ll->nNodes	= nNodes;
+	ll->window	= window;
+	ll->maxLag	= maxLag;
+	ll->leadLag	= calloc((size_t)nNodes * nNodes, sizeof(_Atomic(float)));
+	ll->peakLag	= calloc((size_t)nNodes * nNodes, sizeof(_Atomic(int8_t)));
+	if (ll->leadLag == NULL || ll->peakLag == NULL) {
+		RNLeadLagDestroy(ll);
+		return NULL;
+	}
+	RNLeadLagReset(ll);
+	return ll;
+}
+
+void RNLeadLagDestroy(RNLeadLag *ll)
+{
+	if (ll == NULL) return;
+	free((void *) ll->leadLag);
+	free((void *) ll->peakLag);
+	free(ll->series);
+	free(ll);
+}
+
+static inline void beginPublish(RNLeadLag *ll)
+{
+	uint32_t sequence = atomic_load_explicit(&ll->sequence, memory_order_relaxed);
+	atomic_store_explicit(&ll->sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+static inline void endPublish(RNLeadLag *ll)
+{
+	uint32_t sequence = atomic_load_explicit(&ll->sequence, memory_order_relaxed);
+	atomic_store_explicit(&ll->sequence, sequence + 1, memory_order_release);
+}
+
+static inline void publishPair(RNLeadLag *ll, unsigned a, unsigned b, float leadLag, int8_t peakLag)
+{
+	atomic_store_explicit(&ll->leadLag[a * ll->nNodes + b], leadLag, memory_order_relaxed);
+	atomic_store_explicit(&ll->leadLag[b * ll->nNodes + a], -leadLag, memory_order_relaxed);
+	atomic_store_explicit(&ll->peakLag[a * ll->nNodes + b], peakLag, memory_order_relaxed);
+	atomic_store_explicit(&ll->peakLag[b * ll->nNodes + a], (int8_t) -peakLag, memory_order_relaxed);
+}
+
+static void clearPublished(RNLeadLag *ll)
+{
+	beginPublish(ll);
+	for (size_t p = 0; p < (size_t)ll->nNodes * ll->nNodes; p++) {
+		atomic_store_explicit(&ll->leadLag[p], NAN, memory_order_relaxed);
+		atomic_store_explicit(&ll->peakLag[p], 0, memory_order_relaxed);
+	}
+	endPublish(ll);
+}
+
+void RNLeadLagReset(RNLeadLag *ll)
+{
+	memset(ll->node, 0, sizeof(ll->node));
+	ll->nSeries = 0;
+	clearPublished(ll);
+}
+
+void RNLeadLagClearConnections(RNLeadLag *ll)
+{
+	memset(ll->connected, 0, sizeof(ll->connected));
+	clearPublished(ll); // values for old pairs no longer apply; ITI history and series are kept
+}
+
+void RNLeadLagSetConnected(RNLeadLag *ll, unsigned a, unsigned b, bool connected)
+{
+	if (a >= ll->nNodes || b >= ll->nNodes || a == b) return;
+	if (connected) {
+		ll->connected[a] |= (1ULL << b);
+		ll->connected[b] |= (1ULL << a);
+	} else {
+		ll->connected[a] &= ~(1ULL << b);
+		ll->connected[b] &= ~(1ULL << a);
+	}
+}
+
+// the node's last n ITIs, oldest first
+static inline void copyRecentITIs(const RNLeadLagNode *node, float *dst, unsigned n)
+{
+	uint32_t first = node->nITIs - n;
+	for (unsigned i = 0; i < n; i++)
+		dst[i] = node->ITI_ms[(first + i) & kHistoryMask];
+}
+
+// out[k] = sum x[i] * y[i + k], k = 0..nLags-1: the correlation kernel
+static void laggedDotProducts(const float *restrict x, const float *restrict y, unsigned n,
+							  unsigned nLags, float *restrict out)
+{
+	for (unsigned k = 0; k < nLags; k++) {
+		float sum = 0.0f;
+		const float *restrict yk = y + k;
+		for (unsigned i = 0; i < n; i++)
+			sum += x[i] * yk[i];
+		out[k] = sum;
+	}
+}
+
+// r[k + maxLag] = corr(a[n], b[n + k]) over the window; false if either series is flat
+static bool laggedCorrelation(const RNLeadLag *ll, const RNLeadLagNode *a, const RNLeadLagNode *b, float *r)
+{
+	const unsigned W = ll->window, L = ll->maxLag, nLags = 2 * L + 1, span = W + 2 * L;
+	float aFull[kRNLeadLagHistory], y[kRNLeadLagHistory], x[kRNLeadLagHistory];
+	float dots[kMaxLags];
+
+	copyRecentITIs(a, aFull, span);
+	copyRecentITIs(b, y, span);
+
+	// a's window sits in the middle of its span, so b can be shifted by up to L either way
+	double sumX = 0.0, sumXX = 0.0;
+	for (unsigned i = 0; i < W; i++) {
+		x[i] = aFull[i + L];
+		sumX += x[i];
+	}
+	float meanX = (float)(sumX / W);
+	for (unsigned i = 0; i < W; i++) {
+		x[i] -= meanX;
+		sumXX += (double) x[i] * x[i];
+	}
+	if (sumXX <= 0.0) return false;
+
+	// x has zero mean, so dot(x, y) is dot(x, y - mean(y)) for any shift of y
+	laggedDotProducts(x, y, W, nLags, dots);
+
+	// per-shift norm of y from running sums
+	double sumY = 0.0, sumYY = 0.0;
+	for (unsigned i = 0; i < W; i++) {
+		sumY += y[i];
+		sumYY += (double) y[i] * y[i];
+	}
+	for (unsigned k = 0; k < nLags; k++) {
+		if (k > 0) {
+			sumY += y[k + W - 1] - y[k - 1];
+			sumYY += (double) y[k + W - 1] * y[k + W - 1] - (double) y[k - 1] * y[k - 1];
+		}
+		double varY = sumYY - sumY * sumY / W;
+		if (varY <= 0.0) return false;
+		r[k] = (float)(dots[k] / sqrt(sumXX * varY));
+	}
+	return true;
+}
+
+static void appendSample(RNLeadLag *ll, const RNLeadLagSample *sample)
+{
+	if (ll->nSeries == ll->seriesCapacity) {
+		size_t capacity = (ll->seriesCapacity > 0) ? 2 * ll->seriesCapacity : 4096;
+		RNLeadLagSample *series = realloc(ll->series, capacity * sizeof(RNLeadLagSample));
+		if (series == NULL) return; // keep computing, stop recording
+		ll->series = series;
+		ll->seriesCapacity = capacity;
+	}
+	ll->series[ll->nSeries++] = *sample;
+}
+
+void RNLeadLagAddTap(RNLeadLag *ll, unsigned iNode, int64_t time_ns)
+{
+	if (iNode >= ll->nNodes) return;
+	RNLeadLagNode *tapper = &ll->node[iNode];
+
+	if (tapper->nTaps > 0) {
+		tapper->ITI_ms[tapper->nITIs & kHistoryMask] = (float)((time_ns - tapper->lastTap_ns) / 1e6);
+		tapper->nITIs++;
+	}
+	tapper->nTaps++;
+	tapper->lastTap_ns = time_ns;
+
+	const unsigned span = ll->window + 2 * ll->maxLag;
+	uint64_t partners = ll->connected[iNode];
+	if (tapper->nITIs < span || partners == 0) return;
+
+	beginPublish(ll);
+	while (partners) {
+		unsigned j = (unsigned) __builtin_ctzll(partners);
+		partners &= partners - 1;
+		if (ll->node[j].nITIs < span) continue;
+
+		// always as (lower, higher) so the sign convention is fixed
+		unsigned a = (iNode < j) ? iNode : j, b = (iNode < j) ? j : iNode;
+		float r[kMaxLags];
+		if (!laggedCorrelation(ll, &ll->node[a], &ll->node[b], r)) continue;
+
+		const unsigned L = ll->maxLag;
+		unsigned best = 0;
+		for (unsigned k = 1; k < 2 * L + 1; k++)
+			if (r[k] > r[best]) best = k;
+		float leadLag = r[L + 1] - r[L - 1];
+		int8_t peakLag = (int8_t)((int) best - (int) L);
+		publishPair(ll, a, b, leadLag, peakLag);
+
+		RNLeadLagSample sample = {
+			.time_ns = time_ns, .nodeA = (uint16_t) a, .nodeB = (uint16_t) b,
+			.leadLag = leadLag, .r0 = r[L], .peakLag = peakLag,
+		};
+		appendSample(ll, &sample);
+	}
+	endPublish(ll);
+}
+
+size_t RNLeadLagSeriesCount(const RNLeadLag *ll)
+{
+	return ll->nSeries;
+}
+
+const RNLeadLagSample *RNLeadLagSeries(const RNLeadLag *ll)
+{
+	return ll->series;
+}
+
+size_t RNLeadLagSeriesFormatLength(const RNLeadLag *ll)
+{
+	return ll->nSeries * kSeriesRowLength;
+}
+
+size_t RNLeadLagSeriesFormat(const RNLeadLag *ll, char *dst, size_t capacity)
+{
+	size_t length = 0;
+	char row[kSeriesRowLength + 1];
+
+	for (size_t i = 0; i < ll->nSeries; i++) {
+		const RNLeadLagSample *sample = &ll->series[i];
+		int n = snprintf(row, sizeof(row), "%lld\t%u\t%u\t%.4f\t%.4f\t%d\n", (long long) sample->time_ns,
+						 sample->nodeA, sample->nodeB, sample->leadLag, sample->r0, sample->peakLag);
+		if (n < 0 || length + (size_t) n > capacity) break;
+		memcpy(dst + length, row, (size_t) n);
+		length += (size_t) n;
+	}
+	return length;
+}
+
+unsigned RNLeadLagNodeCount(const RNLeadLag *ll)
+{
+	return ll->nNodes;
+}
+
+void RNLeadLagGetMatrix(const RNLeadLag *leadLag, float *leadLagMatrix, int8_t *peakLagMatrix)
+{
+	RNLeadLag *ll = (RNLeadLag *) leadLag;
+	size_t n = (size_t) ll->nNodes * ll->nNodes;
+	uint32_t before, after;
+
+	do {
+		before = atomic_load_explicit(&ll->sequence, memory_order_acquire);
+		for (size_t p = 0; p < n; p++) {
+			if (leadLagMatrix) leadLagMatrix[p] = atomic_load_explicit(&ll->leadLag[p], memory_order_relaxed);
+			if (peakLagMatrix) peakLagMatrix[p] = atomic_load_explicit(&ll->peakLag[p], memory_order_relaxed);
+		}
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&ll->sequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+}
+
+double RNLeadLagBenchmark(unsigned nNodes, uint32_t nTaps)
+{
+	RNLeadLag *ll = RNLeadLagCreate(nNodes, 0, 0);
+	struct timespec t0, t1;
+	if (ll == NULL || nTaps == 0) {
+		RNLeadLagDestroy(ll);
+		return 0.0;
+	}
+	for (unsigned a = 0; a < nNodes; a++)
+		for (unsigned b = a + 1; b < nNodes; b++)
+			RNLeadLagSetConnected(ll, a, b, true);
+
+	// ~500 ms taps with scatter
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint32_t i = 0; i < nTaps; i++) {
+		unsigned node = i % nNodes;
+		int64_t time_ns = (int64_t)(i / nNodes) * 500000000LL + (int64_t)((i * 2654435761u) % 30000000u);
+		RNLeadLagAddTap(ll, node, time_ns);
+		if (ll->nSeries > (1u << 20)) ll->nSeries = 0; // don't let the recorded series dominate
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	double elapsed_ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+	RNLeadLagDestroy(ll);
+	return elapsed_ns / nTaps;
+}
@@ -0,0 +1,85 @@
+//
+//  RNLeadLag.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Leader/follower estimates for connected tapper pairs, updated as each tap arrives.
+//	- every node keeps a ring of its recent ITIs
+//	- on a tap by node a, each connected pair (a, b) is recomputed: the lagged correlation
+//	  r(k) = corr(ITI_a[n], ITI_b[n + k]) for k in -maxLag..maxLag over window ITIs, with the two
+//	  series aligned on their most recent taps
+//	- the lead/lag index of the pair is r(+1) - r(-1): > 0 when b's ITIs echo a's previous
+//	  ones, i.e. a leads. The matrix is antisymmetric: leadLag[a][b] = -leadLag[b][a]
+//	- peak lag is the k with the largest r (row leads column by k ITIs when k > 0)
+//
+// Cost per tap is (connected partners) * (window * lags), done with contiguous dot products the
+//	compiler vectorizes. One thread writes; any thread reads the matrices through a sequence counter.
+
+#ifndef RNLeadLag_h
+#define RNLeadLag_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNLeadLagMaxNodes		64
+#define kRNLeadLagMaxLag		4
+#define kRNLeadLagHistory		64	// ITIs kept per node: window + 2 * maxLag must fit
+#define kRNLeadLagDefaultWindow	16
+#define kRNLeadLagDefaultMaxLag	2
+
+// one pair update, as recorded for saving
+typedef struct {
+	int64_t		time_ns;		// tap that triggered it
+	uint16_t	nodeA;			// lower node number
+	uint16_t	nodeB;			// leadLag > 0: nodeA leads nodeB
+	float		leadLag;
+	float		r0;				// zero-lag correlation
+	int8_t		peakLag;
+	uint8_t		spare[3];
+} RNLeadLagSample;
+
+typedef struct RNLeadLag RNLeadLag;
+
+// Nodes 0..nNodes-1 (<= kRNLeadLagMaxNodes); window ITIs (0: default); lags up to maxLag
+//	(0: default, at most kRNLeadLagMaxLag).
+RNLeadLag	*RNLeadLagCreate(unsigned nNodes, unsigned window, unsigned maxLag);
+void		RNLeadLagDestroy(RNLeadLag *leadLag);
+
+// Writer side. Only connected pairs are computed; connections are undirected here. Clearing
+//	connections clears the published matrices but keeps ITI history and the recorded series.
+void		RNLeadLagClearConnections(RNLeadLag *leadLag);
+void		RNLeadLagSetConnected(RNLeadLag *leadLag, unsigned a, unsigned b, bool connected);
+void		RNLeadLagReset(RNLeadLag *leadLag);	// ITI history, matrices, series; connections kept
+
+// Writer side: a tap (taps of a node in time order).
+void		RNLeadLagAddTap(RNLeadLag *leadLag, unsigned node, int64_t time_ns);
+
+// Writer side (or with the writer stopped): pair updates so far, in order.
+size_t		RNLeadLagSeriesCount(const RNLeadLag *leadLag);
+const RNLeadLagSample *RNLeadLagSeries(const RNLeadLag *leadLag);
+
+// Rows "time_ns<tab>nodeA<tab>nodeB<tab>leadLag<tab>r0<tab>peakLag\n". Same truncation rules as
+//	RNSynchronySeriesFormat; RNLeadLagSeriesFormatLength is enough room.
+size_t		RNLeadLagSeriesFormatLength(const RNLeadLag *leadLag);
+size_t		RNLeadLagSeriesFormat(const RNLeadLag *leadLag, char *dst, size_t capacity);
+
+// Any thread. Matrices are nNodes * nNodes, row major. leadLag is NAN (and peakLag 0) for pairs
+//	not connected or without enough ITIs yet. Either pointer may be NULL.
+unsigned	RNLeadLagNodeCount(const RNLeadLag *leadLag);
+void		RNLeadLagGetMatrix(const RNLeadLag *leadLag, float *leadLagMatrix, int8_t *peakLagMatrix);
+
+// Rough timing of AddTap with every pair of nNodes connected, returns mean ns per tap (clock_gettime).
+double		RNLeadLagBenchmark(unsigned nNodes, uint32_t nTaps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNLeadLag_h */
@@ -8,19 +8,41 @@
 #import <Foundation/Foundation.h>
 #import <stdatomic.h>
 #import "RNArchitectureDefines.h"
+#import "MIOCVelocityMap.h"
 
 typedef double NodeMatrix[kMaxNodes + 1][kMaxNodes + 1]; // we use 1-based index, with 0 as BB node
 
+// a velocity table (MIOCVelocityMap.h) for each distinct weight in a weight matrix, as an MIOC velocity processor
+//	set to that weight would map; table 0 leaves velocity alone (weight 1, or no route)
+#define kRNMaxVelocityTables ((kMaxNodes + 1) * (kMaxNodes + 1) + 1)
+typedef struct {
+	uint16_t index[kMaxNodes + 1][kMaxNodes + 1]; // each route's table
+	uint16_t nTables;
+	uint8_t  table[kRNMaxVelocityTables][kMIOCVelocityTableLength];
+} RNVelocityTables;
+
+// a weight matrix and its tables, swapped in together
+typedef struct {
+	NodeMatrix       matrix;      // first, so a NodeMatrix * to it is one to this
+	RNVelocityTables velocity;
+} RNWeightMatrix;
+
+// compile weights->velocity from weights->matrix, before it is swapped in
+void RNWeightMatrixCompileVelocityTables(RNWeightMatrix *weights);
+
 typedef struct {
 	// Swappable transformation matrices (atomic for thread safety)
-	_Atomic(NodeMatrix *) weightMatrix; // 0 = no route, +/- = velocity scale
+	_Atomic(RNWeightMatrix *) weightMatrix; // 0 = no route, +/- = velocity scale; with its velocity tables
 	_Atomic(NodeMatrix *) delayMatrix;  // in ms, 0=immediate
+	// Routes made inside the MIOC (not emitted by us). Fixed once the network is built; used only to log the feedback they produce
+	NodeMatrix           *MIOCMatrix;   // 0 = no route, else weight
 } RNRealtimeRoutingTable;
 
 @interface RNMIDIRouting : NSObject {
 	RNRealtimeRoutingTable _routingTable;
-	NodeMatrix             _weightMatrix[2];
+	RNWeightMatrix         _weightMatrix[2];
 	NodeMatrix             _delayMatrix[2];
+	NodeMatrix             _MIOCMatrix;
 	int                    _weightMatrixIndex; // index of the 'live' matrix
 	int                    _delayMatrixIndex;
 }
@@ -38,4 +60,7 @@ typedef struct {
 - (NodeMatrix *)getEmptyWeightMatrix;
 - (NodeMatrix *)getEmptyDelayMatrix;
 
+// fill in before the routing table is handed to MIDIIO; not swappable
+- (NodeMatrix *)MIOCMatrix;
+
 @end
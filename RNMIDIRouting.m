@@ -13,6 +13,32 @@
 #define WEIGHT_INACTIVE_INDEX (1 - _weightMatrixIndex)
 #define DELAY_INACTIVE_INDEX (1 - _delayMatrixIndex)
 
+// one table per distinct weight, each made once here rather than per note in the processing thread
+void RNWeightMatrixCompileVelocityTables(RNWeightMatrix *weights)
+{
+	RNVelocityTables *velocity = &weights->velocity;
+	double tableWeight[kRNMaxVelocityTables];
+	MIOCVelocityTableCompile(velocity->table[0], NULL, 0);
+	tableWeight[0] = 1.0;
+	velocity->nTables = 1;
+	for (int from = 0; from <= kMaxNodes; from++) {
+		for (int to = 0; to <= kMaxNodes; to++) {
+			double wt = weights->matrix[from][to];
+			uint16_t iTable = 0;
+			if (wt != 0.0 && wt != 1.0) {
+				while (iTable < velocity->nTables && tableWeight[iTable] != wt) iTable++;
+				if (iTable == velocity->nTables) {
+					MIOCVelocityCurve curve = MIOCVelocityCurveForWeight(wt);
+					MIOCVelocityTableCompile(velocity->table[iTable], &curve, 1);
+					tableWeight[iTable] = wt;
+					velocity->nTables++;
+				}
+			}
+			velocity->index[from][to] = iTable;
+		}
+	}
+}
+
 @implementation RNMIDIRouting
 
 - (RNMIDIRouting *) init {
@@ -21,15 +47,19 @@
 
 	// explicitly initialize routing to the first one, and set to empty
 	_weightMatrixIndex = 0;
-	NodeMatrix *active = &_weightMatrix[_weightMatrixIndex];
-	memset(active, 0, sizeof(NodeMatrix));
-	atomic_store(&_routingTable.weightMatrix, active);
+	RNWeightMatrix *activeWeights = &_weightMatrix[_weightMatrixIndex];
+	memset(&activeWeights->matrix, 0, sizeof(NodeMatrix));
+	RNWeightMatrixCompileVelocityTables(activeWeights);
+	atomic_store(&_routingTable.weightMatrix, activeWeights);
 	
 	_delayMatrixIndex = 0;
-	active = &_delayMatrix[_delayMatrixIndex];
+	NodeMatrix *active = &_delayMatrix[_delayMatrixIndex];
 	memset(active, 0, sizeof(NodeMatrix));
 	atomic_store(&_routingTable.delayMatrix, active);
 	
+	memset(&_MIOCMatrix, 0, sizeof(NodeMatrix));
+	_routingTable.MIOCMatrix = &_MIOCMatrix;
+	
 	return self;
 }
 
@@ -37,11 +67,12 @@
 	return &_routingTable;
 }
 
-// atomically flip to new matrix
+// atomically flip to new matrix, its velocity tables compiled first
 - (void)setWeightMatrix:(NodeMatrix *)matrix {
-	NodeMatrix *inactive = &_weightMatrix[WEIGHT_INACTIVE_INDEX];
-	NSAssert(matrix==inactive,@"illegal input pointer--must a pointer returned by ond of the get___MatrixCopy methods");
-	atomic_store(&_routingTable.weightMatrix, matrix);
+	RNWeightMatrix *inactive = &_weightMatrix[WEIGHT_INACTIVE_INDEX];
+	NSAssert(matrix==&inactive->matrix,@"illegal input pointer--must a pointer returned by ond of the get___MatrixCopy methods");
+	RNWeightMatrixCompileVelocityTables(inactive);
+	atomic_store(&_routingTable.weightMatrix, inactive);
 	_weightMatrixIndex = 1 - _weightMatrixIndex;
 }
 
@@ -54,9 +85,9 @@
 
 // grab current matrix and copy into backing buffer
 - (NodeMatrix *)getCurrentWeightMatrixCopy {
-	NodeMatrix *active = atomic_load(&_routingTable.weightMatrix);
-	NodeMatrix *inactive = &_weightMatrix[WEIGHT_INACTIVE_INDEX];
-	memcpy(inactive, active, sizeof(NodeMatrix));
+	RNWeightMatrix *active = atomic_load(&_routingTable.weightMatrix);
+	NodeMatrix *inactive = &_weightMatrix[WEIGHT_INACTIVE_INDEX].matrix;
+	memcpy(inactive, &active->matrix, sizeof(NodeMatrix));
 	return inactive;
 }
 
@@ -69,7 +100,7 @@
 
 // zero out backing buffer
 - (NodeMatrix *)getEmptyWeightMatrix {
-	NodeMatrix *inactive = &_weightMatrix[WEIGHT_INACTIVE_INDEX];
+	NodeMatrix *inactive = &_weightMatrix[WEIGHT_INACTIVE_INDEX].matrix;
 	memset(inactive, 0, sizeof(NodeMatrix));
 	return inactive;
 }
@@ -80,6 +111,10 @@
 	return inactive;
 }
 
+- (NodeMatrix *)MIOCMatrix {
+	return &_MIOCMatrix;
+}
+
 // strikes me that it'd be very useful to have some convenience methods that modify Node Matrices
 //
 
@@ -21,7 +21,7 @@
 	NSMutableArray *_nodeList;            // will contain RNTapperNode s
 	NSMutableArray *_connectionList;      // will contain RNConnection s
 	NSMutableArray *_MIOCConnectionList;  // translation of RNConnections to MIOCConnections
-	RNMIDIRouting  *_MIDIRouting;         // real-time routing table; pushed to MIDIIO by RNController (programMIDIRoutingWithNetwork)
+	RNMIDIRouting  *_MIDIRouting;         // real-time routing table; pushed to MIDIIO as the network starts (RNExperiment part scheduler), or by RNController testPart
 	NSString       *_description;
 	BOOL            _isWeighted;
 	BOOL            _isDelay;
@@ -36,9 +36,13 @@
 - (RNNetwork *)initFromDictionary:(NSDictionary *)theDict;
 
 - (NSArray *)nodeList;
+- (NSArray *)connectionList;
 - (NSArray *)MIOCConnectionList;
 - (NSArray *)MIOCVelocityProcessorList;
+- (NSArray *)MIOCVelocityProcessorListWithInputStrength:(RNGlobalConnectionStrength *)inputStrength
+									  otherNodeStrength:(RNGlobalConnectionStrength *)otherStrength;
 - (RNMIDIRouting *)MIDIRouting;
+- (BOOL)isWeighted;
 //- (RNNodeNum_t)nodeIndexForChannel:(Byte)channel Note:(Byte)note;
 
 - (NSString *)description;
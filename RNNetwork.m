@@ -173,17 +173,13 @@
 	NSEnumerator	*theEnumerator = [_connectionList objectEnumerator];
 	RNConnection	*thisConn;
 	
-	NodeMatrix *weightMatrix = NULL;
-	NodeMatrix *delayMatrix  = NULL;
-	// for delay, we have to instantiate _MIDIRouting and then grab copies of the routing matrices
-	if (_isDelay) {
-		_MIDIRouting = [[RNMIDIRouting alloc] init];
-		weightMatrix = [_MIDIRouting getEmptyWeightMatrix];
-		delayMatrix  = [_MIDIRouting getEmptyDelayMatrix];
-	} else { // if not delay, remove routing
-		[_MIDIRouting release];
-		_MIDIRouting = nil;
-	}
+	// we always instantiate _MIDIRouting: for delay networks it carries the matrices MIDIIO emits from, and for
+	//	all networks it describes the tapper->tapper routes made inside the MIOC, so MIDIIO can log the feedback
+	//	they produce. Without delay the weight and delay matrices stay empty, so nothing is emitted.
+	_MIDIRouting = [[RNMIDIRouting alloc] init];
+	NodeMatrix *weightMatrix = [_MIDIRouting getEmptyWeightMatrix];
+	NodeMatrix *delayMatrix  = [_MIDIRouting getEmptyDelayMatrix];
+	NodeMatrix *MIOCMatrix   = [_MIDIRouting MIOCMatrix];
 
 	while (thisConn = [theEnumerator nextObject]) {
 
@@ -229,6 +225,7 @@
 				// connection from input to destination or otherNodePassthroughPort depending on if weighted
 				newMIOCConn = [MIOCConnection connectionWithInPort:sourcePort InChannel:sourceChan OutPort:destPort OutChannel:destChan];
 				[_MIOCConnectionList addObject:newMIOCConn];
+				(*MIOCMatrix)[[_nodeList[[thisConn fromNode]] sourceChan]-1][[_nodeList[[thisConn toNode]] destChan]-1] = [thisConn weight];
 				
 			} else { // Delay
 				// input to big brother is already set up in 1b) above
@@ -260,6 +257,8 @@
 					destChan = [_nodeList[[thisConn toNode]] destChan];
 					(*weightMatrix)[sourceChan-1][destChan-1] = weight;
 					(*delayMatrix)[sourceChan-1][destChan-1] = delay;
+				} else {
+					(*MIOCMatrix)[sourceChan-1][destChan-1] = weight;
 				}
 				
 				//TODO: After checking latencies could route all weight=1, delay=0 through MIOC instead of core MIDI. This would be used for 'self feedback'
@@ -270,10 +269,8 @@
 	// Oh, crap. We can't commit the routing matrices yet as we've only just created the network, not made it 'live'. No,
 	// wait, we own the RNMIDIRouting, so yes we absolutely can and then when we go live we just pass OUR routing
 	// table pointer to MIDIIO for use. Phew. This can be done on RNController's programMIOCWithNetwork!
-	if (_isDelay) {
-		[_MIDIRouting setWeightMatrix:weightMatrix];
-		[_MIDIRouting setDelayMatrix:delayMatrix];
-	}
+	[_MIDIRouting setWeightMatrix:weightMatrix];
+	[_MIDIRouting setDelayMatrix:delayMatrix];
 
 	return self;
 }
@@ -288,13 +285,31 @@
 	return [NSArray arrayWithArray:_nodeList];
 }
 
+- (NSArray *)connectionList
+{
+	return [NSArray arrayWithArray:_connectionList];
+}
+
 - (NSArray *)MIOCConnectionList
 {
 	return [NSArray arrayWithArray:_MIOCConnectionList];// return non-mutable form, necessary?
 }
 
+- (BOOL)isWeighted
+{
+	return _isWeighted;
+}
+
 // Dynamically harvest any processors from nodes
 - (NSArray *)MIOCVelocityProcessorList
+{
+	return [self MIOCVelocityProcessorListWithInputStrength:nil otherNodeStrength:nil];
+}
+
+// the processors as they would be after setGlobalConnectionStrength: with each strength given, without making it;
+// nil leaves the nodes' own processors
+- (NSArray *)MIOCVelocityProcessorListWithInputStrength:(RNGlobalConnectionStrength *)inputStrength
+									  otherNodeStrength:(RNGlobalConnectionStrength *)otherStrength
 {
 
 	RNNodeNum_t nNodes = [[self nodeList] count] - 1;	// number of tappers (exclude BB)
@@ -302,7 +317,8 @@
 	MIOCVelocityProcessor	*processor;
 
 	for (RNNodeNum_t iNode = 1; iNode <= nNodes; iNode++) {
-		processor = [_nodeList[iNode] sourceVelocityProcessor];
+		processor = (inputStrength != nil) ? [_nodeList[iNode] sourceVelocityProcessorFrom:[inputStrength processor]]
+											: [_nodeList[iNode] sourceVelocityProcessor];
 		if (processor != nil) {
 			[processorList addObject:processor];
 		}
@@ -312,7 +328,8 @@
 			[processorList addObject:processor];
 		}
 
-		processor = [_nodeList[iNode] otherNodeVelocityProcessor];
+		processor = (otherStrength != nil) ? [_nodeList[iNode] otherNodeVelocityProcessorFrom:[otherStrength processor]]
+											: [_nodeList[iNode] otherNodeVelocityProcessor];
 		if (processor != nil) {
 			[processorList addObject:processor];
 		}
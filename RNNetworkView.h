@@ -2,6 +2,12 @@
 
 #import <Cocoa/Cocoa.h>
 #import "MIDIListenerProtocols.h"
+#import "RNEventStore.h"
+#import "RNTimingStats.h"
+#import "RNSynchrony.h"
+#import "RNLeadLag.h"
+#import "RNHistogram.h"
+#import "RNTimeSeries.h"
 
 @class	RNNetwork;
 @class	RNNodeHistogramView;
@@ -16,6 +22,12 @@
 	BOOL            _doPlotData;           // whether midi input is added to data plots
 	NSMutableArray *_nodeHistogramViews;   // array of views
 	RNDataView     *_dataView;
+	RNEventStore   *_eventStore;           // recorded events, shared with histograms and data view (not owned)
+	RNTimingStats  *_timingStats;          // running tap statistics, read by histograms (not owned)
+	RNHistogram   **_asynchronyHistograms; // per node asynchrony counts, indexed by node number (not owned)
+	RNSynchrony    *_synchrony;            // network synchrony, shown in the corner (not owned)
+	RNLeadLag      *_leadLag;              // lead/lag of connected pairs, strongest leader shown in the corner (not owned)
+	RNTimeSeries   *_ITISeries;            // per node ITIs, plotted by the data view (not owned)
 }
 
 + (instancetype)sharedNetworkView;
@@ -36,6 +48,13 @@
 - (void)setPlotData:(BOOL)doIt;
 
 - (void)setDataView:(RNDataView *)dataView;
+- (void)setEventStore:(RNEventStore *)store;
+- (void)setTimingStats:(RNTimingStats *)stats;
+- (void)setAsynchronyHistograms:(RNHistogram **)histograms;
+- (void)setSynchrony:(RNSynchrony *)synchrony;
+- (void)setLeadLag:(RNLeadLag *)leadLag;
+- (void)setITISeries:(RNTimeSeries *)ITISeries;
+- (void)eventStoreDidChange;
 
 - (void)receiveMIDIData:(NSData *)MIDIData;
 
@@ -113,6 +113,8 @@ static RNNetworkView *_sharedNetworkView = nil;
 			
 			stim = [[self network] stimulusForChannel:subChannel];
 			histView = _nodeHistogramViews[(nodeNumber-1)]; //-1 bec bb node was not added in the array
+			[histView setNode:nodeNumber histogram:(_asynchronyHistograms != NULL) ? _asynchronyHistograms[nodeNumber] : NULL];
+			[histView setTimingStats:_timingStats];
 			[histView setTargetStimulus:stim];
 		}
 	}
@@ -211,6 +213,91 @@ static RNNetworkView *_sharedNetworkView = nil;
 - (void) setDataView: (RNDataView *) dataView
 {
 	_dataView = dataView;
+	[_dataView setTimeSeries:_ITISeries];
+}
+
+- (void) setEventStore: (RNEventStore *) store
+{
+	_eventStore = store;
+	[self synchronizeWithStimuli];
+}
+
+//the data view plots decimated ITIs rather than walking the store
+- (void) setITISeries: (RNTimeSeries *) ITISeries
+{
+	_ITISeries = ITISeries;
+	[_dataView setTimeSeries:ITISeries];
+}
+
+- (void) setTimingStats: (RNTimingStats *) stats
+{
+	_timingStats = stats;
+	[self synchronizeWithStimuli];
+}
+
+- (void) setAsynchronyHistograms: (RNHistogram **) histograms
+{
+	_asynchronyHistograms = histograms;
+	[self synchronizeWithStimuli];
+}
+
+- (void) setSynchrony: (RNSynchrony *) synchrony
+{
+	_synchrony = synchrony;
+	[self setNeedsDisplayInRect:[self synchronyTextRect]];
+}
+
+- (void) setLeadLag: (RNLeadLag *) leadLag
+{
+	_leadLag = leadLag;
+	[self setNeedsDisplayInRect:[self synchronyTextRect]];
+}
+
+//node leading its partners most (largest sum of positive lead/lag indices), 0 if none yet
+- (RNNodeNum_t) strongestLeader
+{
+	unsigned nNodes = RNLeadLagNodeCount(_leadLag);
+	float matrix[kRNLeadLagMaxNodes * kRNLeadLagMaxNodes];
+	RNLeadLagGetMatrix(_leadLag, matrix, NULL);
+	
+	RNNodeNum_t leader = 0;
+	float maxLead = 0.0;
+	for (unsigned iRow = 1; iRow < nNodes; iRow++) {
+		float lead = 0.0;
+		for (unsigned iCol = 1; iCol < nNodes; iCol++) {
+			float value = matrix[iRow * nNodes + iCol];
+			if (value > 0.0) //skips NAN
+				lead += value;
+		}
+		if (lead > maxLead) {
+			maxLead = lead;
+			leader = iRow;
+		}
+	}
+	return leader;
+}
+
+//top left corner, where the current synchrony is written
+- (NSRect) synchronyTextRect
+{
+	NSRect bounds = [self bounds];
+	return NSMakeRect(NSMinX(bounds) + 4.0, NSMaxY(bounds) - 18.0, 280.0, 14.0);
+}
+
+//the experiment has flushed new events into the store: update histogram and ITI plot in one go
+- (void) eventStoreDidChange
+{
+	if (_doPlotData == NO)
+		return;
+	
+	NSEnumerator *histEnumerator = [_nodeHistogramViews objectEnumerator];
+	RNNodeHistogramView *histView;
+	while (histView = [histEnumerator nextObject]) {
+		[histView updateFromHistogram];
+	}
+	[_dataView eventStoreDidChange];
+	if (_synchrony != NULL || _leadLag != NULL)
+		[self setNeedsDisplayInRect:[self synchronyTextRect]];
 }
 
 
@@ -228,6 +315,26 @@ static RNNetworkView *_sharedNetworkView = nil;
 	if (_network != nil) {
 		[_network drawWithRadius: _drawRadius];
 	}	
+	
+	//network synchrony: order parameter at the latest tap, and mean pairwise phase locking
+	//	and the strongest leader among connected pairs
+	if (_synchrony != NULL) {
+		RNSynchronySnapshot snapshot;
+		RNSynchronyGetSnapshot(_synchrony, &snapshot);
+		NSString *syncStr;
+		if (snapshot.nSamples > 0)
+			syncStr = [NSString stringWithFormat:@"R %.2f (%.2f)  PLV %.2f  n=%u", snapshot.R, snapshot.windowR, snapshot.meanPLV, snapshot.nActive];
+		else
+			syncStr = @"R ---";
+		RNNodeNum_t leader = (_leadLag != NULL) ? [self strongestLeader] : 0;
+		if (leader != 0)
+			syncStr = [syncStr stringByAppendingFormat:@"  leader %d", leader];
+		NSDictionary *attributes = @{
+			NSForegroundColorAttributeName: [NSColor blackColor],
+			NSFontAttributeName:[NSFont fontWithName:@"Helvetica" size:10]
+		};
+		[syncStr drawAtPoint:[self synchronyTextRect].origin withAttributes:attributes];
+	}
 }
 
 // TEST CODE
@@ -280,19 +387,7 @@ static RNNetworkView *_sharedNetworkView = nil;
                 dispatch_async(dispatch_get_main_queue(), ^{
                     [nodeList[iNode] flashWithColor:[NSColor systemBlueColor]];
                 });
-				
-                //send event to appropriate histogramView
-				//FIXME: problem with dataView add event...
-				if (NO && _doPlotData == YES) {
-					if (_nodeHistogramViews != nil) {
-						RNNodeHistogramView *hview = _nodeHistogramViews[(iNode-1)]; //**note indexing
-						[hview addEventAtTime:message->eventTime_ns];
-						//mine histogram view data to add to ITI plot
-						if (_dataView != nil) {
-                            [_dataView addEventAtTime: [hview lastEventTime] withITI: [hview lastITI] forNode:iNode];
-						}
-					}
-				}
+				//histogram and ITI plot are updated when the experiment flushes its recording (eventStoreDidChange)
 			}
 		} else { 	//if it's unexpected, display the offending channel, note info		
 					//NSAssert( (iNode != 0xFFFF), @"Received MIDI channel,note that doesn't correspond to a node!");
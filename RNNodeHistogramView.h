@@ -7,42 +7,50 @@
 //
 
 #import <Cocoa/Cocoa.h>
+#import "RNArchitectureDefines.h"
+#import "RNTimingStats.h"
+#import "RNHistogram.h"
 
 #define kInitialYMax	5
-#define kMaxNumBins		1000
-#define kMaxNumEvents	10000
 
 @class RNStimulus;
 
+// Draws one node's asynchrony histogram. The counts live in an RNHistogram filled by the
+//	recording path; the view only takes snapshots of it when asked to update, at display rate.
 @interface RNNodeHistogramView : NSView
 {
-	RNStimulus		*_targetStimulus;		// stimulus this node should be tracking
-	double			_targetIOI_ms;			// desired IOI--determines timebase of histogram
-	UInt64			_stimStartTime_ns;		// convenience--absolute start time of stimulus (re experiment start)
-	double			_sweepTime_ms;			// varies from - to + IOI/2
-	double			_binWidth_ms;			// histogram bin
-	double			_yMax;					// histogram max
+	RNStimulus			*_targetStimulus;		// stimulus this node should be tracking
+	double				_targetIOI_ms;			// desired IOI--determines timebase of histogram
+	UInt64				_stimStartTime_ns;		// convenience--absolute start time of stimulus (re experiment start)
+	double				_sweepTime_ms;			// varies from - to + IOI/2
+	double				_yMax;					// histogram max
 	BOOL				_isNormalized;			// raw counts, or normalized to max=1
-	int				_counts[kMaxNumBins];		// array of counts for each bin
-	UInt64			_eventTimes[kMaxNumEvents];	// raw event times (used to re-format histogram w/ new IOI or bin)
-	unsigned int		_numEvents;				// number of events stored in _eventTimes
-	double			_ITI_ms;				// instantaneous ITI
-	double			_smoothITI_ms;			// smoothed measure of ITI
-	NSInteger		_updatedBinIndex;		// for optimzed drawing of single updated bin; -1 -> draw all
+	RNNodeNum_t			_node;					// node whose taps we show
+	RNHistogram			*_histogram;			// the node's asynchrony counts (not owned)
+	RNHistogramSnapshot	*_shown;				// what is on screen
+	RNHistogramSnapshot	*_frozen;				// last stimulus's histogram, drawn as an outline
+	BOOL				_hasFrozen;
+	RNTimingStats		*_timingStats;			// running statistics of all nodes (not owned); ITIs are read from here
+	NSRect				_dirtyRect;				// bars changed since last draw (NSZeroRect: none, or a full redraw)
 }
 
-- (void)setTargetStimulus:(RNStimulus *)stim;	// initializes histogram
+- (void)setTargetStimulus:(RNStimulus *)stim;	// freezes what was shown for the previous stimulus
 
 - (NSRect)barRectForIndex:(NSUInteger)iBin;
 
-- (void)addEventAtTime:(UInt64)eventTime_ns;	// update with a new event
+- (void)setNode:(RNNodeNum_t)node histogram:(RNHistogram *)histogram;
+- (void)setTimingStats:(RNTimingStats *)stats;
+- (void)updateFromHistogram;	// snapshot the histogram and redraw the bars that changed
 
 - (void)clearData;
 
-- (int *)counts;
+- (const RNHistogramSnapshot *)shownHistogram;
+- (BOOL)getFrozenComparison:(RNHistogramComparison *)comparison;	// frozen vs shown
 
 - (double)lastEventTime;
 - (double)lastITI;
 - (double)smoothedITI;
+- (BOOL)getTimingSnapshot:(RNTimingSnapshot *)snapshot;
+- (uint64_t)numOutOfRange;
 
 @end
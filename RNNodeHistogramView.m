@@ -13,8 +13,6 @@
 
 #define kFontSize 9
 
-static const NSInteger kNoSingleBinUpdatePending = -1;
-
 @implementation RNNodeHistogramView
 
 - (id)initWithFrame:(NSRect)frameRect
@@ -25,7 +23,10 @@ static const NSInteger kNoSingleBinUpdatePending = -1;
 		// set origin half way along x axis, keep same dimensions (in owning view's coordinates (pixels))
 		bounds = NSMakeRect(-(frameRect.size.width / 2.0), 0.0, frameRect.size.width, frameRect.size.height);
 		[self setBounds:bounds];
-		_updatedBinIndex = -1; //default to full draw
+		_shown	= calloc(1, sizeof(RNHistogramSnapshot));
+		_frozen	= calloc(1, sizeof(RNHistogramSnapshot));
+		NSAssert((_shown != NULL && _frozen != NULL), @"Could not allocate histogram snapshots");
+		_yMax	= kInitialYMax;
 	}
 
 	return self;
@@ -33,6 +34,8 @@ static const NSInteger kNoSingleBinUpdatePending = -1;
 
 - (void)dealloc
 {
+	free(_shown);
+	free(_frozen);
 	[super dealloc];
 }
 
@@ -41,132 +44,139 @@ static const NSInteger kNoSingleBinUpdatePending = -1;
 	return YES;
 }
 
-// this does actual initialization of ivars, bounds rectangle and allocate counts
+// new stimulus: keep what we had as an outline to compare against, start over on the new timebase
+//	(the recording path rebins the histogram itself when the node's pacer changes)
 - (void)setTargetStimulus:(RNStimulus *)stim
 {
-	NSRect	frame;
-	int		nBins, i;
-
 	// NSAssert( (stim != nil), @"nil stimulus");
 
 	if ((_targetStimulus != stim) && (stim != nil)) {
+		if (_targetStimulus != nil && _shown->total > 0) {
+			memcpy(_frozen, _shown, sizeof(RNHistogramSnapshot));
+			_hasFrozen = YES;
+		}
 		_targetStimulus = stim;
 		_targetIOI_ms	= [stim IOI_ms];
 		_yMax			= kInitialYMax;
 		_isNormalized	= NO;
-		_ITI_ms			= 0;// invalid value
-
-		frame = [self frame];
-		// calculate binWidth based on actual width in pixels, **add some minimum width checking?
-		_binWidth_ms	= _targetIOI_ms / frame.size.width;
-		nBins			= _targetIOI_ms / _binWidth_ms;
-
-		// zero out counts (could contain data from last stimulus)
-		// **later--make some way to preserve the counts, e.g. a line on the plot
-		// ** also--posibility to reinterpret (or not) past events in terms of new stimulus periodicity
-		for (i = 0; i < nBins; i++) {
-			_counts[i] = 0;
-		}
-
-		_numEvents = 0;	// necessary when re-setting stimulus
+		memset(_shown, 0, sizeof(RNHistogramSnapshot));
+		[self setNeedsDisplay:YES];
 	}
 }
 
+- (void)setNode:(RNNodeNum_t)node histogram:(RNHistogram *)histogram
+{
+	_node		= node;
+	_histogram	= histogram;
+	memset(_shown, 0, sizeof(RNHistogramSnapshot));
+	[self setNeedsDisplay:YES];
+}
+
+- (void)setTimingStats:(RNTimingStats *)stats
+{
+	_timingStats = stats;
+}
+
 - (void)clearData
 {
-	int nBins, i;
+	memset(_shown, 0, sizeof(RNHistogramSnapshot));
+	_hasFrozen	= NO;
+	_yMax		= kInitialYMax;
+	[self setNeedsDisplay:YES];
+}
 
-	nBins = _targetIOI_ms / _binWidth_ms;
+- (const RNHistogramSnapshot *)shownHistogram
+{
+	return _shown;
+}
 
-	// zero out counts (could contain data from last stimulus)
-	for (i = 0; i < nBins; i++) {
-		_counts[i] = 0;
+- (BOOL)getFrozenComparison:(RNHistogramComparison *)comparison
+{
+	if (!_hasFrozen) {
+		return NO;
 	}
-
-	_numEvents		= 0;// necessary when re-setting stimulus
-	_ITI_ms			= 0;
-	_smoothITI_ms	= 0;
+	*comparison = RNHistogramSnapshotCompare(_frozen, _shown);
+	return YES;
 }
 
-- (int *)counts
+- (BOOL)getTimingSnapshot:(RNTimingSnapshot *)snapshot
 {
-	return _counts;
+	return (_timingStats != NULL) && RNTimingStatsGetSnapshot(_timingStats, _node, snapshot);
 }
 
 - (double)lastEventTime
 {
-	if (_targetStimulus != nil) {
-		double expStart_ms = [_targetStimulus experimentStartTime] / 1e6;
-		return (_eventTimes[_numEvents] / 1e6) - expStart_ms;
-	} else {
-		return 0;
-	}
+	// relative to experiment start
+	RNTimingSnapshot snapshot;
+	return [self getTimingSnapshot:&snapshot] ? snapshot.lastTapTime_ms : 0;
 }
 
 - (double)lastITI
 {
-	return _ITI_ms;
+	RNTimingSnapshot snapshot;
+	return [self getTimingSnapshot:&snapshot] ? snapshot.lastITI_ms : 0;
 }
 
 - (double)smoothedITI
 {
-	return _smoothITI_ms;
+	RNTimingSnapshot snapshot;
+	return [self getTimingSnapshot:&snapshot] ? snapshot.smoothITI_ms : 0;
+}
+
+- (uint64_t)numOutOfRange
+{
+	return _shown->outOfRange;
 }
 
 - (NSRect)barRectForIndex:(NSUInteger)iBin {
-	CGFloat yCount = (_counts[iBin] / _yMax) * self.bounds.size.height * 0.8;
-	CGFloat x = iBin - (self.bounds.size.width / 2.0);
-	return NSMakeRect(x, 0.0, 1.0, yCount);
+	return [self barRectForIndex:iBin count:_shown->counts[iBin] ofSnapshot:_shown];
 }
 
-- (void)addEventAtTime:(UInt64)eventTime_ns
-{
-	// figure out which bin this event belongs into
-	int		iBin, nBins;
-	double	asynchrony_ms;
+- (NSRect)barRectForIndex:(NSUInteger)iBin count:(uint32_t)count ofSnapshot:(const RNHistogramSnapshot *)snapshot {
+	NSRect bounds = self.bounds;
+	CGFloat binWidth = bounds.size.width / snapshot->binning.nBins;
+	CGFloat yCount = (count / _yMax) * bounds.size.height * 0.8;
+	CGFloat x = (iBin * binWidth) - (bounds.size.width / 2.0);
+	return NSMakeRect(x, 0.0, binWidth, yCount);
+}
 
-	NSAssert((_numEvents < kMaxNumEvents - 1), @"Event storage overflow");
-	_eventTimes[++_numEvents] = eventTime_ns;
+// called at display rate: cheap if nothing was added since the last call
+- (void)updateFromHistogram
+{
+	if (_histogram == NULL || _targetStimulus == nil) {
+		return;
+	}
+	if (RNHistogramEpoch(_histogram) == _shown->epoch) {
+		return;
+	}
 
-	// calculate estimate of ITI, smoothed after last few points
-	if (_numEvents > 1) {										// need more than 1 event (count from 1)
-		_ITI_ms			= (_eventTimes[_numEvents] - _eventTimes[_numEvents - 1]) / 1e6;
-		_smoothITI_ms	= (3.0 * _smoothITI_ms + _ITI_ms) / 4.0;// weight history more than new to smooth
+	RNHistogramSnapshot *latest = malloc(sizeof(RNHistogramSnapshot));
+	if (latest == NULL) {
+		return;
 	}
+	RNHistogramGetSnapshot(_histogram, latest);
 
-	// NSAssert(( _targetStimulus != nil ), @"cannot add event: targetStimulus = nil");
-	if (_targetStimulus != nil) {
-		asynchrony_ms	= [_targetStimulus asynchronyForNanoseconds:eventTime_ns];
-		iBin			= (int)floor((asynchrony_ms + (_targetIOI_ms / 2.0)) / _binWidth_ms);
-		nBins			= _targetIOI_ms / _binWidth_ms;
-		NSAssert3((iBin >= 0 && iBin < nBins), @"iBin out of range (%d > %d), async %.1f", iBin, nBins, asynchrony_ms);
-		_counts[iBin] += 1;
+	uint16_t changed[kRNHistogramMaxBins];
+	uint32_t nChanged = RNHistogramSnapshotDiff(_shown, latest, changed, kRNHistogramMaxBins);
+	memcpy(_shown, latest, sizeof(RNHistogramSnapshot));
+	free(latest);
 
-		// have we grown past yMax? Yes, rescale and request redraw of entire histogram
-		if (_counts[iBin] > _yMax) {
+	// have we grown past yMax (or been cleared/rebinned)? Yes, rescale and request redraw of entire histogram
+	if (nChanged == UINT32_MAX || _shown->maxCount > _yMax || _shown->total == 0) {
+		while (_shown->maxCount > _yMax) {
 			_yMax += 5;
-			[self setNeedsDisplay:YES];
-			return;
 		}
+		[self setNeedsDisplay:YES];
+		return;
+	}
 
-		// no rescale, so just update the single bin
-		// If a previous bin update hasn't been flushed to the screen yet,
-		// we fall back to a full redraw to ensure all changes are visible.
-		if (_updatedBinIndex == kNoSingleBinUpdatePending) {
-			_updatedBinIndex = iBin;
-			[self setNeedsDisplayInRect:[self barRectForIndex:iBin]];
-		} else { //another single bin had been requested, so just redraw it all
-			NSLog(@"!!! RNHistogramView: ⚠️ Multiple bins queued before redraw — falling back to full redraw.Oh, ");
-			_updatedBinIndex = kNoSingleBinUpdatePending; //aka draw them all
-			[self setNeedsDisplay:YES];
-		}
-		
-		//TODO: if the log above shows up a lot, keep track of multiple bin update, but I doubt this'll be the case
-		//NSMutableIndexSet *_binsToRedraw;
-		//[binsToRedraw addIndex:iBin];
-		//[self setNeedsDisplayInRect:[self barRectForIndex:iBin]];
-		// in drawRect,  iterate over [binsToRedraw enumerateIndexesUsingBlock:].
-		
+	// no rescale, so just redraw the bars that changed (counts only grow between clears)
+	NSRect dirty = NSZeroRect;
+	for (uint32_t i = 0; i < nChanged; i++) {
+		dirty = NSUnionRect(dirty, [self barRectForIndex:changed[i]]);
+	}
+	if (!NSIsEmptyRect(dirty)) {
+		[self setNeedsDisplayInRect:dirty];
 	}
 }
 
@@ -183,96 +193,85 @@ static const NSInteger kNoSingleBinUpdatePending = -1;
 	NSRect			barRect, bounds;
 	NSUInteger		iBin, nBins;
 
-	// aPath = [NSBezierPath bezierPathWithRect:[self bounds]];
-	// [aPath setLineWidth:1.0];
-	// [aPath stroke];
-
-	if (_targetStimulus != nil) {
-		
-		// New: a shortcircuited single-bin draw
-		if (_updatedBinIndex != kNoSingleBinUpdatePending) {
-			iBin = _updatedBinIndex;
-			_updatedBinIndex = kNoSingleBinUpdatePending;
-			if (_counts[iBin] > 0) {
-				barRect = [self barRectForIndex:iBin];
-				[[NSColor blueColor] setFill];
-				aPath	= [NSBezierPath bezierPathWithRect:barRect];
-				[aPath fill];
+	if (_targetStimulus == nil) {
+		return;
+	}
+
+	// clear what we are asked to draw; everything below is clipped to it, and bars outside it are skipped
+	bounds	= [self bounds];
+	aPath	= [NSBezierPath bezierPathWithRect:rect];
+	[[NSColor windowBackgroundColor] setFill];
+	[aPath fill];
+	aPath	= [NSBezierPath bezierPath];
+
+	// draw histogram
+	[[NSColor blueColor] setFill];
+	nBins = _shown->binning.nBins;
+	for (iBin = 0; iBin < nBins; iBin++) {
+		if (_shown->counts[iBin] > 0) {
+			barRect = [self barRectForIndex:iBin];
+			if ([self needsToDrawRect:barRect]) {
+				NSRectFill(barRect);
 			}
-			return;
 		}
-		
-		// FULL REDRAW
-		// clear
-		bounds	= [self bounds];
-		aPath	= [NSBezierPath bezierPathWithRect:bounds];
-		[[NSColor windowBackgroundColor] setFill];
-		[[NSColor windowBackgroundColor] setStroke];
-		[aPath fill];
-		[aPath removeAllPoints];
-
-		// draw IOI target
-		[aPath moveToPoint:NSMakePoint(0.0, 0.0)];
-		[aPath lineToPoint:NSMakePoint(0.0, bounds.size.height * 0.8)];
-		[[NSColor redColor] setStroke];
-		[aPath stroke];
-		[aPath removeAllPoints];
+	}
 
-		// baseline
+	// previous stimulus, as an outline
+	if (_hasFrozen && _frozen->binning.nBins > 0 && _frozen->maxCount > 0) {
 		[aPath moveToPoint:NSMakePoint(-(bounds.size.width / 2.0), 0.0)];
+		for (iBin = 0; iBin < _frozen->binning.nBins; iBin++) {
+			// scaled to its own peak, so the shapes compare whatever the counts
+			uint32_t count = (uint32_t)ceil(_yMax * _frozen->counts[iBin] / _frozen->maxCount);
+			barRect = [self barRectForIndex:iBin count:count ofSnapshot:_frozen];
+			[aPath lineToPoint:NSMakePoint(NSMinX(barRect), NSMaxY(barRect))];
+			[aPath lineToPoint:NSMakePoint(NSMaxX(barRect), NSMaxY(barRect))];
+		}
 		[aPath lineToPoint:NSMakePoint((bounds.size.width / 2.0), 0.0)];
-		[aPath setLineWidth:1.0];
+		[aPath setLineWidth:0.5];
+		[[NSColor grayColor] setStroke];
 		[aPath stroke];
 		[aPath removeAllPoints];
+	}
 
-		// CGContextFlush([[NSGraphicsContext currentContext] graphicsPort]);
-
-		// target IOI text--start stimple w/ NSString additions draw methods
-		NSString *IOIStr;
-
-		if (_targetIOI_ms != 0) {
-			IOIStr = [NSString stringWithFormat:@"%.0f", _targetIOI_ms];
-		} else {
-			IOIStr = [NSString stringWithFormat:@"---"];
-		}
-
-		NSDictionary *attributes = @{
-			NSForegroundColorAttributeName: [NSColor redColor],
-			NSFontAttributeName:[NSFont fontWithName:@"Helvetica" size:kFontSize]
-		};
-		[IOIStr drawAtPoint:NSMakePoint(-(bounds.size.width / 2.0), (bounds.size.height * 0.7)) withAttributes:attributes];
+	// draw IOI target
+	[aPath moveToPoint:NSMakePoint(0.0, 0.0)];
+	[aPath lineToPoint:NSMakePoint(0.0, bounds.size.height * 0.8)];
+	[aPath setLineWidth:1.0];
+	[[NSColor redColor] setStroke];
+	[aPath stroke];
+	[aPath removeAllPoints];
+
+	// baseline
+	[aPath moveToPoint:NSMakePoint(-(bounds.size.width / 2.0), 0.0)];
+	[aPath lineToPoint:NSMakePoint((bounds.size.width / 2.0), 0.0)];
+	[aPath stroke];
+	[aPath removeAllPoints];
+
+	// target IOI text--start stimple w/ NSString additions draw methods
+	NSString *IOIStr;
+
+	if (_targetIOI_ms != 0) {
+		IOIStr = [NSString stringWithFormat:@"%.0f", _targetIOI_ms];
+	} else {
+		IOIStr = [NSString stringWithFormat:@"---"];
+	}
 
-		// smoothed ITI text
-		NSString *ITIStr;
+	NSDictionary *attributes = @{
+		NSForegroundColorAttributeName: [NSColor redColor],
+		NSFontAttributeName:[NSFont fontWithName:@"Helvetica" size:kFontSize]
+	};
+	[IOIStr drawAtPoint:NSMakePoint(-(bounds.size.width / 2.0), (bounds.size.height * 0.7)) withAttributes:attributes];
 
-		if (_ITI_ms != 0) {
-			ITIStr = [NSString stringWithFormat:@"%.0f", _ITI_ms];
-		} else {
-			ITIStr = [NSString stringWithFormat:@"---"];
-		}
+	// last ITI text
+	NSString *ITIStr;
+	double ITI_ms = [self lastITI];
 
-		attributes = @{
-			NSForegroundColorAttributeName: [NSColor redColor],
-			NSFontAttributeName:[NSFont fontWithName:@"Helvetica" size:kFontSize]
-		};
-		[ITIStr drawAtPoint:NSMakePoint((0.15 * bounds.size.width / 2.0), (bounds.size.height * 0.7)) withAttributes:attributes];
-
-		// draw histogram
-		[[NSColor blueColor] setFill];
-		// nBins = _targetIOI_ms / _binWidth_ms;
-		nBins = bounds.size.width;
-		float yCount;
-
-		for (iBin = 0; iBin < nBins; iBin++) {
-			if (_counts[iBin] > 0) {
-				// barRect = NSMakeRect( (iBin * _binWidth_ms) - (_targetIOI_ms/2.0), 0, _binWidth_ms, _counts[iBin]);
-				yCount	= (_counts[iBin] / _yMax) * bounds.size.height * 0.8;
-				barRect = NSMakeRect(iBin - (bounds.size.width / 2.0), 0.0, 1.0, yCount);
-				aPath	= [NSBezierPath bezierPathWithRect:barRect];
-				[aPath fill];
-			}
-		}
+	if (ITI_ms != 0) {
+		ITIStr = [NSString stringWithFormat:@"%.0f", ITI_ms];
+	} else {
+		ITIStr = [NSString stringWithFormat:@"---"];
 	}
+	[ITIStr drawAtPoint:NSMakePoint((0.15 * bounds.size.width / 2.0), (bounds.size.height * 0.7)) withAttributes:attributes];
 }
 
 @end
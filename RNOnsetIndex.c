@@ -0,0 +1,119 @@
+//
+//  RNOnsetIndex.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNOnsetIndex.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kHintSteps	4	// forward steps tried from the hint before falling back to a binary search
+
+struct RNOnsetIndex {
+	_Atomic(uint32_t)	references;
+	uint32_t			nOnsets;
+	int64_t				onsets_ns[];
+};
+
+static int compareOnsets(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *) a, y = *(const int64_t *) b;
+	return (x > y) - (x < y);
+}
+
+RNOnsetIndex *RNOnsetIndexCreate(const int64_t *onsets_ns, uint32_t nOnsets)
+{
+	if (onsets_ns == NULL || nOnsets == 0) return NULL;
+	RNOnsetIndex *index = malloc(sizeof(RNOnsetIndex) + nOnsets * sizeof(int64_t));
+	if (index == NULL) return NULL;
+	atomic_init(&index->references, 1);
+	index->nOnsets = nOnsets;
+	memcpy(index->onsets_ns, onsets_ns, nOnsets * sizeof(int64_t));
+
+	// generated onsets are already in order; sort only if not (jitter larger than the IOI)
+	for (uint32_t i = 1; i < nOnsets; i++) {
+		if (index->onsets_ns[i] < index->onsets_ns[i - 1]) {
+			qsort(index->onsets_ns, nOnsets, sizeof(int64_t), compareOnsets);
+			break;
+		}
+	}
+	return index;
+}
+
+RNOnsetIndex *RNOnsetIndexRetain(RNOnsetIndex *index)
+{
+	if (index) atomic_fetch_add_explicit(&index->references, 1, memory_order_relaxed);
+	return index;
+}
+
+void RNOnsetIndexRelease(RNOnsetIndex *index)
+{
+	if (index && atomic_fetch_sub_explicit(&index->references, 1, memory_order_acq_rel) == 1)
+		free(index);
+}
+
+uint32_t RNOnsetIndexCount(const RNOnsetIndex *index)
+{
+	return index ? index->nOnsets : 0;
+}
+
+const int64_t *RNOnsetIndexOnsets(const RNOnsetIndex *index)
+{
+	return index ? index->onsets_ns : NULL;
+}
+
+// first onset > time_ns
+static uint32_t upperBound(const RNOnsetIndex *index, int64_t time_ns, uint32_t *hint)
+{
+	const int64_t *onsets = index->onsets_ns;
+	uint32_t n = index->nOnsets;
+
+	if (hint && *hint <= n && (*hint == 0 || onsets[*hint - 1] <= time_ns)) {
+		uint32_t i = *hint;
+		for (unsigned step = 0; step < kHintSteps && i < n; step++, i++)
+			if (onsets[i] > time_ns) return *hint = i;
+		if (i == n) return *hint = n;
+	}
+
+	uint32_t first = 0, count = n;
+	while (count > 0) {
+		uint32_t half = count / 2;
+		if (onsets[first + half] <= time_ns) {
+			first += half + 1;
+			count -= half + 1;
+		} else {
+			count = half;
+		}
+	}
+	if (hint) *hint = first;
+	return first;
+}
+
+RNOnsetMatch RNOnsetIndexNearest(const RNOnsetIndex *index, int64_t time_ns, uint32_t *hint)
+{
+	RNOnsetMatch match = { -1, 0, 0, 0 };
+	if (index == NULL || index->nOnsets == 0) return match;
+
+	const int64_t *onsets = index->onsets_ns;
+	uint32_t n = index->nOnsets;
+	uint32_t next = upperBound(index, time_ns, hint);	// onsets[next - 1] <= time_ns < onsets[next]
+
+	uint32_t nearest;
+	if (next == 0) nearest = 0;
+	else if (next == n) nearest = n - 1;
+	else nearest = (onsets[next] - time_ns <= time_ns - onsets[next - 1]) ? next : next - 1;
+
+	match.index			= nearest;
+	match.onset_ns		= onsets[nearest];
+	match.asynchrony_ns	= time_ns - onsets[nearest];
+	if (n > 1) {
+		if (match.asynchrony_ns >= 0)
+			match.interval_ns = (nearest + 1 < n) ? onsets[nearest + 1] - onsets[nearest] : onsets[nearest] - onsets[nearest - 1];
+		else
+			match.interval_ns = (nearest > 0) ? onsets[nearest] - onsets[nearest - 1] : onsets[1] - onsets[0];
+	}
+	return match;
+}
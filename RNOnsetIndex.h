@@ -0,0 +1,49 @@
+//
+//  RNOnsetIndex.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// A stimulus' scheduled onsets (ns, relative to experiment start) in a sorted array, so taps can be
+//	timed against the onsets actually generated (jitter included) rather than a nominal period.
+//	- nearest-onset lookup is a binary search, or amortized O(1) with a caller-kept hint when
+//	  times arrive in order (a node's taps)
+//	- immutable once created and reference counted, so a pacer holding one can be copied to
+//	  another thread; the last release frees it
+
+#ifndef RNOnsetIndex_h
+#define RNOnsetIndex_h
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	int64_t		index;			// of the nearest onset; -1 if there are none
+	int64_t		onset_ns;
+	int64_t		asynchrony_ns;	// time - onset
+	int64_t		interval_ns;	// local IOI around the time: to the next onset if after, the previous if before
+} RNOnsetMatch;
+
+typedef struct RNOnsetIndex RNOnsetIndex;
+
+// Copies (and sorts) the onsets. Returns NULL for none. The caller holds one reference.
+RNOnsetIndex	*RNOnsetIndexCreate(const int64_t *onsets_ns, uint32_t nOnsets);
+RNOnsetIndex	*RNOnsetIndexRetain(RNOnsetIndex *index);	// NULL safe, returns index
+void			RNOnsetIndexRelease(RNOnsetIndex *index);	// NULL safe
+
+uint32_t		RNOnsetIndexCount(const RNOnsetIndex *index);
+const int64_t	*RNOnsetIndexOnsets(const RNOnsetIndex *index);
+
+// Nearest onset to time_ns (ties go to the later one). hint, if not NULL, is the caller's cursor:
+//	start it at 0 and pass it back with each call.
+RNOnsetMatch	RNOnsetIndexNearest(const RNOnsetIndex *index, int64_t time_ns, uint32_t *hint);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNOnsetIndex_h */
@@ -0,0 +1,496 @@
+//
+//  RNPacketCapture.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNPacketCapture.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+
+#define kRingMask			(kRNPacketCaptureRingLength - 1)
+#define kWriterPoll_ns		10000000	// writer thread wake
+#define kReplayRetry_ns		100000		// consumer full: try again
+#define kPacketHeaderLength	10			// MIDIPacket: UInt64 timeStamp, UInt16 length, then data
+
+static inline uint32_t padded(uint32_t length)	{ return (length + 7u) & ~7u; }
+
+typedef struct {
+	uint8_t				bytes[kRNPacketCaptureRingLength];
+	_Atomic(uint32_t)	head;		// next byte to write; producer only (free running, wraps)
+	_Atomic(uint32_t)	tail;		// next byte to write out; writer thread only
+	_Atomic(uint64_t)	records;
+	_Atomic(uint64_t)	dropped;
+} RNCaptureRing;
+
+struct RNPacketCapture {
+	FILE				*file;
+	pthread_t			thread;
+	_Atomic(bool)		running;
+	_Atomic(uint64_t)	bytes;
+	RNCaptureRing		rings[kRNPacketCaptureNumProducers];
+};
+
+struct RNPacketCaptureReader {
+	const uint8_t		*map;
+	size_t				length;
+};
+
+uint64_t RNPacketCaptureHostTime(void)
+{
+#ifdef __APPLE__
+	return mach_absolute_time();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+#endif
+}
+
+void RNPacketCaptureHostTimebase(uint32_t *numer, uint32_t *denom)
+{
+#ifdef __APPLE__
+	mach_timebase_info_data_t timebase;
+	mach_timebase_info(&timebase);
+	*numer = timebase.numer;
+	*denom = timebase.denom;
+#else
+	*numer = 1;
+	*denom = 1;
+#endif
+}
+
+static void sleepNanos(int64_t ns)
+{
+	if (ns <= 0) return;
+	struct timespec interval = { (time_t)(ns / 1000000000), (long)(ns % 1000000000) };
+	nanosleep(&interval, NULL);
+}
+
+static inline uint16_t readU16(const uint8_t *p)	{ uint16_t v; memcpy(&v, p, sizeof v); return v; }
+static inline uint32_t readU32(const uint8_t *p)	{ uint32_t v; memcpy(&v, p, sizeof v); return v; }
+static inline uint64_t readU64(const uint8_t *p)	{ uint64_t v; memcpy(&v, p, sizeof v); return v; }
+
+uint32_t RNPacketListLength(const void *list, uint32_t capacity, uint32_t packetAlignment)
+{
+	const uint8_t *bytes = list;
+	if (capacity < 4) return 0;
+	uint32_t nPackets = readU32(bytes);
+	uint32_t offset = 4;
+	uint32_t mask = (packetAlignment > 1) ? packetAlignment - 1 : 0;
+	for (uint32_t i = 0; i < nPackets; i++) {
+		if (i > 0) offset = (offset + mask) & ~mask;	// MIDIPacketNext: lists start aligned, so offsets are too
+		if (offset + kPacketHeaderLength > capacity) return 0;
+		offset += kPacketHeaderLength + readU16(bytes + offset + 8);
+		if (offset > capacity) return 0;
+	}
+	return offset;
+}
+
+// *********************************************
+//    Capturing
+// *********************************************
+
+static void ringWrite(RNCaptureRing *ring, uint32_t at, const void *data, uint32_t length)
+{
+	uint32_t start = at & kRingMask;
+	uint32_t first = (length < kRNPacketCaptureRingLength - start) ? length : kRNPacketCaptureRingLength - start;
+	memcpy(ring->bytes + start, data, first);
+	memcpy(ring->bytes, (const uint8_t *) data + first, length - first);
+}
+
+bool RNPacketCaptureAppend(RNPacketCapture *capture, RNPacketCaptureProducer producer, RNPacketCaptureKind kind,
+						   uint64_t hostTime, uint32_t sequence, const void *packetList, uint32_t length)
+{
+	RNCaptureRing *ring = &capture->rings[producer];
+	uint32_t total = (uint32_t) sizeof(RNPacketCaptureRecord) + padded(length);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	if (length > kRNPacketCaptureMaxList || total > kRNPacketCaptureRingLength - (head - tail)) {
+		atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+		return false;
+	}
+
+	RNPacketCaptureRecord record = { .hostTime = hostTime, .sequence = sequence, .length = length, .kind = (uint8_t) kind };
+	static const uint8_t zeros[8];
+	ringWrite(ring, head, &record, sizeof(record));
+	ringWrite(ring, head + sizeof(record), packetList, length);
+	ringWrite(ring, head + sizeof(record) + length, zeros, padded(length) - length);
+	atomic_store_explicit(&ring->head, head + total, memory_order_release);
+	atomic_fetch_add_explicit(&ring->records, 1, memory_order_relaxed);
+	return true;
+}
+
+// whole records only ever become visible, so the file interleaves producers record by record
+static void drainRings(RNPacketCapture *capture)
+{
+	for (unsigned p = 0; p < kRNPacketCaptureNumProducers; p++) {
+		RNCaptureRing *ring = &capture->rings[p];
+		uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		uint32_t length = head - tail;
+		if (length == 0) continue;
+		uint32_t start = tail & kRingMask;
+		uint32_t first = (length < kRNPacketCaptureRingLength - start) ? length : kRNPacketCaptureRingLength - start;
+		fwrite(ring->bytes + start, 1, first, capture->file);
+		fwrite(ring->bytes, 1, length - first, capture->file);
+		atomic_fetch_add_explicit(&capture->bytes, length, memory_order_relaxed);
+		atomic_store_explicit(&ring->tail, head, memory_order_release);
+	}
+}
+
+static void *writerThread(void *arg)
+{
+	RNPacketCapture *capture = arg;
+	while (atomic_load_explicit(&capture->running, memory_order_acquire)) {
+		drainRings(capture);
+		sleepNanos(kWriterPoll_ns);
+	}
+	drainRings(capture);
+	return NULL;
+}
+
+RNPacketCapture *RNPacketCaptureCreate(const char *path)
+{
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) return NULL;
+
+	RNPacketCaptureHeader header = { .version = kRNPacketCaptureVersion, .packetAlignment = kRNPacketAlignment,
+									 .startHostTime = RNPacketCaptureHostTime() };
+	memcpy(header.magic, kRNPacketCaptureMagic, sizeof(header.magic));
+	RNPacketCaptureHostTimebase(&header.timebaseNumer, &header.timebaseDenom);
+
+	RNPacketCapture *capture = calloc(1, sizeof(RNPacketCapture));
+	if (capture == NULL || fwrite(&header, sizeof(header), 1, file) != 1) {
+		free(capture);
+		fclose(file);
+		return NULL;
+	}
+	capture->file = file;
+	atomic_store(&capture->running, true);
+	if (pthread_create(&capture->thread, NULL, writerThread, capture) != 0) {
+		fclose(file);
+		free(capture);
+		return NULL;
+	}
+	return capture;
+}
+
+void RNPacketCaptureClose(RNPacketCapture *capture)
+{
+	if (capture == NULL) return;
+	atomic_store_explicit(&capture->running, false, memory_order_release);
+	pthread_join(capture->thread, NULL);
+	fclose(capture->file);
+	free(capture);
+}
+
+RNPacketCaptureCounts RNPacketCaptureGetCounts(const RNPacketCapture *capture)
+{
+	RNPacketCaptureCounts counts = { 0 };
+	for (unsigned p = 0; p < kRNPacketCaptureNumProducers; p++) {
+		counts.records += atomic_load_explicit(&capture->rings[p].records, memory_order_relaxed);
+		counts.dropped += atomic_load_explicit(&capture->rings[p].dropped, memory_order_relaxed);
+	}
+	counts.bytes = atomic_load_explicit(&capture->bytes, memory_order_relaxed);
+	return counts;
+}
+
+// *********************************************
+//    Reading
+// *********************************************
+
+RNPacketCaptureReader *RNPacketCaptureOpen(const char *path)
+{
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return NULL;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(RNPacketCaptureHeader)) {
+		close(fd);
+		return NULL;
+	}
+	void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) return NULL;
+
+	const RNPacketCaptureHeader *header = map;
+	if (memcmp(header->magic, kRNPacketCaptureMagic, sizeof(header->magic)) != 0 || header->version != kRNPacketCaptureVersion
+		|| header->timebaseNumer == 0 || header->timebaseDenom == 0) {
+		munmap(map, (size_t) info.st_size);
+		return NULL;
+	}
+	RNPacketCaptureReader *reader = malloc(sizeof(RNPacketCaptureReader));
+	if (reader == NULL) {
+		munmap(map, (size_t) info.st_size);
+		return NULL;
+	}
+	reader->map = map;
+	reader->length = (size_t) info.st_size;
+	return reader;
+}
+
+void RNPacketCaptureReaderClose(RNPacketCaptureReader *reader)
+{
+	if (reader == NULL) return;
+	munmap((void *) reader->map, reader->length);
+	free(reader);
+}
+
+const RNPacketCaptureHeader *RNPacketCaptureReaderHeader(const RNPacketCaptureReader *reader)
+{
+	return (const RNPacketCaptureHeader *) reader->map;
+}
+
+const RNPacketCaptureRecord *RNPacketCaptureNext(const RNPacketCaptureReader *reader, size_t *cursor, const uint8_t **packetList)
+{
+	size_t offset = sizeof(RNPacketCaptureHeader) + *cursor;
+	if (offset + sizeof(RNPacketCaptureRecord) > reader->length) return NULL;
+	const RNPacketCaptureRecord *record = (const RNPacketCaptureRecord *)(reader->map + offset);
+	size_t total = sizeof(RNPacketCaptureRecord) + padded(record->length);
+	if (offset + total > reader->length) return NULL;
+	if (packetList) *packetList = reader->map + offset + sizeof(RNPacketCaptureRecord);
+	*cursor += total;
+	return record;
+}
+
+static inline double ticksToNanos(const RNPacketCaptureHeader *header, uint64_t ticks)
+{
+	return (double) ticks * header->timebaseNumer / header->timebaseDenom;
+}
+
+// *********************************************
+//    Replaying
+// *********************************************
+
+bool RNPacketCaptureReplay(const RNPacketCaptureReader *reader, bool realTime,
+						   RNPacketReplayProc proc, void *refCon, RNPacketReplayResult *result)
+{
+	const RNPacketCaptureHeader *header = RNPacketCaptureReaderHeader(reader);
+	RNPacketReplayResult counts = { 0 };
+	if (header->packetAlignment != kRNPacketAlignment) return false;
+	uint8_t *scratch = malloc(kRNPacketCaptureMaxList);
+	if (scratch == NULL) return false;
+
+	uint64_t start = RNPacketCaptureHostTime();
+	uint64_t firstArrival = 0;
+	bool first = true;
+	size_t cursor = 0;
+	const uint8_t *list;
+	const RNPacketCaptureRecord *record;
+	while ((record = RNPacketCaptureNext(reader, &cursor, &list)) != NULL) {
+		if (record->kind != kRNPacketCaptureInput || RNPacketListLength(list, record->length, kRNPacketAlignment) != record->length) continue;
+		if (first) {
+			firstArrival = record->hostTime;
+			first = false;
+		}
+		uint64_t due = start + (record->hostTime - firstArrival);
+		if (realTime) {
+			uint64_t now = RNPacketCaptureHostTime();
+			if (now < due) sleepNanos((int64_t) ticksToNanos(header, due - now));
+			int64_t lateness_ns = (int64_t) ticksToNanos(header, RNPacketCaptureHostTime() - due);	// wraps negative if early
+			if (lateness_ns > counts.maxLateness_ns) counts.maxLateness_ns = lateness_ns;
+		}
+
+		// packets keep their spacing from arrival: moved by as much as the arrival was (0, "now", stays 0)
+		memcpy(scratch, list, record->length);
+		uint64_t shift = (realTime ? due : RNPacketCaptureHostTime()) - record->hostTime;
+		uint32_t nPackets = readU32(scratch);
+		uint32_t offset = 4;
+		for (uint32_t i = 0; i < nPackets; i++) {
+			if (i > 0) offset = (offset + kRNPacketAlignment - 1) & ~(uint32_t)(kRNPacketAlignment - 1);
+			uint64_t timeStamp = readU64(scratch + offset);
+			if (timeStamp != 0) {
+				timeStamp += shift;
+				memcpy(scratch + offset, &timeStamp, sizeof(timeStamp));
+			}
+			offset += kPacketHeaderLength + readU16(scratch + offset + 8);
+		}
+
+		while (!proc(scratch, record->length, refCon)) {
+			counts.nRetries++;
+			sleepNanos(kReplayRetry_ns);
+		}
+		counts.nLists++;
+	}
+	free(scratch);
+	counts.duration_s = ticksToNanos(header, RNPacketCaptureHostTime() - start) * 1e-9;
+	if (result) *result = counts;
+	return true;
+}
+
+// *********************************************
+//    Comparing
+// *********************************************
+
+typedef struct {
+	uint32_t		input;		// numbered from the capture's first input
+	uint32_t		rank;		// among the outputs answering that input
+	uint64_t		latency;	// ticks from the input's arrival to send
+	const uint8_t	*list;
+	uint32_t		length;
+	uint64_t		reference;	// first packet timestamp of the input: output timestamps are compared relative to it
+} RNCapturedOutput;
+
+typedef struct {
+	uint64_t			nInputs;
+	RNCapturedOutput	*outputs;
+	uint64_t			nOutputs;
+} RNCaptureIndex;
+
+static int compareOutputs(const void *a, const void *b)
+{
+	const RNCapturedOutput *x = a, *y = b;
+	if (x->input != y->input) return (x->input < y->input) ? -1 : 1;
+	return (x->rank < y->rank) ? -1 : (x->rank > y->rank);
+}
+
+static int compareDoubles(const void *a, const void *b)
+{
+	double x = *(const double *) a, y = *(const double *) b;
+	return (x < y) ? -1 : (x > y);
+}
+
+// outputs of inputs that arrived before the capture started (or were dropped from it) are left out
+static bool indexCapture(const RNPacketCaptureReader *reader, RNCaptureIndex *index)
+{
+	memset(index, 0, sizeof(RNCaptureIndex));
+	size_t cursor = 0, nRecords = 0;
+	const RNPacketCaptureRecord *record;
+	while ((record = RNPacketCaptureNext(reader, &cursor, NULL)) != NULL) nRecords++;
+
+	uint64_t *arrival = calloc(nRecords + 1, sizeof(uint64_t));
+	uint64_t *reference = calloc(nRecords + 1, sizeof(uint64_t));
+	bool *present = calloc(nRecords + 1, sizeof(bool));
+	uint32_t *nAnswers = calloc(nRecords + 1, sizeof(uint32_t));
+	index->outputs = malloc((nRecords + 1) * sizeof(RNCapturedOutput));
+	if (!arrival || !reference || !present || !nAnswers || !index->outputs) {
+		free(arrival); free(reference); free(present); free(nAnswers); free(index->outputs);
+		return false;
+	}
+
+	// inputs first: the two producers' rings are written out independently, so an output may precede its input in the file
+	uint32_t firstSequence = 0;
+	bool first = true;
+	const uint8_t *list;
+	for (cursor = 0; (record = RNPacketCaptureNext(reader, &cursor, &list)) != NULL; ) {
+		if (record->kind != kRNPacketCaptureInput) continue;
+		if (first) {
+			firstSequence = record->sequence;
+			first = false;
+		}
+		uint32_t input = record->sequence - firstSequence;
+		if (input > nRecords) continue;
+		arrival[input] = record->hostTime;
+		reference[input] = (record->length >= 4 + kPacketHeaderLength && readU32(list) > 0) ? readU64(list + 4) : 0;
+		present[input] = true;
+		if (input + 1 > index->nInputs) index->nInputs = input + 1;
+	}
+	for (cursor = 0; !first && (record = RNPacketCaptureNext(reader, &cursor, &list)) != NULL; ) {
+		uint32_t input = record->sequence - firstSequence;
+		if (record->kind == kRNPacketCaptureInput || input > nRecords || !present[input]) continue;
+		index->outputs[index->nOutputs++] = (RNCapturedOutput) {
+			.input = input, .rank = nAnswers[input]++, .latency = record->hostTime - arrival[input],
+			.list = list, .length = record->length, .reference = reference[input] };
+	}
+	free(arrival); free(reference); free(present); free(nAnswers);
+	qsort(index->outputs, index->nOutputs, sizeof(RNCapturedOutput), compareOutputs);
+	return true;
+}
+
+static RNPacketCaptureLatency latencies(const RNPacketCaptureHeader *header, const RNCaptureIndex *index)
+{
+	RNPacketCaptureLatency latency = { .n = index->nOutputs };
+	if (index->nOutputs == 0) return latency;
+	double *us = malloc(index->nOutputs * sizeof(double));
+	if (us == NULL) return latency;
+	double sum = 0.0;
+	for (uint64_t i = 0; i < index->nOutputs; i++) {
+		us[i] = ticksToNanos(header, index->outputs[i].latency) * 1e-3;
+		sum += us[i];
+	}
+	qsort(us, index->nOutputs, sizeof(double), compareDoubles);
+	latency.mean_us	= sum / index->nOutputs;
+	latency.p50_us	= us[(index->nOutputs - 1) / 2];
+	latency.p99_us	= us[(uint64_t) floor(0.99 * (index->nOutputs - 1))];
+	latency.max_us	= us[index->nOutputs - 1];
+	free(us);
+	return latency;
+}
+
+// same packets carrying the same bytes, scheduled at the same offsets from the input they answer
+static bool sameOutput(const RNCapturedOutput *x, const RNCapturedOutput *y)
+{
+	if (x->length != y->length || readU32(x->list) != readU32(y->list)) return false;
+	uint32_t nPackets = readU32(x->list);
+	uint32_t offset = 4;
+	for (uint32_t i = 0; i < nPackets; i++) {
+		if (i > 0) offset = (offset + kRNPacketAlignment - 1) & ~(uint32_t)(kRNPacketAlignment - 1);
+		uint64_t tx = readU64(x->list + offset), ty = readU64(y->list + offset);
+		if ((tx == 0) != (ty == 0) || (tx != 0 && tx - x->reference != ty - y->reference)) return false;
+		uint16_t length = readU16(x->list + offset + 8);
+		if (length != readU16(y->list + offset + 8)
+			|| memcmp(x->list + offset + kPacketHeaderLength, y->list + offset + kPacketHeaderLength, length) != 0) return false;
+		offset += kPacketHeaderLength + length;
+	}
+	return true;
+}
+
+bool RNPacketCaptureCompare(const RNPacketCaptureReader *a, const RNPacketCaptureReader *b,
+							RNPacketCaptureComparison *comparison)
+{
+	memset(comparison, 0, sizeof(RNPacketCaptureComparison));
+	comparison->firstDifference = -1;
+	const RNPacketCaptureHeader *headers[2] = { RNPacketCaptureReaderHeader(a), RNPacketCaptureReaderHeader(b) };
+	if (headers[0]->timebaseNumer != headers[1]->timebaseNumer || headers[0]->timebaseDenom != headers[1]->timebaseDenom
+		|| headers[0]->packetAlignment != headers[1]->packetAlignment || headers[0]->packetAlignment != kRNPacketAlignment) return false;
+
+	RNCaptureIndex index[2];
+	if (!indexCapture(a, &index[0])) return false;
+	if (!indexCapture(b, &index[1])) {
+		free(index[0].outputs);
+		return false;
+	}
+	for (unsigned c = 0; c < 2; c++) {
+		comparison->nInputs[c]	= index[c].nInputs;
+		comparison->nOutputs[c]	= index[c].nOutputs;
+		comparison->latency[c]	= latencies(headers[c], &index[c]);
+	}
+
+	uint64_t i = 0, j = 0;
+	while (i < index[0].nOutputs && j < index[1].nOutputs) {
+		int order = compareOutputs(&index[0].outputs[i], &index[1].outputs[j]);
+		if (order != 0) {
+			comparison->nUnpaired++;
+			if (comparison->firstDifference < 0) comparison->firstDifference = (int64_t) i;
+			if (order < 0) i++; else j++;
+			continue;
+		}
+		if (sameOutput(&index[0].outputs[i], &index[1].outputs[j])) {
+			comparison->nMatched++;
+		} else {
+			comparison->nDiffering++;
+			if (comparison->firstDifference < 0) comparison->firstDifference = (int64_t) i;
+		}
+		i++, j++;
+	}
+	uint64_t rest = (index[0].nOutputs - i) + (index[1].nOutputs - j);
+	if (rest > 0 && comparison->firstDifference < 0) comparison->firstDifference = (int64_t) i;
+	comparison->nUnpaired += rest;
+
+	free(index[0].outputs);
+	free(index[1].outputs);
+	return true;
+}
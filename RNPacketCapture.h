@@ -0,0 +1,156 @@
+//
+//  RNPacketCapture.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Capture and replay of the raw MIDI input, so a session's timing can be fed through the pipeline
+//	again: a repeatable throughput and latency benchmark from real tapping.
+//	- capture file (.rnpc): a header, then records of every packet list the read proc received
+//	  (arrival host time and the MIDIPacketList bytes as CoreMIDI gave them) and of every delay
+//	  output list handed to MIDISend, tagged with the input list it answers
+//	- appending is a copy into a single-producer byte ring per thread (the read proc, the
+//	  processing thread): no locks, allocation or I/O; a writer thread drains them to the file
+//	- replay hands the captured input lists back, in order, either at their original spacing or
+//	  as fast as the consumer takes them, with packet timestamps moved to the replay's clock
+//	- two captures (original, replay) compare output for output: same bytes at the same offsets
+//	  from their input, and the latency from input arrival to send in each
+//
+// Plain C: also built into Tools/rncapture and Tools/rnloadbench.
+
+#ifndef RNPacketCapture_h
+#define RNPacketCapture_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNPacketCaptureMagic		"RNC1"
+#define kRNPacketCaptureVersion		1
+#define kRNPacketCaptureRingLength	(1u << 20)	// bytes per producer ring (power of 2): seconds of dense input
+#define kRNPacketCaptureMaxList		65536		// largest packet list kept
+
+#if defined(__arm64__) || defined(__aarch64__)
+#define kRNPacketAlignment			4			// MIDIPacketNext rounding on this machine
+#else
+#define kRNPacketAlignment			1
+#endif
+
+typedef enum {
+	kRNPacketCaptureInput		= 0,	// received by the read proc
+	kRNPacketCaptureDelayOutput	= 1,	// sent by emitDelayedNotes
+} RNPacketCaptureKind;
+
+typedef enum {
+	kRNPacketCaptureProducerReadProc	= 0,
+	kRNPacketCaptureProducerProcessing	= 1,
+	kRNPacketCaptureNumProducers
+} RNPacketCaptureProducer;
+
+typedef struct {
+	char		magic[4];			// kRNPacketCaptureMagic
+	uint32_t	version;
+	uint32_t	timebaseNumer;		// host ticks * numer / denom = ns
+	uint32_t	timebaseDenom;
+	uint32_t	packetAlignment;	// MIDIPacketNext rounding of the capturing machine: 4 (arm64) or 1
+	uint32_t	reserved;
+	uint64_t	startHostTime;
+} RNPacketCaptureHeader;
+
+typedef struct {
+	uint64_t	hostTime;	// input: arrival in the read proc; output: handed to MIDISend
+	uint32_t	sequence;	// input: the list's number on arrival; output: number of the input list it answers
+	uint32_t	length;		// bytes of MIDIPacketList following, then padding to 8
+	uint8_t		kind;		// RNPacketCaptureKind
+	uint8_t		spare[7];
+} RNPacketCaptureRecord;
+
+_Static_assert(sizeof(RNPacketCaptureHeader) == 32, "capture header layout");
+_Static_assert(sizeof(RNPacketCaptureRecord) == 24, "capture record layout");
+
+typedef struct {
+	uint64_t	records;
+	uint64_t	bytes;		// written to the file
+	uint64_t	dropped;	// records lost to a full ring (or too long)
+} RNPacketCaptureCounts;
+
+// *********************************************
+//    Capturing
+
+typedef struct RNPacketCapture RNPacketCapture;
+
+// Creates the file and starts the writer thread. NULL if the file can't be created.
+RNPacketCapture			*RNPacketCaptureCreate(const char *path);
+// Drains what is left, closes the file and frees. Producers must have stopped appending.
+void					RNPacketCaptureClose(RNPacketCapture *capture);
+
+// Producer side: only one thread may append to a given producer ring. Returns false (counted) if full.
+bool					RNPacketCaptureAppend(RNPacketCapture *capture, RNPacketCaptureProducer producer, RNPacketCaptureKind kind,
+											  uint64_t hostTime, uint32_t sequence, const void *packetList, uint32_t length);
+
+RNPacketCaptureCounts	RNPacketCaptureGetCounts(const RNPacketCapture *capture);	// any thread
+
+// Host clock, in ticks of the header's timebase (mach absolute time on macOS, as MIDITimeStamps)
+uint64_t				RNPacketCaptureHostTime(void);
+void					RNPacketCaptureHostTimebase(uint32_t *numer, uint32_t *denom);
+
+// Length of the MIDIPacketList at list (packets walked with the given alignment), 0 if it overruns capacity
+uint32_t				RNPacketListLength(const void *list, uint32_t capacity, uint32_t packetAlignment);
+
+// *********************************************
+//    Reading, replaying, comparing
+
+typedef struct RNPacketCaptureReader RNPacketCaptureReader;
+
+RNPacketCaptureReader	*RNPacketCaptureOpen(const char *path);	// NULL if not a capture
+void					RNPacketCaptureReaderClose(RNPacketCaptureReader *reader);
+const RNPacketCaptureHeader *RNPacketCaptureReaderHeader(const RNPacketCaptureReader *reader);
+
+// Records in file order: start *cursor at 0. NULL at the end (or at a truncated record).
+const RNPacketCaptureRecord *RNPacketCaptureNext(const RNPacketCaptureReader *reader, size_t *cursor, const uint8_t **packetList);
+
+// Called with each input list, timestamps moved to now; false if the consumer has no room yet (retried).
+typedef bool (*RNPacketReplayProc)(const void *packetList, uint32_t length, void *refCon);
+
+typedef struct {
+	uint64_t	nLists;
+	uint64_t	nRetries;			// proc had no room
+	int64_t		maxLateness_ns;		// real time: behind the captured spacing
+	double		duration_s;
+} RNPacketReplayResult;
+
+// Blocks until every input list has been handed to proc. The capture must come from a machine
+//	with this one's packet alignment.
+bool					RNPacketCaptureReplay(const RNPacketCaptureReader *reader, bool realTime,
+											  RNPacketReplayProc proc, void *refCon, RNPacketReplayResult *result);
+
+typedef struct {
+	uint64_t	n;
+	double		mean_us, p50_us, p99_us, max_us;
+} RNPacketCaptureLatency;
+
+typedef struct {
+	uint64_t				nInputs[2];
+	uint64_t				nOutputs[2];
+	uint64_t				nMatched;		// same packets, same bytes, same timestamp offsets from the input
+	uint64_t				nDiffering;
+	uint64_t				nUnpaired;		// in one capture only
+	int64_t					firstDifference;	// output index in the first capture; -1 if none
+	RNPacketCaptureLatency	latency[2];		// input arrival to send, per capture
+} RNPacketCaptureComparison;
+
+// Outputs pair up by the input list they answer (numbered from each capture's first input) and
+//	their order among that list's outputs.
+bool					RNPacketCaptureCompare(const RNPacketCaptureReader *a, const RNPacketCaptureReader *b,
+											   RNPacketCaptureComparison *comparison);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNPacketCapture_h */
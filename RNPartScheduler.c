@@ -0,0 +1,111 @@
+//
+//  RNPartScheduler.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNPartScheduler.h"
+#include "RNHostClock.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
+
+struct RNPartScheduler {
+	RNPartEntry			*entries;	// by due time
+	uint32_t			nEntries;
+	RNPartFireProc		fireProc;
+	void				*refCon;
+	pthread_t			thread;
+	_Atomic(bool)		running;
+
+	_Atomic(uint32_t)	fired;
+	_Atomic(int64_t)	maxLateness_ns;
+};
+
+static int compareDue(const void *a, const void *b)
+{
+	const RNPartEntry *ea = a, *eb = b;
+	if (ea->due_ns != eb->due_ns) return (ea->due_ns < eb->due_ns) ? -1 : 1;
+	return (ea->part < eb->part) ? -1 : (ea->part > eb->part);	// parts starting together fire in timeline order
+}
+
+static void *schedulerThread(void *arg)
+{
+	RNPartScheduler *scheduler = arg;
+#ifdef __APPLE__
+	pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0); // as the MIDI processing queue
+#endif
+
+	uint32_t next = 0;
+	while (next < scheduler->nEntries && atomic_load_explicit(&scheduler->running, memory_order_acquire)) {
+		const RNPartEntry *entry = &scheduler->entries[next];
+		int64_t sleep_ns = entry->due_ns - kRNPartSpin_ns - RNHostClockNow();
+		if (sleep_ns > 0) {
+			if (sleep_ns > kRNPartPoll_ns) sleep_ns = kRNPartPoll_ns;
+			struct timespec interval = { (time_t)(sleep_ns / 1000000000), (long)(sleep_ns % 1000000000) };
+			nanosleep(&interval, NULL);
+			continue;
+		}
+
+		int64_t now_ns;
+		while ((now_ns = RNHostClockNow()) < entry->due_ns)
+			;
+		scheduler->fireProc(entry, now_ns, scheduler->refCon);
+		if (now_ns - entry->due_ns > atomic_load_explicit(&scheduler->maxLateness_ns, memory_order_relaxed))
+			atomic_store_explicit(&scheduler->maxLateness_ns, now_ns - entry->due_ns, memory_order_relaxed);
+		atomic_store_explicit(&scheduler->fired, ++next, memory_order_release);
+	}
+	return NULL;
+}
+
+RNPartScheduler *RNPartSchedulerCreate(const RNPartEntry *entries, uint32_t nEntries, RNPartFireProc fireProc, void *refCon)
+{
+	if (fireProc == NULL || (entries == NULL && nEntries > 0)) return NULL;
+	RNPartScheduler *scheduler = calloc(1, sizeof(RNPartScheduler));
+	if (scheduler == NULL) return NULL;
+	scheduler->entries = malloc((nEntries > 0 ? nEntries : 1) * sizeof(RNPartEntry));
+	if (scheduler->entries == NULL) {
+		free(scheduler);
+		return NULL;
+	}
+	if (nEntries > 0)
+		memcpy(scheduler->entries, entries, nEntries * sizeof(RNPartEntry));
+	qsort(scheduler->entries, nEntries, sizeof(RNPartEntry), compareDue);
+	scheduler->nEntries	= nEntries;
+	scheduler->fireProc	= fireProc;
+	scheduler->refCon	= refCon;
+	atomic_init(&scheduler->running, true);
+
+	if (pthread_create(&scheduler->thread, NULL, schedulerThread, scheduler) != 0) {
+		free(scheduler->entries);
+		free(scheduler);
+		return NULL;
+	}
+	return scheduler;
+}
+
+void RNPartSchedulerDestroy(RNPartScheduler *scheduler)
+{
+	if (scheduler == NULL) return;
+	atomic_store_explicit(&scheduler->running, false, memory_order_release);
+	pthread_join(scheduler->thread, NULL);
+	free(scheduler->entries);
+	free(scheduler);
+}
+
+RNPartSchedulerCounts RNPartSchedulerGetCounts(const RNPartScheduler *scheduler)
+{
+	RNPartSchedulerCounts counts = { 0, 0, 0 };
+	if (scheduler == NULL) return counts;
+	RNPartScheduler *mutableScheduler = (RNPartScheduler *) scheduler; // atomics are read-only here
+	counts.fired			= atomic_load_explicit(&mutableScheduler->fired, memory_order_acquire);
+	counts.pending			= scheduler->nEntries - counts.fired;
+	counts.maxLateness_ns	= atomic_load_explicit(&mutableScheduler->maxLateness_ns, memory_order_relaxed);
+	return counts;
+}
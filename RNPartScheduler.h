@@ -0,0 +1,70 @@
+//
+//  RNPartScheduler.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// The experiment's timeline: part transitions fired at their host-clock times from a dedicated
+//	thread, rather than by run loop timers whose latency depends on what the UI is doing.
+//	- the timeline is compiled once, at start, into entries sorted by due time; nothing is
+//	  allocated or locked while it plays
+//	- the thread sleeps until just before an entry is due and spins the rest of the way, so an
+//	  entry fires within microseconds of its time; the fire proc gets the time it actually fired
+//	- the fire proc runs on the scheduler's thread: it makes the realtime change (e.g. swapping
+//	  the routing table) there, and hands anything slower or UI bound to another queue
+//	- a part may also have entries due ahead of it, for changes that take time to be heard: a
+//	  stimulus starts streaming a lookahead early, and an MIOC switch is sent to land on time
+
+#ifndef RNPartScheduler_h
+#define RNPartScheduler_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNPartPoll_ns		10000000	// longest sleep: how soon Destroy is noticed
+#define kRNPartSpin_ns		1000000		// spin (rather than sleep) this close to an entry
+
+typedef enum {
+	kRNPartActionNotify		= 0,	// nothing realtime: report it
+	kRNPartActionRouting	= 1,	// switch the realtime routing state to payload
+	// ahead of a part, so what it starts is heard on time; not reported (the part's own entry is)
+	kRNPartActionStimulus	= 2,	// start the stimulus stream in payload, one lookahead ahead
+	kRNPartActionMIOC		= 3,	// send payload, a timestamped MIOC switch, to land as the part starts
+} RNPartAction;
+
+typedef struct {
+	int64_t			due_ns;		// absolute (host clock)
+	uint32_t		part;		// caller's index
+	RNPartAction	action;
+	void			*payload;	// the action's, e.g. the routing table
+} RNPartEntry;
+
+// Called on the scheduler's thread as each entry falls due, in time order. Must not block.
+typedef void (*RNPartFireProc)(const RNPartEntry *entry, int64_t fired_ns, void *refCon);
+
+typedef struct {
+	uint32_t	fired;
+	uint32_t	pending;
+	int64_t		maxLateness_ns;	// fired after due
+} RNPartSchedulerCounts;
+
+typedef struct RNPartScheduler RNPartScheduler;
+
+// Copies and sorts the entries and starts the thread. Entries already due fire at once.
+RNPartScheduler			*RNPartSchedulerCreate(const RNPartEntry *entries, uint32_t nEntries, RNPartFireProc fireProc,
+											   void *refCon);
+void					RNPartSchedulerDestroy(RNPartScheduler *scheduler);	// entries not yet fired never are
+
+// Any thread.
+RNPartSchedulerCounts	RNPartSchedulerGetCounts(const RNPartScheduler *scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNPartScheduler_h */
@@ -0,0 +1,213 @@
+//
+//  RNRoutingLoad.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNRoutingLoad.h"
+#include "RNPacketCapture.h"
+#include "RNSimulator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define kLoadStart_ns		100000000	// first beat, after the capture starts
+#define kPacketHeaderLength	10			// MIDIPacket: UInt64 timeStamp, UInt16 length, then data
+#define kMessageLength		3
+
+typedef struct {
+	int64_t		tap_ns;
+	int64_t		arrival_ns;
+	uint8_t		node;
+} RNLoadTap;
+
+void RNRoutingLoadDefaultConfig(RNRoutingLoadConfig *config)
+{
+	*config = (RNRoutingLoadConfig) {
+		.nodes = 6, .rate_Hz = 2.0, .synchronySD_ms = 10.0, .density = 1.0,
+		.delayDistribution = kRNLoadDelayFixed, .delay_ms = 50.0, .delaySpread_ms = 0.0,
+		.noteOff = false, .transport = kRNLoadTransportIdeal, .duration_s = 60.0, .seed = 1,
+	};
+}
+
+void RNRoutingLoadMatrices(const RNRoutingLoadConfig *config, RNLoadMatrix weight, RNLoadMatrix delay_ms)
+{
+	RNSimRandom random;
+	RNSimRandomSeed(&random, config->seed ^ 0x5A5A5A5A5A5A5A5AULL);	// not the taps' stream
+	memset(weight, 0, sizeof(RNLoadMatrix));
+	memset(delay_ms, 0, sizeof(RNLoadMatrix));
+	unsigned nodes = (config->nodes < kRNLoadMaxNodes) ? config->nodes : kRNLoadMaxNodes;
+	for (unsigned from = 0; from < nodes; from++) {
+		for (unsigned to = 0; to < nodes; to++) {
+			if (from == to || RNSimRandomUniform(&random) >= config->density) continue;
+			double delay = config->delay_ms;
+			switch (config->delayDistribution) {
+				case kRNLoadDelayUniform:	delay += config->delaySpread_ms * (2.0 * RNSimRandomUniform(&random) - 1.0); break;
+				case kRNLoadDelayGaussian:	delay += config->delaySpread_ms * RNSimRandomGaussian(&random); break;
+				default: break;
+			}
+			weight[from][to] = 1.0;
+			delay_ms[from][to] = (delay > 0.0) ? delay : 0.0;
+		}
+	}
+}
+
+static int compareTaps(const void *a, const void *b)
+{
+	const RNLoadTap *x = a, *y = b;
+	if (x->tap_ns != y->tap_ns) return (x->tap_ns < y->tap_ns) ? -1 : 1;
+	return (int) x->node - (int) y->node;
+}
+
+static inline uint64_t nanosToTicks(int64_t ns, uint32_t numer, uint32_t denom)
+{
+	return (uint64_t)((double) ns * denom / numer + 0.5);
+}
+
+static uint32_t alignedOffset(uint32_t offset)
+{
+	return (offset + kRNPacketAlignment - 1) & ~(uint32_t)(kRNPacketAlignment - 1);
+}
+
+bool RNRoutingLoadWriteCapture(const RNRoutingLoadConfig *config, const char *path, RNRoutingLoadSummary *summary)
+{
+	RNRoutingLoadSummary result = { 0 };
+	unsigned nodes = (config->nodes < kRNLoadMaxNodes) ? config->nodes : kRNLoadMaxNodes;
+	if (nodes == 0 || config->rate_Hz <= 0.0 || config->duration_s <= 0.0) return false;
+
+	// the taps, in the order they were made
+	uint64_t nBeats = (uint64_t) ceil(config->duration_s * config->rate_Hz);
+	RNLoadTap *taps = malloc(nBeats * nodes * sizeof(RNLoadTap));
+	if (taps == NULL) return false;
+	RNSimRandom random;
+	RNSimRandomSeed(&random, config->seed);
+	double period_ns = 1e9 / config->rate_Hz;
+	uint64_t nTaps = 0;
+	for (uint64_t beat = 0; beat < nBeats; beat++) {
+		for (unsigned node = 1; node <= nodes; node++) {
+			double jitter_ns = (config->synchronySD_ms > 0.0) ? config->synchronySD_ms * 1e6 * RNSimRandomGaussian(&random) : 0.0;
+			double tap_ns = kLoadStart_ns + beat * period_ns + jitter_ns;
+			taps[nTaps++] = (RNLoadTap) { .tap_ns = (int64_t)((tap_ns > 0.0) ? tap_ns : 0.0), .node = (uint8_t) node };
+		}
+	}
+	qsort(taps, nTaps, sizeof(RNLoadTap), compareTaps);
+
+	// through the transport: on a serial link each message waits for the one before
+	int64_t wireFree_ns = 0;
+	for (uint64_t i = 0; i < nTaps; i++) {
+		if (config->transport == kRNLoadTransportSerial) {
+			int64_t start_ns = (taps[i].tap_ns > wireFree_ns) ? taps[i].tap_ns : wireFree_ns;
+			double wait_ms = (start_ns - taps[i].tap_ns) / 1e6;
+			if (wait_ms > result.maxTransport_ms) result.maxTransport_ms = wait_ms;
+			taps[i].arrival_ns = wireFree_ns = start_ns + kMessageLength * kRNLoadSerialByte_ns;
+		} else {
+			taps[i].arrival_ns = taps[i].tap_ns;
+		}
+	}
+
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		free(taps);
+		return false;
+	}
+	RNPacketCaptureHeader header = { .version = kRNPacketCaptureVersion, .packetAlignment = kRNPacketAlignment,
+									 .startHostTime = RNPacketCaptureHostTime() };
+	memcpy(header.magic, kRNPacketCaptureMagic, sizeof(header.magic));
+	RNPacketCaptureHostTimebase(&header.timebaseNumer, &header.timebaseDenom);
+	bool ok = (fwrite(&header, sizeof(header), 1, file) == 1);
+
+	RNLoadMatrix weight, delay_ms;
+	RNRoutingLoadMatrices(config, weight, delay_ms);
+	uint8_t list[4 + kRNLoadMaxNodes * 16 * (kPacketHeaderLength + kMessageLength + 8)];
+	uint64_t first = 0;
+	while (ok && first < nTaps) {
+		// arrivals within a window go together, delivered when the last is in
+		uint64_t last = first;
+		while (last + 1 < nTaps && taps[last + 1].arrival_ns < taps[first].arrival_ns + kRNLoadListWindow_ns
+			   && (last + 1 - first) * (kPacketHeaderLength + kMessageLength + kRNPacketAlignment) + 4 < sizeof(list)) last++;
+		uint32_t nPackets = (uint32_t)(last - first + 1);
+		memcpy(list, &nPackets, sizeof(nPackets));
+		uint32_t offset = 4;
+		for (uint64_t i = first; i <= last; i++) {
+			if (i > first) offset = alignedOffset(offset);
+			uint64_t timeStamp = header.startHostTime + nanosToTicks(taps[i].arrival_ns, header.timebaseNumer, header.timebaseDenom);
+			uint16_t length = kMessageLength;
+			uint8_t node = taps[i].node;
+			uint8_t message[kMessageLength] = { 0x90 | ((node - 1) & 0x0F), kRNLoadBaseNote + node, kRNLoadVelocity };
+			memcpy(list + offset, &timeStamp, sizeof(timeStamp));
+			memcpy(list + offset + 8, &length, sizeof(length));
+			memcpy(list + offset + kPacketHeaderLength, message, kMessageLength);
+			offset += kPacketHeaderLength + kMessageLength;
+		}
+
+		RNPacketCaptureRecord record = {
+			.hostTime = header.startHostTime + nanosToTicks(taps[last].arrival_ns, header.timebaseNumer, header.timebaseDenom),
+			.sequence = (uint32_t) result.nLists, .length = offset, .kind = kRNPacketCaptureInput };
+		static const uint8_t zeros[8];
+		ok = fwrite(&record, sizeof(record), 1, file) == 1 && fwrite(list, 1, offset, file) == offset
+			&& fwrite(zeros, 1, ((offset + 7u) & ~7u) - offset, file) == ((offset + 7u) & ~7u) - offset;
+
+		uint32_t nEvents = 0;
+		uint32_t bytes = RNRoutingLoadDelayListBytes(list, weight, delay_ms, config->noteOff, &nEvents);
+		if (bytes > result.maxDelayListBytes) result.maxDelayListBytes = bytes;
+		if (nPackets > result.maxTapsPerList) result.maxTapsPerList = nPackets;
+		result.nDelayEvents += nEvents;
+		result.nTaps += nPackets;
+		result.nLists++;
+		first = last + 1;
+	}
+	ok = (fclose(file) == 0) && ok;
+	free(taps);
+	if (summary) *summary = result;
+	return ok;
+}
+
+// as emitDelayedNotes: every tap in a list is delayed from the list's first timestamp, and MIDIPacketListAdd
+//	appends to the current packet when the timestamp is the same, else starts an aligned new one
+uint32_t RNRoutingLoadDelayListBytes(const void *packetList, RNLoadMatrix weight, RNLoadMatrix delay_ms,
+									 bool noteOff, uint32_t *nEvents)
+{
+	const uint8_t *bytes = packetList;
+	uint32_t nPackets, offset = 4;
+	memcpy(&nPackets, bytes, sizeof(nPackets));
+	if (nPackets == 0) return 4;
+	uint64_t listTimeStamp;
+	memcpy(&listTimeStamp, bytes + offset, sizeof(listTimeStamp));
+	uint32_t numer, denom;
+	RNPacketCaptureHostTimebase(&numer, &denom);
+
+	uint32_t end = 4, packetStart = 0, events = 0;
+	uint64_t packetTimeStamp = 0;
+	bool hasPacket = false;
+	for (uint32_t i = 0; i < nPackets; i++) {
+		if (i > 0) offset = alignedOffset(offset);
+		uint16_t length;
+		memcpy(&length, bytes + offset + 8, sizeof(length));
+		const uint8_t *data = bytes + offset + kPacketHeaderLength;
+		for (uint32_t j = 0; j + 2 < length; j += kMessageLength) {
+			if ((data[j] & 0xF0) != 0x90 || data[j + 2] == 0) continue;
+			unsigned channel = data[j] & 0x0F;
+			for (unsigned to = 0; to < kRNLoadMaxNodes; to++) {
+				if (weight[channel][to] == 0.0) continue;
+				uint64_t on = listTimeStamp + ((delay_ms[channel][to] > 0.0) ? nanosToTicks((int64_t)(delay_ms[channel][to] * 1e6), numer, denom) : 0);
+				uint64_t times[2] = { on, on + nanosToTicks(kRNLoadNoteOffDelay_ms * 1000000LL, numer, denom) };
+				for (unsigned k = 0; k < (noteOff ? 2u : 1u); k++) {
+					if (hasPacket && times[k] == packetTimeStamp) {
+						end += kMessageLength;
+					} else {
+						packetStart = hasPacket ? alignedOffset(end) : 4;
+						end = packetStart + kPacketHeaderLength + kMessageLength;
+						packetTimeStamp = times[k];
+						hasPacket = true;
+					}
+					events++;
+				}
+			}
+		}
+		offset += kPacketHeaderLength + length;
+	}
+	if (nEvents) *nEvents = events;
+	return end;
+}
@@ -0,0 +1,92 @@
+//
+//  RNRoutingLoad.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Synthetic workloads for the delay routing path (MIDIIO emitDelayedNotes:), to find where it breaks.
+//	- a workload is a group tapping together: nodes, tap rate, how tightly taps cluster on each
+//	  beat, how many of the N(N-1) connections are routed, their delays and whether note-offs go out
+//	- taps reach the computer through a transport: ideal (as tapped) or a MIDI serial link, where
+//	  simultaneous taps queue behind each other; taps arriving in the same millisecond (one USB
+//	  frame) are delivered as one packet list, as CoreMIDI would
+//	- output is a capture of input only (RNPacketCapture.h), replayed through the live pipeline
+//	  to measure it end to end; the routing matrices go in a routing table
+//	- the size of the delay packet list each input list produces can be predicted without CoreMIDI,
+//	  packets merged as MIDIPacketListAdd merges them, for the margin under kDelayPacketListLength
+//
+// Plain C: also built into Tools/rnloadbench.
+
+#ifndef RNRoutingLoad_h
+#define RNRoutingLoad_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNLoadMaxNodes			16		// kMaxNodes
+#define kRNLoadBaseNote			64		// kBaseNote
+#define kRNLoadVelocity			100
+#define kRNLoadNoteOffDelay_ms	200		// kNoteOffDelay_ms
+#define kRNLoadListWindow_ns	1000000	// arrivals delivered together
+#define kRNLoadSerialByte_ns	320000	// 10 bits at 31250 baud
+
+typedef enum {
+	kRNLoadDelayFixed		= 0,	// delay_ms
+	kRNLoadDelayUniform		= 1,	// delay_ms +/- delaySpread_ms
+	kRNLoadDelayGaussian	= 2,	// SD delaySpread_ms, at least 0
+} RNLoadDelayDistribution;
+
+typedef enum {
+	kRNLoadTransportIdeal	= 0,
+	kRNLoadTransportSerial	= 1,
+} RNLoadTransport;
+
+typedef struct {
+	unsigned				nodes;			// tappers 1..nodes
+	double					rate_Hz;		// beats per second; every node taps each beat
+	double					synchronySD_ms;	// spread of taps around the beat; 0: all at once
+	double					density;		// fraction of connections routed (1: all to all)
+	RNLoadDelayDistribution	delayDistribution;
+	double					delay_ms;
+	double					delaySpread_ms;
+	bool					noteOff;
+	RNLoadTransport			transport;
+	double					duration_s;
+	uint64_t				seed;
+} RNRoutingLoadConfig;
+
+// as NodeMatrix, indexed as emitDelayedNotes: indexes it, by 0-based MIDI channel
+typedef double RNLoadMatrix[kRNLoadMaxNodes + 1][kRNLoadMaxNodes + 1];
+
+void	RNRoutingLoadDefaultConfig(RNRoutingLoadConfig *config);	// 6 nodes, 2 Hz, 10 ms, all to all, 50 ms, 60 s
+
+// Connection weights (1 or 0) and delays (ms) for the config
+void	RNRoutingLoadMatrices(const RNRoutingLoadConfig *config, RNLoadMatrix weight, RNLoadMatrix delay_ms);
+
+typedef struct {
+	uint64_t	nLists;
+	uint64_t	nTaps;
+	uint32_t	maxTapsPerList;
+	uint32_t	maxDelayListBytes;	// predicted, for the largest list
+	uint64_t	nDelayEvents;		// predicted note-ons (and -offs) emitted
+	double		maxTransport_ms;	// serial: longest a tap waited for the wire
+} RNRoutingLoadSummary;
+
+// Writes the workload as a capture of input lists (host time, this machine's packet layout).
+//	false if the file can't be written.
+bool	RNRoutingLoadWriteCapture(const RNRoutingLoadConfig *config, const char *path, RNRoutingLoadSummary *summary);
+
+// Bytes of the delay packet list emitDelayedNotes: builds for one input list
+uint32_t RNRoutingLoadDelayListBytes(const void *packetList, RNLoadMatrix weight, RNLoadMatrix delay_ms,
+									 bool noteOff, uint32_t *nEvents);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNRoutingLoad_h */
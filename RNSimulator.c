@@ -0,0 +1,628 @@
+//
+//  RNSimulator.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNSimulator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define kHeardHistory	4	// events remembered per input, enough to find the one nearest a tap
+
+typedef enum {
+	kPartNetwork,
+	kPartStimulus,
+	kPartStrength,
+} RNSimPartKind;
+
+typedef struct {
+	int64_t			start_ns;
+	uint32_t		order;
+	RNSimPartKind	kind;
+	uint32_t		index;		// into networks or stimuli
+	double			strength;
+} RNSimPart;
+
+struct RNSimExperiment {
+	double			duration_s;
+	RNSimPart		*parts;
+	size_t			nParts, partCapacity;
+	RNSimNetwork	*networks;
+	size_t			nNetworks, networkCapacity;
+	RNSimStimulus	*stimuli;
+	size_t			nStimuli, stimulusCapacity;
+};
+
+// *********************************************
+//    Experiment definition
+// *********************************************
+
+static bool grow(void **array, size_t *capacity, size_t count, size_t size)
+{
+	if (count < *capacity) return true;
+	size_t newCapacity = (*capacity > 0) ? 2 * *capacity : 16;
+	void *grown = realloc(*array, newCapacity * size);
+	if (grown == NULL) return false;
+	*array = grown;
+	*capacity = newCapacity;
+	return true;
+}
+
+RNSimExperiment *RNSimExperimentCreate(double duration_s)
+{
+	RNSimExperiment *experiment = calloc(1, sizeof(RNSimExperiment));
+	if (experiment) experiment->duration_s = duration_s;
+	return experiment;
+}
+
+void RNSimExperimentDestroy(RNSimExperiment *experiment)
+{
+	if (experiment == NULL) return;
+	free(experiment->parts);
+	free(experiment->networks);
+	free(experiment->stimuli);
+	free(experiment);
+}
+
+static RNSimPart *addPart(RNSimExperiment *e, double start_s, RNSimPartKind kind)
+{
+	if (!grow((void **) &e->parts, &e->partCapacity, e->nParts, sizeof(RNSimPart))) return NULL;
+	RNSimPart *part = &e->parts[e->nParts];
+	memset(part, 0, sizeof(RNSimPart));
+	part->start_ns	= llround(start_s * 1e9);
+	part->order		= (uint32_t) e->nParts++;
+	part->kind		= kind;
+	return part;
+}
+
+bool RNSimExperimentAddNetwork(RNSimExperiment *e, double start_s, const RNSimNetwork *network)
+{
+	if (network->nNodes > kRNSimMaxNodes) return false;
+	if (!grow((void **) &e->networks, &e->networkCapacity, e->nNetworks, sizeof(RNSimNetwork))) return false;
+	RNSimPart *part = addPart(e, start_s, kPartNetwork);
+	if (part == NULL) return false;
+	part->index = (uint32_t) e->nNetworks;
+	e->networks[e->nNetworks++] = *network;
+	return true;
+}
+
+bool RNSimExperimentAddStimulus(RNSimExperiment *e, double start_s, RNSimStimulus stimulus)
+{
+	if (stimulus.channel < 1 || stimulus.channel > kRNSimMaxChannels || stimulus.IOI_ms <= 0.0) return false;
+	if (!grow((void **) &e->stimuli, &e->stimulusCapacity, e->nStimuli, sizeof(RNSimStimulus))) return false;
+	RNSimPart *part = addPart(e, start_s, kPartStimulus);
+	if (part == NULL) return false;
+	part->index = (uint32_t) e->nStimuli;
+	e->stimuli[e->nStimuli++] = stimulus;
+	return true;
+}
+
+bool RNSimExperimentAddStrength(RNSimExperiment *e, double start_s, double strength)
+{
+	RNSimPart *part = addPart(e, start_s, kPartStrength);
+	if (part == NULL) return false;
+	part->strength = strength;
+	return true;
+}
+
+double RNSimExperimentDuration(const RNSimExperiment *e)
+{
+	return e->duration_s;
+}
+
+unsigned RNSimExperimentNodeCount(const RNSimExperiment *e)
+{
+	unsigned nNodes = 0;
+	for (size_t i = 0; i < e->nNetworks; i++)
+		if (e->networks[i].nNodes > nNodes) nNodes = e->networks[i].nNodes;
+	return nNodes;
+}
+
+bool RNSimNetworkAddConnectionString(RNSimNetwork *network, const char *string)
+{
+	double from, to, weight = 1.0, delay_ms = 0.0;
+	int consumed = 0;
+	if (sscanf(string, " { %lf , %lf } %n", &from, &to, &consumed) < 2 || consumed == 0) return false;
+	sscanf(string + consumed, "%lf , %lf", &weight, &delay_ms);
+
+	unsigned iFrom = (unsigned) floor(from), iTo = (unsigned) floor(to);
+	if (iFrom > kRNSimMaxNodes || iTo < 1 || iTo > kRNSimMaxNodes) return false;
+	if (iFrom == 0) {
+		unsigned subChannel = (unsigned) lround((from - iFrom) * 100.0);
+		if (subChannel == 0) subChannel = 1;
+		if (subChannel > kRNSimMaxChannels) return false;
+		network->stimulusChannel[iTo] = (uint8_t) subChannel;
+	}
+	network->weight[iFrom][iTo]		= weight;
+	network->delay_ms[iFrom][iTo]	= delay_ms;
+	return true;
+}
+
+bool RNSimStimulusFromString(const char *string, RNSimStimulus *stimulus)
+{
+	int channel, MIDIChannel, note, nEvents, consumed = 0;
+	double IOI;
+	memset(stimulus, 0, sizeof(RNSimStimulus));
+	if (sscanf(string, " %d : %d ( %d ) , IOI= %lf , events= %d%n", &channel, &MIDIChannel, &note, &IOI, &nEvents, &consumed) < 5)
+		return false;
+	if (channel < 1 || channel > kRNSimMaxChannels || MIDIChannel < 1 || MIDIChannel > 16 || nEvents < 0 || IOI <= 0.0)
+		return false;
+	stimulus->channel		= (uint8_t) channel;
+	stimulus->MIDIChannel	= (uint8_t) MIDIChannel;
+	stimulus->note			= (uint8_t) note;
+	stimulus->IOI_ms		= IOI;
+	stimulus->nEvents		= (uint32_t) nEvents;
+	// optional: phase, jitter
+	const char *phase = strstr(string + consumed, "phase=");
+	if (phase) stimulus->phase_ms = strtod(phase + strlen("phase="), NULL);
+	const char *jitter = strstr(string + consumed, "jitter=");
+	if (jitter) stimulus->jitter_ms = strtod(jitter + strlen("jitter="), NULL);
+	return true;
+}
+
+// *********************************************
+//    Simulation
+// *********************************************
+
+typedef enum {
+	kActionPart,
+	kActionOnset,		// next onset of a running stimulus
+	kActionDelivery,	// a tap reaching a listener through the network
+	kActionDecision,	// a tapper settles its next tap
+	kActionTap,
+} RNSimActionKind;
+
+typedef struct {
+	int64_t		time_ns;
+	uint64_t	order;		// ties run in the order scheduled
+	uint8_t		kind;
+	uint8_t		node;		// tapper (listener for deliveries)
+	uint8_t		source;		// delivery: tapper that tapped
+	uint32_t	index;		// part, stimulus run, or tap id
+} RNSimAction;
+
+typedef struct {
+	RNSimAction	*actions;
+	size_t		count, capacity;
+	uint64_t	nextOrder;
+} RNSimQueue;
+
+static inline bool actionBefore(const RNSimAction *a, const RNSimAction *b)
+{
+	return a->time_ns < b->time_ns || (a->time_ns == b->time_ns && a->order < b->order);
+}
+
+static bool queuePush(RNSimQueue *q, RNSimAction action)
+{
+	if (!grow((void **) &q->actions, &q->capacity, q->count, sizeof(RNSimAction))) return false;
+	action.order = q->nextOrder++;
+	size_t i = q->count++;
+	while (i > 0) {
+		size_t parent = (i - 1) / 2;
+		if (!actionBefore(&action, &q->actions[parent])) break;
+		q->actions[i] = q->actions[parent];
+		i = parent;
+	}
+	q->actions[i] = action;
+	return true;
+}
+
+static RNSimAction queuePop(RNSimQueue *q)
+{
+	RNSimAction top = q->actions[0];
+	RNSimAction last = q->actions[--q->count];
+	size_t i = 0;
+	for (;;) {
+		size_t child = 2 * i + 1;
+		if (child >= q->count) break;
+		if (child + 1 < q->count && actionBefore(&q->actions[child + 1], &q->actions[child])) child++;
+		if (!actionBefore(&q->actions[child], &last)) break;
+		q->actions[i] = q->actions[child];
+		i = child;
+	}
+	if (q->count > 0) q->actions[i] = last;
+	return top;
+}
+
+// *********************************************
+//    Timing model
+// *********************************************
+
+void RNSimRandomSeed(RNSimRandom *random, uint64_t seed)
+{
+	random->state		= seed;
+	random->spare		= 0.0;
+	random->hasSpare	= false;
+}
+
+static inline uint64_t randomNext(RNSimRandom *r)
+{
+	uint64_t z = (r->state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+double RNSimRandomUniform(RNSimRandom *r)
+{
+	return (randomNext(r) >> 11) * 0x1.0p-53;
+}
+
+double RNSimRandomGaussian(RNSimRandom *r)
+{
+	if (r->hasSpare) {
+		r->hasSpare = false;
+		return r->spare;
+	}
+	double u, v, s;
+	do {
+		u = 2.0 * RNSimRandomUniform(r) - 1.0;
+		v = 2.0 * RNSimRandomUniform(r) - 1.0;
+		s = u * u + v * v;
+	} while (s >= 1.0 || s == 0.0);
+	s = sqrt(-2.0 * log(s) / s);
+	r->spare = v * s;
+	r->hasSpare = true;
+	return u * s;
+}
+
+int64_t RNSimTimekeeperStart(RNSimTimekeeper *tk, const RNSimTapperParameters *p, double defaultPeriod_ns, int64_t time_ns, RNSimRandom *random)
+{
+	double preferred_ns = (p->period_ms > 0.0) ? p->period_ms * 1e6 : defaultPeriod_ns;
+	preferred_ns += p->periodSD_ms * 1e6 * RNSimRandomGaussian(random);
+	if (preferred_ns < 0.1 * defaultPeriod_ns) preferred_ns = 0.1 * defaultPeriod_ns;
+
+	tk->preferred_ns	= preferred_ns;
+	tk->period_ns		= preferred_ns;
+	tk->command_ns		= (double) time_ns + RNSimRandomUniform(random) * preferred_ns; // join at a random phase
+	tk->motor_ns		= p->motorSD_ms * 1e6 * RNSimRandomGaussian(random);
+
+	int64_t tap_ns = llround(tk->command_ns + tk->motor_ns);
+	return (tap_ns > time_ns) ? tap_ns : time_ns + 1;
+}
+
+int64_t RNSimTimekeeperNext(RNSimTimekeeper *tk, const RNSimTapperParameters *p, double weightedAsynchrony_ns, int64_t now_ns, RNSimRandom *random)
+{
+	double phaseCorrection_ns = p->alpha * weightedAsynchrony_ns;
+	phaseCorrection_ns = fmax(-tk->period_ns / 2.0, fmin(tk->period_ns / 2.0, phaseCorrection_ns));
+	tk->period_ns = fmax(0.5 * tk->preferred_ns, fmin(2.0 * tk->preferred_ns, tk->period_ns - p->beta * weightedAsynchrony_ns));
+
+	// Wing-Kristofferson: timekeeper interval plus the change in motor delay
+	double motor_ns	= p->motorSD_ms * 1e6 * RNSimRandomGaussian(random);
+	tk->command_ns	+= tk->period_ns + p->timekeeperSD_ms * 1e6 * RNSimRandomGaussian(random) - phaseCorrection_ns;
+	tk->motor_ns	= motor_ns;
+
+	int64_t tap_ns = llround(tk->command_ns + motor_ns);
+	if (tap_ns <= now_ns) { // can't tap in the past: restart the timekeeper from now
+		tap_ns = now_ns + 1;
+		tk->command_ns = (double) tap_ns - motor_ns;
+	}
+	return tap_ns;
+}
+
+// *********************************************
+//    Simulation state
+// *********************************************
+
+typedef struct {
+	bool		active;
+	bool		hasTapped;
+	RNSimTimekeeper timekeeper;
+	int64_t		lastTap_ns;
+	int64_t		heard[kRNSimMaxNodes + 1][kHeardHistory];	// by input (0: stimulus), ring
+	uint8_t		nextHeard[kRNSimMaxNodes + 1];
+} RNSimTapper;
+
+typedef struct {
+	const RNSimStimulus	*stimulus;
+	uint32_t			nSent;
+	int64_t				sent_ns;		// when the stimulus part started (events are sent then)
+	int64_t				lastOnset_ns;
+} RNSimStimulusRun;
+
+typedef struct {
+	int64_t		n;
+	double		mean, M2;
+} RNSimRunning;
+
+static inline void runningAdd(RNSimRunning *r, double x)
+{
+	r->n++;
+	double delta = x - r->mean;
+	r->mean += delta / r->n;
+	r->M2 += delta * (x - r->mean);
+}
+
+static inline double runningSD(const RNSimRunning *r)
+{
+	return (r->n > 1) ? sqrt(r->M2 / (r->n - 1)) : 0.0;
+}
+
+typedef struct {
+	const RNSimExperiment		*experiment;
+	const RNSimTapperParameters	*parameters;
+	RNSimOutput					*output;
+	RNSimQueue					queue;
+	RNSimRandom					random;
+	const RNSimNetwork			*network;
+	double						strength;
+	double						defaultPeriod_ns;
+	RNSimTapper					tapper[kRNSimMaxNodes + 1];
+	RNSimStimulusRun			*runs;
+	size_t						nRuns;
+	uint32_t					nextTapID;
+	RNSimRunning				ITI, stimulusAsynchrony, partnerAsynchrony;
+} RNSimState;
+
+static bool emit(RNSimState *s, RNEvent event)
+{
+	RNSimOutput *out = s->output;
+	if (!grow((void **) &out->events, &out->capacity, out->nEvents, sizeof(RNEvent))) return false;
+	out->events[out->nEvents++] = event;
+	return true;
+}
+
+static inline void hear(RNSimTapper *tapper, unsigned input, int64_t time_ns)
+{
+	tapper->heard[input][tapper->nextHeard[input]] = time_ns;
+	tapper->nextHeard[input] = (tapper->nextHeard[input] + 1) % kHeardHistory;
+}
+
+// the input's event nearest time_ns, if within window_ns of it
+static bool nearestHeard(const RNSimTapper *tapper, unsigned input, int64_t time_ns, int64_t window_ns, int64_t *heard_ns)
+{
+	int64_t best = INT64_MAX;
+	for (unsigned k = 0; k < kHeardHistory; k++) {
+		int64_t h = tapper->heard[input][k];
+		if (h == INT64_MIN) continue;
+		int64_t distance = llabs(time_ns - h);
+		if (distance <= window_ns && distance < best) {
+			best = distance;
+			*heard_ns = h;
+		}
+	}
+	return best != INT64_MAX;
+}
+
+static bool startTapper(RNSimState *s, unsigned node, int64_t time_ns)
+{
+	RNSimTapper *tapper = &s->tapper[node];
+	memset(tapper, 0, sizeof(RNSimTapper));
+	for (unsigned j = 0; j <= kRNSimMaxNodes; j++)
+		for (unsigned k = 0; k < kHeardHistory; k++)
+			tapper->heard[j][k] = INT64_MIN;
+	tapper->active = true;
+
+	int64_t tap_ns = RNSimTimekeeperStart(&tapper->timekeeper, s->parameters, s->defaultPeriod_ns, time_ns, &s->random);
+	RNSimAction tap = { .time_ns = tap_ns, .kind = kActionTap, .node = (uint8_t) node };
+	return queuePush(&s->queue, tap);
+}
+
+static bool runPart(RNSimState *s, const RNSimPart *part)
+{
+	switch (part->kind) {
+		case kPartNetwork: {
+			s->network = &s->experiment->networks[part->index];
+			for (unsigned node = 1; node <= kRNSimMaxNodes; node++) {
+				bool inNetwork = (node <= s->network->nNodes);
+				if (inNetwork && !s->tapper[node].active) {
+					if (!startTapper(s, node, part->start_ns)) return false;
+				} else if (!inNetwork) {
+					s->tapper[node].active = false; // its pending actions lapse
+				}
+			}
+			return true;
+		}
+		case kPartStimulus: {
+			RNSimStimulusRun *run = &s->runs[s->nRuns];
+			run->stimulus		= &s->experiment->stimuli[part->index];
+			run->nSent			= 0;
+			run->sent_ns		= part->start_ns;
+			run->lastOnset_ns	= part->start_ns + llround(run->stimulus->phase_ms * 1e6);
+			if (run->stimulus->nEvents == 0) return true;
+			RNSimAction onset = { .time_ns = run->lastOnset_ns, .kind = kActionOnset, .index = (uint32_t) s->nRuns++ };
+			return queuePush(&s->queue, onset);
+		}
+		case kPartStrength:
+			s->strength = part->strength;
+			return true;
+	}
+	return true;
+}
+
+static bool runOnset(RNSimState *s, const RNSimAction *action)
+{
+	RNSimStimulusRun *run = &s->runs[action->index];
+	const RNSimStimulus *stimulus = run->stimulus;
+	RNEvent event = {
+		.time_ns		= action->time_ns,
+		.sendTime_ns	= run->sent_ns,
+		.sourceID		= run->nSent,
+		.channel		= stimulus->MIDIChannel - 1,
+		.note			= stimulus->note,
+		.velocity		= kRNSimStimulusVelocity,
+		.kind			= kRNEventKindStimulus,
+	};
+
+	// one event per listener, as recorded (node 0 if nobody hears it)
+	unsigned nListeners = 0;
+	for (unsigned node = 1; s->network && node <= s->network->nNodes; node++) {
+		if (s->network->stimulusChannel[node] != stimulus->channel || s->network->weight[0][node] <= 0.0) continue;
+		hear(&s->tapper[node], 0, action->time_ns);
+		event.node = (uint16_t) node;
+		if (!emit(s, event)) return false;
+		nListeners++;
+	}
+	if (nListeners == 0) {
+		event.node = 0;
+		if (!emit(s, event)) return false;
+	}
+
+	if (++run->nSent >= stimulus->nEvents) return true;
+	double jitter_ns = (stimulus->jitter_ms != 0.0) ? stimulus->jitter_ms * 1e6 * (2.0 * RNSimRandomUniform(&s->random) - 1.0) : 0.0;
+	int64_t next_ns = run->lastOnset_ns + llround(stimulus->IOI_ms * 1e6 + jitter_ns);
+	run->lastOnset_ns = next_ns;
+	RNSimAction onset = { .time_ns = next_ns, .kind = kActionOnset, .index = action->index };
+	return queuePush(&s->queue, onset);
+}
+
+static bool runTap(RNSimState *s, const RNSimAction *action)
+{
+	RNSimTapper *tapper = &s->tapper[action->node];
+	if (!tapper->active) return true;
+	unsigned node = action->node;
+	uint32_t tapID = s->nextTapID++;
+
+	if (tapper->hasTapped) runningAdd(&s->ITI, (action->time_ns - tapper->lastTap_ns) / 1e6);
+	tapper->hasTapped	= true;
+	tapper->lastTap_ns	= action->time_ns;
+
+	RNEvent event = {
+		.time_ns		= action->time_ns,
+		.sendTime_ns	= action->time_ns,
+		.sourceID		= tapID,
+		.node			= (uint16_t) node,
+		.channel		= (uint8_t)(node - 1),
+		.note			= (uint8_t)(kRNSimBaseNote + node),
+		.velocity		= kRNSimTapVelocity,
+		.kind			= kRNEventKindTap,
+	};
+	if (!emit(s, event)) return false;
+
+	// through the network to each listener
+	for (unsigned to = 1; to <= s->network->nNodes; to++) {
+		if (s->network->weight[node][to] <= 0.0) continue;
+		double delay_ms = s->network->isDelay ? s->network->delay_ms[node][to] : 0.0;
+		RNSimAction delivery = {
+			.time_ns	= action->time_ns + llround(delay_ms * 1e6),
+			.kind		= kActionDelivery,
+			.node		= (uint8_t) to,
+			.source		= (uint8_t) node,
+			.index		= tapID,
+		};
+		if (!queuePush(&s->queue, delivery)) return false;
+	}
+
+	// settle the next tap once what happened around this one has been heard
+	RNSimAction decision = { .time_ns = action->time_ns + llround(tapper->timekeeper.period_ns / 2.0), .kind = kActionDecision, .node = (uint8_t) node };
+	return queuePush(&s->queue, decision);
+}
+
+static bool runDelivery(RNSimState *s, const RNSimAction *action)
+{
+	if (action->node > s->network->nNodes) return true;
+	double weight = s->network->weight[action->source][action->node];
+	hear(&s->tapper[action->node], action->source, action->time_ns);
+	double velocity = kRNSimTapVelocity * ((weight > 0.0) ? weight : 1.0) * s->strength;
+	RNEvent event = {
+		.time_ns		= action->time_ns,
+		.sendTime_ns	= action->time_ns,
+		.sourceID		= action->index,
+		.node			= action->node,
+		.channel		= (uint8_t)(action->node - 1),
+		.note			= (uint8_t)(kRNSimBaseNote + action->source),
+		.velocity		= (uint8_t) fmin(127.0, fmax(1.0, round(velocity))),
+		.kind			= kRNEventKindFeedback,
+		.flags			= s->network->isDelay ? 0 : kRNEventFlagMIOCRoute,
+	};
+	return emit(s, event);
+}
+
+static bool runDecision(RNSimState *s, const RNSimAction *action)
+{
+	unsigned node = action->node;
+	RNSimTapper *tapper = &s->tapper[node];
+	if (!tapper->active) return true;
+	const RNSimNetwork *network = s->network;
+	int64_t window_ns = llround(tapper->timekeeper.period_ns / 2.0);
+
+	// asynchronies of the last tap to each input
+	double weightedAsynchrony_ns = 0.0;
+	for (unsigned input = 0; input <= network->nNodes; input++) {
+		double weight = network->weight[input][node];
+		if (weight <= 0.0) continue;
+		int64_t heard_ns;
+		if (!nearestHeard(tapper, input, tapper->lastTap_ns, window_ns, &heard_ns)) continue;
+		double asynchrony_ns = (double)(tapper->lastTap_ns - heard_ns);
+		double gain = (input == 0) ? weight : weight * s->strength;
+		weightedAsynchrony_ns += gain * asynchrony_ns;
+		if (input == 0) runningAdd(&s->stimulusAsynchrony, asynchrony_ns / 1e6);
+		else if (input != node) runningAdd(&s->partnerAsynchrony, asynchrony_ns / 1e6);
+	}
+
+	int64_t tap_ns = RNSimTimekeeperNext(&tapper->timekeeper, s->parameters, weightedAsynchrony_ns, action->time_ns, &s->random);
+	RNSimAction tap = { .time_ns = tap_ns, .kind = kActionTap, .node = (uint8_t) node };
+	return queuePush(&s->queue, tap);
+}
+
+static int compareParts(const void *a, const void *b)
+{
+	const RNSimPart *x = a, *y = b;
+	if (x->start_ns != y->start_ns) return (x->start_ns > y->start_ns) - (x->start_ns < y->start_ns);
+	return (x->order > y->order) - (x->order < y->order);
+}
+
+bool RNSimulate(const RNSimExperiment *experiment, const RNSimTapperParameters *parameters, uint64_t seed, RNSimOutput *output)
+{
+	RNSimState s;
+	memset(&s, 0, sizeof(s));
+	s.experiment	= experiment;
+	s.parameters	= parameters;
+	s.output		= output;
+	s.strength		= 1.0;
+	RNSimRandomSeed(&s.random, seed);
+	s.defaultPeriod_ns = (experiment->nStimuli > 0) ? experiment->stimuli[0].IOI_ms * 1e6 : 500e6;
+	s.runs = calloc(experiment->nStimuli + 1, sizeof(RNSimStimulusRun));
+	RNSimPart *parts = malloc((experiment->nParts + 1) * sizeof(RNSimPart));
+	bool ok = (s.runs != NULL && parts != NULL);
+
+	if (ok) {
+		memcpy(parts, experiment->parts, experiment->nParts * sizeof(RNSimPart));
+		qsort(parts, experiment->nParts, sizeof(RNSimPart), compareParts);
+		for (size_t i = 0; ok && i < experiment->nParts; i++) {
+			RNSimAction action = { .time_ns = parts[i].start_ns, .kind = kActionPart, .index = (uint32_t) i };
+			ok = queuePush(&s.queue, action);
+		}
+	}
+
+	int64_t end_ns = llround(experiment->duration_s * 1e9);
+	while (ok && s.queue.count > 0) {
+		RNSimAction action = queuePop(&s.queue);
+		if (action.time_ns > end_ns) break;
+		switch (action.kind) {
+			case kActionPart:		ok = runPart(&s, &parts[action.index]); break;
+			case kActionOnset:		ok = runOnset(&s, &action); break;
+			case kActionTap:		ok = (s.network == NULL) || runTap(&s, &action); break;
+			case kActionDelivery:	ok = runDelivery(&s, &action); break;
+			case kActionDecision:	ok = runDecision(&s, &action); break;
+		}
+	}
+
+	RNSimSummary summary = {
+		.nTaps						= s.nextTapID,
+		.meanITI_ms					= s.ITI.mean,
+		.sdITI_ms					= runningSD(&s.ITI),
+		.nStimulusAsynchronies		= (uint64_t) s.stimulusAsynchrony.n,
+		.meanStimulusAsynchrony_ms	= s.stimulusAsynchrony.mean,
+		.sdStimulusAsynchrony_ms	= runningSD(&s.stimulusAsynchrony),
+		.nPartnerAsynchronies		= (uint64_t) s.partnerAsynchrony.n,
+		.meanPartnerAsynchrony_ms	= s.partnerAsynchrony.mean,
+		.sdPartnerAsynchrony_ms		= runningSD(&s.partnerAsynchrony),
+	};
+	output->summary = summary;
+
+	free(s.queue.actions);
+	free(s.runs);
+	free(parts);
+	return ok;
+}
+
+void RNSimOutputFree(RNSimOutput *output)
+{
+	free(output->events);
+	memset(output, 0, sizeof(RNSimOutput));
+}
@@ -0,0 +1,141 @@
+//
+//  RNSimulator.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Simulated sessions: the tappers of an experiment replaced by phase-correcting oscillators, to
+//	get a feel for a design (and sweep its parameters) before running it with people.
+//	- each tapper is a Wing-Kristofferson timekeeper with motor noise plus linear phase (alpha)
+//	  and period (beta) correction: half an interval after each tap it corrects its next one by
+//	  the asynchronies of that tap to the nearest event it heard from each input, scaled by the
+//	  connection weight (and the global connection strength)
+//	- the network is the experiment's own: per-connection weights and delays, which stimulus
+//	  channel each tapper hears, and network, stimulus and strength parts switching at their
+//	  start times, as the experiment would run them
+//	- output is the recorded event stream (taps, stimulus events per listener, feedback
+//	  deliveries), so sessions can be journaled and analyzed like real ones
+//	- a run is deterministic for a seed and touches no shared state, so runs can go in parallel
+//
+// Plain C: also built into Tools/rnsimulate and Tools/rnloadbench.
+
+#ifndef RNSimulator_h
+#define RNSimulator_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNEventStore.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNSimMaxNodes			16		// tappers 1..16; node 0 is big brother (kMaxNodes)
+#define kRNSimMaxChannels		16		// stimulus channels 1..16
+#define kRNSimBaseNote			64		// RNArchitectureDefines.h kBaseNote
+#define kRNSimStimulusVelocity	90		// RNArchitectureDefines.h kStimulusNoteVelocity
+#define kRNSimTapVelocity		100
+
+// One network definition. weight[from][to] > 0 is a connection (from 0: stimulus, see channel).
+typedef struct {
+	unsigned	nNodes;
+	double		weight[kRNSimMaxNodes + 1][kRNSimMaxNodes + 1];
+	double		delay_ms[kRNSimMaxNodes + 1][kRNSimMaxNodes + 1];
+	uint8_t		stimulusChannel[kRNSimMaxNodes + 1];	// channel a tapper hears (0: none)
+	bool		isDelay;	// routed through the computer (else through the MIOC: no delays)
+} RNSimNetwork;
+
+// One stimulus, as in its definition string
+typedef struct {
+	uint8_t		channel;		// stimulus channel 1..16
+	uint8_t		MIDIChannel;	// 1-based
+	uint8_t		note;
+	uint32_t	nEvents;
+	double		IOI_ms;
+	double		phase_ms;
+	double		jitter_ms;		// each onset after the first: previous + IOI + uniform(-jitter, jitter)
+} RNSimStimulus;
+
+typedef struct {
+	double		alpha;				// phase correction per unit weight
+	double		beta;				// period correction per unit weight
+	double		period_ms;			// preferred period; <= 0: the first stimulus' IOI (500 ms if none)
+	double		periodSD_ms;		// spread of preferred periods across tappers
+	double		timekeeperSD_ms;
+	double		motorSD_ms;
+} RNSimTapperParameters;
+
+// The timing model, also driving live agents (RNVirtualTappers)
+
+// splitmix64, with normals by Box-Muller: small, fast, and good enough for noise
+typedef struct {
+	uint64_t	state;
+	double		spare;
+	bool		hasSpare;
+} RNSimRandom;
+
+void			RNSimRandomSeed(RNSimRandom *random, uint64_t seed);
+double			RNSimRandomUniform(RNSimRandom *random);	// [0, 1)
+double			RNSimRandomGaussian(RNSimRandom *random);	// N(0, 1)
+
+typedef struct {
+	double		preferred_ns;
+	double		period_ns;
+	double		command_ns;		// timekeeper command behind the last tap
+	double		motor_ns;		// motor noise of the last tap
+} RNSimTimekeeper;
+
+// Join at a random phase from time_ns (preferred period: parameters', else defaultPeriod_ns). Returns the first tap time.
+int64_t			RNSimTimekeeperStart(RNSimTimekeeper *timekeeper, const RNSimTapperParameters *parameters,
+									 double defaultPeriod_ns, int64_t time_ns, RNSimRandom *random);
+// Next tap, correcting for the last one's asynchronies (tap - heard) summed with their connection
+//	gains. Never at or before now_ns.
+int64_t			RNSimTimekeeperNext(RNSimTimekeeper *timekeeper, const RNSimTapperParameters *parameters,
+									double weightedAsynchrony_ns, int64_t now_ns, RNSimRandom *random);
+
+typedef struct {
+	uint64_t	nTaps;
+	double		meanITI_ms, sdITI_ms;
+	uint64_t	nStimulusAsynchronies;		// taps with a stimulus event within half a period
+	double		meanStimulusAsynchrony_ms, sdStimulusAsynchrony_ms;
+	uint64_t	nPartnerAsynchronies;		// tap against the nearest heard tap of each other input
+	double		meanPartnerAsynchrony_ms, sdPartnerAsynchrony_ms;
+} RNSimSummary;
+
+typedef struct {
+	RNEvent		*events;		// in time order
+	size_t		nEvents, capacity;
+	RNSimSummary summary;
+} RNSimOutput;
+
+typedef struct RNSimExperiment RNSimExperiment;
+
+RNSimExperiment	*RNSimExperimentCreate(double duration_s);
+void			RNSimExperimentDestroy(RNSimExperiment *experiment);
+
+// Parts, in any order (they are run in start time order; equal times in the order added)
+bool			RNSimExperimentAddNetwork(RNSimExperiment *experiment, double start_s, const RNSimNetwork *network);
+bool			RNSimExperimentAddStimulus(RNSimExperiment *experiment, double start_s, RNSimStimulus stimulus);
+bool			RNSimExperimentAddStrength(RNSimExperiment *experiment, double start_s, double strength);
+double			RNSimExperimentDuration(const RNSimExperiment *experiment);
+unsigned		RNSimExperimentNodeCount(const RNSimExperiment *experiment);	// most tappers in any network
+
+// Definition strings, as RNConnection and RNStimulus read them:
+//	"{from, to}weight,delay" (from 0.0k: stimulus channel k) and
+//	"channel: MIDIchannel(note), IOI=..., events=...[, phase=...[, jitter=...]]"
+bool			RNSimNetworkAddConnectionString(RNSimNetwork *network, const char *string);
+bool			RNSimStimulusFromString(const char *string, RNSimStimulus *stimulus);
+
+// One session. Events are appended to output (reusable across runs: reset with nEvents = 0).
+//	Returns false if out of memory.
+bool			RNSimulate(const RNSimExperiment *experiment, const RNSimTapperParameters *parameters,
+						   uint64_t seed, RNSimOutput *output);
+void			RNSimOutputFree(RNSimOutput *output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNSimulator_h */
@@ -7,6 +7,8 @@
 //
 
 #import <Foundation/Foundation.h>
+#import "RNTimingStats.h"
+#import "RNStimulusStream.h"
 
 @interface RNStimulus : NSObject
 {
@@ -19,8 +21,15 @@
 	double		_IOI_ms;
 	double		_jitter_ms;	// if non-zero, jitter:pick ioi uniformly between ioi-jitter & ioi+jitter
 	double		_startPhase_ms;
-	int			_nEvents;
+	int			_nEvents;	// 0: plays until cancelled
+	uint64_t	_seed;			// of its jitter: the same seed, the same onsets
+	BOOL		_isPlanned;		// eventTimes and _onsetIndex are the nominal onsets for the current parameters and seed
 	NSString	*_eventTimes;	// \n sep list of requested stimulus times (rel to experiment start), String easier for matlab
+	RNOnsetIndex *_onsetIndex;	// the same times, sorted, for timing taps (NULL until planned)
+	RNStimulusStreamID _stream;	// while playing (MIDIIO startStimulusStream:)
+	uint32_t	_adaptiveNodes;	// if non-zero, adaptive pacer (RNAdaptivePacer.h): these nodes' taps steer its onsets
+	double		_alpha;			// its phase correction
+	double		_beta;			// and period correction
 }
 
 - (RNStimulus *)initWithStimulusNumber:(Byte)stimChannel MIDIChannel:(Byte)channel Note:(Byte)note StartTime:(double)startTime IOI:(double)IOI StartPhase:(double)startPhase Count:(int)nEvents;
@@ -28,20 +37,32 @@
 
 - (void)setStartTimeSeconds:(NSTimeInterval)startTime_s;
 - (void)setJitter:(double)jitter_ms;
+- (void)setSeed:(uint64_t)seed;	// and plans the onsets: call once the rest is set
+- (void)setAdaptiveNodes:(uint32_t)nodes alpha:(double)alpha beta:(double)beta;
 
 - (Byte)stimulusChannel;
 - (Byte)MIDIChannel;
 - (double)startTime_ms;
 - (double)IOI_ms;
 - (double)jitter_ms;
+- (uint64_t)seed;
 - (double)startPhase_ms;
 - (int)nEvents;
+- (BOOL)isAdaptive;
+- (uint32_t)adaptiveNodes;
+- (double)alpha;
+- (double)beta;
 - (NSString *)eventTimes;
 - (void)setEventTimes:(NSString *)eventStr;
 
+- (RNTimingPacer)timingPacer;	// onsets relative to experiment start; the stimulus owns pacer.onsets (retain to keep)
+- (RNOnsetMatch)onsetMatchForNanoseconds:(UInt64)time_ns;
 - (double)asynchronyForNanoseconds:(UInt64)time_ns;
 - (UInt64)experimentStartTime;
 
-- (NSData *)MIDIPacketListForExperimentStartTime:(UInt64)experimentStartTime_ns;
+- (RNStimulusStreamDefinition)streamDefinitionForExperimentStartTime:(UInt64)experimentStartTime_ns;
+- (void)replanFromGenerator:(const RNOnsetGenerator *)generator;
+- (RNStimulusStreamID)stream;
+- (void)setStream:(RNStimulusStreamID)stream;
 
 @end
@@ -10,8 +10,9 @@
 
 #import "RNTapperNode.h"
 #import <CoreAudio/HostTime.h>
-#import <CoreMIDI/MIDIServices.h>
 #import "RNArchitectureDefines.h"
+#import "RNEventFormat.h"
+#import "RNVirtualTappers.h"
 
 @implementation RNStimulus
 
@@ -30,16 +31,20 @@
 	_startPhase_ms			= startPhase;
 	_nEvents				= nEvents;
 	_jitter_ms				= 0;
+	_seed					= AudioGetCurrentHostTime(); //unless an experiment seeds it
+	_stream					= kRNStimulusInvalidStream;
 	
 	return self;
 }
 
-// string format:  stimulus#: MIDIchannel(note), IOI, duration, phase, jitter 
+// string format:  stimulus#: MIDIchannel(note), IOI, duration, then optionally phase, jitter, adaptive pacing
 // (e.g. "1: 16(64), IOI=1000.0, events=10, phase=400.0, jitter=50.0")
+//	adaptive: "adapt=1-4+7, alpha=0.5, beta=0.1" (nodes whose taps steer it, phase and period correction)
 - (RNStimulus *) initWithString: (NSString *) initString
 {
 	int		stimChannel, MIDIChannel, note, nEvents;
-	double	startTime = 0.0, IOI, startPhase = 0.0, jitter = 0.0;
+	double	startTime = 0.0, IOI, startPhase = 0.0, jitter = 0.0, alpha = 0.0, beta = 0.0;
+	uint32_t adaptiveNodes = 0;
 	NSScanner *theScanner;
 	
 	theScanner		= [NSScanner scannerWithString:initString];
@@ -55,17 +60,26 @@
 		[theScanner scanString:@"," intoString:NULL] &&
 		[theScanner scanString:@"events=" intoString:NULL] &&
 		[theScanner scanInt:&nEvents]) {
-		//successful scan of necessary elements, now check for optional ones
-		if ([theScanner isAtEnd] == NO) { //phase is optional
-			if ([theScanner scanString:@"," intoString:NULL] &&
-				[theScanner scanString:@"phase=" intoString:NULL] &&
-				[theScanner scanDouble:&startPhase] == NO) {
-				startPhase = 0.0; //didn't find phase, no chance of finding jitter
-			} else { //found phase, now look for optional jitter
-				if ([theScanner scanString:@"," intoString:NULL] &&
-					[theScanner scanString:@"jitter=" intoString:NULL] &&
-					[theScanner scanDouble:&jitter] == NO)	jitter = 0.0; //didn't find jitter
-			} 
+		//successful scan of necessary elements, now check for optional ones (key=value, any order)
+		NSCharacterSet *nodeCharacters = [NSCharacterSet characterSetWithCharactersInString:@"0123456789-+"];
+		NSString *key, *nodes;
+		while ([theScanner isAtEnd] == NO &&
+			   [theScanner scanString:@"," intoString:NULL] &&
+			   [theScanner scanUpToString:@"=" intoString:&key] &&
+			   [theScanner scanString:@"=" intoString:NULL]) {
+			BOOL ok;
+			if ([key isEqualToString:@"phase"])			ok = [theScanner scanDouble:&startPhase];
+			else if ([key isEqualToString:@"jitter"])	ok = [theScanner scanDouble:&jitter];
+			else if ([key isEqualToString:@"alpha"])	ok = [theScanner scanDouble:&alpha];
+			else if ([key isEqualToString:@"beta"])		ok = [theScanner scanDouble:&beta];
+			else if ([key isEqualToString:@"adapt"]) { //node list, ranges joined by + (commas separate fields)
+				uint64_t mask = 0;
+				ok = [theScanner scanCharactersFromSet:nodeCharacters intoString:&nodes] &&
+					 RNVirtualTappersParseNodes([[nodes stringByReplacingOccurrencesOfString:@"+" withString:@","] UTF8String], &mask) &&
+					 (mask >> (kMaxNodes + 1)) == 0;
+				adaptiveNodes = (uint32_t) mask;
+			} else ok = NO;
+			NSAssert2(ok, @"Error parsing stimulus string at '%@': %@", key, initString);
 		}
 	} else {
 		//we've had a scan error if we make it here
@@ -78,18 +92,42 @@
 	
 	self = [self initWithStimulusNumber:stimChannel MIDIChannel:MIDIChannel Note:note StartTime:startTime IOI:IOI StartPhase:startPhase Count:nEvents];
 	[self setJitter:jitter];
+	[self setAdaptiveNodes:adaptiveNodes alpha:alpha beta:beta];
 	return self;
 	
 }
 
+- (void) dealloc
+{
+	[_eventTimes release];
+	RNOnsetIndexRelease(_onsetIndex);
+	[super dealloc];
+}
+
 - (void) setStartTimeSeconds: (NSTimeInterval) startTime_s
 {
 	_relativeStartTime_ms = startTime_s * 1000.0;
+	_isPlanned = NO;
 }
 
 - (void) setJitter: (double) jitter_ms
 {
 	_jitter_ms = jitter_ms;
+	_isPlanned = NO;
+}
+
+- (void) setSeed: (uint64_t) seed
+{
+	_seed = seed;
+	[self planOnsets];
+}
+
+- (void) setAdaptiveNodes: (uint32_t) nodes alpha: (double) alpha beta: (double) beta
+{
+	_adaptiveNodes	= nodes;
+	_alpha			= alpha;
+	_beta			= beta;
+	_isPlanned		= NO;
 }
 
 - (Byte) stimulusChannel { return _stimulusChannel; }
@@ -97,8 +135,13 @@
 - (double) startTime_ms { return _relativeStartTime_ms; }
 - (double) IOI_ms { return _IOI_ms; }
 - (double) jitter_ms { return _jitter_ms; }
+- (uint64_t) seed { return _seed; }
 - (double) startPhase_ms { return _startPhase_ms; }
 - (int) nEvents { return _nEvents; }
+- (BOOL) isAdaptive { return _adaptiveNodes != 0; }
+- (uint32_t) adaptiveNodes { return _adaptiveNodes; }
+- (double) alpha { return _alpha; }
+- (double) beta { return _beta; }
 - (NSString *) eventTimes { return _eventTimes; }
 - (void) setEventTimes: (NSString *) eventStr
 {
@@ -107,19 +150,29 @@
 	_eventTimes = [eventStr copy];
 }
 	
-// TO DO: calculate relative to actual eventTimes
+// nominal onsets, relative to experiment start, plus the planned ones (with jitter) once planned
+- (RNTimingPacer) timingPacer
+{
+	RNTimingPacer pacer = {
+		.onset_ns	= llround(1000000.0 * ([self startTime_ms] + [self startPhase_ms])),
+		.IOI_ns		= llround(1000000.0 * [self IOI_ms]),
+		.onsets		= _onsetIndex,
+	};
+	return pacer;
+}
+
+// nearest scheduled onset to a tap: its number, asynchrony and local IOI
+// time_ns is realtime
+- (RNOnsetMatch) onsetMatchForNanoseconds: (UInt64) time_ns
+{
+	SInt64 relativeTime_ns = (SInt64) (time_ns - _experimentStartTime_ns);
+	return RNTimingPacerMatch([self timingPacer], relativeTime_ns, NULL);
+}
+
 // time_ns is realtime
 - (double) asynchronyForNanoseconds: (UInt64) time_ns
 {
-	UInt64 stimStartTime_ns;
-	double timeSinceStimStart_ms, asynchrony_ms, junk;
-	
-	stimStartTime_ns = (UInt64) roundf( 1000000.0 * ([self startTime_ms] + [self startPhase_ms]) ) \
-		+ _experimentStartTime_ns;
-	timeSinceStimStart_ms = (time_ns - stimStartTime_ns) / 1000000.0;
-	asynchrony_ms = [self IOI_ms] * (modf( (timeSinceStimStart_ms / [self IOI_ms]) + 0.5 , &junk) - 0.5);
-	
-	return asynchrony_ms;
+	return [self onsetMatchForNanoseconds:time_ns].asynchrony_ns / 1000000.0;
 }
 
 - (UInt64) experimentStartTime
@@ -129,91 +182,103 @@
 
 - (NSString *) description
 {
-	return [NSString stringWithFormat:@"@T+%.1fs: #%d: %d(%d):IOI=%.1f, events=%d, phase=%.1f, jitter=%.1f", \
+	NSString *description = [NSString stringWithFormat:@"@T+%.1fs: #%d: %d(%d):IOI=%.1f, events=%d, phase=%.1f, jitter=%.1f", \
 		_relativeStartTime_ms / 1000.0, _stimulusChannel, _MIDIChannel, _note, _IOI_ms, _nEvents, _startPhase_ms, _jitter_ms];
+	if ([self isAdaptive])
+		description = [description stringByAppendingFormat:@", adapt=0x%05x, alpha=%.2f, beta=%.2f", _adaptiveNodes, _alpha, _beta];
+	return description;
 }
 
-- (NSData *) MIDIPacketListForExperimentStartTime: (UInt64) experimentStartTime_ns
+- (RNStimulusStreamID) stream { return _stream; }
+- (void) setStream: (RNStimulusStreamID) stream { _stream = stream; }
+
+// what the stimulus plays, for streaming from experimentStartTime_ns (MIDIIO startStimulusStream:). Onsets are
+//	generated as they are sent, from the same seed as the plan (setSeed:), so the same times offset by the start:
+//	nothing is worked out here unless a parameter has changed since. An adaptive stimulus decides its onsets as
+//	it plays (without jitter), so has none planned: they are recorded as sent. listeners is left to the caller
+- (RNStimulusStreamDefinition) streamDefinitionForExperimentStartTime: (UInt64) experimentStartTime_ns
 {
-	MIDIPacket	*curPkt;
-	Byte onMessage[3], offMessage[3];
-	size_t packetListLength = 8192; //big enough for ~500 events
-	MIDIPacketList *packetList = malloc(packetListLength);
-	NSMutableString *eventStr = [NSMutableString stringWithCapacity:1024];
-	
-	UInt64 eventOnTime_ns, eventOffTime_ns, stimStartTime_ns, IOI_ns, noteDuration_ns, previousEventTime_ns;
-	MIDITimeStamp eventTimeStamp;
-	
 	_experimentStartTime_ns = experimentStartTime_ns; //keep it around
+	if (!_isPlanned)
+		[self planOnsets];
 	
-	//internal time calculations are in ns, convert to hosttime only at end
-	stimStartTime_ns = (UInt64) roundf( 1000000.0 * (_relativeStartTime_ms + _startPhase_ms) ) + experimentStartTime_ns;
-	IOI_ns = (UInt64) roundf( 1000000.0 * _IOI_ms );
-	noteDuration_ns = (UInt64) roundf (1000000.0 * _noteDuration_ms );
-	
-	//note on and off MIDI messages
-	onMessage[0] = 0x90 + (_MIDIChannel - 1); //NB convert to MIDI 0-based index
-	onMessage[1] = _note;
-	onMessage[2] = kStimulusNoteVelocity;
-	
-	offMessage[0] = onMessage[0];
-	offMessage[1] = onMessage[1];
-	offMessage[2] = 0;
-	
-	//random seed
-	srand( (unsigned) time(NULL) );
-	double urand;
-	SInt64 jitter;
-	
-	//assemble packet list of all stimulus events
-	curPkt = MIDIPacketListInit(packetList);
+	RNStimulusStreamDefinition definition = {
+		.channel			= _MIDIChannel - 1, //NB convert to MIDI 0-based index
+		.note				= _note,
+		.velocity			= kStimulusNoteVelocity,
+		.stimulusChannel	= _stimulusChannel,
+		.noteDuration_ns	= kDoEmitNoteOff ? llround(1000000.0 * _noteDuration_ms) : 0,
+		.adaptive = {
+			.sources	= _adaptiveNodes,
+			.alpha		= _alpha,
+			.beta		= _beta,
+			.minIOI_ns	= llround(1000000.0 * _IOI_ms / 2.0),
+			.maxIOI_ns	= llround(1000000.0 * _IOI_ms * 2.0),
+		},
+	};
+	RNOnsetGeneratorInit(&definition.generator, (int64_t) experimentStartTime_ns + [self firstOnset_ns], llround(1000000.0 * _IOI_ms),
+						 [self isAdaptive] ? 0 : llround(1000000.0 * _jitter_ms), (_nEvents > 0) ? (uint32_t) _nEvents : 0, _seed);
+	return definition;
+}
 
-	previousEventTime_ns = stimStartTime_ns - IOI_ns; //one event prior to start
-	
-	unsigned int iEvent;
-	for (iEvent = 0; iEvent < _nEvents; iEvent++) {
-		
-		//calculate jitter (in ns)--first event: no jitter
-		if (iEvent == 0 || _jitter_ms == 0.0)  
-			jitter = 0.0;
-		else {
-			urand = (double) rand() / RAND_MAX; //unit random
-			urand = 2.0 * (urand - 0.5);
-			jitter = (SInt64) roundf( _jitter_ms * 1000000.0 * urand );
-		}
+// after a tempo change: the onsets already taken stay as planned, the rest follow the generator. No longer
+//	the nominal plan, so the next play plans afresh
+- (void) replanFromGenerator: (const RNOnsetGenerator *) generator
+{
+	if (_nEvents <= 0 || [self isAdaptive]) return;
+	_IOI_ms = generator->IOI_ns / 1000000.0;
+	SInt64 *relativeEventTimes_ns = malloc(_nEvents * sizeof(SInt64));
+	uint32_t nEvents = (_onsetIndex != NULL) ? MIN(generator->taken, RNOnsetIndexCount(_onsetIndex)) : 0;
+	if (nEvents > 0)
+		memcpy(relativeEventTimes_ns, RNOnsetIndexOnsets(_onsetIndex), nEvents * sizeof(SInt64));
+	RNOnsetGenerator rest = *generator;
+	while (nEvents < (uint32_t) _nEvents && RNOnsetGeneratorHasNext(&rest))
+		relativeEventTimes_ns[nEvents++] = RNOnsetGeneratorNext(&rest) - (SInt64) _experimentStartTime_ns;
+	[self setPlannedOnsets:relativeEventTimes_ns count:nEvents];
+	free(relativeEventTimes_ns);
+	_isPlanned = NO;
+}
 
-		//noteOn
-		//eventTime_ns = stimStartTime_ns + (iEvent * IOI_ns) + jitter; //old way, actually is jittered asynchrony, not IOI
-		eventOnTime_ns = previousEventTime_ns + (IOI_ns + jitter);
-		previousEventTime_ns = eventOnTime_ns;
-		eventTimeStamp = AudioConvertNanosToHostTime(eventOnTime_ns);
-		curPkt = MIDIPacketListAdd(packetList,packetListLength,curPkt,eventTimeStamp,3,onMessage);
-		
-		if (kDoEmitNoteOff) {
-			//noteOff
-			eventOffTime_ns = eventOnTime_ns + noteDuration_ns;
-			eventTimeStamp = AudioConvertNanosToHostTime(eventOffTime_ns);
-			curPkt = MIDIPacketListAdd(packetList,packetListLength,curPkt,eventTimeStamp,3,offMessage);
-		}
-		
-		NSAssert2( (curPkt != NULL), @"Packet List overflow (after %d events of %d)", iEvent, _nEvents);
-		
-		//stuff event time into eventTimes string
-		[eventStr appendFormat:@"%qi\n", (eventOnTime_ns - experimentStartTime_ns)];
+// first onset, relative to experiment start
+- (SInt64) firstOnset_ns
+{
+	return llround(1000000.0 * (_relativeStartTime_ms + _startPhase_ms));
+}
+
+// the nominal onsets, relative to experiment start, filled in one pass from the seed (integer ns throughout, so
+//	exactly what the generator will play once offset by the start)
+- (void) planOnsets
+{
+	_isPlanned = YES;
+	if (_nEvents <= 0 || [self isAdaptive]) { //endless or adaptive: nothing to plan, the pacer is periodic
+		[self setPlannedOnsets:NULL count:0];
+		return;
+	}
+	SInt64 *relativeEventTimes_ns = malloc(_nEvents * sizeof(SInt64));
+	RNOnsetTableFill((int64_t *) relativeEventTimes_ns, (uint32_t) _nEvents, [self firstOnset_ns], llround(1000000.0 * _IOI_ms),
+					 llround(1000000.0 * _jitter_ms), _seed);
+	[self setPlannedOnsets:relativeEventTimes_ns count:(uint32_t) _nEvents];
+	free(relativeEventTimes_ns);
+}
+
+// eventTimes and the onset index
+- (void) setPlannedOnsets: (const SInt64 *) relativeEventTimes_ns count: (uint32_t) nEvents
+{
+	RNOnsetIndexRelease(_onsetIndex); //pacers already handed out keep their own reference
+	_onsetIndex = NULL;
+	if (nEvents == 0) {
+		[self setEventTimes:@""];
+		return;
 	}
 	
-	// stash eventStr
+	// stash event times as a \n separated string
+	size_t capacity = nEvents * RNEventFormatMaxRowLength(0);
+	char *eventBuf = malloc(capacity + 1);
+	size_t length = RNFormatTimeList(eventBuf, capacity, (const int64_t *) relativeEventTimes_ns, nEvents, NULL);
+	NSString *eventStr = [[NSString alloc] initWithBytesNoCopy:eventBuf length:length encoding:NSASCIIStringEncoding freeWhenDone:YES];
 	[self setEventTimes:eventStr];
-	
-	//calculate actual packetListLength
-	//	curPkt points to the last one added, so add the length of the last packet
-	packetListLength = (size_t) curPkt - (size_t) packetList + 
-		sizeof(MIDITimeStamp) + sizeof(UInt16) + 3;
-	
-	//wrap
-	NSData *wrappedPacketList = [NSData dataWithBytes:packetList length:packetListLength];
-	free(packetList);
-	return wrappedPacketList;
+	[eventStr release];
+	_onsetIndex = RNOnsetIndexCreate((const int64_t *) relativeEventTimes_ns, nEvents);
 }
 
 @end
@@ -0,0 +1,538 @@
+//
+//  RNStimulusStream.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNStimulusStream.h"
+#include "RNHostClock.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
+
+#define kCommandMask	(kRNStimulusCommandLength - 1)
+#define kTapMask		(kRNStimulusTapRingLength - 1)
+#define kDecisionMask	(kRNStimulusDecisionLength - 1)
+#define kSlotBits		8
+#define kSlotMask		((1 << kSlotBits) - 1)
+
+// *********************************************
+//    Onsets
+// *********************************************
+
+void RNOnsetGeneratorInit(RNOnsetGenerator *generator, int64_t first_ns, int64_t IOI_ns, int64_t jitter_ns,
+						  uint32_t count, uint64_t seed)
+{
+	memset(generator, 0, sizeof(RNOnsetGenerator));
+	generator->next_ns		= first_ns;
+	generator->previous_ns	= first_ns - IOI_ns;
+	generator->IOI_ns		= IOI_ns;
+	generator->jitter_ns	= (jitter_ns > 0) ? jitter_ns : 0;
+	generator->count		= count;
+	generator->seed			= seed;
+}
+
+int64_t RNOnsetGeneratorNext(RNOnsetGenerator *generator)
+{
+	int64_t onset_ns = generator->next_ns;
+	generator->previous_ns = onset_ns;
+	generator->taken++;
+	generator->nextJitter_ns = RNOnsetJitter(generator->seed, generator->taken, generator->jitter_ns);
+	generator->next_ns = onset_ns + generator->IOI_ns + generator->nextJitter_ns;
+	return onset_ns;
+}
+
+void RNOnsetGeneratorSetIOI(RNOnsetGenerator *generator, int64_t IOI_ns)
+{
+	generator->IOI_ns	= IOI_ns;
+	generator->next_ns	= generator->previous_ns + IOI_ns + generator->nextJitter_ns;
+}
+
+void RNOnsetTableFill(int64_t *onsets_ns, uint32_t nOnsets, int64_t first_ns, int64_t IOI_ns, int64_t jitter_ns, uint64_t seed)
+{
+	if (jitter_ns < 0) jitter_ns = 0;
+	int64_t onset_ns = first_ns;
+	for (uint32_t i = 0; i < nOnsets; i++) {
+		if (i > 0) onset_ns += IOI_ns + RNOnsetJitter(seed, i, jitter_ns);
+		onsets_ns[i] = onset_ns;
+	}
+}
+
+// *********************************************
+//    Scheduler
+// *********************************************
+
+typedef enum {
+	kCommandStart,
+	kCommandCancel,
+	kCommandCancelAll,
+	kCommandSetIOI,
+} RNStreamCommandType;
+
+// SetIOI's answer, on its caller's stack: written by the scheduler before it releases the command
+typedef struct {
+	RNOnsetGenerator	generator;
+	bool				playing;
+} RNStreamAcknowledgement;
+
+typedef struct {
+	RNStreamCommandType			type;
+	RNStimulusStreamID			stream;
+	int64_t						IOI_ns;
+	RNStimulusStreamDefinition	definition;
+	RNStreamAcknowledgement		*acknowledgement;	// SetIOI
+} RNStreamCommand;
+
+typedef struct {
+	bool						playing;
+	bool						decided;	// adaptive: the generator's next onset is final
+	RNStimulusStreamID			stream;
+	RNStimulusStreamDefinition	definition;
+} RNStream;
+
+typedef struct {
+	int64_t		time_ns;
+	uint16_t	node;
+} RNStreamTap;
+
+struct RNStimulusScheduler {
+	int64_t					lookahead_ns;
+	RNStimulusSendProc		sendProc;
+	void					*refCon;
+	pthread_t				thread;
+	_Atomic(bool)			running;
+
+	// the scheduler sleeps on wake until its next poll or decision, or until a control thread has a command
+	//	for it; cancel and SetIOI wait on taken until the scheduler has taken theirs
+	pthread_mutex_t			lock;
+	pthread_cond_t			wake;
+	pthread_cond_t			taken;
+	bool					wakePending;	// under lock
+
+	// control threads -> scheduler
+	RNStreamCommand			commands[kRNStimulusCommandLength];
+	_Atomic(uint32_t)		commandHead;	// control threads, under lock (free running, wraps)
+	_Atomic(uint32_t)		commandTail;	// scheduler only
+
+	// a slot is claimed by a control thread when it starts a stream, released by the scheduler when it ends
+	_Atomic(RNStimulusStreamID)	slotStream[kRNStimulusMaxStreams];	// kRNStimulusInvalidStream: free
+	uint32_t				nextSerial;		// under lock
+
+	// MIDI processing thread -> scheduler
+	RNStreamTap				taps[kRNStimulusTapRingLength];
+	_Atomic(uint32_t)		tapHead;
+	_Atomic(uint32_t)		tapTail;
+
+	// scheduler -> consumer
+	RNPacerDecision			decisions[kRNStimulusDecisionLength];
+	_Atomic(uint32_t)		decisionHead;
+	_Atomic(uint32_t)		decisionTail;
+
+	// scheduler only
+	RNStream				streams[kRNStimulusMaxStreams];
+	RNStimulusOnset			batch[kRNStimulusBatchLength];
+	RNAdaptiveTaps			recentTaps;
+
+	_Atomic(uint64_t)		nOnsets;
+	_Atomic(uint64_t)		nStreams;
+	_Atomic(uint64_t)		nLate;
+	_Atomic(int64_t)		maxLateness_ns;
+	_Atomic(int64_t)		minLead_ns;
+	_Atomic(uint64_t)		nDecisions;
+	_Atomic(uint64_t)		nDecisionsDropped;
+	_Atomic(uint64_t)		nTapsDropped;
+	_Atomic(int64_t)		maxDecisionLatency_ns;
+	_Atomic(int64_t)		maxDecisionTime_ns;
+};
+
+static inline unsigned slotOf(RNStimulusStreamID stream)
+{
+	return (unsigned)(stream & kSlotMask);
+}
+
+static inline bool isValidStream(RNStimulusStreamID stream)
+{
+	return stream >= 0 && slotOf(stream) < kRNStimulusMaxStreams;
+}
+
+static void endStream(RNStimulusScheduler *scheduler, RNStream *s)
+{
+	s->playing = false;
+	atomic_store_explicit(&scheduler->slotStream[slotOf(s->stream)], kRNStimulusInvalidStream, memory_order_release);
+}
+
+static uint32_t takeCommands(RNStimulusScheduler *scheduler)
+{
+	uint32_t head = atomic_load_explicit(&scheduler->commandHead, memory_order_acquire);
+	uint32_t tail = atomic_load_explicit(&scheduler->commandTail, memory_order_relaxed);
+	uint32_t nTaken = head - tail;
+	for (; tail != head; tail++) {
+		const RNStreamCommand *command = &scheduler->commands[tail & kCommandMask];
+		RNStream *s = isValidStream(command->stream) ? &scheduler->streams[slotOf(command->stream)] : NULL;
+		bool isCurrent = s != NULL && s->playing && s->stream == command->stream;
+		switch (command->type) {
+			case kCommandStart:
+				s->playing		= true;
+				s->decided		= true;	// the first onset is as planned
+				s->stream		= command->stream;
+				s->definition	= command->definition;
+				atomic_fetch_add_explicit(&scheduler->nStreams, 1, memory_order_relaxed);
+				break;
+			case kCommandCancel:
+				if (isCurrent) endStream(scheduler, s);
+				break;
+			case kCommandCancelAll:
+				for (unsigned slot = 0; slot < kRNStimulusMaxStreams; slot++)
+					if (scheduler->streams[slot].playing) endStream(scheduler, &scheduler->streams[slot]);
+				break;
+			case kCommandSetIOI:
+				if (isCurrent) RNOnsetGeneratorSetIOI(&s->definition.generator, command->IOI_ns);
+				command->acknowledgement->generator	= isCurrent ? s->definition.generator : (RNOnsetGenerator) { 0 };
+				command->acknowledgement->playing	= isCurrent;
+				break;
+		}
+	}
+	atomic_store_explicit(&scheduler->commandTail, tail, memory_order_release);
+	return nTaken;
+}
+
+static inline void atomicMax(_Atomic(int64_t) *value, int64_t candidate)
+{
+	if (candidate > atomic_load_explicit(value, memory_order_relaxed))
+		atomic_store_explicit(value, candidate, memory_order_relaxed);	// scheduler is the only writer
+}
+
+// the generator's onsets before horizon_ns, up to maxOnsets, through the send proc in batches
+static void sendOnsets(RNStimulusScheduler *scheduler, RNStream *s, int64_t horizon_ns, uint32_t maxOnsets, int64_t now_ns)
+{
+	RNOnsetGenerator *generator = &s->definition.generator;
+	while (maxOnsets > 0 && RNOnsetGeneratorHasNext(generator) && generator->next_ns < horizon_ns) {
+		uint32_t nOnsets = 0;
+		while (nOnsets < kRNStimulusBatchLength && nOnsets < maxOnsets && RNOnsetGeneratorHasNext(generator)
+			   && generator->next_ns < horizon_ns) {
+			uint32_t number = generator->taken;
+			int64_t onset_ns = RNOnsetGeneratorNext(generator);
+			scheduler->batch[nOnsets++] = (RNStimulusOnset) { onset_ns, number };
+
+			int64_t lead_ns = onset_ns - now_ns;
+			if (lead_ns < atomic_load_explicit(&scheduler->minLead_ns, memory_order_relaxed))
+				atomic_store_explicit(&scheduler->minLead_ns, lead_ns, memory_order_relaxed);
+			if (lead_ns < 0) {
+				atomic_fetch_add_explicit(&scheduler->nLate, 1, memory_order_relaxed);
+				atomicMax(&scheduler->maxLateness_ns, -lead_ns);
+			}
+		}
+		scheduler->sendProc(&s->definition, scheduler->batch, nOnsets, now_ns, scheduler->refCon);
+		atomic_fetch_add_explicit(&scheduler->nOnsets, nOnsets, memory_order_relaxed);
+		maxOnsets -= nOnsets;
+	}
+}
+
+static void drainTaps(RNStimulusScheduler *scheduler)
+{
+	uint32_t head = atomic_load_explicit(&scheduler->tapHead, memory_order_acquire);
+	uint32_t tail = atomic_load_explicit(&scheduler->tapTail, memory_order_relaxed);
+	for (; tail != head; tail++)
+		RNAdaptiveTapsAdd(&scheduler->recentTaps, scheduler->taps[tail & kTapMask].node, scheduler->taps[tail & kTapMask].time_ns);
+	atomic_store_explicit(&scheduler->tapTail, tail, memory_order_release);
+}
+
+// settle the generator's next onset from the taps around the last one, and log how
+static void decide(RNStimulusScheduler *scheduler, RNStream *s, int64_t due_ns, int64_t now_ns)
+{
+	RNOnsetGenerator *generator = &s->definition.generator;
+	RNPacerDecision decision;
+	int64_t start_ns = RNHostClockNow();
+	generator->next_ns = RNAdaptivePacerDecide(&s->definition.adaptive, &scheduler->recentTaps, generator->previous_ns,
+											   generator->IOI_ns, now_ns, &decision);
+	generator->IOI_ns			= decision.nextIOI_ns;
+	generator->nextJitter_ns	= 0;
+	s->decided					= true;
+	atomicMax(&scheduler->maxDecisionTime_ns, RNHostClockNow() - start_ns);
+	atomicMax(&scheduler->maxDecisionLatency_ns, now_ns - due_ns);
+	atomic_fetch_add_explicit(&scheduler->nDecisions, 1, memory_order_relaxed);
+
+	decision.due_ns				= due_ns;
+	decision.number				= generator->taken;
+	decision.stimulusChannel	= s->definition.stimulusChannel;
+	uint32_t head = atomic_load_explicit(&scheduler->decisionHead, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&scheduler->decisionTail, memory_order_acquire);
+	if (head - tail == kRNStimulusDecisionLength) {
+		atomic_fetch_add_explicit(&scheduler->nDecisionsDropped, 1, memory_order_relaxed);
+		return;
+	}
+	scheduler->decisions[head & kDecisionMask] = decision;
+	atomic_store_explicit(&scheduler->decisionHead, head + 1, memory_order_release);
+}
+
+// plain stream: everything within the lookahead. Returns when it next needs the scheduler (INT64_MAX: at its poll)
+static int64_t sendDue(RNStimulusScheduler *scheduler, RNStream *s, int64_t now_ns)
+{
+	sendOnsets(scheduler, s, now_ns + scheduler->lookahead_ns, UINT32_MAX, now_ns);
+	if (!RNOnsetGeneratorHasNext(&s->definition.generator)) endStream(scheduler, s);
+	return INT64_MAX;
+}
+
+// adaptive stream: one onset at a time, decided when it is a lead away and sent as soon as it is decided and
+//	within the lead. Returns when the next decision or send is due
+static int64_t sendAdaptive(RNStimulusScheduler *scheduler, RNStream *s, int64_t now_ns)
+{
+	RNOnsetGenerator *generator = &s->definition.generator;
+	int64_t lead_ns = (s->definition.adaptive.lead_ns > 0) ? s->definition.adaptive.lead_ns : kRNAdaptiveLead_ns;
+	while (RNOnsetGeneratorHasNext(generator)) {
+		int64_t due_ns = generator->next_ns - lead_ns;
+		if (now_ns < due_ns) return due_ns;
+		if (!s->decided) {
+			decide(scheduler, s, due_ns, now_ns);
+			if (generator->next_ns - lead_ns > now_ns) return generator->next_ns - lead_ns;
+		}
+		sendOnsets(scheduler, s, INT64_MAX, 1, now_ns);
+		s->decided = false;
+	}
+	endStream(scheduler, s);
+	return INT64_MAX;
+}
+
+// on the host clock (never the wall clock, which may be stepped back), so a sleep ends on time [caller holds the lock]
+static void waitForWake(RNStimulusScheduler *scheduler, int64_t sleep_ns)
+{
+#ifdef __APPLE__
+	struct timespec interval = { (time_t)(sleep_ns / 1000000000), (long)(sleep_ns % 1000000000) };
+	pthread_cond_timedwait_relative_np(&scheduler->wake, &scheduler->lock, &interval);
+#else
+	int64_t deadline_ns = RNHostClockNow() + sleep_ns;	// CLOCK_MONOTONIC, as the condition waits on
+	struct timespec deadline = { (time_t)(deadline_ns / 1000000000), (long)(deadline_ns % 1000000000) };
+	pthread_cond_timedwait(&scheduler->wake, &scheduler->lock, &deadline);
+#endif
+}
+
+static void *schedulerThread(void *arg)
+{
+	RNStimulusScheduler *scheduler = arg;
+#ifdef __APPLE__
+	pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0); // as the MIDI processing queue
+#endif
+
+	while (atomic_load_explicit(&scheduler->running, memory_order_acquire)) {
+		int64_t now_ns = RNHostClockNow();
+		if (takeCommands(scheduler) > 0) {
+			pthread_mutex_lock(&scheduler->lock);
+			pthread_cond_broadcast(&scheduler->taken);
+			pthread_mutex_unlock(&scheduler->lock);
+		}
+		drainTaps(scheduler);
+		int64_t wake_ns = now_ns + kRNStimulusPoll_ns;
+		for (unsigned slot = 0; slot < kRNStimulusMaxStreams; slot++) {
+			RNStream *s = &scheduler->streams[slot];
+			if (!s->playing) continue;
+			int64_t due_ns = (s->definition.adaptive.sources != 0) ? sendAdaptive(scheduler, s, now_ns) : sendDue(scheduler, s, now_ns);
+			if (due_ns < wake_ns) wake_ns = due_ns;
+		}
+
+		// sleep until the poll, a decision due before it, or a command
+		int64_t sleep_ns = wake_ns - RNHostClockNow();
+		pthread_mutex_lock(&scheduler->lock);
+		if (sleep_ns > 0 && !scheduler->wakePending && atomic_load_explicit(&scheduler->running, memory_order_acquire)) {
+			waitForWake(scheduler, sleep_ns);
+		}
+		scheduler->wakePending = false;
+		pthread_mutex_unlock(&scheduler->lock);
+	}
+	return NULL;
+}
+
+// *********************************************
+//    Public
+// *********************************************
+
+RNStimulusScheduler *RNStimulusSchedulerCreate(int64_t lookahead_ns, RNStimulusSendProc sendProc, void *refCon)
+{
+	if (sendProc == NULL) return NULL;
+	RNStimulusScheduler *scheduler = calloc(1, sizeof(RNStimulusScheduler));
+	if (scheduler == NULL) return NULL;
+	scheduler->lookahead_ns	= (lookahead_ns > 0) ? lookahead_ns : kRNStimulusLookahead_ns;
+	scheduler->sendProc		= sendProc;
+	scheduler->refCon		= refCon;
+	for (unsigned slot = 0; slot < kRNStimulusMaxStreams; slot++)
+		atomic_init(&scheduler->slotStream[slot], kRNStimulusInvalidStream);
+	atomic_init(&scheduler->minLead_ns, INT64_MAX);
+	RNAdaptiveTapsInit(&scheduler->recentTaps);
+	atomic_init(&scheduler->running, true);
+	pthread_mutex_init(&scheduler->lock, NULL);
+	pthread_condattr_t wakeAttributes;
+	pthread_condattr_init(&wakeAttributes);
+#ifndef __APPLE__
+	pthread_condattr_setclock(&wakeAttributes, CLOCK_MONOTONIC);	// waitForWake's deadline
+#endif
+	pthread_cond_init(&scheduler->wake, &wakeAttributes);
+	pthread_condattr_destroy(&wakeAttributes);
+	pthread_cond_init(&scheduler->taken, NULL);
+
+	if (pthread_create(&scheduler->thread, NULL, schedulerThread, scheduler) != 0) {
+		pthread_cond_destroy(&scheduler->taken);
+		pthread_cond_destroy(&scheduler->wake);
+		pthread_mutex_destroy(&scheduler->lock);
+		free(scheduler);
+		return NULL;
+	}
+	return scheduler;
+}
+
+// caller holds the lock
+static void signalScheduler(RNStimulusScheduler *scheduler)
+{
+	scheduler->wakePending = true;
+	pthread_cond_signal(&scheduler->wake);
+}
+
+void RNStimulusSchedulerDestroy(RNStimulusScheduler *scheduler)
+{
+	if (scheduler == NULL) return;
+	pthread_mutex_lock(&scheduler->lock);
+	atomic_store_explicit(&scheduler->running, false, memory_order_release);
+	signalScheduler(scheduler);
+	pthread_mutex_unlock(&scheduler->lock);
+	pthread_join(scheduler->thread, NULL);
+	pthread_cond_destroy(&scheduler->taken);
+	pthread_cond_destroy(&scheduler->wake);
+	pthread_mutex_destroy(&scheduler->lock);
+	free(scheduler);
+}
+
+static bool pushCommand(RNStimulusScheduler *scheduler, const RNStreamCommand *command)
+{
+	uint32_t head = atomic_load_explicit(&scheduler->commandHead, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&scheduler->commandTail, memory_order_acquire);
+	if (head - tail == kRNStimulusCommandLength) return false;
+	scheduler->commands[head & kCommandMask] = *command;
+	atomic_store_explicit(&scheduler->commandHead, head + 1, memory_order_release);
+	return true;
+}
+
+// wakes the scheduler, so the stream's first onsets go out now rather than at the next poll
+RNStimulusStreamID RNStimulusSchedulerStart(RNStimulusScheduler *scheduler, const RNStimulusStreamDefinition *definition)
+{
+	RNStimulusStreamID stream = kRNStimulusInvalidStream;
+	pthread_mutex_lock(&scheduler->lock);
+	for (unsigned slot = 0; slot < kRNStimulusMaxStreams; slot++) {
+		if (atomic_load_explicit(&scheduler->slotStream[slot], memory_order_acquire) != kRNStimulusInvalidStream) continue;
+		RNStreamCommand command = { .type = kCommandStart, .definition = *definition };
+		command.stream = (RNStimulusStreamID)(((scheduler->nextSerial++ & 0x7FFFFF) << kSlotBits) | slot);
+		atomic_store_explicit(&scheduler->slotStream[slot], command.stream, memory_order_relaxed);
+		if (pushCommand(scheduler, &command)) {
+			stream = command.stream;
+			signalScheduler(scheduler);
+		} else {
+			atomic_store_explicit(&scheduler->slotStream[slot], kRNStimulusInvalidStream, memory_order_relaxed);
+		}
+		break;
+	}
+	pthread_mutex_unlock(&scheduler->lock);
+	return stream;
+}
+
+// wakes the scheduler for the command and waits for it to be taken: only as long as the scheduler takes to get to it,
+//	not a poll (if the ring is full, the wake frees all of it first)
+static void pushCommandAndWait(RNStimulusScheduler *scheduler, const RNStreamCommand *command)
+{
+	pthread_mutex_lock(&scheduler->lock);
+	while (!pushCommand(scheduler, command)) {
+		signalScheduler(scheduler);
+		pthread_cond_wait(&scheduler->taken, &scheduler->lock);
+	}
+	uint32_t head = atomic_load_explicit(&scheduler->commandHead, memory_order_relaxed);
+	signalScheduler(scheduler);
+	//taken once the tail reaches our head; it may go past it, with commands pushed after ours
+	while ((int32_t)(atomic_load_explicit(&scheduler->commandTail, memory_order_acquire) - head) < 0)
+		pthread_cond_wait(&scheduler->taken, &scheduler->lock);
+	pthread_mutex_unlock(&scheduler->lock);
+}
+
+void RNStimulusSchedulerCancel(RNStimulusScheduler *scheduler, RNStimulusStreamID stream)
+{
+	if (!isValidStream(stream)) return;
+	RNStreamCommand command = { .type = kCommandCancel, .stream = stream };
+	pushCommandAndWait(scheduler, &command);
+}
+
+void RNStimulusSchedulerCancelAll(RNStimulusScheduler *scheduler)
+{
+	RNStreamCommand command = { .type = kCommandCancelAll, .stream = kRNStimulusInvalidStream };
+	pushCommandAndWait(scheduler, &command);
+}
+
+bool RNStimulusSchedulerSetIOI(RNStimulusScheduler *scheduler, RNStimulusStreamID stream, int64_t IOI_ns, RNOnsetGenerator *generator)
+{
+	if (!isValidStream(stream) || IOI_ns <= 0) return false;
+	RNStreamAcknowledgement acknowledgement;
+	RNStreamCommand command = { .type = kCommandSetIOI, .stream = stream, .IOI_ns = IOI_ns, .acknowledgement = &acknowledgement };
+	pushCommandAndWait(scheduler, &command);
+	if (generator) *generator = acknowledgement.generator;
+	return acknowledgement.playing;
+}
+
+void RNStimulusSchedulerPushTaps(RNStimulusScheduler *scheduler, const RNEvent *events, uint32_t nEvents)
+{
+	uint32_t head = atomic_load_explicit(&scheduler->tapHead, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&scheduler->tapTail, memory_order_acquire);
+	uint64_t nDropped = 0;
+	for (uint32_t i = 0; i < nEvents; i++) {
+		if (events[i].kind != kRNEventKindTap || events[i].node == 0 || events[i].node > kRNAdaptiveMaxNodes) continue;
+		if (head - tail == kRNStimulusTapRingLength) {
+			nDropped++;
+			continue;
+		}
+		scheduler->taps[head & kTapMask] = (RNStreamTap) { events[i].time_ns, events[i].node };
+		head++;
+	}
+	atomic_store_explicit(&scheduler->tapHead, head, memory_order_release);
+	if (nDropped) atomic_fetch_add_explicit(&scheduler->nTapsDropped, nDropped, memory_order_relaxed);
+}
+
+uint32_t RNStimulusSchedulerReadDecisions(RNStimulusScheduler *scheduler, RNPacerDecision *decisions, uint32_t maxDecisions)
+{
+	uint32_t head = atomic_load_explicit(&scheduler->decisionHead, memory_order_acquire);
+	uint32_t tail = atomic_load_explicit(&scheduler->decisionTail, memory_order_relaxed);
+	uint32_t nRead = 0;
+	for (; tail != head && nRead < maxDecisions; tail++)
+		decisions[nRead++] = scheduler->decisions[tail & kDecisionMask];
+	atomic_store_explicit(&scheduler->decisionTail, tail, memory_order_release);
+	return nRead;
+}
+
+bool RNStimulusSchedulerIsPlaying(const RNStimulusScheduler *scheduler, RNStimulusStreamID stream)
+{
+	if (!isValidStream(stream)) return false;
+	RNStimulusScheduler *mutableScheduler = (RNStimulusScheduler *) scheduler; // atomics are read-only here
+	return atomic_load_explicit(&mutableScheduler->slotStream[slotOf(stream)], memory_order_acquire) == stream;
+}
+
+int64_t RNStimulusSchedulerLookahead(const RNStimulusScheduler *scheduler)
+{
+	return scheduler->lookahead_ns;
+}
+
+RNStimulusSchedulerCounts RNStimulusSchedulerGetCounts(const RNStimulusScheduler *scheduler)
+{
+	RNStimulusScheduler *mutableScheduler = (RNStimulusScheduler *) scheduler; // atomics are read-only here
+	RNStimulusSchedulerCounts counts = {
+		.onsets			= atomic_load_explicit(&mutableScheduler->nOnsets, memory_order_relaxed),
+		.streams		= atomic_load_explicit(&mutableScheduler->nStreams, memory_order_relaxed),
+		.late			= atomic_load_explicit(&mutableScheduler->nLate, memory_order_relaxed),
+		.maxLateness_ns	= atomic_load_explicit(&mutableScheduler->maxLateness_ns, memory_order_relaxed),
+		.minLead_ns		= atomic_load_explicit(&mutableScheduler->minLead_ns, memory_order_relaxed),
+		.decisions				= atomic_load_explicit(&mutableScheduler->nDecisions, memory_order_relaxed),
+		.decisionsDropped		= atomic_load_explicit(&mutableScheduler->nDecisionsDropped, memory_order_relaxed),
+		.tapsDropped			= atomic_load_explicit(&mutableScheduler->nTapsDropped, memory_order_relaxed),
+		.maxDecisionLatency_ns	= atomic_load_explicit(&mutableScheduler->maxDecisionLatency_ns, memory_order_relaxed),
+		.maxDecisionTime_ns		= atomic_load_explicit(&mutableScheduler->maxDecisionTime_ns, memory_order_relaxed),
+	};
+	if (counts.minLead_ns == INT64_MAX) counts.minLead_ns = 0;
+	return counts;
+}
@@ -0,0 +1,164 @@
+//
+//  RNStimulusStream.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Just-in-time stimulus output: onsets are generated as they are needed and handed to the MIDI
+//	driver a short lookahead ahead of time, so a stimulus can be any length (or play until
+//	cancelled) in constant memory, and a cancel or tempo change is heard within one lookahead.
+//	- an onset generator holds all of a stimulus' state: the next onset, IOI, jitter and its seed.
+//	  Jitter is counter-based, a function of seed and onset number alone, in integer ns: the same
+//	  seed gives the same onsets on any machine, whether generated live or filled ahead in bulk
+//	- the scheduler runs on its own thread, waking every poll to send each stream's onsets that
+//	  fall before now + lookahead through a send proc, in batches, from fixed buffers
+//	- streams are started, changed and cancelled from control threads (e.g. the main thread, and the
+//	  part scheduler's for parts due to start) through a command ring, under a lock that also wakes
+//	  the scheduler to take the command at once; what has been sent stays sent
+//	- up to 16 streams play at once; a stream ends after its last onset, or when cancelled
+//	- an adaptive stream (RNAdaptivePacer.h) decides each onset a short lead before it sounds, from
+//	  taps pushed by the MIDI processing thread; the scheduler wakes for each decision rather than
+//	  waiting for its poll, and logs it for a consumer to read
+
+#ifndef RNStimulusStream_h
+#define RNStimulusStream_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNEventStore.h"
+#include "RNAdaptivePacer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNStimulusMaxStreams		16
+#define kRNStimulusLookahead_ns		200000000	// default: how far ahead onsets are sent
+#define kRNStimulusPoll_ns			10000000	// scheduler wake interval: well inside the lookahead
+#define kRNStimulusBatchLength		128			// onsets per send proc call (more go in further calls)
+#define kRNStimulusCommandLength	64			// pending commands (power of 2)
+#define kRNStimulusTapRingLength	1024		// taps pushed between wakes (power of 2)
+#define kRNStimulusDecisionLength	1024		// adaptive decisions waiting for the consumer (power of 2)
+
+// The i-th output of a splitmix64 stream seeded with seed, computed directly
+static inline uint64_t RNOnsetRandom(uint64_t seed, uint64_t i)
+{
+	uint64_t z = seed + (i + 1) * 0x9E3779B97F4A7C15ULL;
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+// Jitter of onset i (from 1): uniform integer in [-jitter_ns, jitter_ns], without floating point
+static inline int64_t RNOnsetJitter(uint64_t seed, uint64_t i, int64_t jitter_ns)
+{
+	if (jitter_ns <= 0) return 0;
+	return (int64_t)(((unsigned __int128) RNOnsetRandom(seed, i) * (uint64_t)(2 * jitter_ns + 1)) >> 64) - jitter_ns;
+}
+
+// Onsets, first unjittered, then each the previous plus IOI plus RNOnsetJitter. Jitter for an
+//	onset is worked out when the onset before it is taken, so changing the IOI moves the next
+//	onset (not yet taken) but keeps its jitter.
+typedef struct {
+	int64_t		next_ns;		// next onset, absolute (host clock)
+	int64_t		previous_ns;	// last one taken
+	int64_t		IOI_ns;
+	int64_t		jitter_ns;
+	int64_t		nextJitter_ns;	// already in next_ns
+	uint32_t	taken;
+	uint32_t	count;			// 0: endless
+	uint64_t	seed;
+} RNOnsetGenerator;
+
+void			RNOnsetGeneratorInit(RNOnsetGenerator *generator, int64_t first_ns, int64_t IOI_ns, int64_t jitter_ns,
+									 uint32_t count, uint64_t seed);
+static inline bool RNOnsetGeneratorHasNext(const RNOnsetGenerator *generator)
+{
+	return generator->count == 0 || generator->taken < generator->count;
+}
+int64_t			RNOnsetGeneratorNext(RNOnsetGenerator *generator);	// takes next_ns
+void			RNOnsetGeneratorSetIOI(RNOnsetGenerator *generator, int64_t IOI_ns);
+
+// The first nOnsets a generator initialized with the same arguments would give, in one pass
+void			RNOnsetTableFill(int64_t *onsets_ns, uint32_t nOnsets, int64_t first_ns, int64_t IOI_ns, int64_t jitter_ns,
+								 uint64_t seed);
+
+// What a stream plays, and who hears it (for recording)
+typedef struct {
+	RNOnsetGenerator	generator;
+	uint8_t				channel;			// 0-based MIDI channel
+	uint8_t				note;
+	uint8_t				velocity;
+	uint8_t				stimulusChannel;
+	int64_t				noteDuration_ns;	// note-off this long after each onset; 0: none
+	uint32_t			listeners;			// bit n: node n hears it
+	RNAdaptivePacerParameters adaptive;		// sources 0: plays the generator's onsets as they come
+} RNStimulusStreamDefinition;
+
+typedef struct {
+	int64_t		time_ns;
+	uint32_t	number;		// within the stream, from 0
+} RNStimulusOnset;
+
+// Called on the scheduler's thread with a stream's onsets due within the lookahead, in time order.
+//	now_ns is when they are being sent. Must not block.
+typedef void (*RNStimulusSendProc)(const RNStimulusStreamDefinition *definition, const RNStimulusOnset *onsets,
+								   uint32_t nOnsets, int64_t now_ns, void *refCon);
+
+typedef int32_t RNStimulusStreamID;	// slot and serial: stale IDs are ignored
+#define kRNStimulusInvalidStream	(-1)
+
+typedef struct {
+	uint64_t	onsets;			// sent
+	uint64_t	streams;		// started
+	uint64_t	late;			// onsets already due when sent (the scheduler fell behind the lookahead)
+	int64_t		maxLateness_ns;
+	int64_t		minLead_ns;		// least time ahead an onset was sent (0 until one is)
+	uint64_t	decisions;		// adaptive onsets decided
+	uint64_t	decisionsDropped;	// not logged: the consumer fell behind
+	uint64_t	tapsDropped;	// pushed to a full tap ring
+	int64_t		maxDecisionLatency_ns;	// decided after it was due
+	int64_t		maxDecisionTime_ns;		// spent deciding
+} RNStimulusSchedulerCounts;
+
+typedef struct RNStimulusScheduler RNStimulusScheduler;
+
+// Starts the scheduler's thread. lookahead_ns <= 0: kRNStimulusLookahead_ns.
+RNStimulusScheduler			*RNStimulusSchedulerCreate(int64_t lookahead_ns, RNStimulusSendProc sendProc, void *refCon);
+void						RNStimulusSchedulerDestroy(RNStimulusScheduler *scheduler);	// stops and joins the thread
+
+// Control threads (these calls hold the scheduler's lock only briefly). Start wakes the scheduler,
+//	so onsets before now + lookahead go out at once: a stream started one lookahead ahead of its
+//	first onset has it sent on time. kRNStimulusInvalidStream if all streams are playing or the
+//	command ring is full.
+RNStimulusStreamID			RNStimulusSchedulerStart(RNStimulusScheduler *scheduler, const RNStimulusStreamDefinition *definition);
+// Onsets not yet sent are dropped; those within the lookahead are already with the driver (flush it
+//	to silence them). Wakes the scheduler and, as SetIOI, waits for it to take the cancel (not for a
+//	poll), so nothing more is sent.
+void						RNStimulusSchedulerCancel(RNStimulusScheduler *scheduler, RNStimulusStreamID stream);
+void						RNStimulusSchedulerCancelAll(RNStimulusScheduler *scheduler);
+// Changes the IOI from the next onset not yet sent. Wakes the scheduler and waits for it to take
+//	the change: as long as a pass in progress, not a poll. generator (optional) gets the stream's
+//	onsets as they now stand, to replan from. false if the stream has ended.
+bool						RNStimulusSchedulerSetIOI(RNStimulusScheduler *scheduler, RNStimulusStreamID stream,
+													  int64_t IOI_ns, RNOnsetGenerator *generator);
+bool						RNStimulusSchedulerIsPlaying(const RNStimulusScheduler *scheduler, RNStimulusStreamID stream);
+int64_t						RNStimulusSchedulerLookahead(const RNStimulusScheduler *scheduler);
+
+// Producer side, one thread only (the MIDI processing thread): taps for adaptive streams. Times are
+//	absolute (host clock); anything but taps of nodes 1..kRNAdaptiveMaxNodes is ignored.
+void						RNStimulusSchedulerPushTaps(RNStimulusScheduler *scheduler, const RNEvent *events, uint32_t nEvents);
+
+// Consumer side, one thread only: adaptive decisions in the order made. Returns the number read.
+uint32_t					RNStimulusSchedulerReadDecisions(RNStimulusScheduler *scheduler, RNPacerDecision *decisions,
+															 uint32_t maxDecisions);
+
+// Any thread.
+RNStimulusSchedulerCounts	RNStimulusSchedulerGetCounts(const RNStimulusScheduler *scheduler);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNStimulusStream_h */
@@ -0,0 +1,409 @@
+//
+//  RNSynchrony.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNSynchrony.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define kSnapshotWords		(sizeof(RNSynchronySnapshot) / sizeof(uint64_t))
+#define kSeriesRowLength	64
+_Static_assert(sizeof(RNSynchronySnapshot) % sizeof(uint64_t) == 0, "snapshot must be whole words");
+
+typedef struct {
+	RNTimingPacer	pacer;
+	uint32_t		onsetHint;							// cursor into the pacer's onsets
+	int64_t			nTaps;
+	int64_t			lastTap_ns;
+	double			tapPhase;							// pacer mode: phase re pacer at the last tap
+	double			ITI_ns[kRNSynchronyITIHistory];
+	unsigned		nITIs;								// valid entries (<= history)
+	unsigned		iITI;								// next slot
+	double			sumITI_ns;
+} RNSyncNode;
+
+// sliding window of unit phase-difference vectors for one pair (a < b): phase_a - phase_b
+typedef struct {
+	float			*cosine;
+	float			*sine;
+	unsigned		count;
+	unsigned		next;
+	double			sumCos, sumSin;
+	double			PLV;								// published value, < 0 until the window is full
+} RNSyncPair;
+
+struct RNSynchrony {
+	unsigned				nNodes;
+	unsigned				window;
+	RNSyncNode				node[kRNSynchronyMaxNodes];
+	RNSyncPair				*pair;						// nNodes * nNodes, only a < b used
+	float					*pairStorage;
+
+	// order parameter window
+	double					*windowR;
+	unsigned				windowCount, windowNext;
+	double					windowSumR;
+
+	// mean PLV bookkeeping over pairs with a full window
+	double					sumPLV;
+	uint32_t				nPLV;
+
+	RNSynchronySnapshot		latest;						// writer copy of what was last published
+
+	RNSynchronySample		*series;
+	size_t					nSeries, seriesCapacity;
+
+	// published to readers
+	_Atomic(uint32_t)		sequence;
+	_Atomic(uint64_t)		snapshotWords[kSnapshotWords];
+	_Atomic(double)			*publishedPLV;				// nNodes * nNodes
+};
+
+static inline RNSyncPair *pairFor(RNSynchrony *s, unsigned a, unsigned b)
+{
+	return (a < b) ? &s->pair[a * s->nNodes + b] : &s->pair[b * s->nNodes + a];
+}
+
+RNSynchrony *RNSynchronyCreate(unsigned nNodes, unsigned windowLength)
+{
+	if (nNodes == 0 || nNodes > kRNSynchronyMaxNodes) return NULL;
+	RNSynchrony *s = calloc(1, sizeof(RNSynchrony));
+	if (s == NULL) return NULL;
+
+	s->nNodes		= nNodes;
+	s->window		= (windowLength > 0) ? windowLength : kRNSynchronyDefaultWindow;
+	s->pair			= calloc((size_t)nNodes * nNodes, sizeof(RNSyncPair));
+	s->pairStorage	= calloc((size_t)nNodes * nNodes * 2 * s->window, sizeof(float));
+	s->windowR		= calloc(s->window, sizeof(double));
+	s->publishedPLV	= calloc((size_t)nNodes * nNodes, sizeof(_Atomic(double)));
+	if (!s->pair || !s->pairStorage || !s->windowR || !s->publishedPLV) {
+		RNSynchronyDestroy(s);
+		return NULL;
+	}
+	for (size_t p = 0; p < (size_t)nNodes * nNodes; p++) {
+		s->pair[p].cosine	= s->pairStorage + p * 2 * s->window;
+		s->pair[p].sine		= s->pair[p].cosine + s->window;
+	}
+	RNSynchronyReset(s);
+	return s;
+}
+
+void RNSynchronyDestroy(RNSynchrony *s)
+{
+	if (s == NULL) return;
+	for (unsigned n = 0; n < s->nNodes; n++)
+		RNOnsetIndexRelease(s->node[n].pacer.onsets);
+	free(s->pair);
+	free(s->pairStorage);
+	free(s->windowR);
+	free(s->publishedPLV);
+	free(s->series);
+	free(s);
+}
+
+static void publishSnapshot(RNSynchrony *s)
+{
+	uint64_t words[kSnapshotWords];
+	memcpy(words, &s->latest, sizeof(words));
+	for (unsigned i = 0; i < kSnapshotWords; i++)
+		atomic_store_explicit(&s->snapshotWords[i], words[i], memory_order_relaxed);
+}
+
+static inline void beginPublish(RNSynchrony *s)
+{
+	uint32_t sequence = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+	atomic_store_explicit(&s->sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+}
+
+static inline void endPublish(RNSynchrony *s)
+{
+	uint32_t sequence = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+	atomic_store_explicit(&s->sequence, sequence + 1, memory_order_release);
+}
+
+void RNSynchronyReset(RNSynchrony *s)
+{
+	for (unsigned n = 0; n < s->nNodes; n++) {
+		RNTimingPacer pacer = s->node[n].pacer;
+		memset(&s->node[n], 0, sizeof(RNSyncNode));
+		s->node[n].pacer = pacer;
+	}
+	for (size_t p = 0; p < (size_t)s->nNodes * s->nNodes; p++) {
+		RNSyncPair *pair = &s->pair[p];
+		pair->count = pair->next = 0;
+		pair->sumCos = pair->sumSin = 0.0;
+		pair->PLV = -1.0;
+	}
+	s->windowCount = s->windowNext = 0;
+	s->windowSumR = 0.0;
+	s->sumPLV = 0.0;
+	s->nPLV = 0;
+	s->nSeries = 0;
+	memset(&s->latest, 0, sizeof(s->latest));
+
+	beginPublish(s);
+	publishSnapshot(s);
+	for (size_t p = 0; p < (size_t)s->nNodes * s->nNodes; p++)
+		atomic_store_explicit(&s->publishedPLV[p], -1.0, memory_order_relaxed);
+	endPublish(s);
+}
+
+void RNSynchronySetPacer(RNSynchrony *s, unsigned node, RNTimingPacer pacer)
+{
+	if (node >= s->nNodes || RNTimingPacerEqual(s->node[node].pacer, pacer)) return;
+	RNOnsetIndexRetain(pacer.onsets);
+	RNOnsetIndexRelease(s->node[node].pacer.onsets);
+	s->node[node].pacer = pacer;
+	s->node[node].onsetHint = 0;
+}
+
+// period used for extrapolation and activity: the pacer's if any, else the node's recent mean ITI
+static inline double nodePeriod_ns(const RNSyncNode *n)
+{
+	if (n->pacer.IOI_ns > 0) return (double) n->pacer.IOI_ns;
+	return (n->nITIs > 0) ? n->sumITI_ns / n->nITIs : 0.0;
+}
+
+static inline bool nodePhaseAt(const RNSyncNode *n, int64_t time_ns, double *phase)
+{
+	double period_ns = nodePeriod_ns(n);
+	if (n->nTaps == 0 || period_ns <= 0.0) return false;
+
+	double sinceTap_ns = (double)(time_ns - n->lastTap_ns);
+	if (sinceTap_ns > kRNSynchronyActiveITIs * period_ns) return false;
+
+	if (n->pacer.IOI_ns > 0)
+		*phase = n->tapPhase;
+	else
+		*phase = 2.0 * M_PI * remainder(sinceTap_ns / period_ns, 1.0);
+	return true;
+}
+
+static void pairAdd(RNSynchrony *s, RNSyncPair *pair, double difference)
+{
+	float c = (float) cos(difference), sn = (float) sin(difference);
+
+	if (pair->count == s->window) {
+		pair->sumCos -= pair->cosine[pair->next];
+		pair->sumSin -= pair->sine[pair->next];
+	} else {
+		pair->count++;
+	}
+	pair->cosine[pair->next]	= c;
+	pair->sine[pair->next]		= sn;
+	pair->sumCos += c;
+	pair->sumSin += sn;
+	if (++pair->next == s->window) {
+		// resum once per window so rounding from the running sums can't accumulate
+		pair->next = 0;
+		double sumCos = 0.0, sumSin = 0.0;
+		for (unsigned k = 0; k < pair->count; k++) {
+			sumCos += pair->cosine[k];
+			sumSin += pair->sine[k];
+		}
+		pair->sumCos = sumCos;
+		pair->sumSin = sumSin;
+	}
+
+	if (pair->count == s->window) {
+		double PLV = hypot(pair->sumCos, pair->sumSin) / pair->count;
+		if (pair->PLV >= 0.0) s->sumPLV -= pair->PLV;
+		else s->nPLV++;
+		s->sumPLV += PLV;
+		pair->PLV = PLV;
+	}
+}
+
+static void appendSample(RNSynchrony *s, const RNSynchronySample *sample)
+{
+	if (s->nSeries == s->seriesCapacity) {
+		size_t capacity = (s->seriesCapacity > 0) ? 2 * s->seriesCapacity : 4096;
+		RNSynchronySample *series = realloc(s->series, capacity * sizeof(RNSynchronySample));
+		if (series == NULL) return; // keep computing, stop recording
+		s->series = series;
+		s->seriesCapacity = capacity;
+	}
+	s->series[s->nSeries++] = *sample;
+}
+
+double RNSynchronyAddTap(RNSynchrony *s, unsigned iNode, int64_t time_ns)
+{
+	if (iNode >= s->nNodes) return -1.0;
+	RNSyncNode *tapper = &s->node[iNode];
+
+	// the tapper's own state
+	if (tapper->nTaps > 0) {
+		double ITI_ns = (double)(time_ns - tapper->lastTap_ns);
+		if (tapper->nITIs == kRNSynchronyITIHistory) tapper->sumITI_ns -= tapper->ITI_ns[tapper->iITI];
+		else tapper->nITIs++;
+		tapper->ITI_ns[tapper->iITI] = ITI_ns;
+		tapper->sumITI_ns += ITI_ns;
+		tapper->iITI = (tapper->iITI + 1) % kRNSynchronyITIHistory;
+	}
+	tapper->nTaps++;
+	tapper->lastTap_ns = time_ns;
+	if (tapper->pacer.IOI_ns > 0) {
+		RNOnsetMatch match = RNTimingPacerMatch(tapper->pacer, time_ns, &tapper->onsetHint);
+		tapper->tapPhase = (match.interval_ns > 0) ? 2.0 * M_PI * match.asynchrony_ns / (double) match.interval_ns : 0.0;
+	}
+
+	double tapperPhase;
+	if (!nodePhaseAt(tapper, time_ns, &tapperPhase))
+		return -1.0; // no period estimate yet
+
+	// one pass over the other nodes: order parameter and the tapper's pairs
+	double sumCos = cos(tapperPhase), sumSin = sin(tapperPhase);
+	unsigned nActive = 1;
+	unsigned changed[kRNSynchronyMaxNodes];
+	unsigned nChanged = 0;
+
+	for (unsigned j = 0; j < s->nNodes; j++) {
+		double phase;
+		if (j == iNode || !nodePhaseAt(&s->node[j], time_ns, &phase)) continue;
+		sumCos += cos(phase);
+		sumSin += sin(phase);
+		nActive++;
+		double difference = (iNode < j) ? tapperPhase - phase : phase - tapperPhase;
+		pairAdd(s, pairFor(s, iNode, j), difference);
+		changed[nChanged++] = j;
+	}
+
+	if (nActive < 2) return -1.0;
+
+	double R = hypot(sumCos, sumSin) / nActive;
+	if (s->windowCount == s->window) s->windowSumR -= s->windowR[s->windowNext];
+	else s->windowCount++;
+	s->windowR[s->windowNext] = R;
+	s->windowSumR += R;
+	s->windowNext = (s->windowNext + 1) % s->window;
+
+	s->latest.nSamples++;
+	s->latest.time_ns	= time_ns;
+	s->latest.R			= R;
+	s->latest.meanPhase	= atan2(sumSin, sumCos);
+	s->latest.windowR	= s->windowSumR / s->windowCount;
+	s->latest.meanPLV	= (s->nPLV > 0) ? s->sumPLV / s->nPLV : 0.0;
+	s->latest.nActive	= nActive;
+	s->latest.nPairs	= s->nPLV;
+
+	RNSynchronySample sample = {
+		.time_ns = time_ns, .R = (float) R, .windowR = (float) s->latest.windowR,
+		.node = (uint16_t) iNode, .nActive = (uint16_t) nActive,
+	};
+	appendSample(s, &sample);
+
+	beginPublish(s);
+	publishSnapshot(s);
+	for (unsigned k = 0; k < nChanged; k++) {
+		unsigned j = changed[k];
+		double PLV = pairFor(s, iNode, j)->PLV;
+		atomic_store_explicit(&s->publishedPLV[iNode * s->nNodes + j], PLV, memory_order_relaxed);
+		atomic_store_explicit(&s->publishedPLV[j * s->nNodes + iNode], PLV, memory_order_relaxed);
+	}
+	endPublish(s);
+
+	return R;
+}
+
+size_t RNSynchronySeriesCount(const RNSynchrony *s)
+{
+	return s->nSeries;
+}
+
+const RNSynchronySample *RNSynchronySeries(const RNSynchrony *s)
+{
+	return s->series;
+}
+
+size_t RNSynchronySeriesFormatLength(const RNSynchrony *s)
+{
+	return s->nSeries * kSeriesRowLength;
+}
+
+size_t RNSynchronySeriesFormat(const RNSynchrony *s, char *dst, size_t capacity)
+{
+	size_t length = 0;
+	char row[kSeriesRowLength + 1];
+
+	for (size_t i = 0; i < s->nSeries; i++) {
+		const RNSynchronySample *sample = &s->series[i];
+		int n = snprintf(row, sizeof(row), "%lld\t%.4f\t%.4f\t%u\t%u\n", (long long) sample->time_ns,
+						 sample->R, sample->windowR, sample->node, sample->nActive);
+		if (n < 0 || length + (size_t) n > capacity) break;
+		memcpy(dst + length, row, (size_t) n);
+		length += (size_t) n;
+	}
+	return length;
+}
+
+unsigned RNSynchronyNodeCount(const RNSynchrony *s)
+{
+	return s->nNodes;
+}
+
+void RNSynchronyGetSnapshot(const RNSynchrony *synchrony, RNSynchronySnapshot *snapshot)
+{
+	RNSynchrony *s = (RNSynchrony *) synchrony;
+	uint64_t words[kSnapshotWords];
+	uint32_t before, after;
+
+	do {
+		before = atomic_load_explicit(&s->sequence, memory_order_acquire);
+		for (unsigned i = 0; i < kSnapshotWords; i++)
+			words[i] = atomic_load_explicit(&s->snapshotWords[i], memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	memcpy(snapshot, words, sizeof(words));
+}
+
+void RNSynchronyGetPLVMatrix(const RNSynchrony *synchrony, double *plv)
+{
+	RNSynchrony *s = (RNSynchrony *) synchrony;
+	size_t n = (size_t) s->nNodes * s->nNodes;
+	uint32_t before, after;
+
+	do {
+		before = atomic_load_explicit(&s->sequence, memory_order_acquire);
+		for (size_t p = 0; p < n; p++)
+			plv[p] = atomic_load_explicit(&s->publishedPLV[p], memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&s->sequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+}
+
+double RNSynchronyBenchmark(unsigned nNodes, uint32_t nTaps)
+{
+	RNSynchrony *s = RNSynchronyCreate(nNodes, 0);
+	struct timespec t0, t1;
+	if (s == NULL || nTaps == 0) {
+		RNSynchronyDestroy(s);
+		return 0.0;
+	}
+
+	// everyone near 500 ms, each with a small offset and scatter
+	double sum = 0.0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint32_t i = 0; i < nTaps; i++) {
+		unsigned node = i % nNodes;
+		int64_t time_ns = (int64_t)(i / nNodes) * 500000000LL + node * 3000000LL
+						+ (int64_t)((i * 2654435761u) % 20000000u);
+		sum += RNSynchronyAddTap(s, node, time_ns);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	double elapsed_ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+	volatile double sink = sum; (void)sink; // keep the work
+
+	RNSynchronyDestroy(s);
+	return elapsed_ns / nTaps;
+}
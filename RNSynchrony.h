@@ -0,0 +1,95 @@
+//
+//  RNSynchrony.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Network synchrony, updated as each tap arrives, in O(nodes) per tap:
+//	- every node has a phase: relative to its pacer at its last tap if it has one, otherwise
+//	  extrapolated from its last tap with the mean of its recent ITIs
+//	- at each tap, the Kuramoto order parameter R = |mean(exp(i*phase))| over the active nodes
+//	  (those that tapped within the last few of their ITIs), plus its mean over the last
+//	  window taps; each tap's value is appended to a time series kept for saving
+//	- pairwise phase-locking value PLV = |mean(exp(i*(phase_a - phase_b)))| over the last
+//	  window taps of either node, for every active pair involving the tapping node
+//
+// One thread writes; any thread may read the latest values (GetSnapshot, GetPLVMatrix)
+//	through a sequence counter, retrying if it races a tap.
+
+#ifndef RNSynchrony_h
+#define RNSynchrony_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNTimingStats.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNSynchronyMaxNodes		64
+#define kRNSynchronyDefaultWindow	16	// taps per sliding window
+#define kRNSynchronyITIHistory		4	// ITIs averaged for a node's period estimate
+#define kRNSynchronyActiveITIs		3	// a node is active if it tapped within this many of its ITIs
+
+// one point of the recorded order parameter time series
+typedef struct {
+	int64_t		time_ns;		// time of the tap that produced it
+	float		R;				// order parameter at that tap
+	float		windowR;		// mean R over the window
+	uint16_t	node;			// tapping node
+	uint16_t	nActive;		// nodes included
+	uint32_t	spare;
+} RNSynchronySample;
+
+typedef struct {
+	uint64_t	nSamples;		// taps that produced an R (>= 2 active nodes)
+	int64_t		time_ns;		// of the latest
+	double		R;
+	double		meanPhase;		// radians, argument of the mean phase vector
+	double		windowR;
+	double		meanPLV;		// over all pairs with a full window
+	uint32_t	nActive;
+	uint32_t	nPairs;			// pairs contributing to meanPLV
+} RNSynchronySnapshot;
+
+typedef struct RNSynchrony RNSynchrony;
+
+// Nodes 0..nNodes-1 (at most kRNSynchronyMaxNodes), windows of windowLength taps (0: default)
+RNSynchrony			*RNSynchronyCreate(unsigned nNodes, unsigned windowLength);
+void				RNSynchronyDestroy(RNSynchrony *synchrony);
+
+// Writer side. A node without a pacer (IOI_ns <= 0) gets its phase from its ITIs; one with scheduled
+//	onsets is phased against them (a reference to them is kept).
+void				RNSynchronySetPacer(RNSynchrony *synchrony, unsigned node, RNTimingPacer pacer);
+void				RNSynchronyReset(RNSynchrony *synchrony);	// phases, windows and time series; pacers kept
+
+// Writer side: a tap (taps in time order). Returns R at this tap, or a negative value if fewer
+//	than two nodes are active.
+double				RNSynchronyAddTap(RNSynchrony *synchrony, unsigned node, int64_t time_ns);
+
+// Writer side (or with the writer stopped): the recorded time series.
+size_t				RNSynchronySeriesCount(const RNSynchrony *synchrony);
+const RNSynchronySample *RNSynchronySeries(const RNSynchrony *synchrony);
+
+// Rows "time_ns<tab>R<tab>windowR<tab>node<tab>nActive\n", R to 4 decimals. Returns bytes written
+//	(no terminator); stops before a row that would not fit. RNSynchronySeriesFormatLength is enough room.
+size_t				RNSynchronySeriesFormatLength(const RNSynchrony *synchrony);
+size_t				RNSynchronySeriesFormat(const RNSynchrony *synchrony, char *dst, size_t capacity);
+
+// Any thread.
+unsigned			RNSynchronyNodeCount(const RNSynchrony *synchrony);
+void				RNSynchronyGetSnapshot(const RNSynchrony *synchrony, RNSynchronySnapshot *snapshot);
+// plv: nNodes * nNodes values, row major and symmetric; negative where a pair has less than a full window
+void				RNSynchronyGetPLVMatrix(const RNSynchrony *synchrony, double *plv);
+
+// Rough timing of AddTap with nNodes tapping in turn, returns mean ns per tap (clock_gettime).
+double				RNSynchronyBenchmark(unsigned nNodes, uint32_t nTaps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNSynchrony_h */
@@ -75,12 +75,14 @@
 
 - (MIOCVelocityProcessor *)sourceVelocityProcessor;
 - (void)setSourceVelocityProcessor:(MIOCVelocityProcessor *)newSourceVelocityProcessor;
+- (MIOCVelocityProcessor *)sourceVelocityProcessorFrom:(MIOCVelocityProcessor *)processor;
 
 - (MIOCVelocityProcessor *)destVelocityProcessor;
 - (void)setDestVelocityProcessor:(MIOCVelocityProcessor *)newDestVelocityProcessor;
 
 - (MIOCVelocityProcessor *)otherNodeVelocityProcessor;
 - (void)setOtherNodeVelocityProcessor:(MIOCVelocityProcessor *)newVelocityProcessor;
+- (MIOCVelocityProcessor *)otherNodeVelocityProcessorFrom:(MIOCVelocityProcessor *)processor;
 
 - (Byte)drumsetNumber;
 - (void)setDrumsetNumber:(Byte)newDrumsetNumber;
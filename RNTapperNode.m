@@ -204,10 +204,16 @@ static NSArray *colorArray;
 - (void) setSourceVelocityProcessor: (MIOCVelocityProcessor *) newSourceVelocityProcessor
 {
 	[_sourceVelocityProcessor autorelease];
-	_sourceVelocityProcessor = [newSourceVelocityProcessor copy];
-	[_sourceVelocityProcessor setPort:[self sourcePort]];
-	[_sourceVelocityProcessor setChannel:[self sourceChan]];
-	[_sourceVelocityProcessor setOnInput:YES];
+	_sourceVelocityProcessor = [[self sourceVelocityProcessorFrom:newSourceVelocityProcessor] retain];
+}
+//a copy of processor with our input port and channel, as setSourceVelocityProcessor: would set it
+- (MIOCVelocityProcessor *) sourceVelocityProcessorFrom: (MIOCVelocityProcessor *) processor
+{
+	MIOCVelocityProcessor *sourceProcessor = [[processor copy] autorelease];
+	[sourceProcessor setPort:[self sourcePort]];
+	[sourceProcessor setChannel:[self sourceChan]];
+	[sourceProcessor setOnInput:YES];
+	return sourceProcessor;
 }
 
 //processor applied to all output sent to a tapper's drum machine
@@ -229,11 +235,16 @@ static NSArray *colorArray;
 - (void) setOtherNodeVelocityProcessor: (MIOCVelocityProcessor *) newVelocityProcessor
 {
 	[_otherNodeVelocityProcessor autorelease];
-	//patch up the processor with correct channel in passthru port
-	_otherNodeVelocityProcessor = [newVelocityProcessor copy];
-	[_otherNodeVelocityProcessor setPort:[self otherNodePassthroughPort] ];
-	[_otherNodeVelocityProcessor setChannel:[self otherNodePassthroughChan] ];
-	[_otherNodeVelocityProcessor setOnInput:NO];
+	_otherNodeVelocityProcessor = [[self otherNodeVelocityProcessorFrom:newVelocityProcessor] retain];
+}
+//a copy of processor with correct channel in passthru port, as setOtherNodeVelocityProcessor: would set it
+- (MIOCVelocityProcessor *) otherNodeVelocityProcessorFrom: (MIOCVelocityProcessor *) processor
+{
+	MIOCVelocityProcessor *otherProcessor = [[processor copy] autorelease];
+	[otherProcessor setPort:[self otherNodePassthroughPort] ];
+	[otherProcessor setChannel:[self otherNodePassthroughChan] ];
+	[otherProcessor setOnInput:NO];
+	return otherProcessor;
 }
 
 - (Byte) drumsetNumber { return _drumsetNumber; }
@@ -0,0 +1,263 @@
+//
+//  RNTimeSeries.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNTimeSeries.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define kCapacityMask	(kRNTimeSeriesCapacity - 1)
+#define kQuerySlack		4	// a level is used if it has at most this many times the buckets asked for
+_Static_assert((kRNTimeSeriesCapacity & kCapacityMask) == 0, "capacity must be a power of 2");
+
+// a bucket as two words, so readers can copy it with plain atomic loads
+typedef struct {
+	_Atomic(uint64_t)	time;
+	_Atomic(uint64_t)	range;		// min bits | max bits << 32
+} RNAtomicBucket;
+
+typedef struct {
+	RNAtomicBucket		ring[kRNTimeSeriesCapacity];
+	_Atomic(uint64_t)	count;			// buckets ever completed (free running)
+	RNAtomicBucket		pending;		// being accumulated from the level below (levels > 0)
+	_Atomic(uint32_t)	pendingCount;
+	RNTimeSeriesBucket	accumulator;	// writer's copy of pending
+} RNSeriesLevel;
+
+typedef struct {
+	_Atomic(uint32_t)	sequence;		// odd during an append
+	RNSeriesLevel		level[kRNTimeSeriesLevels];
+} RNSeries;
+
+struct RNTimeSeries {
+	unsigned			nSeries;
+	_Atomic(int64_t)	lastTime_ns;
+	RNSeries			series[];
+};
+
+static inline uint64_t packRange(float min, float max)
+{
+	uint32_t lo, hi;
+	memcpy(&lo, &min, sizeof(lo));
+	memcpy(&hi, &max, sizeof(hi));
+	return (uint64_t) lo | ((uint64_t) hi << 32);
+}
+
+static inline void storeBucket(RNAtomicBucket *dst, const RNTimeSeriesBucket *bucket)
+{
+	atomic_store_explicit(&dst->time, (uint64_t) bucket->time_ns, memory_order_relaxed);
+	atomic_store_explicit(&dst->range, packRange(bucket->min, bucket->max), memory_order_relaxed);
+}
+
+static inline RNTimeSeriesBucket loadBucket(RNAtomicBucket *src)
+{
+	RNTimeSeriesBucket bucket;
+	uint64_t range = atomic_load_explicit(&src->range, memory_order_relaxed);
+	uint32_t lo = (uint32_t) range, hi = (uint32_t)(range >> 32);
+	bucket.time_ns = (int64_t) atomic_load_explicit(&src->time, memory_order_relaxed);
+	memcpy(&bucket.min, &lo, sizeof(lo));
+	memcpy(&bucket.max, &hi, sizeof(hi));
+	return bucket;
+}
+
+RNTimeSeries *RNTimeSeriesCreate(unsigned nSeries)
+{
+	RNTimeSeries *ts = calloc(1, sizeof(RNTimeSeries) + nSeries * sizeof(RNSeries));
+	if (ts == NULL) return NULL;
+	ts->nSeries = nSeries;
+	atomic_store_explicit(&ts->lastTime_ns, INT64_MIN, memory_order_relaxed);
+	return ts;
+}
+
+void RNTimeSeriesDestroy(RNTimeSeries *ts)
+{
+	free(ts);
+}
+
+void RNTimeSeriesClear(RNTimeSeries *ts)
+{
+	for (unsigned s = 0; s < ts->nSeries; s++) {
+		RNSeries *series = &ts->series[s];
+		uint32_t sequence = atomic_load_explicit(&series->sequence, memory_order_relaxed);
+		atomic_store_explicit(&series->sequence, sequence + 1, memory_order_relaxed);
+		atomic_thread_fence(memory_order_release);
+		for (unsigned l = 0; l < kRNTimeSeriesLevels; l++) {
+			atomic_store_explicit(&series->level[l].count, 0, memory_order_relaxed);
+			atomic_store_explicit(&series->level[l].pendingCount, 0, memory_order_relaxed);
+		}
+		atomic_store_explicit(&series->sequence, sequence + 2, memory_order_release);
+	}
+	atomic_store_explicit(&ts->lastTime_ns, INT64_MIN, memory_order_relaxed);
+}
+
+static inline void pushBucket(RNSeriesLevel *level, const RNTimeSeriesBucket *bucket)
+{
+	uint64_t count = atomic_load_explicit(&level->count, memory_order_relaxed);
+	storeBucket(&level->ring[count & kCapacityMask], bucket);
+	atomic_store_explicit(&level->count, count + 1, memory_order_relaxed);
+}
+
+void RNTimeSeriesAppend(RNTimeSeries *ts, unsigned s, int64_t time_ns, float value)
+{
+	if (s >= ts->nSeries) return;
+	RNSeries *series = &ts->series[s];
+
+	uint32_t sequence = atomic_load_explicit(&series->sequence, memory_order_relaxed);
+	atomic_store_explicit(&series->sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+
+	RNTimeSeriesBucket carry = { time_ns, value, value };
+	pushBucket(&series->level[0], &carry);
+
+	// roll completed buckets up the levels
+	for (unsigned l = 1; l < kRNTimeSeriesLevels; l++) {
+		RNSeriesLevel *level = &series->level[l];
+		uint32_t pendingCount = atomic_load_explicit(&level->pendingCount, memory_order_relaxed);
+		if (pendingCount == 0) {
+			level->accumulator = carry;
+		} else {
+			if (carry.min < level->accumulator.min) level->accumulator.min = carry.min;
+			if (carry.max > level->accumulator.max) level->accumulator.max = carry.max;
+		}
+		if (++pendingCount < kRNTimeSeriesFactor) {
+			storeBucket(&level->pending, &level->accumulator);
+			atomic_store_explicit(&level->pendingCount, pendingCount, memory_order_relaxed);
+			break;
+		}
+		pushBucket(level, &level->accumulator);
+		atomic_store_explicit(&level->pendingCount, 0, memory_order_relaxed);
+		carry = level->accumulator;
+	}
+
+	atomic_store_explicit(&series->sequence, sequence + 2, memory_order_release);
+	if (time_ns > atomic_load_explicit(&ts->lastTime_ns, memory_order_relaxed))
+		atomic_store_explicit(&ts->lastTime_ns, time_ns, memory_order_relaxed);
+}
+
+int64_t RNTimeSeriesLastTime(const RNTimeSeries *ts)
+{
+	return atomic_load_explicit(&((RNTimeSeries *) ts)->lastTime_ns, memory_order_relaxed);
+}
+
+// first ring index in [first, count) whose time is >= time_ns
+static uint64_t lowerBound(RNSeriesLevel *level, uint64_t first, uint64_t count, int64_t time_ns)
+{
+	while (first < count) {
+		uint64_t middle = first + (count - first) / 2;
+		int64_t t = (int64_t) atomic_load_explicit(&level->ring[middle & kCapacityMask].time, memory_order_relaxed);
+		if (t < time_ns) first = middle + 1;
+		else count = middle;
+	}
+	return first;
+}
+
+// merges buckets into the output, group buckets per output bucket
+typedef struct {
+	RNTimeSeriesBucket	*out;
+	uint32_t			nOut;
+	uint32_t			group;
+	uint32_t			inGroup;
+} RNBucketMerger;
+
+static inline void mergeBucket(RNBucketMerger *merger, RNTimeSeriesBucket bucket)
+{
+	if (merger->inGroup == 0) {
+		merger->out[merger->nOut++] = bucket;
+	} else {
+		RNTimeSeriesBucket *last = &merger->out[merger->nOut - 1];
+		if (bucket.min < last->min) last->min = bucket.min;
+		if (bucket.max > last->max) last->max = bucket.max;
+	}
+	if (++merger->inGroup == merger->group) merger->inGroup = 0;
+}
+
+uint32_t RNTimeSeriesQuery(const RNTimeSeries *timeSeries, unsigned s, int64_t start_ns, int64_t end_ns,
+						   uint32_t maxBuckets, RNTimeSeriesBucket *buckets)
+{
+	RNTimeSeries *ts = (RNTimeSeries *) timeSeries;
+	if (s >= ts->nSeries || maxBuckets == 0 || end_ns <= start_ns) return 0;
+	RNSeries *series = &ts->series[s];
+	uint32_t before, after, nOut;
+
+	do {
+		before = atomic_load_explicit(&series->sequence, memory_order_acquire);
+
+		// finest level that reaches back to start_ns without too many buckets in range
+		unsigned chosen = kRNTimeSeriesLevels - 1;
+		uint64_t first = 0, end = 0;
+		for (unsigned l = 0; l < kRNTimeSeriesLevels; l++) {
+			RNSeriesLevel *level = &series->level[l];
+			uint64_t count = atomic_load_explicit(&level->count, memory_order_relaxed);
+			uint64_t oldest = (count > kRNTimeSeriesCapacity) ? count - kRNTimeSeriesCapacity : 0;
+			bool reaches = (oldest == 0)
+				|| (int64_t) atomic_load_explicit(&level->ring[oldest & kCapacityMask].time, memory_order_relaxed) <= start_ns;
+			first	= lowerBound(level, oldest, count, start_ns);
+			end		= lowerBound(level, first, count, end_ns);
+			if (first > oldest) first--; // the bucket running into the range, so a plot enters from the left
+			if ((reaches && (end - first) <= (uint64_t) kQuerySlack * maxBuckets) || l == kRNTimeSeriesLevels - 1) {
+				chosen = l;
+				break;
+			}
+		}
+
+		// the newest points are still pending in the levels below the chosen one (oldest first)
+		RNTimeSeriesBucket tail[kRNTimeSeriesLevels];
+		unsigned nTail = 0;
+		for (unsigned l = chosen; l >= 1; l--) {
+			RNSeriesLevel *level = &series->level[l];
+			if (atomic_load_explicit(&level->pendingCount, memory_order_relaxed) == 0) continue;
+			RNTimeSeriesBucket pending = loadBucket(&level->pending);
+			if (pending.time_ns >= start_ns && pending.time_ns < end_ns) tail[nTail++] = pending;
+		}
+
+		uint64_t nIn = (end - first) + nTail;
+		RNBucketMerger merger = { buckets, 0, (uint32_t)((nIn + maxBuckets - 1) / maxBuckets), 0 };
+		if (merger.group == 0) merger.group = 1;
+		RNSeriesLevel *level = &series->level[chosen];
+		for (uint64_t i = first; i < end; i++)
+			mergeBucket(&merger, loadBucket(&level->ring[i & kCapacityMask]));
+		for (unsigned i = 0; i < nTail; i++)
+			mergeBucket(&merger, tail[i]);
+		nOut = merger.nOut;
+
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&series->sequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	return nOut;
+}
+
+void RNTimeSeriesBenchmark(uint32_t nPoints, double *append_ns, double *query_ns)
+{
+	RNTimeSeries *ts = RNTimeSeriesCreate(1);
+	RNTimeSeriesBucket *buckets = malloc(1000 * sizeof(RNTimeSeriesBucket));
+	struct timespec t0, t1, t2;
+	*append_ns = *query_ns = 0.0;
+	if (ts == NULL || buckets == NULL || nPoints == 0) {
+		RNTimeSeriesDestroy(ts);
+		free(buckets);
+		return;
+	}
+
+	// ~500 ms ITIs
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint32_t i = 0; i < nPoints; i++)
+		RNTimeSeriesAppend(ts, 0, (int64_t) i * 500000000LL, 480.0f + (float)((i * 2654435761u) % 40u));
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	const unsigned nQueries = 100;
+	uint32_t total = 0;
+	for (unsigned q = 0; q < nQueries; q++)
+		total += RNTimeSeriesQuery(ts, 0, 0, (int64_t) nPoints * 500000000LL, 1000, buckets);
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	volatile uint32_t sink = total; (void)sink; // keep the work
+
+	*append_ns	= ((double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec)) / nPoints;
+	*query_ns	= ((double)(t2.tv_sec - t1.tv_sec) * 1e9 + (double)(t2.tv_nsec - t1.tv_nsec)) / nQueries;
+	RNTimeSeriesDestroy(ts);
+	free(buckets);
+}
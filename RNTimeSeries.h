@@ -0,0 +1,64 @@
+//
+//  RNTimeSeries.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Fixed-memory time series for plotting (e.g. each node's ITIs over a whole session).
+//	- each series keeps kRNTimeSeriesLevels rings of buckets: level 0 holds single points,
+//	  each coarser level holds the min and max of kRNTimeSeriesFactor buckets of the level below
+//	- decimation is done as points are appended (O(1) amortized), so nothing is ever rescanned
+//	- old buckets fall off each ring; coarser levels reach further back in time
+//	- a query for a time range picks the finest level that covers it with a bounded number of
+//	  buckets and merges down to the number requested, so drawing costs O(pixels), not O(points)
+//
+// One thread appends; any thread may query. A query that races an append to the same series
+//	retries, so it always sees whole appends.
+
+#ifndef RNTimeSeries_h
+#define RNTimeSeries_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNTimeSeriesLevels		6
+#define kRNTimeSeriesFactor		8		// points per bucket grow by this much per level
+#define kRNTimeSeriesCapacity	2048	// buckets per level ring (power of 2)
+
+typedef struct {
+	int64_t		time_ns;		// first point in the bucket
+	float		min;
+	float		max;
+} RNTimeSeriesBucket;
+
+typedef struct RNTimeSeries RNTimeSeries;
+
+RNTimeSeries	*RNTimeSeriesCreate(unsigned nSeries);
+void			RNTimeSeriesDestroy(RNTimeSeries *timeSeries);
+
+// Appending thread only. Times within a series must not decrease.
+void			RNTimeSeriesAppend(RNTimeSeries *timeSeries, unsigned series, int64_t time_ns, float value);
+void			RNTimeSeriesClear(RNTimeSeries *timeSeries);
+
+// Any thread. Buckets of series starting in [start_ns, end_ns), plus the one before (it runs into
+//	the range), oldest first, merged so there are at most maxBuckets. Returns the number written.
+uint32_t		RNTimeSeriesQuery(const RNTimeSeries *timeSeries, unsigned series, int64_t start_ns, int64_t end_ns,
+								  uint32_t maxBuckets, RNTimeSeriesBucket *buckets);
+
+// Any thread. Time of the latest point in any series (INT64_MIN if empty).
+int64_t			RNTimeSeriesLastTime(const RNTimeSeries *timeSeries);
+
+// Rough timing of appends (ns per point) and of querying a full-session range into 1000 buckets
+//	(ns per query), with nPoints points in one series (clock_gettime).
+void			RNTimeSeriesBenchmark(uint32_t nPoints, double *append_ns, double *query_ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNTimeSeries_h */
@@ -0,0 +1,283 @@
+//
+//  RNTimingStats.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNTimingStats.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define kSnapshotWords	(sizeof(RNTimingSnapshot) / sizeof(uint64_t))
+_Static_assert(sizeof(RNTimingSnapshot) % sizeof(uint64_t) == 0, "snapshot must be whole words");
+
+// Welford running mean and sum of squared deviations
+typedef struct {
+	int64_t		n;
+	double		mean;
+	double		M2;
+} RNRunning;
+
+static inline void runningAdd(RNRunning *r, double x)
+{
+	r->n++;
+	double delta = x - r->mean;
+	r->mean += delta / r->n;
+	r->M2 += delta * (x - r->mean);
+}
+
+static inline double runningSD(const RNRunning *r)
+{
+	return (r->n > 1) ? sqrt(r->M2 / (r->n - 1)) : 0.0;
+}
+
+// writer-only state of one node
+typedef struct {
+	RNTimingPacer	pacer;
+	uint32_t		onsetHint;		// cursor into the pacer's onsets (taps arrive in time order)
+	int64_t			nTaps;
+	int64_t			lastTap_ns;
+	double			lastITI_ms;
+	double			smoothITI_ms;
+	double			lastAsynchrony_ms;
+	int64_t			lastOnsetIndex;
+	double			lastPhase;
+	RNRunning		ITI;
+	RNRunning		asynchrony;
+	double			sumCos, sumSin;
+	// drift: running co-moment of (time, unwrapped asynchrony)
+	double			unwrapped_ms;
+	double			meanTime_s, meanUnwrapped_ms;
+	double			Cxy, Mxx;
+} RNNodeTimingState;
+
+// what readers see: sequence counter is odd while a publish is in progress
+typedef struct {
+	_Atomic(uint32_t)	sequence;
+	_Atomic(uint64_t)	words[kSnapshotWords];
+} RNPublishedSnapshot;
+
+struct RNTimingStats {
+	unsigned				nNodes;
+	RNNodeTimingState		*state;
+	RNPublishedSnapshot		*published;
+};
+
+RNTimingStats *RNTimingStatsCreate(unsigned nNodes)
+{
+	RNTimingStats *stats = calloc(1, sizeof(RNTimingStats));
+	if (stats == NULL) return NULL;
+	stats->nNodes		= nNodes;
+	stats->state		= calloc(nNodes, sizeof(RNNodeTimingState));
+	stats->published	= calloc(nNodes, sizeof(RNPublishedSnapshot));
+	if (stats->state == NULL || stats->published == NULL) {
+		RNTimingStatsDestroy(stats);
+		return NULL;
+	}
+	return stats;
+}
+
+void RNTimingStatsDestroy(RNTimingStats *stats)
+{
+	if (stats == NULL) return;
+	if (stats->state)
+		for (unsigned node = 0; node < stats->nNodes; node++)
+			RNOnsetIndexRelease(stats->state[node].pacer.onsets);
+	free(stats->state);
+	free(stats->published);
+	free(stats);
+}
+
+static void publish(RNTimingStats *stats, unsigned node)
+{
+	const RNNodeTimingState *s = &stats->state[node];
+	RNPublishedSnapshot *p = &stats->published[node];
+	double IOI_ms = (s->pacer.IOI_ns > 0) ? s->pacer.IOI_ns / 1e6 : 0.0;
+	double phase = atan2(s->sumSin, s->sumCos);
+
+	RNTimingSnapshot snap = {
+		.nTaps						= s->nTaps,
+		.nITIs						= s->ITI.n,
+		.nAsynchronies				= s->asynchrony.n,
+		.lastTapTime_ms				= s->lastTap_ns / 1e6,
+		.lastITI_ms					= s->lastITI_ms,
+		.smoothITI_ms				= s->smoothITI_ms,
+		.meanITI_ms					= s->ITI.mean,
+		.sdITI_ms					= runningSD(&s->ITI),
+		.lastAsynchrony_ms			= s->lastAsynchrony_ms,
+		.lastOnsetIndex				= (s->asynchrony.n > 0) ? s->lastOnsetIndex : -1,
+		.lastPhase					= s->lastPhase,
+		.meanAsynchrony_ms			= s->asynchrony.mean,
+		.sdAsynchrony_ms			= runningSD(&s->asynchrony),
+		.circularMeanPhase			= (s->asynchrony.n > 0) ? phase : 0.0,
+		.circularMeanAsynchrony_ms	= (s->asynchrony.n > 0) ? phase / (2.0 * M_PI) * IOI_ms : 0.0,
+		.resultantLength			= (s->asynchrony.n > 0) ? hypot(s->sumCos, s->sumSin) / s->asynchrony.n : 0.0,
+		.drift_ms_per_s				= (s->Mxx > 0.0) ? s->Cxy / s->Mxx : 0.0,
+		.pacerIOI_ms				= IOI_ms,
+	};
+	uint64_t words[kSnapshotWords];
+	memcpy(words, &snap, sizeof(words));
+
+	uint32_t sequence = atomic_load_explicit(&p->sequence, memory_order_relaxed);
+	atomic_store_explicit(&p->sequence, sequence + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	for (unsigned i = 0; i < kSnapshotWords; i++)
+		atomic_store_explicit(&p->words[i], words[i], memory_order_relaxed);
+	atomic_store_explicit(&p->sequence, sequence + 2, memory_order_release);
+}
+
+RNOnsetMatch RNTimingPacerMatch(RNTimingPacer pacer, int64_t time_ns, uint32_t *hint)
+{
+	RNOnsetMatch match = RNOnsetIndexNearest(pacer.onsets, time_ns, hint);
+	int64_t first = 0;
+	if (match.index >= 0) {
+		int64_t last = (int64_t) RNOnsetIndexCount(pacer.onsets) - 1;
+		if (match.interval_ns <= 0) match.interval_ns = pacer.IOI_ns; // a single onset
+		int64_t halfInterval = match.interval_ns / 2;
+		bool beyond = (match.index == 0 && match.asynchrony_ns < -halfInterval)
+			|| (match.index == last && match.asynchrony_ns >= halfInterval);
+		if (!beyond || pacer.IOI_ns <= 0)
+			return match;
+		// past the scheduled onsets: carry on periodically from the end one
+		pacer.onset_ns	= match.onset_ns;
+		first			= match.index;
+	} else if (pacer.IOI_ns <= 0) {
+		return match;
+	}
+
+	match.asynchrony_ns	= RNTimingPacerAsynchrony(pacer, time_ns);
+	match.onset_ns		= time_ns - match.asynchrony_ns;
+	match.index			= first + (match.onset_ns - pacer.onset_ns) / pacer.IOI_ns;
+	match.interval_ns	= pacer.IOI_ns;
+	return match;
+}
+
+void RNTimingStatsResetNode(RNTimingStats *stats, unsigned node)
+{
+	if (node >= stats->nNodes) return;
+	RNTimingPacer pacer = stats->state[node].pacer;
+	memset(&stats->state[node], 0, sizeof(RNNodeTimingState));
+	stats->state[node].pacer = pacer;
+	publish(stats, node);
+}
+
+void RNTimingStatsReset(RNTimingStats *stats)
+{
+	for (unsigned node = 0; node < stats->nNodes; node++)
+		RNTimingStatsResetNode(stats, node);
+}
+
+void RNTimingStatsSetPacer(RNTimingStats *stats, unsigned node, RNTimingPacer pacer)
+{
+	if (node >= stats->nNodes) return;
+	RNNodeTimingState *s = &stats->state[node];
+	if (RNTimingPacerEqual(s->pacer, pacer)) return;
+	RNOnsetIndexRetain(pacer.onsets);
+	RNOnsetIndexRelease(s->pacer.onsets);
+	s->pacer = pacer;
+	RNTimingStatsResetNode(stats, node);
+}
+
+int64_t RNTimingStatsAddTap(RNTimingStats *stats, unsigned node, int64_t time_ns)
+{
+	if (node >= stats->nNodes) return 0;
+	RNNodeTimingState *s = &stats->state[node];
+
+	if (s->nTaps > 0) {
+		s->lastITI_ms	= (time_ns - s->lastTap_ns) / 1e6;
+		s->smoothITI_ms	= (s->ITI.n == 0) ? s->lastITI_ms : (3.0 * s->smoothITI_ms + s->lastITI_ms) / 4.0;
+		runningAdd(&s->ITI, s->lastITI_ms);
+	}
+	s->nTaps++;
+	s->lastTap_ns = time_ns;
+
+	int64_t asynchrony_ns = 0;
+	if (s->pacer.IOI_ns > 0) {
+		RNOnsetMatch match		= RNTimingPacerMatch(s->pacer, time_ns, &s->onsetHint);
+		asynchrony_ns			= match.asynchrony_ns;
+		double asynchrony_ms	= asynchrony_ns / 1e6;
+		double IOI_ms			= s->pacer.IOI_ns / 1e6;
+		double phase			= (match.interval_ns > 0) ? 2.0 * M_PI * asynchrony_ns / (double) match.interval_ns : 0.0;
+
+		s->lastAsynchrony_ms	= asynchrony_ms;
+		s->lastOnsetIndex		= match.index;
+		s->lastPhase			= phase;
+		runningAdd(&s->asynchrony, asynchrony_ms);
+		s->sumCos += cos(phase);
+		s->sumSin += sin(phase);
+
+		// unwrap across beat boundaries so a steady tempo mismatch reads as a constant slope
+		if (s->asynchrony.n == 1) {
+			s->unwrapped_ms = asynchrony_ms;
+		} else {
+			double step = asynchrony_ms - remainder(s->unwrapped_ms, IOI_ms);
+			s->unwrapped_ms += remainder(step, IOI_ms);
+		}
+		double t_s = time_ns / 1e9;
+		double n = (double) s->asynchrony.n;
+		double dx = t_s - s->meanTime_s;
+		s->meanTime_s		+= dx / n;
+		s->meanUnwrapped_ms	+= (s->unwrapped_ms - s->meanUnwrapped_ms) / n;
+		s->Cxy += dx * (s->unwrapped_ms - s->meanUnwrapped_ms);
+		s->Mxx += dx * (t_s - s->meanTime_s);
+	}
+
+	publish(stats, node);
+	return asynchrony_ns;
+}
+
+bool RNTimingStatsGetSnapshot(const RNTimingStats *stats, unsigned node, RNTimingSnapshot *snapshot)
+{
+	if (node >= stats->nNodes) return false;
+	RNPublishedSnapshot *p = &((RNTimingStats *)stats)->published[node];
+	uint64_t words[kSnapshotWords];
+	uint32_t before, after;
+
+	do {
+		before = atomic_load_explicit(&p->sequence, memory_order_acquire);
+		for (unsigned i = 0; i < kSnapshotWords; i++)
+			words[i] = atomic_load_explicit(&p->words[i], memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		after = atomic_load_explicit(&p->sequence, memory_order_relaxed);
+	} while ((before & 1) || before != after);
+
+	memcpy(snapshot, words, sizeof(words));
+	return true;
+}
+
+double RNTimingStatsBenchmark(unsigned nNodes, uint32_t nTaps)
+{
+	RNTimingStats *stats = RNTimingStatsCreate(nNodes);
+	int64_t *times = malloc(nTaps * sizeof(int64_t));
+	struct timespec t0, t1;
+
+	if (stats == NULL || times == NULL || nNodes == 0 || nTaps == 0) {
+		RNTimingStatsDestroy(stats);
+		free(times);
+		return 0.0;
+	}
+
+	// ~500 ms tapping against a 500 ms pacer, with some scatter
+	RNTimingPacer pacer = { .onset_ns = 1000000000LL, .IOI_ns = 500000000LL };
+	for (unsigned node = 0; node < nNodes; node++)
+		RNTimingStatsSetPacer(stats, node, pacer);
+	for (uint32_t i = 0; i < nTaps; i++)
+		times[i] = (int64_t)(i / nNodes) * 500000000LL + (int64_t)((i * 2654435761u) % 40000000u) - 20000000LL;
+
+	int64_t sum = 0;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (uint32_t i = 0; i < nTaps; i++)
+		sum += RNTimingStatsAddTap(stats, i % nNodes, times[i]);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	double elapsed_ns = (double)(t1.tv_sec - t0.tv_sec) * 1e9 + (double)(t1.tv_nsec - t0.tv_nsec);
+	volatile int64_t sink = sum; (void)sink; // keep the work
+
+	RNTimingStatsDestroy(stats);
+	free(times);
+	return elapsed_ns / nTaps;
+}
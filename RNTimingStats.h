@@ -0,0 +1,106 @@
+//
+//  RNTimingStats.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Running tapping statistics, one set per node, updated in O(1) as each tap arrives:
+//	- ITI: last, smoothed, Welford mean and standard deviation
+//	- asynchrony to the node's pacer (its scheduled onsets if known): Welford mean and standard deviation
+//	- circular mean phase and resultant vector length (R) of taps relative to the pacer
+//	- drift: least-squares slope of unwrapped asynchrony against time, updated incrementally
+//
+// One thread writes (adds taps, sets pacers); any thread may read a node's latest
+//	values as a consistent snapshot, published through a per-node sequence counter.
+//	Readers never block the writer; a reader that races a publish simply retries.
+
+#ifndef RNTimingStats_h
+#define RNTimingStats_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNOnsetIndex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pacer in integer ns (on the same clock as tap times): nominally onsets at onset_ns + k * IOI_ns.
+//	With an onset index the scheduled onsets are used instead, continued periodically past either end.
+//	Whoever keeps a pacer holds a reference to its onsets (RNOnsetIndexRetain/Release).
+typedef struct {
+	int64_t			onset_ns;
+	int64_t			IOI_ns;		// <= 0: no pacer, asynchrony statistics are not collected
+	RNOnsetIndex	*onsets;	// NULL: periodic
+} RNTimingPacer;
+
+static inline bool RNTimingPacerEqual(RNTimingPacer a, RNTimingPacer b)
+{
+	return a.onset_ns == b.onset_ns && a.IOI_ns == b.IOI_ns && a.onsets == b.onsets;
+}
+
+// Signed distance (ns) from time_ns to the nearest pacer onset, in [-IOI/2, IOI/2).
+//	Exact integer arithmetic, valid before the first onset too.
+static inline int64_t RNTimingPacerAsynchrony(RNTimingPacer pacer, int64_t time_ns)
+{
+	if (pacer.IOI_ns <= 0) return 0;
+	int64_t phase_ns = (time_ns - pacer.onset_ns) % pacer.IOI_ns;
+	if (phase_ns < 0) phase_ns += pacer.IOI_ns;
+	return (2 * phase_ns >= pacer.IOI_ns) ? phase_ns - pacer.IOI_ns : phase_ns;
+}
+
+// Nearest onset to time_ns: scheduled if the pacer has onsets, else periodic (index counts from
+//	onset_ns, so may be negative). index is -1 if there is no pacer. hint as for RNOnsetIndexNearest.
+RNOnsetMatch	RNTimingPacerMatch(RNTimingPacer pacer, int64_t time_ns, uint32_t *hint);
+
+// Published values for one node. All fields are 8 bytes wide (the snapshot is copied word by word).
+typedef struct {
+	int64_t		nTaps;
+	int64_t		nITIs;
+	int64_t		nAsynchronies;
+	double		lastTapTime_ms;
+	double		lastITI_ms;
+	double		smoothITI_ms;			// exponential, weight 1/4 on the newest ITI
+	double		meanITI_ms;
+	double		sdITI_ms;
+	double		lastAsynchrony_ms;
+	int64_t		lastOnsetIndex;			// pacer onset nearest the last tap (-1 if none)
+	double		lastPhase;				// radians in [-pi, pi) of the last tap within its local IOI
+	double		meanAsynchrony_ms;
+	double		sdAsynchrony_ms;
+	double		circularMeanPhase;		// radians in (-pi, pi], 0 = on the pacer onset
+	double		circularMeanAsynchrony_ms;
+	double		resultantLength;		// R in [0, 1]: 1 = perfectly phase locked
+	double		drift_ms_per_s;			// slope of asynchrony vs time; < 0: getting earlier
+	double		pacerIOI_ms;			// 0 if none
+} RNTimingSnapshot;
+
+typedef struct RNTimingStats RNTimingStats;
+
+// Statistics for nodes 0..nNodes-1
+RNTimingStats	*RNTimingStatsCreate(unsigned nNodes);
+void			RNTimingStatsDestroy(RNTimingStats *stats);
+
+// Writer side. Changing a node's pacer restarts its statistics (the old ones were about another beat);
+//	the stats keep a reference to the pacer's onsets.
+void			RNTimingStatsSetPacer(RNTimingStats *stats, unsigned node, RNTimingPacer pacer);
+void			RNTimingStatsResetNode(RNTimingStats *stats, unsigned node);
+void			RNTimingStatsReset(RNTimingStats *stats);	// all nodes, pacers kept
+
+// Writer side: a tap by node at time_ns (taps of a node in time order). Returns its asynchrony
+//	to the node's pacer in ns (0 if the node has none).
+int64_t			RNTimingStatsAddTap(RNTimingStats *stats, unsigned node, int64_t time_ns);
+
+// Any thread: copy node's latest values. Returns false for a node out of range.
+bool			RNTimingStatsGetSnapshot(const RNTimingStats *stats, unsigned node, RNTimingSnapshot *snapshot);
+
+// Rough timing of AddTap: nTaps synthetic taps spread over nNodes nodes, returns mean ns per tap
+//	(uses clock_gettime, so usable off the realtime path only).
+double			RNTimingStatsBenchmark(unsigned nNodes, uint32_t nTaps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNTimingStats_h */
@@ -0,0 +1,370 @@
+//
+//  RNVirtualTappers.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+#include "RNVirtualTappers.h"
+#include "RNHostClock.h"
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#ifdef __APPLE__
+#include <pthread/qos.h>
+#endif
+
+#define kRingMask		(kRNVirtualRingLength - 1)
+#define kHeardHistory	4		// events remembered per input, enough to find the one nearest a tap
+#define kDefaultPeriod_ns	500e6
+
+// what an agent hears, as it travels
+typedef struct {
+	int64_t		time_ns;
+	uint8_t		listener;
+	uint8_t		source;		// tapper, or 0: stimulus
+} RNHeard;
+
+typedef struct {
+	RNHeard				heard[kRNVirtualRingLength];
+	_Atomic(uint32_t)	head;		// next slot to write; producer only (free running, wraps)
+	_Atomic(uint32_t)	tail;		// next slot to read; agents' thread only
+} RNHeardRing;
+
+typedef struct {
+	bool			playing;
+	bool			decided;		// next tap settled (else a decision is due)
+	RNSimTimekeeper	timekeeper;
+	int64_t			lastTap_ns;
+	int64_t			nextTap_ns;
+	int64_t			decision_ns;
+	int64_t			heard[kRNVirtualMaxNodes + 1][kHeardHistory];	// by input (0: stimulus), ring
+	uint8_t			nextHeard[kRNVirtualMaxNodes + 1];
+} RNVirtualAgent;
+
+struct RNVirtualTappers {
+	RNSimTapperParameters	parameters;
+	RNVirtualTapProc		tapProc;
+	void					*refCon;
+	pthread_t				thread;
+	_Atomic(bool)			running;
+
+	// network handoff: control thread writes the buffer not last published, after the agents took that one
+	RNVirtualNetwork		published[2];
+	_Atomic(uint32_t)		publishedGeneration;
+	_Atomic(uint32_t)		takenGeneration;
+	_Atomic(uint64_t)		agentNodes;		// of the last network set: producers filter on it
+
+	RNHeardRing				rings[kRNEventRecorderNumProducers];
+
+	// agents' thread only
+	RNVirtualNetwork		network;
+	RNSimRandom				random;
+	RNVirtualAgent			agents[kRNVirtualMaxNodes + 1];
+	RNHeard					pending[kRNVirtualPendingLength];	// min-heap on time
+	uint32_t				nPending;
+	RNVirtualTap			taps[kRNVirtualMaxNodes];
+
+	_Atomic(uint64_t)		nTaps;
+	_Atomic(uint64_t)		nHeard;
+	_Atomic(uint64_t)		nDropped;
+	_Atomic(int64_t)		maxLateness_ns;
+	_Atomic(int64_t)		sumLateness_ns;
+};
+
+// *********************************************
+//    Pending heard events
+// *********************************************
+
+static bool pendingPush(RNVirtualTappers *vt, RNHeard heard)
+{
+	if (vt->nPending >= kRNVirtualPendingLength) return false;
+	uint32_t i = vt->nPending++;
+	while (i > 0) {
+		uint32_t parent = (i - 1) / 2;
+		if (vt->pending[parent].time_ns <= heard.time_ns) break;
+		vt->pending[i] = vt->pending[parent];
+		i = parent;
+	}
+	vt->pending[i] = heard;
+	return true;
+}
+
+static RNHeard pendingPop(RNVirtualTappers *vt)
+{
+	RNHeard top = vt->pending[0];
+	RNHeard last = vt->pending[--vt->nPending];
+	uint32_t i = 0;
+	for (;;) {
+		uint32_t child = 2 * i + 1;
+		if (child >= vt->nPending) break;
+		if (child + 1 < vt->nPending && vt->pending[child + 1].time_ns < vt->pending[child].time_ns) child++;
+		if (vt->pending[child].time_ns >= last.time_ns) break;
+		vt->pending[i] = vt->pending[child];
+		i = child;
+	}
+	if (vt->nPending > 0) vt->pending[i] = last;
+	return top;
+}
+
+// *********************************************
+//    Agents
+// *********************************************
+
+static void startAgent(RNVirtualTappers *vt, unsigned node, int64_t now_ns)
+{
+	RNVirtualAgent *agent = &vt->agents[node];
+	memset(agent, 0, sizeof(RNVirtualAgent));
+	for (unsigned j = 0; j <= kRNVirtualMaxNodes; j++)
+		for (unsigned k = 0; k < kHeardHistory; k++)
+			agent->heard[j][k] = INT64_MIN;
+	double defaultPeriod_ns = (vt->network.period_ms > 0.0) ? vt->network.period_ms * 1e6 : kDefaultPeriod_ns;
+	agent->playing		= true;
+	agent->decided		= true;
+	agent->lastTap_ns	= INT64_MIN;
+	agent->nextTap_ns	= RNSimTimekeeperStart(&agent->timekeeper, &vt->parameters, defaultPeriod_ns, now_ns, &vt->random);
+}
+
+static void takeNetwork(RNVirtualTappers *vt, int64_t now_ns)
+{
+	uint32_t generation = atomic_load_explicit(&vt->publishedGeneration, memory_order_acquire);
+	if (generation == atomic_load_explicit(&vt->takenGeneration, memory_order_relaxed)) return;
+	memcpy(&vt->network, &vt->published[generation & 1], sizeof(RNVirtualNetwork));
+	atomic_store_explicit(&vt->takenGeneration, generation, memory_order_release);
+
+	for (unsigned node = 1; node <= kRNVirtualMaxNodes; node++) {
+		bool isAgent = (vt->network.agents >> node) & 1;
+		if (isAgent && !vt->agents[node].playing) startAgent(vt, node, now_ns);
+		else if (!isAgent) vt->agents[node].playing = false;
+	}
+}
+
+static void drainRings(RNVirtualTappers *vt)
+{
+	for (unsigned iRing = 0; iRing < kRNEventRecorderNumProducers; iRing++) {
+		RNHeardRing *ring = &vt->rings[iRing];
+		uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+		uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		uint64_t nDropped = 0;
+		for (; tail != head; tail++)
+			if (!pendingPush(vt, ring->heard[tail & kRingMask])) nDropped++;
+		atomic_store_explicit(&ring->tail, tail, memory_order_release);
+		if (nDropped) atomic_fetch_add_explicit(&vt->nDropped, nDropped, memory_order_relaxed);
+	}
+}
+
+static void hear(RNVirtualTappers *vt, RNHeard heard)
+{
+	RNVirtualAgent *agent = &vt->agents[heard.listener];
+	if (!agent->playing) return;
+	agent->heard[heard.source][agent->nextHeard[heard.source]] = heard.time_ns;
+	agent->nextHeard[heard.source] = (agent->nextHeard[heard.source] + 1) % kHeardHistory;
+	atomic_fetch_add_explicit(&vt->nHeard, 1, memory_order_relaxed);
+}
+
+// settle the next tap from the asynchronies of the last one to the nearest event heard from each input
+static void decide(RNVirtualTappers *vt, unsigned node, int64_t now_ns)
+{
+	RNVirtualAgent *agent = &vt->agents[node];
+	int64_t window_ns = llround(agent->timekeeper.period_ns / 2.0);
+	double weightedAsynchrony_ns = 0.0;
+
+	for (unsigned input = 0; input <= kRNVirtualMaxNodes; input++) {
+		float gain = vt->network.gain[input][node];
+		if (gain <= 0.0f) continue;
+		int64_t best = INT64_MAX, heard_ns = 0;
+		for (unsigned k = 0; k < kHeardHistory; k++) {
+			int64_t h = agent->heard[input][k];
+			if (h == INT64_MIN) continue;
+			int64_t distance = llabs(agent->lastTap_ns - h);
+			if (distance <= window_ns && distance < best) {
+				best = distance;
+				heard_ns = h;
+			}
+		}
+		if (best != INT64_MAX) weightedAsynchrony_ns += gain * (double)(agent->lastTap_ns - heard_ns);
+	}
+
+	agent->nextTap_ns	= RNSimTimekeeperNext(&agent->timekeeper, &vt->parameters, weightedAsynchrony_ns, now_ns, &vt->random);
+	agent->decided		= true;
+}
+
+static void *agentThread(void *arg)
+{
+	RNVirtualTappers *vt = arg;
+#ifdef __APPLE__
+	pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0); // as the MIDI processing queue
+#endif
+
+	while (atomic_load_explicit(&vt->running, memory_order_acquire)) {
+		int64_t now_ns = RNHostClockNow();
+		takeNetwork(vt, now_ns);
+		drainRings(vt);
+		while (vt->nPending > 0 && vt->pending[0].time_ns <= now_ns)
+			hear(vt, pendingPop(vt));
+
+		// taps due, then decisions due
+		uint32_t nTaps = 0;
+		bool anyPlaying = false;
+		int64_t wake_ns = INT64_MAX;
+		for (unsigned node = 1; node <= kRNVirtualMaxNodes; node++) {
+			RNVirtualAgent *agent = &vt->agents[node];
+			if (!agent->playing) continue;
+			anyPlaying = true;
+			if (agent->decided && agent->nextTap_ns <= now_ns) {
+				RNVirtualTap tap = { agent->nextTap_ns, (uint16_t) node, kRNSimTapVelocity };
+				uint32_t i = nTaps++;
+				for (; i > 0 && vt->taps[i - 1].time_ns > tap.time_ns; i--) vt->taps[i] = vt->taps[i - 1];
+				vt->taps[i] = tap;
+
+				int64_t lateness_ns = now_ns - agent->nextTap_ns;
+				atomic_fetch_add_explicit(&vt->sumLateness_ns, lateness_ns, memory_order_relaxed);
+				if (lateness_ns > atomic_load_explicit(&vt->maxLateness_ns, memory_order_relaxed))
+					atomic_store_explicit(&vt->maxLateness_ns, lateness_ns, memory_order_relaxed);
+
+				agent->lastTap_ns	= agent->nextTap_ns;
+				agent->decision_ns	= agent->lastTap_ns + llround(agent->timekeeper.period_ns / 2.0);
+				agent->decided		= false;
+			}
+			if (!agent->decided && agent->decision_ns <= now_ns) decide(vt, node, now_ns);
+			int64_t due_ns = agent->decided ? agent->nextTap_ns : agent->decision_ns;
+			if (due_ns < wake_ns) wake_ns = due_ns;
+		}
+		if (nTaps > 0) {
+			vt->tapProc(vt->taps, nTaps, vt->refCon);
+			atomic_fetch_add_explicit(&vt->nTaps, nTaps, memory_order_relaxed);
+		}
+
+		// sleep until something is due, checking for new input at least every poll
+		if (vt->nPending > 0 && vt->pending[0].time_ns < wake_ns) wake_ns = vt->pending[0].time_ns;
+		int64_t poll_ns = now_ns + (anyPlaying ? kRNVirtualPoll_ns : kRNVirtualIdlePoll_ns);
+		if (poll_ns < wake_ns) wake_ns = poll_ns;
+		int64_t sleep_ns = wake_ns - RNHostClockNow();
+		if (sleep_ns > 0) {
+			struct timespec interval = { (time_t)(sleep_ns / 1000000000), (long)(sleep_ns % 1000000000) };
+			nanosleep(&interval, NULL);
+		}
+	}
+	return NULL;
+}
+
+// *********************************************
+//    Public
+// *********************************************
+
+RNVirtualTappers *RNVirtualTappersCreate(const RNSimTapperParameters *parameters, uint64_t seed,
+										 RNVirtualTapProc tapProc, void *refCon)
+{
+	if (parameters == NULL || tapProc == NULL) return NULL;
+	RNVirtualTappers *vt = calloc(1, sizeof(RNVirtualTappers));
+	if (vt == NULL) return NULL;
+	vt->parameters	= *parameters;
+	vt->tapProc		= tapProc;
+	vt->refCon		= refCon;
+	RNSimRandomSeed(&vt->random, seed);
+	atomic_init(&vt->running, true);
+
+	if (pthread_create(&vt->thread, NULL, agentThread, vt) != 0) {
+		free(vt);
+		return NULL;
+	}
+	return vt;
+}
+
+void RNVirtualTappersDestroy(RNVirtualTappers *vt)
+{
+	if (vt == NULL) return;
+	atomic_store_explicit(&vt->running, false, memory_order_release);
+	pthread_join(vt->thread, NULL);
+	free(vt);
+}
+
+void RNVirtualTappersSetNetwork(RNVirtualTappers *vt, const RNVirtualNetwork *network)
+{
+	uint32_t generation = atomic_load_explicit(&vt->publishedGeneration, memory_order_relaxed);
+	while (atomic_load_explicit(&vt->takenGeneration, memory_order_acquire) != generation) {
+		struct timespec interval = { 0, kRNVirtualPoll_ns / 4 };
+		nanosleep(&interval, NULL);
+	}
+	memcpy(&vt->published[(generation + 1) & 1], network, sizeof(RNVirtualNetwork));
+	vt->published[(generation + 1) & 1].agents &= ~1ULL; // node 0 is big brother
+	atomic_store_explicit(&vt->agentNodes, vt->published[(generation + 1) & 1].agents, memory_order_relaxed);
+	atomic_store_explicit(&vt->publishedGeneration, generation + 1, memory_order_release);
+}
+
+uint32_t RNVirtualTappersPush(RNVirtualTappers *vt, RNEventRecorderProducer producer, const RNEvent *events, uint32_t nEvents)
+{
+	if ((unsigned)producer >= kRNEventRecorderNumProducers) return 0;
+	RNHeardRing *ring = &vt->rings[producer];
+	uint64_t agentNodes = atomic_load_explicit(&vt->agentNodes, memory_order_relaxed);
+
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	uint32_t nDropped = 0;
+	for (uint32_t i = 0; i < nEvents; i++) {
+		const RNEvent *event = &events[i];
+		if (event->node == 0 || event->node > kRNVirtualMaxNodes || !((agentNodes >> event->node) & 1)) continue;
+		RNHeard heard = { .time_ns = event->time_ns, .listener = (uint8_t) event->node };
+		if (event->kind == kRNEventKindStimulus) {
+			heard.source = 0;
+		} else if (event->kind == kRNEventKindFeedback) {
+			if (event->note <= kRNSimBaseNote || event->note > kRNSimBaseNote + kRNVirtualMaxNodes) continue;
+			heard.source = (uint8_t)(event->note - kRNSimBaseNote);
+		} else {
+			continue;
+		}
+		if (head - tail == kRNVirtualRingLength) {
+			nDropped++;
+			continue;
+		}
+		ring->heard[head & kRingMask] = heard;
+		head++;
+	}
+	atomic_store_explicit(&ring->head, head, memory_order_release);
+	if (nDropped) atomic_fetch_add_explicit(&vt->nDropped, nDropped, memory_order_relaxed);
+	return nEvents - nDropped;
+}
+
+RNVirtualTappersCounts RNVirtualTappersGetCounts(const RNVirtualTappers *vt)
+{
+	RNVirtualTappers *mutableVT = (RNVirtualTappers *) vt; // atomics are read-only here
+	RNVirtualTappersCounts counts = {
+		.taps			= atomic_load_explicit(&mutableVT->nTaps, memory_order_relaxed),
+		.heard			= atomic_load_explicit(&mutableVT->nHeard, memory_order_relaxed),
+		.dropped		= atomic_load_explicit(&mutableVT->nDropped, memory_order_relaxed),
+		.maxLateness_ns	= atomic_load_explicit(&mutableVT->maxLateness_ns, memory_order_relaxed),
+	};
+	int64_t sum_ns = atomic_load_explicit(&mutableVT->sumLateness_ns, memory_order_relaxed);
+	counts.meanLateness_ns = (counts.taps > 0) ? (double) sum_ns / counts.taps : 0.0;
+	return counts;
+}
+
+bool RNVirtualTappersParseNodes(const char *string, uint64_t *nodes)
+{
+	uint64_t mask = 0;
+	const char *p = string;
+	while (*p) {
+		char *end;
+		long first = strtol(p, &end, 10), last;
+		if (end == p) return false;
+		p = end;
+		while (*p == ' ') p++;
+		if (*p == '-') {
+			last = strtol(p + 1, &end, 10);
+			if (end == p + 1) return false;
+			p = end;
+		} else {
+			last = first;
+		}
+		if (first < 1 || last > kRNVirtualMaxNodes || first > last) return false;
+		for (long node = first; node <= last; node++) mask |= 1ULL << node;
+		while (*p == ' ') p++;
+		if (*p == ',') p++;
+		else if (*p) return false;
+	}
+	*nodes = mask;
+	return mask != 0;
+}
@@ -0,0 +1,91 @@
+//
+//  RNVirtualTappers.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Simulated tappers for a live session, to rehearse and stress-test experiments without a full
+//	group: each agent plays one node with the timing model of RNSimulator.h, listening to what it
+//	is actually routed (stimulus events and feedback) and tapping back.
+//	- agents run on their own thread, sleeping until the next tap or decision is due (never more
+//	  than a poll interval): taps are handed out when due, stamped with the time they were meant
+//	  for; how late that was is kept in the counts
+//	- what agents hear is pushed from the threads that know it, each through its own single-
+//	  producer ring (as RNEventRecorder: no locks or allocation), as the RNEvents being recorded:
+//	  stimulus events by listener, feedback by target node with the tapper in its note
+//	- events may be pushed before they sound (stimuli are scheduled ahead): agents hear them when due
+//	- the network is set from the control thread and swapped in on the agents' next wake
+//	- up to 16 agents (one MIDI channel per node, as for real tappers), mixed freely with real
+//	  inputs: nodes without an agent are left to people
+
+#ifndef RNVirtualTappers_h
+#define RNVirtualTappers_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "RNEventStore.h"
+#include "RNEventRecorder.h"
+#include "RNSimulator.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define kRNVirtualMaxNodes			16		// = kMaxNodes: taps are sent on the node's MIDI channel
+#define kRNVirtualRingLength		16384	// heard events per producer ring (power of 2): a long stimulus, several listeners
+#define kRNVirtualPendingLength		16384	// heard events waiting for their time
+#define kRNVirtualPoll_ns			1000000	// longest sleep while any agent plays
+#define kRNVirtualIdlePoll_ns		20000000
+
+typedef struct {
+	uint64_t	agents;		// bit n: node n is played by an agent
+	double		period_ms;	// preferred period if the parameters give none (the stimulus IOI); <= 0: 500 ms
+	float		gain[kRNVirtualMaxNodes + 1][kRNVirtualMaxNodes + 1];	// [from][to] connection weight (from 0: stimulus); 0: not heard
+} RNVirtualNetwork;
+
+typedef struct {
+	int64_t		time_ns;	// host clock: when the tap was meant to happen
+	uint16_t	node;
+	uint8_t		velocity;
+} RNVirtualTap;
+
+typedef struct {
+	uint64_t	taps;
+	uint64_t	heard;			// events applied to an agent
+	uint64_t	dropped;		// pushed events lost to a full ring or pending queue
+	int64_t		maxLateness_ns;	// of a tap handed out after its time
+	double		meanLateness_ns;
+} RNVirtualTappersCounts;
+
+// Called on the agents' thread with the taps due, in time order. Must not block.
+typedef void (*RNVirtualTapProc)(const RNVirtualTap *taps, uint32_t nTaps, void *refCon);
+
+typedef struct RNVirtualTappers RNVirtualTappers;
+
+// Starts the agents' thread, with no agents playing until a network is set.
+RNVirtualTappers		*RNVirtualTappersCreate(const RNSimTapperParameters *parameters, uint64_t seed,
+												RNVirtualTapProc tapProc, void *refCon);
+void					RNVirtualTappersDestroy(RNVirtualTappers *tappers);		// stops and joins the thread
+
+// Control thread. Agents new to the network join at a random phase; agents left out stop.
+//	Waits (at most a poll interval) if the agents have not yet taken the previous network.
+void					RNVirtualTappersSetNetwork(RNVirtualTappers *tappers, const RNVirtualNetwork *network);
+
+// Producer side: only one thread may push to a given producer ring. Times are absolute (host clock).
+//	Stimulus and feedback events are taken; anything else, or for a node without an agent, is ignored.
+//	Returns the number of events accepted; the rest are counted as dropped.
+uint32_t				RNVirtualTappersPush(RNVirtualTappers *tappers, RNEventRecorderProducer producer,
+											 const RNEvent *events, uint32_t nEvents);
+
+// Any thread.
+RNVirtualTappersCounts	RNVirtualTappersGetCounts(const RNVirtualTappers *tappers);
+
+// "1-6,9,12" -> bit mask of nodes 1..kRNVirtualMaxNodes. false if malformed or out of range.
+bool					RNVirtualTappersParseNodes(const char *string, uint64_t *nodes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* RNVirtualTappers_h */
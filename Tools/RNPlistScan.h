@@ -0,0 +1,147 @@
+//
+//  RNPlistScan.h
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// In-place scanning of XML plist text for the command line tools: no parser, no copies, just
+//	pointers into a (memory-mapped) buffer. Enough for the flat dictionaries we write and read:
+//	a key's value element, integers in running text, and entity-decoded strings.
+//
+// Header only (static inline functions); define _GNU_SOURCE before including anything, for memmem.
+
+#ifndef RNPlistScan_h
+#define RNPlistScan_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+
+// next signed integer at or after p (skipping whitespace only); NULL if none before end
+static inline const char *parseInt64(const char *p, const char *end, int64_t *value)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+	bool negative = false;
+	if (p < end && *p == '-') { negative = true; p++; }
+	if (p >= end || (unsigned)(*p - '0') > 9) return NULL;
+
+	uint64_t u = 0;
+	while (p < end && (unsigned)(*p - '0') <= 9) u = u * 10 + (uint64_t)(*p++ - '0');
+	*value = negative ? -(int64_t)u : (int64_t)u;
+	return p;
+}
+
+static inline const char *skipSpace(const char *p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+	return p;
+}
+
+static inline bool hasPrefix(const char *p, const char *end, const char *prefix)
+{
+	size_t n = strlen(prefix);
+	return (size_t)(end - p) >= n && memcmp(p, prefix, n) == 0;
+}
+
+static inline const char *find(const char *p, const char *end, const char *needle)
+{
+	return memmem(p, (size_t)(end - p), needle, strlen(needle));
+}
+
+// value element following p: sets [*valueStart, *valueEnd) to its text and returns the position after it
+static inline const char *plistValue(const char *p, const char *end, const char **valueStart, const char **valueEnd)
+{
+	p = skipSpace(p, end);
+	if (p >= end || *p != '<') return NULL;
+	const char *tagEnd = memchr(p, '>', (size_t)(end - p));
+	if (!tagEnd) return NULL;
+
+	if (tagEnd[-1] == '/') {	// empty element, e.g. <string/>
+		*valueStart = *valueEnd = tagEnd;
+		return tagEnd + 1;
+	}
+	char closeTag[32] = "</";
+	size_t nameLength = (size_t)(tagEnd - p - 1);
+	if (nameLength + 4 > sizeof(closeTag)) return NULL;
+	memcpy(closeTag + 2, p + 1, nameLength);
+	closeTag[2 + nameLength] = '>';
+	closeTag[3 + nameLength] = '\0';
+
+	// nested elements of the same name (an <array> of <array>s) close first
+	char openTag[32] = "<";
+	memcpy(openTag + 1, p + 1, nameLength + 1);
+	openTag[nameLength + 2] = '\0';
+	const char *close = tagEnd + 1, *open = tagEnd + 1;
+	unsigned depth = 1;
+	while (depth > 0) {
+		close = find(close, end, closeTag);
+		if (!close) return NULL;
+		while ((open = find(open, close, openTag))) {
+			open += strlen(openTag);
+			depth++;
+		}
+		open = close;
+		if (--depth > 0) close += strlen(closeTag);
+	}
+	*valueStart = tagEnd + 1;
+	*valueEnd = close;
+	return close + strlen(closeTag);
+}
+
+// text of the value of <key>key</key> in [p, end)
+static inline bool plistValueForKey(const char *p, const char *end, const char *key, const char **valueStart, const char **valueEnd)
+{
+	char keyTag[96];
+	snprintf(keyTag, sizeof(keyTag), "<key>%s</key>", key);
+	const char *k = find(p, end, keyTag);
+	return k && plistValue(k + strlen(keyTag), end, valueStart, valueEnd);
+}
+
+// copy XML text, decoding the entities the plist writer produces
+static inline void copyXMLText(char *dst, size_t capacity, const char *p, const char *end)
+{
+	static const struct { const char *entity; char c; } entities[] = {
+		{ "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' }, { "&quot;", '"' }, { "&apos;", '\'' },
+	};
+	size_t n = 0;
+	while (p < end && n + 1 < capacity) {
+		char c = *p++;
+		if (c == '&') {
+			for (size_t i = 0; i < sizeof(entities) / sizeof(entities[0]); i++) {
+				if (hasPrefix(p - 1, end, entities[i].entity)) {
+					c = entities[i].c;
+					p += strlen(entities[i].entity) - 1;
+					break;
+				}
+			}
+		}
+		dst[n++] = c;
+	}
+	dst[n] = '\0';
+}
+
+// <true/> or <false/> value of <key>key</key> in [p, end); false if absent
+static inline bool plistBoolForKey(const char *p, const char *end, const char *key)
+{
+	char keyTag[96];
+	snprintf(keyTag, sizeof(keyTag), "<key>%s</key>", key);
+	const char *k = find(p, end, keyTag);
+	return k && hasPrefix(skipSpace(k + strlen(keyTag), end), end, "<true");
+}
+
+// number value (<real> or <integer>) of <key>key</key> in [p, end); fallback if absent
+static inline double plistDoubleForKey(const char *p, const char *end, const char *key, double fallback)
+{
+	const char *v, *vEnd;
+	if (!plistValueForKey(p, end, key, &v, &vEnd) || v == vEnd) return fallback;
+	char text[64];
+	size_t n = (size_t)(vEnd - v) < sizeof(text) - 1 ? (size_t)(vEnd - v) : sizeof(text) - 1;
+	memcpy(text, v, n);
+	text[n] = '\0';
+	return strtod(text, NULL);
+}
+
+#endif /* RNPlistScan_h */
@@ -0,0 +1,579 @@
+//
+//  rnanalyze.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Headless offline analysis of saved experiments, for batches too big for matlab.
+//
+//	rnanalyze [-j threads] [-f csv|bin] [-o outdir] session...
+//
+//	Each session is a saved experiment plist (XML text) or its binary event journal (.rnj,
+//	see RNEventJournal.h). Files are memory-mapped and the event text is tokenized in place.
+//	For every session it computes
+//	  - per-node inter-tap intervals
+//	  - asynchrony of each tap to the nearest stimulus onset (partTiming subEventTimes, or the
+//	    stimulus events in a journal), when it is within half an IOI
+//	  - per-part segment summaries: taps between one part's start and the next, per node
+//	and writes <outdir>/<session>.taps.csv (or .taps.bin, packed RNAnalysisTapRecord) with one
+//	row per tap. Segment summaries for all sessions go to stdout as CSV, in command line order.
+//	Sessions are processed in parallel, one per worker thread.
+//
+// Build (Linux or macOS):
+//	cc -O2 -std=gnu11 -pthread -I.. rnanalyze.c ../RNEventFormat.c -o rnanalyze
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "RNEventFormat.h"
+#include "RNEventJournal.h"
+#include "RNPlistScan.h"
+
+#define kBaseNote			64		// RNArchitectureDefines.h: tapper note = kBaseNote + node
+#define kMaxAnalysisNodes	256
+#define kMaxParts			4096
+#define kInvalid			INT64_MIN
+
+// *********************************************
+//    Output formats
+// *********************************************
+
+#define kRNAnalysisMagic	"RNA1"
+
+enum {
+	kTapHasITI			= 0x01,
+	kTapHasAsynchrony	= 0x02,
+};
+
+typedef struct {
+	int64_t		time_ns;		// relative to experiment start
+	int64_t		iti_ns;			// since this node's previous tap
+	int64_t		asynchrony_ns;	// tap - nearest stimulus onset (negative: tap led)
+	uint16_t	node;
+	uint16_t	segment;		// index of the part whose segment contains the tap
+	uint32_t	flags;
+} RNAnalysisTapRecord;
+
+typedef enum { kOutputCSV, kOutputBinary } OutputFormat;
+
+// *********************************************
+//    Session data
+// *********************************************
+
+typedef struct {
+	int64_t		time_ns;
+	uint16_t	node;
+} Tap;
+
+typedef struct {
+	double		start_s;
+	char		type[64];
+	char		description[256];
+} Part;
+
+typedef struct {
+	Tap			*taps;
+	size_t		nTaps, tapCapacity;
+	int64_t		*onsets;		// stimulus onsets, sorted, unique
+	size_t		nOnsets, onsetCapacity;
+	Part		*parts;			// sorted by start
+	size_t		nParts;
+} Session;
+
+typedef struct {
+	uint64_t	n;
+	double		mean, m2;		// Welford
+} RunningStats;
+
+static void statsAdd(RunningStats *s, double x)
+{
+	s->n++;
+	double delta = x - s->mean;
+	s->mean += delta / (double)s->n;
+	s->m2 += delta * (x - s->mean);
+}
+
+static double statsSD(const RunningStats *s)
+{
+	return (s->n > 1) ? sqrt(s->m2 / (double)(s->n - 1)) : NAN;
+}
+
+static bool appendTap(Session *session, int64_t time_ns, uint16_t node)
+{
+	if (session->nTaps == session->tapCapacity) {
+		size_t capacity = session->tapCapacity ? 2 * session->tapCapacity : 4096;
+		Tap *taps = realloc(session->taps, capacity * sizeof(Tap));
+		if (!taps) return false;
+		session->taps = taps;
+		session->tapCapacity = capacity;
+	}
+	session->taps[session->nTaps].time_ns = time_ns;
+	session->taps[session->nTaps].node = node;
+	session->nTaps++;
+	return true;
+}
+
+static bool appendOnset(Session *session, int64_t time_ns)
+{
+	if (session->nOnsets == session->onsetCapacity) {
+		size_t capacity = session->onsetCapacity ? 2 * session->onsetCapacity : 1024;
+		int64_t *onsets = realloc(session->onsets, capacity * sizeof(int64_t));
+		if (!onsets) return false;
+		session->onsets = onsets;
+		session->onsetCapacity = capacity;
+	}
+	session->onsets[session->nOnsets++] = time_ns;
+	return true;
+}
+
+static void freeSession(Session *session)
+{
+	free(session->taps);
+	free(session->onsets);
+	free(session->parts);
+	memset(session, 0, sizeof(Session));
+}
+
+// *********************************************
+//    Readers
+// *********************************************
+
+static int compareInt64(const void *a, const void *b)
+{
+	int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static int compareParts(const void *a, const void *b)
+{
+	double x = ((const Part *)a)->start_s, y = ((const Part *)b)->start_s;
+	return (x > y) - (x < y);
+}
+
+static void sortOnsets(Session *session)
+{
+	qsort(session->onsets, session->nOnsets, sizeof(int64_t), compareInt64);
+	size_t nUnique = 0;
+	for (size_t i = 0; i < session->nOnsets; i++) {
+		if (nUnique == 0 || session->onsets[i] != session->onsets[nUnique - 1])
+			session->onsets[nUnique++] = session->onsets[i];
+	}
+	session->nOnsets = nUnique;
+}
+
+// recordedEvents: "time\tchannel\tnote\tvelocity\n" per tap
+static bool parseRecordedEvents(Session *session, const char *p, const char *end)
+{
+	int64_t time_ns, channel, note, velocity;
+	while ((p = parseInt64(p, end, &time_ns))) {
+		if (!(p = parseInt64(p, end, &channel)) || !(p = parseInt64(p, end, &note)) || !(p = parseInt64(p, end, &velocity)))
+			return false;
+		int64_t node = note - kBaseNote;
+		if (node < 0 || node >= kMaxAnalysisNodes) continue;
+		if (!appendTap(session, time_ns, (uint16_t)node)) return false;
+	}
+	return true;
+}
+
+static bool readPlist(Session *session, const char *buf, const char *end)
+{
+	const char *value, *valueEnd;
+
+	if (!plistValueForKey(buf, end, "recordedEvents", &value, &valueEnd)) {
+		fprintf(stderr, "no recordedEvents\n");
+		return false;
+	}
+	if (!parseRecordedEvents(session, value, valueEnd)) return false;
+
+	// partTiming: array of dicts
+	session->parts = calloc(kMaxParts, sizeof(Part));
+	if (!session->parts) return false;
+	if (plistValueForKey(buf, end, "partTiming", &value, &valueEnd)) {
+		const char *p = value;
+		while ((p = find(p, valueEnd, "<dict>")) && session->nParts < kMaxParts) {
+			const char *dictEnd = find(p, valueEnd, "</dict>");
+			if (!dictEnd) break;
+			Part *part = &session->parts[session->nParts++];
+			const char *v, *vEnd;
+			double startTime = 0.0, actualStartTime = 0.0;
+
+			if (plistValueForKey(p, dictEnd, "type", &v, &vEnd))			copyXMLText(part->type, sizeof(part->type), v, vEnd);
+			if (plistValueForKey(p, dictEnd, "description", &v, &vEnd))		copyXMLText(part->description, sizeof(part->description), v, vEnd);
+			if (plistValueForKey(p, dictEnd, "startTime", &v, &vEnd))		startTime = strtod(v, NULL);
+			if (plistValueForKey(p, dictEnd, "actualStartTime", &v, &vEnd))	actualStartTime = strtod(v, NULL);
+			part->start_s = (actualStartTime > 0.0) ? actualStartTime : startTime;
+
+			if (plistValueForKey(p, dictEnd, "subEventTimes", &v, &vEnd)) {
+				int64_t onset;
+				while ((v = parseInt64(v, vEnd, &onset))) {
+					if (!appendOnset(session, onset)) return false;
+				}
+			}
+			p = dictEnd;
+		}
+	}
+	qsort(session->parts, session->nParts, sizeof(Part), compareParts);
+	return true;
+}
+
+static bool readJournal(Session *session, const char *buf, size_t length)
+{
+	const RNEventJournalHeader *header = (const RNEventJournalHeader *)buf;
+	if (length < sizeof(RNEventJournalHeader) || header->recordSize < sizeof(RNEventJournalRecord)) {
+		fprintf(stderr, "bad journal header\n");
+		return false;
+	}
+	uint64_t nRecords = header->nRecords;
+	if ((length - sizeof(RNEventJournalHeader)) / header->recordSize < nRecords) {
+		fprintf(stderr, "journal truncated\n");
+		nRecords = (length - sizeof(RNEventJournalHeader)) / header->recordSize;
+	}
+
+	const char *p = buf + sizeof(RNEventJournalHeader);
+	for (uint64_t i = 0; i < nRecords; i++, p += header->recordSize) {
+		RNEventJournalRecord record;
+		memcpy(&record, p, sizeof(record));
+		if (record.kind == kRNEventKindTap && record.node > 0 && record.node < kMaxAnalysisNodes) {
+			if (!appendTap(session, record.time_ns, record.node)) return false;
+		} else if (record.kind == kRNEventKindStimulus) {
+			if (!appendOnset(session, record.time_ns)) return false; // one per listening node; deduplicated later
+		}
+	}
+
+	// the journal has no part structure: one segment
+	session->parts = calloc(1, sizeof(Part));
+	if (!session->parts) return false;
+	session->nParts = 1;
+	strcpy(session->parts[0].type, "all");
+	return true;
+}
+
+// *********************************************
+//    Analysis
+// *********************************************
+
+// asynchrony of t to the nearest onset, if within half the local IOI
+static bool asynchrony(const Session *session, int64_t t, int64_t *asyn)
+{
+	const int64_t *onsets = session->onsets;
+	size_t n = session->nOnsets;
+	if (n == 0) return false;
+
+	size_t lo = 0, hi = n;	// first onset >= t
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (onsets[mid] < t) lo = mid + 1; else hi = mid;
+	}
+	size_t nearest;
+	if (lo == n) nearest = n - 1;
+	else if (lo == 0) nearest = 0;
+	else nearest = (t - onsets[lo - 1] <= onsets[lo] - t) ? lo - 1 : lo;
+
+	int64_t d = t - onsets[nearest];
+	int64_t ioi;
+	if (d < 0) ioi = (nearest > 0) ? onsets[nearest] - onsets[nearest - 1] : (n > 1 ? onsets[1] - onsets[0] : INT64_MAX);
+	else ioi = (nearest + 1 < n) ? onsets[nearest + 1] - onsets[nearest] : (n > 1 ? onsets[n - 1] - onsets[n - 2] : INT64_MAX);
+	if (ioi != INT64_MAX && (d < 0 ? -d : d) * 2 > ioi) return false;
+
+	*asyn = d;
+	return true;
+}
+
+static size_t segmentForTime(const Session *session, int64_t t)
+{
+	double t_s = (double)t * 1e-9;
+	size_t lo = 0, hi = session->nParts;	// last part with start <= t
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if (session->parts[mid].start_s <= t_s) lo = mid + 1; else hi = mid;
+	}
+	return lo ? lo - 1 : 0;
+}
+
+typedef struct {
+	RunningStats	iti, asyn;
+	uint64_t		nTaps;
+} NodeSummary;
+
+// csv-quote a field into dst
+static size_t quoteField(char *dst, const char *s)
+{
+	size_t n = 0;
+	dst[n++] = '"';
+	for (; *s; s++) {
+		if (*s == '"') dst[n++] = '"';
+		dst[n++] = *s;
+	}
+	dst[n++] = '"';
+	return n;
+}
+
+typedef struct {
+	const char		*path;
+	char			*summary;		// CSV rows, filled by the worker
+	bool			ok;
+} Job;
+
+typedef struct {
+	Job				*jobs;
+	size_t			nJobs;
+	_Atomic(size_t)	nextJob;
+	const char		*outDir;
+	OutputFormat	format;
+} JobQueue;
+
+static bool writeTaps(const JobQueue *queue, const Job *job, const Session *session,
+					  const int64_t *iti, const int64_t *asyn, const size_t *segment, const size_t *order)
+{
+	const char *name = strrchr(job->path, '/');
+	name = name ? name + 1 : job->path;
+	char outPath[4096];
+	snprintf(outPath, sizeof(outPath), "%s/%s.taps.%s", queue->outDir, name, queue->format == kOutputCSV ? "csv" : "bin");
+
+	FILE *out = fopen(outPath, "wb");
+	if (!out) {
+		fprintf(stderr, "%s: %s\n", outPath, strerror(errno));
+		return false;
+	}
+
+	if (queue->format == kOutputBinary) {
+		uint64_t n = session->nTaps;
+		fwrite(kRNAnalysisMagic, 1, 4, out);
+		fwrite(&n, sizeof(n), 1, out);
+		for (size_t k = 0; k < session->nTaps; k++) {
+			size_t i = order[k];
+			RNAnalysisTapRecord record = {
+				.time_ns		= session->taps[i].time_ns,
+				.iti_ns			= (iti[i] != kInvalid) ? iti[i] : 0,
+				.asynchrony_ns	= (asyn[i] != kInvalid) ? asyn[i] : 0,
+				.node			= session->taps[i].node,
+				.segment		= (uint16_t)segment[i],
+				.flags			= (iti[i] != kInvalid ? kTapHasITI : 0) | (asyn[i] != kInvalid ? kTapHasAsynchrony : 0),
+			};
+			fwrite(&record, sizeof(record), 1, out);
+		}
+	} else {
+		// rows are formatted into a block buffer with the shared fixed-point formatter
+		enum { kBlockLength = 1 << 16, kMaxRow = 4 * kRNEventFormatMaxInt64Length + 8 };
+		char *block = malloc(kBlockLength);
+		if (!block) { fclose(out); return false; }
+		size_t length = 0;
+		length += (size_t)sprintf(block, "node,time_ns,iti_ns,asynchrony_ns,segment\n");
+		for (size_t k = 0; k < session->nTaps; k++) {
+			size_t i = order[k];
+			if (length + kMaxRow > kBlockLength) {
+				fwrite(block, 1, length, out);
+				length = 0;
+			}
+			char *p = block + length;
+			p += RNFormatInt64(p, session->taps[i].node);	*p++ = ',';
+			p += RNFormatInt64(p, session->taps[i].time_ns);	*p++ = ',';
+			if (iti[i] != kInvalid) p += RNFormatInt64(p, iti[i]);
+			*p++ = ',';
+			if (asyn[i] != kInvalid) p += RNFormatInt64(p, asyn[i]);
+			*p++ = ',';
+			p += RNFormatInt64(p, (int64_t)segment[i]);
+			*p++ = '\n';
+			length = (size_t)(p - block);
+		}
+		fwrite(block, 1, length, out);
+		free(block);
+	}
+
+	bool ok = (ferror(out) == 0);
+	return (fclose(out) == 0) && ok;
+}
+
+static bool analyzeSession(const JobQueue *queue, Job *job, const Session *session)
+{
+	size_t n = session->nTaps;
+	int64_t *iti = malloc((n + 1) * sizeof(int64_t));
+	int64_t *asyn = malloc((n + 1) * sizeof(int64_t));
+	size_t *segment = malloc((n + 1) * sizeof(size_t));
+	size_t *order = malloc((n + 1) * sizeof(size_t));	// taps grouped by node, in time order within each
+	NodeSummary *summaries = calloc(session->nParts * kMaxAnalysisNodes, sizeof(NodeSummary));
+	bool ok = (iti && asyn && segment && order && summaries);
+
+	if (ok) {
+		// counting sort by node keeps each node's taps in recording order
+		size_t start[kMaxAnalysisNodes + 1] = { 0 };
+		for (size_t i = 0; i < n; i++) start[session->taps[i].node + 1]++;
+		for (size_t k = 0; k < kMaxAnalysisNodes; k++) start[k + 1] += start[k];
+		for (size_t i = 0; i < n; i++) order[start[session->taps[i].node]++] = i;
+
+		int64_t lastTime[kMaxAnalysisNodes];
+		for (size_t k = 0; k < kMaxAnalysisNodes; k++) lastTime[k] = kInvalid;
+
+		for (size_t k = 0; k < n; k++) {
+			size_t i = order[k];
+			const Tap *tap = &session->taps[i];
+			iti[i] = (lastTime[tap->node] != kInvalid) ? tap->time_ns - lastTime[tap->node] : kInvalid;
+			lastTime[tap->node] = tap->time_ns;
+			if (!asynchrony(session, tap->time_ns, &asyn[i])) asyn[i] = kInvalid;
+			segment[i] = segmentForTime(session, tap->time_ns);
+
+			NodeSummary *summary = &summaries[segment[i] * kMaxAnalysisNodes + tap->node];
+			summary->nTaps++;
+			if (iti[i] != kInvalid) statsAdd(&summary->iti, (double)iti[i] * 1e-6);
+			if (asyn[i] != kInvalid) statsAdd(&summary->asyn, (double)asyn[i] * 1e-6);
+		}
+
+		ok = writeTaps(queue, job, session, iti, asyn, segment, order);
+	}
+
+	// summary rows: file,segment,start_s,type,description,node,nTaps,meanITI_ms,sdITI_ms,nAsyn,meanAsyn_ms,sdAsyn_ms
+	if (ok) {
+		size_t capacity = 4096, length = 0;
+		size_t maxRow = 2 * (strlen(job->path) + sizeof(((Part *)0)->type) + sizeof(((Part *)0)->description)) + 256;
+		char *text = malloc(capacity);
+		for (size_t iPart = 0; text && iPart < session->nParts; iPart++) {
+			const Part *part = &session->parts[iPart];
+			for (size_t node = 0; node < kMaxAnalysisNodes; node++) {
+				const NodeSummary *s = &summaries[iPart * kMaxAnalysisNodes + node];
+				if (s->nTaps == 0) continue;
+				if (length + maxRow + 1 > capacity) {
+					while (length + maxRow + 1 > capacity) capacity *= 2;
+					char *grown = realloc(text, capacity);
+					if (!grown) { free(text); text = NULL; break; }
+					text = grown;
+				}
+				char *p = text + length;
+				p += quoteField(p, job->path);
+				p += sprintf(p, ",%zu,%.6f,", iPart, part->start_s);
+				p += quoteField(p, part->type);
+				*p++ = ',';
+				p += quoteField(p, part->description);
+				p += sprintf(p, ",%zu,%llu,%.3f,%.3f,%llu,%.3f,%.3f\n", node, (unsigned long long)s->nTaps,
+							 s->iti.n ? s->iti.mean : NAN, statsSD(&s->iti),
+							 (unsigned long long)s->asyn.n, s->asyn.n ? s->asyn.mean : NAN, statsSD(&s->asyn));
+				length = (size_t)(p - text);
+			}
+		}
+		if (text) text[length] = '\0';
+		job->summary = text;
+		ok = (text != NULL);
+	}
+
+	free(iti); free(asyn); free(segment); free(order); free(summaries);
+	return ok;
+}
+
+static bool processFile(const JobQueue *queue, Job *job)
+{
+	int fd = open(job->path, O_RDONLY);
+	if (fd < 0) {
+		fprintf(stderr, "%s: %s\n", job->path, strerror(errno));
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		fprintf(stderr, "%s: empty or unreadable\n", job->path);
+		close(fd);
+		return false;
+	}
+	size_t length = (size_t)st.st_size;
+	const char *buf = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buf == MAP_FAILED) {
+		fprintf(stderr, "%s: mmap: %s\n", job->path, strerror(errno));
+		return false;
+	}
+	madvise((void *)buf, length, MADV_SEQUENTIAL);
+
+	Session session;
+	memset(&session, 0, sizeof(session));
+	bool ok;
+	if (length >= 4 && memcmp(buf, kRNEventJournalMagic, 4) == 0) {
+		ok = readJournal(&session, buf, length);
+	} else if (length >= 6 && memcmp(buf, "bplist", 6) == 0) {
+		fprintf(stderr, "%s: binary plists are not supported; convert with plutil -convert xml1\n", job->path);
+		ok = false;
+	} else {
+		ok = readPlist(&session, buf, buf + length);
+	}
+	munmap((void *)buf, length);
+
+	if (ok) {
+		sortOnsets(&session);
+		ok = analyzeSession(queue, job, &session);
+	}
+	if (!ok) fprintf(stderr, "%s: failed\n", job->path);
+	freeSession(&session);
+	return ok;
+}
+
+static void *worker(void *arg)
+{
+	JobQueue *queue = arg;
+	size_t iJob;
+	while ((iJob = atomic_fetch_add(&queue->nextJob, 1)) < queue->nJobs) {
+		queue->jobs[iJob].ok = processFile(queue, &queue->jobs[iJob]);
+	}
+	return NULL;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: rnanalyze [-j threads] [-f csv|bin] [-o outdir] session.plist|session.rnj ...\n");
+}
+
+int main(int argc, char *argv[])
+{
+	long nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	JobQueue queue = { .outDir = ".", .format = kOutputCSV };
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:f:o:h")) != -1) {
+		switch (opt) {
+			case 'j': nThreads = strtol(optarg, NULL, 10); break;
+			case 'f':
+				if (strcmp(optarg, "csv") == 0) queue.format = kOutputCSV;
+				else if (strcmp(optarg, "bin") == 0) queue.format = kOutputBinary;
+				else { usage(); return 2; }
+				break;
+			case 'o': queue.outDir = optarg; break;
+			default: usage(); return 2;
+		}
+	}
+	if (optind >= argc) { usage(); return 2; }
+
+	queue.nJobs = (size_t)(argc - optind);
+	queue.jobs = calloc(queue.nJobs, sizeof(Job));
+	if (!queue.jobs) return 1;
+	for (size_t i = 0; i < queue.nJobs; i++) queue.jobs[i].path = argv[optind + (int)i];
+	atomic_init(&queue.nextJob, 0);
+
+	if (nThreads < 1) nThreads = 1;
+	if ((size_t)nThreads > queue.nJobs) nThreads = (long)queue.nJobs;
+	pthread_t *threads = calloc((size_t)nThreads, sizeof(pthread_t));
+	if (!threads) return 1;
+	long nStarted = 0;
+	for (long i = 0; i < nThreads; i++)
+		if (pthread_create(&threads[nStarted], NULL, worker, &queue) == 0) nStarted++;
+	if (nStarted == 0) worker(&queue);			// no threads to be had: do the work here
+	for (long i = 0; i < nStarted; i++) pthread_join(threads[i], NULL);
+
+	int status = 0;
+	printf("file,segment,start_s,type,description,node,nTaps,meanITI_ms,sdITI_ms,nAsyn,meanAsyn_ms,sdAsyn_ms\n");
+	for (size_t i = 0; i < queue.nJobs; i++) {
+		if (queue.jobs[i].ok) fputs(queue.jobs[i].summary, stdout);
+		else status = 1;
+		free(queue.jobs[i].summary);
+	}
+	free(threads);
+	free(queue.jobs);
+	return status;
+}
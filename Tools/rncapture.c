@@ -0,0 +1,113 @@
+//
+//  rncapture.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Inspection and comparison of raw MIDI input captures (see RNPacketCapture.h), for checking
+//	that a change to the input pipeline emits the same feedback, and how much sooner or later.
+//
+//	rncapture info capture.rnpc
+//	rncapture compare original.rnpc replay.rnpc
+//
+//	info summarizes a capture: records, packets, span, and the latency from input arrival to
+//	delay output send. compare pairs each delay output with its counterpart in the other capture
+//	(by the input it answers) and checks the bytes and the timestamps relative to that input; it
+//	exits 1 if any output differs or is missing from either, and prints the latency of each run.
+//
+// Build (Linux or macOS):
+//	cc -O2 -std=gnu11 -pthread -I.. rncapture.c ../RNPacketCapture.c -lm -o rncapture
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "RNPacketCapture.h"
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: rncapture info capture.rnpc\n"
+					"       rncapture compare original.rnpc replay.rnpc\n");
+}
+
+static void printLatency(const char *label, const RNPacketCaptureLatency *latency)
+{
+	printf("%-10s %8llu outputs  latency us: mean %.1f  p50 %.1f  p99 %.1f  max %.1f\n", label,
+		   (unsigned long long) latency->n, latency->mean_us, latency->p50_us, latency->p99_us, latency->max_us);
+}
+
+static RNPacketCaptureReader *openCapture(const char *path)
+{
+	RNPacketCaptureReader *reader = RNPacketCaptureOpen(path);
+	if (reader == NULL) fprintf(stderr, "%s: not a readable capture\n", path);
+	return reader;
+}
+
+static int info(const char *path)
+{
+	RNPacketCaptureReader *reader = openCapture(path);
+	if (reader == NULL) return 1;
+	const RNPacketCaptureHeader *header = RNPacketCaptureReaderHeader(reader);
+
+	uint64_t nRecords[2] = { 0 }, nPackets[2] = { 0 }, first = 0, last = 0;
+	size_t cursor = 0;
+	const uint8_t *list;
+	const RNPacketCaptureRecord *record;
+	while ((record = RNPacketCaptureNext(reader, &cursor, &list)) != NULL) {
+		unsigned kind = (record->kind == kRNPacketCaptureInput) ? 0 : 1;
+		uint32_t n;
+		memcpy(&n, list, sizeof(n));
+		nRecords[kind]++;
+		nPackets[kind] += n;
+		if (first == 0 || record->hostTime < first) first = record->hostTime;
+		if (record->hostTime > last) last = record->hostTime;
+	}
+	double span_s = (double)(last - first) * header->timebaseNumer / header->timebaseDenom * 1e-9;
+	printf("%s: timebase %u/%u, packet alignment %u\n", path, header->timebaseNumer, header->timebaseDenom, header->packetAlignment);
+	printf("  input  %8llu lists %8llu packets\n", (unsigned long long) nRecords[0], (unsigned long long) nPackets[0]);
+	printf("  output %8llu lists %8llu packets\n", (unsigned long long) nRecords[1], (unsigned long long) nPackets[1]);
+	printf("  span   %.3f s\n", span_s);
+
+	// latencies come with a comparison; against itself, everything pairs
+	RNPacketCaptureComparison comparison;
+	if (RNPacketCaptureCompare(reader, reader, &comparison)) printLatency("  ", &comparison.latency[0]);
+	RNPacketCaptureReaderClose(reader);
+	return 0;
+}
+
+static int compare(const char *pathA, const char *pathB)
+{
+	RNPacketCaptureReader *a = openCapture(pathA), *b = openCapture(pathB);
+	if (a == NULL || b == NULL) {
+		RNPacketCaptureReaderClose(a);
+		RNPacketCaptureReaderClose(b);
+		return 2;
+	}
+	RNPacketCaptureComparison comparison;
+	bool ok = RNPacketCaptureCompare(a, b, &comparison);
+	RNPacketCaptureReaderClose(a);
+	RNPacketCaptureReaderClose(b);
+	if (!ok) {
+		fprintf(stderr, "captures come from machines with different clocks or packet alignment\n");
+		return 2;
+	}
+
+	printf("inputs     %llu / %llu\n", (unsigned long long) comparison.nInputs[0], (unsigned long long) comparison.nInputs[1]);
+	printf("outputs    %llu matched, %llu differing, %llu unpaired", (unsigned long long) comparison.nMatched,
+		   (unsigned long long) comparison.nDiffering, (unsigned long long) comparison.nUnpaired);
+	if (comparison.firstDifference >= 0) printf(" (first at output %lld)", (long long) comparison.firstDifference);
+	printf("\n");
+	printLatency("original", &comparison.latency[0]);
+	printLatency("replay", &comparison.latency[1]);
+	return (comparison.nDiffering == 0 && comparison.nUnpaired == 0) ? 0 : 1;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc == 3 && strcmp(argv[1], "info") == 0) return info(argv[2]);
+	if (argc == 4 && strcmp(argv[1], "compare") == 0) return compare(argv[2], argv[3]);
+	usage();
+	return 2;
+}
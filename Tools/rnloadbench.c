@@ -0,0 +1,141 @@
+//
+//  rnloadbench.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Workload sweep for the delay routing path (see RNRoutingLoad.h): how big the delay packet list
+//	gets as groups grow, tighten and fan out, against the space emitDelayedNotes: has for it.
+//
+//	rnloadbench [-o outdir] [-c capacity] [-x] [-T] [-D fixed|uniform|gaussian] [-w spread_ms]
+//	            [-t duration_s] [-s seed] [-n nodes] [-r rates_Hz] [-y synchronySDs_ms]
+//	            [-d densities] [-m delays_ms]
+//
+//	Sweeps every combination of the list options (v1,v2,... or first:step:last). -x emits
+//	note-offs, -T sends taps over a serial MIDI link (else as tapped). A CSV row per workload goes
+//	to stdout: taps per list, delay events, the largest delay packet list predicted and its margin
+//	under capacity (default kDelayPacketListLength, 8192 bytes); a negative margin is an overflow.
+//	With -o, each workload is also written as a capture, <outdir>/load.<row>.rnpc, to feed through
+//	the app's live pipeline (replayPacketCaptureAtPath:realTime:, routed by the current network);
+//	benchmarkDelayRoutingWithLoad: measures the same workloads in the app, with their own routing.
+//
+// Build (Linux or macOS):
+//	cc -O2 -std=gnu11 -I.. rnloadbench.c ../RNRoutingLoad.c ../RNPacketCapture.c ../RNSimulator.c -lm -o rnloadbench
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include "RNRoutingLoad.h"
+
+#define kMaxSweepValues		256
+#define kDefaultCapacity	8192	// MIDIIO.h kDelayPacketListLength
+
+typedef struct {
+	double		values[kMaxSweepValues];
+	unsigned	count;
+} SweepList;
+
+// "v1,v2,..." or "first:step:last"
+static bool parseSweep(const char *text, SweepList *list)
+{
+	double first, step, last;
+	list->count = 0;
+	if (sscanf(text, "%lf:%lf:%lf", &first, &step, &last) == 3) {
+		if (step <= 0.0 || last < first) return false;
+		for (double v = first; v <= last + step * 1e-9 && list->count < kMaxSweepValues; v += step)
+			list->values[list->count++] = v;
+		return list->count > 0;
+	}
+	const char *p = text;
+	while (*p && list->count < kMaxSweepValues) {
+		char *next;
+		list->values[list->count++] = strtod(p, &next);
+		if (next == p) return false;
+		p = (*next == ',') ? next + 1 : next;
+		if (*next && *next != ',') return false;
+	}
+	return list->count > 0;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: rnloadbench [-o outdir] [-c capacity] [-x] [-T] [-D fixed|uniform|gaussian] [-w spread_ms]\n"
+					"                   [-t duration_s] [-s seed] [-n nodes] [-r rates_Hz] [-y synchronySDs_ms]\n"
+					"                   [-d densities] [-m delays_ms]\n"
+					"       lists: v1,v2,... or first:step:last\n");
+}
+
+int main(int argc, char *argv[])
+{
+	RNRoutingLoadConfig base;
+	RNRoutingLoadDefaultConfig(&base);
+	SweepList nodes = { { base.nodes }, 1 }, rates = { { base.rate_Hz }, 1 }, synchronySDs = { { base.synchronySD_ms }, 1 };
+	SweepList densities = { { base.density }, 1 }, delays = { { base.delay_ms }, 1 };
+	const char *outDir = NULL;
+	long capacity = kDefaultCapacity;
+	bool ok = true;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "o:c:xTD:w:t:s:n:r:y:d:m:h")) != -1) {
+		switch (opt) {
+			case 'o': outDir = optarg; break;
+			case 'c': capacity = strtol(optarg, NULL, 10); break;
+			case 'x': base.noteOff = true; break;
+			case 'T': base.transport = kRNLoadTransportSerial; break;
+			case 'D':
+				if (strcmp(optarg, "fixed") == 0) base.delayDistribution = kRNLoadDelayFixed;
+				else if (strcmp(optarg, "uniform") == 0) base.delayDistribution = kRNLoadDelayUniform;
+				else if (strcmp(optarg, "gaussian") == 0) base.delayDistribution = kRNLoadDelayGaussian;
+				else ok = false;
+				break;
+			case 'w': base.delaySpread_ms = strtod(optarg, NULL); break;
+			case 't': base.duration_s = strtod(optarg, NULL); break;
+			case 's': base.seed = strtoull(optarg, NULL, 10); break;
+			case 'n': ok = parseSweep(optarg, &nodes); break;
+			case 'r': ok = parseSweep(optarg, &rates); break;
+			case 'y': ok = parseSweep(optarg, &synchronySDs); break;
+			case 'd': ok = parseSweep(optarg, &densities); break;
+			case 'm': ok = parseSweep(optarg, &delays); break;
+			default: usage(); return 2;
+		}
+		if (!ok) {
+			fprintf(stderr, "bad value for -%c: %s\n", opt, optarg);
+			return 2;
+		}
+	}
+	if (optind != argc || capacity <= 0) { usage(); return 2; }
+
+	printf("row,nodes,rate_Hz,synchronySD_ms,density,delay_ms,delaySpread_ms,noteOff,serial,lists,taps,"
+		   "maxTapsPerList,delayEvents,maxTransport_ms,maxDelayListBytes,margin\n");
+	unsigned row = 0;
+	for (unsigned in = 0; in < nodes.count; in++)
+	for (unsigned ir = 0; ir < rates.count; ir++)
+	for (unsigned iy = 0; iy < synchronySDs.count; iy++)
+	for (unsigned id = 0; id < densities.count; id++)
+	for (unsigned im = 0; im < delays.count; im++, row++) {
+		RNRoutingLoadConfig config = base;
+		config.nodes			= (unsigned) nodes.values[in];
+		config.rate_Hz			= rates.values[ir];
+		config.synchronySD_ms	= synchronySDs.values[iy];
+		config.density			= densities.values[id];
+		config.delay_ms			= delays.values[im];
+
+		char path[4096] = "/dev/null";
+		if (outDir) snprintf(path, sizeof(path), "%s/load.%u.rnpc", outDir, row);
+		RNRoutingLoadSummary summary;
+		if (!RNRoutingLoadWriteCapture(&config, path, &summary)) {
+			fprintf(stderr, "row %u: %s\n", row, outDir ? "can't write capture" : "bad workload");
+			return 1;
+		}
+		printf("%u,%u,%g,%g,%g,%g,%g,%d,%d,%llu,%llu,%u,%llu,%.3f,%u,%ld\n", row, config.nodes, config.rate_Hz,
+			   config.synchronySD_ms, config.density, config.delay_ms, config.delaySpread_ms, config.noteOff,
+			   config.transport == kRNLoadTransportSerial, (unsigned long long) summary.nLists, (unsigned long long) summary.nTaps,
+			   summary.maxTapsPerList, (unsigned long long) summary.nDelayEvents, summary.maxTransport_ms,
+			   summary.maxDelayListBytes, capacity - (long) summary.maxDelayListBytes);
+	}
+	return 0;
+}
@@ -0,0 +1,437 @@
+//
+//  rnmiocsim.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Regression run and benchmark of MIOC programming against the simulated matrix (see MIOCSimulator.h),
+//	with messages built as MIOCModel builds them.
+//
+//	rnmiocsim [-n switches] [-c connections] [-e events] [-l hop_us] [-s seed] [-S]
+//
+//	Checks, in order, with the computer on port 8 as in the lab:
+//	- online check (port address inquiry) and device name query, answered on port 8
+//	- handshake: an add with handshaking on is acknowledged, a corrupted one cancelled
+//	- velocity processors: constant and weight maps on an output, as RNNetwork programs them
+//	- network switches: -n random networks of -c connections (plus big brother's omni routes to
+//	  port 8), each programmed by sending the diff from the last as setConnectionList: does, at
+//	  31250 baud (MIOCModel's send window only keeps the driver's queue short: the cable is the
+//	  limit); the matrix must match each network afterwards. Reports each switch's bytes and the
+//	  time from its first byte to the last change
+//	- routing throughput: -e note-ons through the last network, every output counted against the
+//	  connections that should carry it
+//	- software matrix (MIDICoreTable.h): a lab network (inputs heard on port 8, tappers routed to each
+//	  other, velocity maps on inputs and outputs) split between the matrix as patchbay and the table, as
+//	  MIOCModel does with the internal processor, must send every tapper what the matrix alone would
+//	A line per check to stdout; exit status 1 if any failed. -S makes outputs serial (31250 baud).
+//
+// Build (Linux or macOS):
+//	cc -O2 -std=gnu11 -I.. rnmiocsim.c ../MIOCSimulator.c ../MIOCSysex.c ../MIOCConnectionSet.c ../MIDICoreTable.c ../MIOCVelocityMap.c -lm -o rnmiocsim
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "MIOCSimulator.h"
+#include "MIOCSysex.h"
+#include "MIOCConnectionSet.h"
+#include "MIDICoreTable.h"
+
+#define kComputerPort		7		// port 8 (kBigBrotherPort), 0-based
+#define kDeviceType			0x20	// PMM-88E
+#define kMaxConnections		4096
+#define kEgressPort			5		// port 6 (kDelayPort)
+#define kLabPorts			4		// concentrators, 3 tappers each (RNArchitectureDefines.h)
+#define kLabTappers			12
+#define kMaxSent			4096
+
+typedef struct {
+	uint64_t	outputs[kMIOCSimPorts];
+	uint8_t		lastReply[kMIOCSysexMaxMessage];	// last sysex to the computer
+	uint32_t	lastReplyLength;
+	uint8_t		lastVelocity[kMIOCSimPorts];
+} Outputs;
+
+static void outputProc(uint8_t port, const uint8_t *bytes, uint32_t length, int64_t time_ns, void *refCon)
+{
+	Outputs *outputs = refCon;
+	(void) time_ns;
+	outputs->outputs[port]++;
+	if (bytes[0] == 0xF0 && port == kComputerPort && length <= sizeof(outputs->lastReply)) {
+		memcpy(outputs->lastReply, bytes, length);
+		outputs->lastReplyLength = length;
+	}
+	if ((bytes[0] & 0xF0) == 0x90 && length == 3) outputs->lastVelocity[port] = bytes[2];
+}
+
+static unsigned nFailed;
+
+static void check(bool ok, const char *what)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+	if (!ok) nFailed++;
+}
+
+static uint64_t randomNext(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static double now_s(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// an add/remove processor message, as MIOCModel sysexMessageForProcessor:withFlag:
+static uint32_t processorMessage(uint8_t *message, bool add, const uint8_t *processor, uint32_t length, bool handshake)
+{
+	uint8_t data[1 + kMIOCSimMaxProcessorLength];
+	data[0] = add ? 0x80 : 0x00;
+	memcpy(data + 1, processor, length);
+	return MIOCSysexCompose(message, 0x00, kDeviceType, kMIOCSysexModeEncoded | (handshake ? kMIOCSysexModeHandshake : 0), 0x04, data, 1 + length);
+}
+
+// MIOCConnection MIDIBytes
+static void routingProcessor(MIOCConnectionBits connection, uint8_t processor[5])
+{
+	processor[0] = 0x00;
+	processor[1] = connection.inPort - 1;
+	processor[2] = (connection.inChannel == kMIOCSetAnyChannel) ? kMIOCSetAnyChannel : connection.inChannel - 1;
+	processor[3] = connection.outPort - 1;
+	processor[4] = (connection.outChannel == kMIOCSetAnyChannel) ? kMIOCSetAnyChannel : connection.outChannel - 1;
+}
+
+// MIOCVelocityProcessor MIDIBytes: output, note-on on a channel
+static void velocityProcessor(uint8_t port, uint8_t channel, uint8_t threshold, double gradientBelow, double gradientAbove, uint8_t processor[8])
+{
+	processor[0] = 0x25;
+	processor[1] = port - 1;
+	processor[2] = 0x90 + channel - 1;
+	processor[3] = 0;
+	processor[4] = threshold;
+	processor[5] = (uint8_t)(int8_t)(gradientBelow * 8);
+	processor[6] = (uint8_t)(int8_t)(gradientAbove * 8);
+	processor[7] = 0;
+}
+
+// bytes onto the computer's cable, a byte every kMIOCSimByte_ns from *clock. Returns its last byte's time.
+static int64_t sendOnCable(MIOCSimulator *simulator, const uint8_t *message, uint32_t length, int64_t *clock_ns)
+{
+	*clock_ns += (int64_t) length * kMIOCSimByte_ns;
+	MIOCSimReceive(simulator, kComputerPort, message, length, *clock_ns);
+	return *clock_ns;
+}
+
+static uint32_t randomNetwork(uint64_t *state, unsigned nConnections, MIOCConnectionSet *network)
+{
+	MIOCConnectionSetClear(network);
+	for (uint8_t port = 1; port <= kMIOCSimPorts - 1; port++)	// big brother hears every tapper
+		MIOCConnectionSetAdd(network, MIOCConnectionSetIndex(port, kMIOCSetAnyChannel, kMIOCSimPorts, kMIOCSetAnyChannel));
+	for (unsigned i = 0; i < nConnections; i++) {
+		uint64_t r = randomNext(state);
+		MIOCConnectionSetAdd(network, MIOCConnectionSetIndex(1 + r % 7, 1 + (r >> 8) % 16, 1 + (r >> 16) % 7, 1 + (r >> 24) % 16));
+	}
+	return MIOCConnectionSetCount(network);
+}
+
+// everything a simulator sent, in order
+typedef struct {
+	uint8_t		port[kMaxSent];
+	uint8_t		bytes[kMaxSent][3];
+	uint32_t	n;
+} Sent;
+
+static void sentProc(uint8_t port, const uint8_t *bytes, uint32_t length, int64_t time_ns, void *refCon)
+{
+	Sent *sent = refCon;
+	(void) time_ns;
+	if (length != 3 || sent->n == kMaxSent) return;
+	sent->port[sent->n] = port;
+	memcpy(sent->bytes[sent->n++], bytes, 3);
+}
+
+// what reached the tappers' ports, as a sum and count independent of order
+static void tapperOutputs(const Sent *sent, uint64_t *sum, uint64_t *count)
+{
+	for (uint32_t i = 0; i < sent->n; i++) {
+		if (sent->port[i] >= kLabPorts) continue;
+		uint64_t key = ((uint64_t) sent->port[i] << 24) | ((uint64_t) sent->bytes[i][0] << 16) | (sent->bytes[i][1] << 8) | sent->bytes[i][2];
+		*sum += key * 0x9E3779B97F4A7C15ULL;
+		(*count)++;
+	}
+}
+
+static void programProcessor(MIOCSimulator *simulator, const uint8_t *processor, uint32_t length)
+{
+	uint8_t message[kMIOCSysexMaxMessage];
+	uint32_t n = processorMessage(message, true, processor, length, false);
+	MIOCSimReceive(simulator, kComputerPort, message, n, 0);
+}
+
+static void programRoute(MIOCSimulator *simulator, const MIDICoreRoute *route)
+{
+	uint8_t processor[5];
+	routingProcessor((MIOCConnectionBits){ route->inPort, route->inChannel, route->outPort, route->outChannel }, processor);
+	programProcessor(simulator, processor, 5);
+}
+
+static void programMap(MIOCSimulator *simulator, const MIDICoreVelocityMap *map)
+{
+	uint8_t processor[8] = { map->onInput ? 0x24 : 0x25, map->port - 1,
+		(map->channel == kMIDICoreAnyChannel) ? 0x10 : 0x90 + map->channel - 1, map->position, map->threshold,
+		(uint8_t) map->gradientBelow, (uint8_t) map->gradientAbove, (uint8_t) map->offset };
+	programProcessor(simulator, processor, 8);
+}
+
+// a lab network through the matrix alone, and split as MIOCModel splits it with the internal processor: the
+//	patchbay brings taps to the computer, the table routes them, and what it sends goes back in at the egress port
+static void checkSoftwareMatrix(uint64_t *state, uint64_t nEvents)
+{
+	MIDICoreRoute routes[kLabPorts + 64], egress[kMIDICoreChannels], software[64], hardware[kLabPorts + 64 + kMIDICoreChannels];
+	MIDICoreVelocityMap maps[8], softwareMaps[8];
+	bool routeInSoftware[kLabPorts + 64], mapInSoftware[8];
+	uint32_t nRoutes = 0, nMaps = 0;
+
+	for (uint8_t port = 1; port <= kLabPorts; port++)	// big brother hears every tapper
+		routes[nRoutes++] = (MIDICoreRoute){ port, kMIDICoreAnyChannel, kComputerPort + 1, kMIDICoreAnyChannel, 0 };
+	routes[nRoutes++] = (MIDICoreRoute){ kComputerPort + 1, 16, 1, kMIDICoreAnyChannel, 0 };	// a stimulus to tapper 1's port
+	for (unsigned i = 0; i < 40; i++) {
+		uint64_t r = randomNext(state);
+		unsigned from = 1 + r % kLabTappers, to = 1 + (r >> 8) % kLabTappers;
+		routes[nRoutes++] = (MIDICoreRoute){ 1 + (from - 1) / 3, from, 1 + (to - 1) / 3, (r >> 16) % 8 ? to : kMIDICoreAnyChannel, 0 };
+	}
+	maps[nMaps++] = (MIDICoreVelocityMap){ 2, 4, true, 0, 0, 8, 4, 0 };				// tapper 4 in, weight 0.5
+	maps[nMaps++] = (MIDICoreVelocityMap){ 3, 7, false, 0, 64, 8, 12, -5 };			// tapper 7 out
+	maps[nMaps++] = (MIDICoreVelocityMap){ 3, 7, false, 1, 0, 0, 0, 90 };			// then constant 90
+	maps[nMaps++] = (MIDICoreVelocityMap){ 1, 16, false, 0, 0, 0, 0, 50 };			// the stimulus' output: stays
+	maps[nMaps++] = (MIDICoreVelocityMap){ 4, kMIDICoreAnyChannel, false, 0, 100, 4, 4, 0 };
+
+	uint32_t nEgress = MIDICoreSplit(routes, nRoutes, maps, nMaps, kComputerPort + 1, kEgressPort + 1, routeInSoftware, mapInSoftware,
+									 egress, kMIDICoreChannels);
+	uint32_t nSoftware = 0, nHardware = 0, nSoftwareMaps = 0;
+	for (uint32_t i = 0; i < nRoutes; i++) {
+		if (routeInSoftware[i]) software[nSoftware++] = routes[i];
+		else hardware[nHardware++] = routes[i];
+	}
+	for (uint32_t i = 0; i < nEgress; i++) hardware[nHardware++] = egress[i];
+	for (uint32_t m = 0; m < nMaps; m++)
+		if (mapInSoftware[m]) softwareMaps[nSoftwareMaps++] = maps[m];
+	MIDICoreTable *table = MIDICoreTableCreate();
+	bool compiled = MIDICoreTableCompile(table, software, nSoftware, softwareMaps, nSoftwareMaps);
+
+	MIOCSimConfig config;
+	MIOCSimDefaultConfig(&config);
+	config.hopLatency_ns = 0;
+	Sent *alone = calloc(1, sizeof(Sent)), *split = calloc(1, sizeof(Sent));
+	MIOCSimulator *matrix = MIOCSimCreate(&config, sentProc, alone), *patchbay = MIOCSimCreate(&config, sentProc, split);
+	for (uint32_t i = 0; i < nRoutes; i++) programRoute(matrix, &routes[i]);
+	for (uint32_t m = 0; m < nMaps; m++) programMap(matrix, &maps[m]);
+	for (uint32_t i = 0; i < nHardware; i++) programRoute(patchbay, &hardware[i]);
+	for (uint32_t m = 0; m < nMaps; m++)
+		if (!mapInSoftware[m]) programMap(patchbay, &maps[m]);
+
+	bool same = compiled;
+	uint64_t nRouted = 0;
+	double routing_s = 0;
+	for (uint64_t e = 0; e < nEvents && same; e++) {
+		uint64_t r = randomNext(state);
+		unsigned tapper = 1 + r % kLabTappers;
+		uint8_t tap[3] = { (uint8_t)(0x90 | (tapper - 1)), (uint8_t)(64 + tapper), (uint8_t)(1 + (r >> 8) % 127) };
+		alone->n = split->n = 0;
+		MIOCSimReceive(matrix, (tapper - 1) / 3, tap, 3, 0);
+		MIOCSimReceive(patchbay, (tapper - 1) / 3, tap, 3, 0);
+		// the computer's share: what reached it, through the table, back in at the egress port
+		uint32_t nHeard = split->n;
+		for (uint32_t i = 0; i < nHeard; i++) {
+			if (split->port[i] != kComputerPort || (split->bytes[i][0] & 0xF0) != 0x90) continue;
+			uint8_t channel = split->bytes[i][0] & 0x0F, inPort = MIDICoreTableInputPort(table, channel);
+			const MIDICoreProcess *processes;
+			double t0 = now_s();
+			uint32_t n = MIDICoreTableProcesses(table, inPort, channel, false, &processes);
+			uint8_t out[16][3];
+			for (uint32_t k = 0; k < n && k < 16; k++) {
+				out[k][0] = 0x90 | processes[k].outChannel;
+				out[k][1] = split->bytes[i][1];
+				out[k][2] = MIDICoreTableVelocity(table, processes[k].velocityTable, split->bytes[i][2]);
+			}
+			routing_s += now_s() - t0;
+			nRouted += n;
+			for (uint32_t k = 0; k < n && k < 16; k++)
+				MIOCSimReceive(patchbay, kEgressPort, out[k], 3, 0);
+		}
+		uint64_t sumAlone = 0, countAlone = 0, sumSplit = 0, countSplit = 0;
+		tapperOutputs(alone, &sumAlone, &countAlone);
+		tapperOutputs(split, &sumSplit, &countSplit);
+		if (sumAlone != sumSplit || countAlone != countSplit) same = false;
+	}
+	char line[256];
+	snprintf(line, sizeof(line), "software matrix: %u of %u routes (%u egress), %u of %u maps in software; same output, %.1f ns a route",
+			 nSoftware, nRoutes, nEgress, nSoftwareMaps, nMaps, nRouted ? routing_s / nRouted * 1e9 : 0.0);
+	check(same && nSoftware > 0, line);
+
+	MIOCSimDestroy(matrix);
+	MIOCSimDestroy(patchbay);
+	MIDICoreTableDestroy(table);
+	free(alone);
+	free(split);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: rnmiocsim [-n switches] [-c connections] [-e events] [-l hop_us] [-s seed] [-S]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned nSwitches = 20, nConnections = 120;
+	uint64_t nEvents = 1000000, seed = 1;
+	MIOCSimConfig config;
+	MIOCSimDefaultConfig(&config);
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:c:e:l:s:Sh")) != -1) {
+		switch (opt) {
+			case 'n': nSwitches = (unsigned) strtoul(optarg, NULL, 10); break;
+			case 'c': nConnections = (unsigned) strtoul(optarg, NULL, 10); break;
+			case 'e': nEvents = strtoull(optarg, NULL, 10); break;
+			case 'l': config.hopLatency_ns = (int64_t)(strtod(optarg, NULL) * 1000.0); break;
+			case 's': seed = strtoull(optarg, NULL, 10); break;
+			case 'S': config.serialOutputs = true; break;
+			default: usage(); return 2;
+		}
+	}
+	if (optind != argc || nConnections > kMaxConnections) { usage(); return 2; }
+
+	Outputs outputs;
+	memset(&outputs, 0, sizeof(outputs));
+	MIOCSimulator *simulator = MIOCSimCreate(&config, outputProc, &outputs);
+	int64_t clock_ns = 0;
+	uint8_t message[kMIOCSysexMaxMessage];
+	MIOCSysexMessage reply;
+
+	// online: MIOCModel queryPortAddress, queryDeviceName
+	static const uint8_t portAddress[] = { 0xF0, 0x00, 0x20, 0x0D, 0x7F, 0x7F, 0x00, 0x78, 0xF7 };
+	static const uint8_t deviceName[] = { 0xF0, 0x00, 0x20, 0x0D, 0x00, 0x20, 0x00, 0x45, 0xF7 };
+	sendOnCable(simulator, portAddress, sizeof(portAddress), &clock_ns);
+	check(MIOCSysexParse(outputs.lastReply, outputs.lastReplyLength, &reply) == kMIOCSysexOK && reply.opcode == 0x38
+		  && reply.data[0] == kComputerPort && reply.data[1] == kComputerPort, "port address: connected to port 8");
+	sendOnCable(simulator, deviceName, sizeof(deviceName), &clock_ns);
+	check(MIOCSysexParse(outputs.lastReply, outputs.lastReplyLength, &reply) == kMIOCSysexOK && reply.opcode == 0x05
+		  && reply.dataLength == 9 && memcmp(reply.data + 1, config.name, 8) == 0, "device name");
+
+	// handshake
+	uint8_t processor[8];
+	routingProcessor((MIOCConnectionBits){ 1, 1, 2, 1 }, processor);
+	uint32_t length = processorMessage(message, true, processor, 5, true);
+	sendOnCable(simulator, message, length, &clock_ns);
+	check(MIOCSysexParse(outputs.lastReply, outputs.lastReplyLength, &reply) == kMIOCSysexOK && reply.opcode == 0x7F
+		  && MIOCSimProcessorCount(simulator, processor, 5) == 1, "handshake: add acknowledged");
+	length = processorMessage(message, false, processor, 5, true);
+	message[length - 2] ^= 0x01;	// checksum
+	sendOnCable(simulator, message, length, &clock_ns);
+	check(MIOCSysexParse(outputs.lastReply, outputs.lastReplyLength, &reply) == kMIOCSysexOK && reply.opcode == 0x7D
+		  && MIOCSimProcessorCount(simulator, processor, 5) == 1 && MIOCSimGetCounts(simulator).checksumErrors == 1,
+		  "handshake: bad checksum cancelled, nothing removed");
+
+	// velocity: note-on 1,1 -> 2,1 mapped on output 2
+	static const uint8_t noteOn[] = { 0x90, 64, 64 };
+	velocityProcessor(2, 1, 100, 0.0, 0.0, processor);	// constant 100 (setConstantVelocity:)
+	length = processorMessage(message, true, processor, 8, false);
+	sendOnCable(simulator, message, length, &clock_ns);
+	MIOCSimReceive(simulator, 0, noteOn, 3, clock_ns);
+	check(outputs.lastVelocity[1] == 100, "velocity: constant 100");
+	length = processorMessage(message, false, processor, 8, false);
+	sendOnCable(simulator, message, length, &clock_ns);
+	velocityProcessor(2, 1, 0, 1.0, 0.5, processor);		// weight 0.5 (setWeight:)
+	length = processorMessage(message, true, processor, 8, false);
+	sendOnCable(simulator, message, length, &clock_ns);
+	MIOCSimReceive(simulator, 0, noteOn, 3, clock_ns);
+	check(outputs.lastVelocity[1] == 32, "velocity: weight 0.5");
+	length = processorMessage(message, false, processor, 8, false);
+	sendOnCable(simulator, message, length, &clock_ns);
+	routingProcessor((MIOCConnectionBits){ 1, 1, 2, 1 }, processor);
+	length = processorMessage(message, false, processor, 5, false);
+	sendOnCable(simulator, message, length, &clock_ns);
+	check(MIOCSimGetCounts(simulator).processors == 0, "velocity: processors removed");
+
+	// network switches, as setConnectionList: sends them: removes, then adds
+	uint64_t state = seed;
+	MIOCConnectionSet current, target, toRemove, toAdd, matrix;
+	MIOCConnectionSetClear(&current);
+	static MIOCConnectionBits changes[kMIOCSetConnections];
+	bool switchesOK = true;
+	double maxSwitch_ms = 0, sumSwitch_ms = 0;
+	uint64_t switchBytes = 0;
+	for (unsigned s = 0; s < nSwitches; s++) {
+		randomNetwork(&state, nConnections, &target);
+		MIOCConnectionSetDifference(&toRemove, &current, &target);
+		MIOCConnectionSetDifference(&toAdd, &target, &current);
+		int64_t start_ns = clock_ns;
+		uint32_t bytes = 0;
+		for (int pass = 0; pass < 2; pass++) {
+			uint32_t n = MIOCConnectionSetMembers(pass == 0 ? &toRemove : &toAdd, changes, kMIOCSetConnections);
+			for (uint32_t i = 0; i < n; i++) {
+				routingProcessor(changes[i], processor);
+				length = processorMessage(message, pass == 1, processor, 5, false);
+				bytes += length;
+				sendOnCable(simulator, message, length, &clock_ns);
+			}
+		}
+		MIOCSimGetRouting(simulator, &matrix);
+		if (!MIOCConnectionSetEqual(&matrix, &target)) switchesOK = false;
+		double switch_ms = (MIOCSimGetCounts(simulator).lastChange_ns - start_ns) * 1e-6;
+		if (bytes == 0) switch_ms = 0;
+		if (switch_ms > maxSwitch_ms) maxSwitch_ms = switch_ms;
+		sumSwitch_ms += switch_ms;
+		switchBytes += bytes;
+		printf("     switch %u: -%u +%u connections, %u B, %.1f ms\n", s, MIOCConnectionSetCount(&toRemove), MIOCConnectionSetCount(&toAdd),
+			   bytes, switch_ms);
+		current = target;
+		clock_ns += 100000000;	// parts apart
+	}
+	char line[256];
+	snprintf(line, sizeof(line), "network switches: %u, matrix matches each; mean %.1f ms, max %.1f ms, %.0f B mean",
+			 nSwitches, nSwitches ? sumSwitch_ms / nSwitches : 0.0, maxSwitch_ms, nSwitches ? (double) switchBytes / nSwitches : 0.0);
+	check(switchesOK, line);
+
+	// throughput through the last network
+	uint32_t expected[kMIOCSimPorts][16];
+	memset(expected, 0, sizeof(expected));
+	uint32_t n = MIOCConnectionSetMembers(&current, changes, kMIOCSetConnections);
+	for (uint32_t i = 0; i < n; i++) {
+		for (unsigned c = 0; c < 16; c++) {
+			if (changes[i].inChannel == kMIOCSetAnyChannel || changes[i].inChannel == c + 1) expected[changes[i].inPort - 1][c]++;
+		}
+	}
+	memset(outputs.outputs, 0, sizeof(outputs.outputs));
+	uint64_t expectedOutputs = 0;
+	double t0 = now_s();
+	for (uint64_t e = 0; e < nEvents; e++) {
+		uint64_t r = randomNext(&state);
+		uint8_t port = r % 7, channel = (r >> 8) % 16;
+		uint8_t event[3] = { (uint8_t)(0x90 | channel), 64, (uint8_t)(1 + (r >> 16) % 127) };
+		MIOCSimReceive(simulator, port, event, 3, clock_ns);
+		expectedOutputs += expected[port][channel];
+		clock_ns += 1000;
+	}
+	double elapsed_s = now_s() - t0;
+	uint64_t routed = 0;
+	for (unsigned port = 0; port < kMIOCSimPorts; port++) routed += outputs.outputs[port];
+	snprintf(line, sizeof(line), "routing: %llu events -> %llu outputs, %.2f M events/s, %.2f M outputs/s",
+			 (unsigned long long) nEvents, (unsigned long long) routed, nEvents / elapsed_s * 1e-6, routed / elapsed_s * 1e-6);
+	check(routed == expectedOutputs, line);
+
+	checkSoftwareMatrix(&state, nEvents / 10);
+
+	MIOCSimDestroy(simulator);
+	return nFailed ? 1 : 0;
+}
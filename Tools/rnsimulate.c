@@ -0,0 +1,374 @@
+//
+//  rnsimulate.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Headless simulation of an experiment definition, for sweeping tapper and network parameters
+//	before running a session (see RNSimulator.h for the model).
+//
+//	rnsimulate [-j threads] [-o outdir] [-q] [-r repeats] [-s seed] [-a alphas] [-b betas]
+//	           [-t timekeeperSDs] [-m motorSDs] [-p period_ms] [-v periodSD_ms] experiment.plist
+//
+//	The experiment plist (XML text) is the one the app opens: its experimentParts (networks,
+//	stimuli, connection strength and strength ramps) and experimentDuration. Each parameter takes
+//	a comma separated list or first:step:last; every combination is run repeats times, with seeds
+//	seed, seed + 1, ... Runs are spread over the worker threads. Every run is journaled to
+//	<outdir>/<experiment>.<run>.rnj (see RNEventJournal.h), which rnanalyze reads like a recorded
+//	session, unless -q. A summary row per run goes to stdout as CSV, in run order.
+//
+//	Defaults: alpha 0.5, beta 0, timekeeper SD 15 ms, motor SD 5 ms, period: the first stimulus' IOI.
+//	Connection strength parts of type constant set loudness only and are ignored.
+//
+// Build (Linux or macOS):
+//	cc -O2 -std=gnu11 -pthread -I.. rnsimulate.c ../RNSimulator.c -lm -o rnsimulate
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "RNSimulator.h"
+#include "RNEventJournal.h"
+#include "RNPlistScan.h"
+
+#define kMaxSweepValues	256
+
+// *********************************************
+//    Experiment definition
+// *********************************************
+
+static bool readNetwork(RNSimExperiment *experiment, double start_s, const char *p, const char *end)
+{
+	RNSimNetwork network;
+	memset(&network, 0, sizeof(network));
+	network.nNodes	= (unsigned) plistDoubleForKey(p, end, "nodes", 0.0);
+	network.isDelay	= plistBoolForKey(p, end, "isDelay");
+	bool isWeighted	= plistBoolForKey(p, end, "isWeighted");
+	if (network.nNodes < 1 || network.nNodes > kRNSimMaxNodes) {
+		fprintf(stderr, "network at %g s: bad number of nodes\n", start_s);
+		return false;
+	}
+
+	const char *array, *arrayEnd;
+	if (!plistValueForKey(p, end, "connections", &array, &arrayEnd)) {
+		fprintf(stderr, "network at %g s: no connections\n", start_s);
+		return false;
+	}
+	const char *element = array, *v, *vEnd;
+	while ((element = plistValue(element, arrayEnd, &v, &vEnd))) {
+		char text[128];
+		copyXMLText(text, sizeof(text), v, vEnd);
+		if (!RNSimNetworkAddConnectionString(&network, text)) {
+			fprintf(stderr, "network at %g s: bad connection \"%s\"\n", start_s, text);
+			return false;
+		}
+	}
+	// unweighted networks pass every tap at full strength, whatever the definition says
+	if (!isWeighted) {
+		for (unsigned from = 0; from <= kRNSimMaxNodes; from++)
+			for (unsigned to = 1; to <= kRNSimMaxNodes; to++)
+				if (network.weight[from][to] > 0.0) network.weight[from][to] = 1.0;
+	}
+	return RNSimExperimentAddNetwork(experiment, start_s, &network);
+}
+
+// as RNGlobalConnectionStrength expands it: weight is quantized to 1/8
+static bool readStrengthRamp(RNSimExperiment *experiment, double start_s, const char *p, const char *end)
+{
+	char type[32] = "";
+	const char *v, *vEnd;
+	if (plistValueForKey(p, end, "parameterType", &v, &vEnd)) copyXMLText(type, sizeof(type), v, vEnd);
+	if (strcmp(type, "weight") != 0) return true;
+
+	double duration_s	= plistDoubleForKey(p, end, "duration", 0.0);
+	double startValue	= plistDoubleForKey(p, end, "startValue", 1.0);
+	double endValue		= plistDoubleForKey(p, end, "endValue", 1.0);
+	unsigned nSteps		= (unsigned) ((endValue - startValue) * 8);
+	if (nSteps == 0) return RNSimExperimentAddStrength(experiment, start_s, startValue);
+	for (unsigned iStep = 0; iStep <= nSteps; iStep++) {
+		double value = startValue + (endValue - startValue) / nSteps * iStep;
+		if (!RNSimExperimentAddStrength(experiment, start_s + iStep * duration_s / nSteps, value)) return false;
+	}
+	return true;
+}
+
+static RNSimExperiment *readExperiment(const char *buf, const char *end)
+{
+	double duration_s = plistDoubleForKey(buf, end, "experimentDuration", 0.0);
+	const char *parts, *partsEnd;
+	if (duration_s <= 0.0 || !plistValueForKey(buf, end, "experimentParts", &parts, &partsEnd)) {
+		fprintf(stderr, "no experimentDuration or experimentParts\n");
+		return NULL;
+	}
+	RNSimExperiment *experiment = RNSimExperimentCreate(duration_s);
+	if (!experiment) return NULL;
+
+	// experimentParts: array of flat dicts
+	bool ok = true;
+	const char *p = parts;
+	while (ok && (p = find(p, partsEnd, "<dict>"))) {
+		const char *dictEnd = find(p, partsEnd, "</dict>");
+		if (!dictEnd) break;
+		char type[64] = "";
+		const char *v, *vEnd;
+		if (plistValueForKey(p, dictEnd, "type", &v, &vEnd)) copyXMLText(type, sizeof(type), v, vEnd);
+		double start_s = plistDoubleForKey(p, dictEnd, "startTime", 0.0);
+
+		if (strcmp(type, "network") == 0) {
+			ok = readNetwork(experiment, start_s, p, dictEnd);
+		} else if (strcmp(type, "stimulus") == 0) {
+			char text[256] = "";
+			RNSimStimulus stimulus;
+			if (plistValueForKey(p, dictEnd, "stimulus", &v, &vEnd)) copyXMLText(text, sizeof(text), v, vEnd);
+			ok = RNSimStimulusFromString(text, &stimulus) && RNSimExperimentAddStimulus(experiment, start_s, stimulus);
+			if (!ok) fprintf(stderr, "bad stimulus \"%s\"\n", text);
+		} else if (strcmp(type, "globalConnectionStrength") == 0) {
+			if (find(p, dictEnd, "<key>weight</key>"))
+				ok = RNSimExperimentAddStrength(experiment, start_s, plistDoubleForKey(p, dictEnd, "weight", 1.0));
+		} else if (strcmp(type, "globalConnectionStrengthRamp") == 0) {
+			ok = readStrengthRamp(experiment, start_s, p, dictEnd);
+		} else {
+			fprintf(stderr, "skipping part of unknown type \"%s\"\n", type);
+		}
+		p = dictEnd;
+	}
+	if (!ok || RNSimExperimentNodeCount(experiment) == 0) {
+		if (ok) fprintf(stderr, "no networks\n");
+		RNSimExperimentDestroy(experiment);
+		return NULL;
+	}
+	return experiment;
+}
+
+// *********************************************
+//    Sweep
+// *********************************************
+
+typedef struct {
+	double		values[kMaxSweepValues];
+	unsigned	count;
+} SweepList;
+
+// "v1,v2,..." or "first:step:last"
+static bool parseSweep(const char *text, SweepList *list)
+{
+	double first, step, last;
+	list->count = 0;
+	if (sscanf(text, "%lf:%lf:%lf", &first, &step, &last) == 3) {
+		if (step <= 0.0 || last < first) return false;
+		for (double v = first; v <= last + step * 1e-9 && list->count < kMaxSweepValues; v += step)
+			list->values[list->count++] = v;
+		return list->count > 0;
+	}
+	const char *p = text;
+	while (*p && list->count < kMaxSweepValues) {
+		char *next;
+		list->values[list->count++] = strtod(p, &next);
+		if (next == p) return false;
+		p = (*next == ',') ? next + 1 : next;
+		if (*next && *next != ',') return false;
+	}
+	return list->count > 0;
+}
+
+typedef struct {
+	RNSimTapperParameters	parameters;
+	unsigned				repeat;
+	uint64_t				seed;
+	RNSimSummary			summary;
+	bool					ok;
+} Run;
+
+typedef struct {
+	const RNSimExperiment	*experiment;
+	Run						*runs;
+	size_t					nRuns;
+	_Atomic(size_t)			nextRun;
+	const char				*outDir;
+	const char				*name;
+	bool					journal;
+} RunQueue;
+
+static bool writeJournal(const RunQueue *queue, size_t iRun, const RNSimOutput *output)
+{
+	char outPath[4096];
+	snprintf(outPath, sizeof(outPath), "%s/%s.%zu.rnj", queue->outDir, queue->name, iRun);
+	FILE *out = fopen(outPath, "wb");
+	if (!out) {
+		fprintf(stderr, "%s: %s\n", outPath, strerror(errno));
+		return false;
+	}
+	RNEventJournalHeader header = {
+		.version		= kRNEventJournalVersion,
+		.recordSize		= sizeof(RNEventJournalRecord),
+		.nRecords		= output->nEvents,
+	};
+	memcpy(header.magic, kRNEventJournalMagic, 4);
+	fwrite(&header, sizeof(header), 1, out);
+	for (size_t i = 0; i < output->nEvents; i++) {
+		RNEventJournalRecord record = RNEventJournalRecordFromEvent(&output->events[i]);
+		fwrite(&record, sizeof(record), 1, out);
+	}
+	bool ok = (ferror(out) == 0);
+	return (fclose(out) == 0) && ok;
+}
+
+static void *worker(void *arg)
+{
+	RunQueue *queue = arg;
+	RNSimOutput output;
+	memset(&output, 0, sizeof(output));
+	size_t iRun;
+	while ((iRun = atomic_fetch_add(&queue->nextRun, 1)) < queue->nRuns) {
+		Run *run = &queue->runs[iRun];
+		output.nEvents = 0;
+		run->ok = RNSimulate(queue->experiment, &run->parameters, run->seed, &output);
+		run->summary = output.summary;
+		if (run->ok && queue->journal) run->ok = writeJournal(queue, iRun, &output);
+		if (!run->ok) fprintf(stderr, "run %zu: failed\n", iRun);
+	}
+	RNSimOutputFree(&output);
+	return NULL;
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: rnsimulate [-j threads] [-o outdir] [-q] [-r repeats] [-s seed] [-a alphas] [-b betas]\n"
+					"                  [-t timekeeperSDs] [-m motorSDs] [-p period_ms] [-v periodSD_ms] experiment.plist\n"
+					"       lists: v1,v2,... or first:step:last\n");
+}
+
+int main(int argc, char *argv[])
+{
+	long nThreads = sysconf(_SC_NPROCESSORS_ONLN);
+	RunQueue queue = { .outDir = ".", .journal = true };
+	SweepList alphas = { { 0.5 }, 1 }, betas = { { 0.0 }, 1 }, timekeeperSDs = { { 15.0 }, 1 }, motorSDs = { { 5.0 }, 1 };
+	unsigned repeats = 1;
+	uint64_t seed = 1;
+	double period_ms = 0.0, periodSD_ms = 0.0;
+	bool ok = true;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:o:qr:s:a:b:t:m:p:v:h")) != -1) {
+		switch (opt) {
+			case 'j': nThreads = strtol(optarg, NULL, 10); break;
+			case 'o': queue.outDir = optarg; break;
+			case 'q': queue.journal = false; break;
+			case 'r': repeats = (unsigned) strtoul(optarg, NULL, 10); break;
+			case 's': seed = strtoull(optarg, NULL, 10); break;
+			case 'a': ok = parseSweep(optarg, &alphas); break;
+			case 'b': ok = parseSweep(optarg, &betas); break;
+			case 't': ok = parseSweep(optarg, &timekeeperSDs); break;
+			case 'm': ok = parseSweep(optarg, &motorSDs); break;
+			case 'p': period_ms = strtod(optarg, NULL); break;
+			case 'v': periodSD_ms = strtod(optarg, NULL); break;
+			default: usage(); return 2;
+		}
+		if (!ok) {
+			fprintf(stderr, "bad list for -%c: %s\n", opt, optarg);
+			return 2;
+		}
+	}
+	if (optind != argc - 1 || repeats < 1) { usage(); return 2; }
+
+	// the definition
+	const char *path = argv[optind];
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd < 0 || fstat(fd, &st) != 0 || st.st_size == 0) {
+		fprintf(stderr, "%s: %s\n", path, (fd < 0) ? strerror(errno) : "empty or unreadable");
+		if (fd >= 0) close(fd);
+		return 1;
+	}
+	size_t length = (size_t) st.st_size;
+	const char *buf = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (buf == MAP_FAILED) {
+		fprintf(stderr, "%s: mmap: %s\n", path, strerror(errno));
+		return 1;
+	}
+	if (length >= 6 && memcmp(buf, "bplist", 6) == 0) {
+		fprintf(stderr, "%s: binary plists are not supported; convert with plutil -convert xml1\n", path);
+		return 1;
+	}
+	RNSimExperiment *experiment = readExperiment(buf, buf + length);
+	munmap((void *) buf, length);
+	if (!experiment) {
+		fprintf(stderr, "%s: failed\n", path);
+		return 1;
+	}
+	char name[256];
+	const char *base = strrchr(path, '/');
+	snprintf(name, sizeof(name), "%s", base ? base + 1 : path);
+	char *extension = strrchr(name, '.');
+	if (extension && extension != name) *extension = '\0';
+	queue.name = name;
+	queue.experiment = experiment;
+
+	// every combination, repeated
+	queue.nRuns = (size_t) alphas.count * betas.count * timekeeperSDs.count * motorSDs.count * repeats;
+	queue.runs = calloc(queue.nRuns, sizeof(Run));
+	if (!queue.runs) return 1;
+	size_t iRun = 0;
+	for (unsigned a = 0; a < alphas.count; a++)
+		for (unsigned b = 0; b < betas.count; b++)
+			for (unsigned t = 0; t < timekeeperSDs.count; t++)
+				for (unsigned m = 0; m < motorSDs.count; m++)
+					for (unsigned r = 0; r < repeats; r++, iRun++) {
+						Run *run = &queue.runs[iRun];
+						run->parameters = (RNSimTapperParameters) {
+							.alpha				= alphas.values[a],
+							.beta				= betas.values[b],
+							.period_ms			= period_ms,
+							.periodSD_ms		= periodSD_ms,
+							.timekeeperSD_ms	= timekeeperSDs.values[t],
+							.motorSD_ms			= motorSDs.values[m],
+						};
+						run->repeat	= r;
+						run->seed	= seed + iRun;
+					}
+	atomic_init(&queue.nextRun, 0);
+
+	if (nThreads < 1) nThreads = 1;
+	if ((size_t) nThreads > queue.nRuns) nThreads = (long) queue.nRuns;
+	pthread_t *threads = calloc((size_t) nThreads, sizeof(pthread_t));
+	if (!threads) return 1;
+	long nStarted = 0;
+	for (long i = 0; i < nThreads; i++)
+		if (pthread_create(&threads[nStarted], NULL, worker, &queue) == 0) nStarted++;
+	if (nStarted == 0) worker(&queue);			// no threads to be had: do the work here
+	for (long i = 0; i < nStarted; i++) pthread_join(threads[i], NULL);
+
+	int status = 0;
+	printf("run,alpha,beta,timekeeperSD_ms,motorSD_ms,repeat,seed,nTaps,meanITI_ms,sdITI_ms,"
+		   "nStimAsyn,meanStimAsyn_ms,sdStimAsyn_ms,nPartnerAsyn,meanPartnerAsyn_ms,sdPartnerAsyn_ms\n");
+	for (size_t i = 0; i < queue.nRuns; i++) {
+		const Run *run = &queue.runs[i];
+		if (!run->ok) {
+			status = 1;
+			continue;
+		}
+		const RNSimSummary *s = &run->summary;
+		printf("%zu,%g,%g,%g,%g,%u,%llu,%llu,%.3f,%.3f,%llu,%.3f,%.3f,%llu,%.3f,%.3f\n", i,
+			   run->parameters.alpha, run->parameters.beta, run->parameters.timekeeperSD_ms, run->parameters.motorSD_ms,
+			   run->repeat, (unsigned long long) run->seed, (unsigned long long) s->nTaps, s->meanITI_ms, s->sdITI_ms,
+			   (unsigned long long) s->nStimulusAsynchronies, s->meanStimulusAsynchrony_ms, s->sdStimulusAsynchrony_ms,
+			   (unsigned long long) s->nPartnerAsynchronies, s->meanPartnerAsynchrony_ms, s->sdPartnerAsynchrony_ms);
+	}
+	free(threads);
+	free(queue.runs);
+	RNSimExperimentDestroy(experiment);
+	return status;
+}
@@ -0,0 +1,364 @@
+//
+//  rnvelocitymap.c
+//  RhythmNetwork
+//
+//  Created by John R. Iversen on 2026-10-19.
+//
+
+// Check and benchmark of the velocity map compiler (MIOCVelocityMap.h).
+//
+//	rnvelocitymap [-c capture] [-n velocities] [-s seed]
+//
+//	Checks:
+//	- golden tables: the app's processors (MIOCVelocityProcessor's defaults, setWeight:,
+//	  setConstantVelocity:) and edge cases, worked out by hand from the manual's function, must
+//	  compile byte for byte, and come out of the simulated MIOC (MIOCSimulator.h) the same, a
+//	  note-on at each velocity through the processors on an output
+//	- the curve setWeight: sends is the one MIOCVelocityCurveForWeight makes
+//	- a weight's table (as RNMIDIRouting compiles one per weight) is its curve at every velocity
+//	- with -c, a capture from the box: lines of threshold, gradient below and above (eighths, as
+//	  sent), offset, velocity in and velocity out, decimal; '#' starts a comment
+//	Then -n routed velocities mapped per second, by their weight's table and by working out its curve each time.
+//	A line per check to stdout; exit status 1 if any failed.
+//
+// Build (Linux or macOS):
+//	cc -O2 -std=gnu11 -I.. rnvelocitymap.c ../MIOCVelocityMap.c ../MIOCSimulator.c ../MIOCSysex.c ../MIOCConnectionSet.c -lm -o rnvelocitymap
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "MIOCVelocityMap.h"
+#include "MIOCSimulator.h"
+#include "MIOCSysex.h"
+
+#define kMaxChain	8
+
+typedef struct {
+	const char			*name;
+	uint32_t			nCurves;
+	MIOCVelocityCurve	curves[kMaxChain];	// threshold, gradient below, above (eighths), offset
+	uint8_t				table[kMIOCVelocityTableLength];
+} Golden;
+
+static const Golden goldens[] = {
+	{ "default (threshold 64, gradients 1)", 1, { { 64, 8, 8, 0 } },
+	  {
+		  0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+		 16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+		 32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+		 48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,
+		 64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+		 80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+		 96,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111,
+		112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125, 126, 127,
+	  } },
+	{ "weight 0.5 (setWeight:)", 1, { { 0, 8, 4, 0 } },
+	  {
+		  0,   1,   1,   1,   2,   2,   3,   3,   4,   4,   5,   5,   6,   6,   7,   7,
+		  8,   8,   9,   9,  10,  10,  11,  11,  12,  12,  13,  13,  14,  14,  15,  15,
+		 16,  16,  17,  17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  23,
+		 24,  24,  25,  25,  26,  26,  27,  27,  28,  28,  29,  29,  30,  30,  31,  31,
+		 32,  32,  33,  33,  34,  34,  35,  35,  36,  36,  37,  37,  38,  38,  39,  39,
+		 40,  40,  41,  41,  42,  42,  43,  43,  44,  44,  45,  45,  46,  46,  47,  47,
+		 48,  48,  49,  49,  50,  50,  51,  51,  52,  52,  53,  53,  54,  54,  55,  55,
+		 56,  56,  57,  57,  58,  58,  59,  59,  60,  60,  61,  61,  62,  62,  63,  63,
+	  } },
+	{ "weight 2", 1, { { 0, 8, 16, 0 } },
+	  {
+		  0,   2,   4,   6,   8,  10,  12,  14,  16,  18,  20,  22,  24,  26,  28,  30,
+		 32,  34,  36,  38,  40,  42,  44,  46,  48,  50,  52,  54,  56,  58,  60,  62,
+		 64,  66,  68,  70,  72,  74,  76,  78,  80,  82,  84,  86,  88,  90,  92,  94,
+		 96,  98, 100, 102, 104, 106, 108, 110, 112, 114, 116, 118, 120, 122, 124, 126,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+	  } },
+	{ "weight -1", 1, { { 0, 8, -8, 0 } },
+	  {
+		  0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+	  } },
+	{ "constant 100 (setConstantVelocity:)", 1, { { 100, 0, 0, 0 } },
+	  {
+		  0, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+		100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100, 100,
+	  } },
+	{ "inverted about 64", 1, { { 64, -8, -8, 0 } },
+	  {
+		  0, 127, 126, 125, 124, 123, 122, 121, 120, 119, 118, 117, 116, 115, 114, 113,
+		112, 111, 110, 109, 108, 107, 106, 105, 104, 103, 102, 101, 100,  99,  98,  97,
+		 96,  95,  94,  93,  92,  91,  90,  89,  88,  87,  86,  85,  84,  83,  82,  81,
+		 80,  79,  78,  77,  76,  75,  74,  73,  72,  71,  70,  69,  68,  67,  66,  65,
+		 64,  63,  62,  61,  60,  59,  58,  57,  56,  55,  54,  53,  52,  51,  50,  49,
+		 48,  47,  46,  45,  44,  43,  42,  41,  40,  39,  38,  37,  36,  35,  34,  33,
+		 32,  31,  30,  29,  28,  27,  26,  25,  24,  23,  22,  21,  20,  19,  18,  17,
+		 16,  15,  14,  13,  12,  11,  10,   9,   8,   7,   6,   5,   4,   3,   2,   1,
+	  } },
+	{ "compressed above 80, +10", 1, { { 80, 8, 2, 10 } },
+	  {
+		  0,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,
+		 26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,
+		 42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+		 58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,
+		 74,  75,  76,  77,  78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  88,  89,
+		 90,  90,  90,  90,  91,  91,  91,  91,  92,  92,  92,  92,  93,  93,  93,  93,
+		 94,  94,  94,  94,  95,  95,  95,  95,  96,  96,  96,  96,  97,  97,  97,  97,
+		 98,  98,  98,  98,  99,  99,  99,  99, 100, 100, 100, 100, 101, 101, 101, 101,
+	  } },
+	{ "expanded below 40, -20", 1, { { 40, 24, 8, -20 } },
+	  {
+		  0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+		  1,   1,   2,   5,   8,  11,  14,  17,  20,  21,  22,  23,  24,  25,  26,  27,
+		 28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,
+		 44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,
+		 60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,
+		 76,  77,  78,  79,  80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,
+		 92,  93,  94,  95,  96,  97,  98,  99, 100, 101, 102, 103, 104, 105, 106, 107,
+	  } },
+	{ "steepest both sides", 1, { { 64, -128, 127, -128 } },
+	  {
+		  0, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 112,  96,  80,  64,  48,  32,  16,   1,   1,   1,   1,
+		  1,   1,   1,   1,   1,  15,  31,  47,  63,  78,  94, 110, 126, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+		127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127, 127,
+	  } },
+	{ "inverted, then weight 0.5", 2, { { 64, -8, -8, 0 }, { 0, 8, 4, 0 } },
+	  {
+		  0,  63,  63,  62,  62,  61,  61,  60,  60,  59,  59,  58,  58,  57,  57,  56,
+		 56,  55,  55,  54,  54,  53,  53,  52,  52,  51,  51,  50,  50,  49,  49,  48,
+		 48,  47,  47,  46,  46,  45,  45,  44,  44,  43,  43,  42,  42,  41,  41,  40,
+		 40,  39,  39,  38,  38,  37,  37,  36,  36,  35,  35,  34,  34,  33,  33,  32,
+		 32,  31,  31,  30,  30,  29,  29,  28,  28,  27,  27,  26,  26,  25,  25,  24,
+		 24,  23,  23,  22,  22,  21,  21,  20,  20,  19,  19,  18,  18,  17,  17,  16,
+		 16,  15,  15,  14,  14,  13,  13,  12,  12,  11,  11,  10,  10,   9,   9,   8,
+		  8,   7,   7,   6,   6,   5,   5,   4,   4,   3,   3,   2,   2,   1,   1,   1,
+	  } },
+};
+
+static unsigned nFailed;
+
+static void check(bool ok, const char *what)
+{
+	printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+	if (!ok) nFailed++;
+}
+
+static uint64_t randomNext(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static double now_s(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// the simulator's note-ons out of port 2, by velocity in
+typedef struct {
+	uint8_t		mapped[kMIOCVelocityTableLength];
+	uint8_t		velocity;
+	unsigned	n;
+} Heard;
+
+static void heardProc(uint8_t port, const uint8_t *bytes, uint32_t length, int64_t time_ns, void *refCon)
+{
+	Heard *heard = refCon;
+	(void) time_ns;
+	if (port != 1 || length != 3 || (bytes[0] & 0xF0) != 0x90) return;
+	heard->mapped[heard->velocity] = bytes[2];
+	heard->n++;
+}
+
+static void addProcessor(MIOCSimulator *simulator, const uint8_t *processor, uint32_t length)
+{
+	uint8_t data[1 + 8], message[kMIOCSysexMaxMessage];
+	data[0] = 0x80;	// add
+	memcpy(data + 1, processor, length);
+	uint32_t n = MIOCSysexCompose(message, 0x00, 0x20, kMIOCSysexModeEncoded, 0x04, data, 1 + length);
+	MIOCSimReceive(simulator, 7, message, n, 0);
+}
+
+// a route from port 1 to port 2, the chain on port 2's output (MIOCVelocityProcessor MIDIBytes), each velocity in
+static bool simulatorMatches(const Golden *golden)
+{
+	Heard heard = { .n = 0 };
+	MIOCSimConfig config;
+	MIOCSimDefaultConfig(&config);
+	MIOCSimulator *simulator = MIOCSimCreate(&config, heardProc, &heard);
+	const uint8_t route[5] = { 0x00, 0, 0x80, 1, 0x80 };
+	addProcessor(simulator, route, sizeof(route));
+	for (uint32_t k = 0; k < golden->nCurves; k++) {
+		const MIOCVelocityCurve *c = &golden->curves[k];
+		uint8_t processor[8] = { 0x25, 1, 0x10, (uint8_t) k, c->threshold, (uint8_t) c->gradientBelow, (uint8_t) c->gradientAbove, (uint8_t) c->offset };
+		addProcessor(simulator, processor, sizeof(processor));
+	}
+	heard.mapped[0] = 0;
+	for (unsigned velocity = 1; velocity < kMIOCVelocityTableLength; velocity++) {
+		uint8_t note[3] = { 0x90, 60, (uint8_t) velocity };
+		heard.velocity = (uint8_t) velocity;
+		MIOCSimReceive(simulator, 0, note, 3, 0);
+	}
+	MIOCSimDestroy(simulator);
+	return heard.n == kMIOCVelocityTableLength - 1 && memcmp(heard.mapped, golden->table, sizeof(heard.mapped)) == 0;
+}
+
+static void checkGoldens(void)
+{
+	for (size_t g = 0; g < sizeof(goldens) / sizeof(goldens[0]); g++) {
+		const Golden *golden = &goldens[g];
+		uint8_t table[kMIOCVelocityTableLength];
+		MIOCVelocityTableCompile(table, golden->curves, golden->nCurves);
+		char what[128];
+		snprintf(what, sizeof(what), "golden: %s", golden->name);
+		check(memcmp(table, golden->table, sizeof(table)) == 0 && simulatorMatches(golden), what);
+	}
+	MIOCVelocityCurve half = MIOCVelocityCurveForWeight(0.5), weight = goldens[1].curves[0];
+	check(memcmp(&half, &weight, sizeof(half)) == 0, "weight 0.5 is the curve setWeight: sends");
+}
+
+// weights as RNMIDIRouting compiles them: one table each, the curve setWeight: sends at every velocity
+static void checkWeightTables(void)
+{
+	static const double weights[] = { -1.0, -0.25, 0.0, 0.1, 0.5, 0.75, 1.0, 1.5, 2.0, 16.0 };
+	bool ok = true;
+	for (size_t w = 0; w < sizeof(weights) / sizeof(weights[0]); w++) {
+		MIOCVelocityCurve curve = MIOCVelocityCurveForWeight(weights[w]);
+		uint8_t table[kMIOCVelocityTableLength];
+		MIOCVelocityTableCompile(table, &curve, 1);
+		if (table[0] != 0) ok = false;
+		for (unsigned v = 1; v < kMIOCVelocityTableLength; v++)
+			if (table[v] != MIOCVelocityCurveMap(&curve, (uint8_t) v)) ok = false;
+	}
+	check(ok, "a weight's table is its curve at every velocity");
+}
+
+static void checkCapture(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		perror(path);
+		nFailed++;
+		return;
+	}
+	char line[256];
+	unsigned nLines = 0, nWrong = 0;
+	while (fgets(line, sizeof(line), file)) {
+		char *comment = strchr(line, '#');
+		if (comment) *comment = '\0';
+		int threshold, below, above, offset, velocity, mapped;
+		if (sscanf(line, "%d %d %d %d %d %d", &threshold, &below, &above, &offset, &velocity, &mapped) != 6) continue;
+		MIOCVelocityCurve curve = { (uint8_t) threshold, (int8_t) below, (int8_t) above, (int8_t) offset };
+		uint8_t ours = MIOCVelocityCurveMap(&curve, (uint8_t) velocity);
+		if (ours != mapped) {
+			if (nWrong < 10)
+				printf("     %d %d %d %d: %d -> %d, we make %d\n", threshold, below, above, offset, velocity, mapped, ours);
+			nWrong++;
+		}
+		nLines++;
+	}
+	fclose(file);
+	char what[256];
+	snprintf(what, sizeof(what), "capture %s: %u of %u velocities as the box mapped them", path, nLines - nWrong, nLines);
+	check(nLines > 0 && nWrong == 0, what);
+}
+
+static volatile uint8_t sink;
+
+// what the delay path does per note-on: a routed weight's velocity, by its table (as now) or by working out its
+//	curve each time (as it did)
+static void benchmark(size_t nVelocities, uint64_t *seed)
+{
+	enum { kBatch = 4096, kWeights = 4 };
+	static const double weights[kWeights] = { 0.25, 0.5, 0.75, 1.5 };
+	uint8_t tables[kWeights][kMIOCVelocityTableLength], velocities[kBatch], weightIndex[kBatch];
+	for (unsigned w = 0; w < kWeights; w++) {
+		MIOCVelocityCurve curve = MIOCVelocityCurveForWeight(weights[w]);
+		MIOCVelocityTableCompile(tables[w], &curve, 1);
+	}
+	for (size_t i = 0; i < kBatch; i++) {
+		velocities[i] = 1 + randomNext(seed) % 127;
+		weightIndex[i] = randomNext(seed) % kWeights;
+	}
+	size_t nBatches = (nVelocities + kBatch - 1) / kBatch;
+	unsigned sum = 0;
+
+	double start = now_s();
+	for (size_t b = 0; b < nBatches; b++) {
+		for (size_t i = 0; i < kBatch; i++)
+			sum += tables[weightIndex[i]][velocities[i]];
+		__asm__ volatile("" : "+r"(sum));	// keep the loop a loop
+	}
+	double lookup = now_s() - start;
+
+	start = now_s();
+	for (size_t b = 0; b < nBatches; b++) {
+		for (size_t i = 0; i < kBatch; i++) {
+			MIOCVelocityCurve curve = MIOCVelocityCurveForWeight(weights[weightIndex[i]]);
+			sum += MIOCVelocityCurveMap(&curve, velocities[i]);
+		}
+		__asm__ volatile("" : "+r"(sum));
+	}
+	double curve = now_s() - start;
+	sink += (uint8_t) sum;
+
+	printf("     weight's table %7.1f M velocities/s (its curve each time %7.1f M/s, %.1fx)\n",
+		   nBatches * (double) kBatch / lookup * 1e-6, nBatches * (double) kBatch / curve * 1e-6, curve / lookup);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "usage: rnvelocitymap [-c capture] [-n velocities] [-s seed]\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *capturePath = NULL;
+	size_t nVelocities = 200000000;
+	uint64_t seed = 1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "c:n:s:h")) != -1) {
+		switch (opt) {
+			case 'c': capturePath = optarg; break;
+			case 'n': nVelocities = (size_t) strtoull(optarg, NULL, 10); break;
+			case 's': seed = strtoull(optarg, NULL, 10); break;
+			default: usage(); return 2;
+		}
+	}
+	if (optind != argc || nVelocities == 0) { usage(); return 2; }
+
+	checkGoldens();
+	checkWeightTables();
+	if (capturePath) checkCapture(capturePath);
+
+	benchmark(nVelocities, &seed);
+
+	return nFailed ? 1 : 0;
+}